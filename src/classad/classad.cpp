@@ -444,23 +444,39 @@ bool ClassAd::Insert( const std::string& serialized_nvp)
 		}
 	}
 
+    bRet = InsertViaCache( name, szValue );
+    
+  } // end if pos != string::npos
+
+  return bRet;
+}
+
+bool ClassAd::InsertViaCache( const std::string& attrName, const std::string& rhs,
+							  ExprTree *tree )
+{
+	bool bRet = false;
+	std::string name = attrName;
+
     // here is the special logic to check
     CachedExprEnvelope * cache_check = NULL;
 	if ( doExpressionCaching ) {
-		cache_check = CachedExprEnvelope::check_hit( name, szValue );
+		cache_check = CachedExprEnvelope::check_hit( name, rhs );
 	}
     if ( cache_check ) 
     {
+	delete tree;
 	ExprTree * in = cache_check;
 	bRet = Insert( name, in, false );
     }
     else
     {
-      ClassAdParser parser;
-      ExprTree * newTree=0;
+      ExprTree * newTree = tree;
 
       // we did not hit in the cache... parse the expression
-      newTree = parser.ParseExpression(szValue);
+      if ( !newTree ) {
+        ClassAdParser parser;
+        newTree = parser.ParseExpression(rhs);
+      }
 
       if ( newTree )
       {
@@ -468,14 +484,15 @@ bool ClassAd::Insert( const std::string& serialized_nvp)
 		// cache doesn't already have an entry for this name:value, so add
 		// it to the cache now. 
 		if (doExpressionCaching) {
-			newTree = CachedExprEnvelope::cache(name, szValue, newTree);
+			newTree = CachedExprEnvelope::cache(name, rhs, newTree);
 		}
 		bRet = Insert(name, newTree, false);
+		if ( !bRet ) {
+			delete newTree;
+		}
       }
 
     }
-    
-  } // end if pos != string::npos
 
   return bRet;
 }
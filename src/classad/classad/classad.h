@@ -49,6 +49,12 @@ void ClassAdLibraryVersion(std::string &version_string);
 void ClassAdSetExpressionCaching(bool do_caching);
 bool ClassAdGetExpressionCaching();
 
+// How many compiled patterns regexp() and friends keep, so that a pattern
+// used over and over is not compiled every time.  0 disables the cache.
+// The default is 500.
+void ClassAdSetRegexCacheSize(int max_patterns);
+int ClassAdGetRegexCacheSize();
+
 // This flag is only meant for use in Condor, which is transitioning
 // from an older version of ClassAds with slightly different evaluation
 // semantics. It will be removed without warning in a future release.
@@ -114,6 +120,19 @@ class ClassAd : public ExprTree
 		bool Insert( const std::string& attrName, ClassAd *& expr, bool cache=true );
 		bool Insert( const std::string& serialized_nvp);
 
+		/** Inserts an attribute given as expression text.  When expression
+				caching is enabled, the tree is shared with any other ad
+				that already has the same name and text, and only parsed
+				on a cache miss.
+			@param attrName The name of the attribute.
+			@param rhs The expression text bound to the name.
+			@param tree If not NULL, the already-parsed form of rhs, which
+				is used (or deleted) instead of parsing rhs again.
+			@return true if the operation succeeded, false otherwise.
+		*/
+		bool InsertViaCache( const std::string& attrName, const std::string& rhs,
+							 ExprTree *tree = NULL );
+
 
 		/** Inserts an attribute into a nested classAd.  The scope expression is
 		 		evaluated to obtain a nested classad, and the attribute is 
@@ -0,0 +1,68 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef __CLASSAD_REGEX_CACHE_H__
+#define __CLASSAD_REGEX_CACHE_H__
+
+#include "classad/common.h"
+#include <string>
+
+namespace classad {
+
+int ClassAdGetRegexCacheSize();
+
+/**
+ * A compiled regular expression in the regex cache.  Each user of the
+ * cache derives whatever it compiles patterns into from this.
+ */
+class RegexCacheEntry
+{
+public:
+	virtual ~RegexCacheEntry() {}
+};
+typedef classad_shared_ptr<RegexCacheEntry> RegexCacheEntryPtr;
+
+/**
+ * The process has one LRU cache of compiled regular expressions, holding
+ * at most ClassAdGetRegexCacheSize() of them in all.  regexp() and
+ * friends use it, as does anything else that matches the same patterns
+ * over and over, such as Condor's stringListRegexpMember().  Entries are
+ * keyed by pattern text and compile options, and by a kind that keeps
+ * apart users that compile patterns into different forms.  The ClassAd
+ * library's own functions use kind 0.
+ *
+ * ClassAds may be evaluated on more than one thread at once (the
+ * negotiator's match workers, for one), so the cache has a lock, and
+ * entries are handed out as shared pointers: evicting an entry never
+ * frees a pattern that another thread is still matching against.
+ * Callers compile outside of the lock, between RegexCacheFind() and
+ * RegexCacheInsert().
+ */
+
+/// Return the cached pattern, or an empty pointer if there is none.
+RegexCacheEntryPtr RegexCacheFind( int kind, int options,
+								   const std::string &pattern );
+
+/// Remember a newly compiled pattern, unless caching is off.
+void RegexCacheInsert( int kind, int options, const std::string &pattern,
+					   const RegexCacheEntryPtr &re );
+
+} // classad
+
+#endif//__CLASSAD_REGEX_CACHE_H__
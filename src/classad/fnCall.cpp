@@ -51,6 +51,13 @@
 #include <dlfcn.h>
 #endif
 
+#include "classad/regexCache.h"
+#include <list>
+#include <map>
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
 using namespace std;
 
 namespace classad {
@@ -2520,6 +2527,121 @@ debug( const char* name,const ArgumentList &argList,EvalState &state,
 	return true;
 }
 
+// Size of the cache of compiled regular expressions, see regexCache.h.
+static size_t regexCacheMax = 500;
+
+void ClassAdSetRegexCacheSize(int max_patterns)
+{
+	regexCacheMax = (max_patterns > 0) ? (size_t)max_patterns : 0;
+}
+
+int ClassAdGetRegexCacheSize()
+{
+	return (int)regexCacheMax;
+}
+
+// The cache of compiled regular expressions behind RegexCacheFind() and
+// RegexCacheInsert(); there is only the one, regexCache.
+class RegexCache
+{
+public:
+	RegexCache() {
+#ifdef WIN32
+		InitializeCriticalSection( &m_cs );
+#else
+		pthread_mutex_init( &m_mutex, NULL );
+#endif
+	}
+	~RegexCache() {
+#ifdef WIN32
+		DeleteCriticalSection( &m_cs );
+#else
+		pthread_mutex_destroy( &m_mutex );
+#endif
+	}
+
+	RegexCacheEntryPtr Find( int kind, int options, const string &pattern ) {
+		RegexCacheEntryPtr re;
+		Key key( kind, options, pattern );
+		lock();
+		Map::iterator it = m_map.find( key );
+		if( it != m_map.end() ) {
+			m_lru.splice( m_lru.begin(), m_lru, it->second.lru );
+			re = it->second.re;
+		}
+		trim( regexCacheMax );
+		unlock();
+		return re;
+	}
+
+	void Insert( int kind, int options, const string &pattern,
+				 const RegexCacheEntryPtr &re ) {
+		Key key( kind, options, pattern );
+		lock();
+		if( regexCacheMax > 0 && m_map.find( key ) == m_map.end() ) {
+			trim( regexCacheMax - 1 );
+			m_lru.push_front( key );
+			Slot &slot = m_map[key];
+			slot.re = re;
+			slot.lru = m_lru.begin();
+		}
+		unlock();
+	}
+
+private:
+	struct Key {
+		int kind;
+		int options;
+		string pattern;
+		Key( int k, int o, const string &p ) : kind(k), options(o), pattern(p) {}
+		bool operator<( const Key &other ) const {
+			if( kind != other.kind ) return kind < other.kind;
+			if( options != other.options ) return options < other.options;
+			return pattern < other.pattern;
+		}
+	};
+	typedef std::list<Key> LRU;
+	struct Slot {
+		RegexCacheEntryPtr	re;
+		LRU::iterator		lru;
+	};
+	typedef std::map<Key, Slot> Map;
+
+		// call with the lock held
+	void trim( size_t max_patterns ) {
+		while( m_map.size() > max_patterns ) {
+			m_map.erase( m_lru.back() );
+			m_lru.pop_back();
+		}
+	}
+
+#ifdef WIN32
+	void lock() { EnterCriticalSection( &m_cs ); }
+	void unlock() { LeaveCriticalSection( &m_cs ); }
+	CRITICAL_SECTION m_cs;
+#else
+	void lock() { pthread_mutex_lock( &m_mutex ); }
+	void unlock() { pthread_mutex_unlock( &m_mutex ); }
+	pthread_mutex_t m_mutex;
+#endif
+
+	Map m_map;
+	LRU m_lru;		// most recently used first
+};
+
+static RegexCache regexCache;
+
+RegexCacheEntryPtr RegexCacheFind( int kind, int options, const string &pattern )
+{
+	return regexCache.Find( kind, options, pattern );
+}
+
+void RegexCacheInsert( int kind, int options, const string &pattern,
+					   const RegexCacheEntryPtr &re )
+{
+	regexCache.Insert( kind, options, pattern, re );
+}
+
 #if defined USE_POSIX_REGEX || defined USE_PCRE
 static bool regexp_helper(const char *pattern, const char *target,
                           const char *replace,
@@ -2749,6 +2871,102 @@ matchPatternMember( const char*,const ArgumentList &argList,EvalState &state,
     return true;
 }
 
+// A compiled regular expression, shared between the cache and any
+// evaluations that are using it.
+class CompiledRegex : public RegexCacheEntry {
+public:
+	CompiledRegex();
+	~CompiledRegex();
+	bool compile(const char *pattern, int options);
+
+#if defined (USE_POSIX_REGEX)
+	regex_t		re;
+#elif defined (USE_PCRE)
+	pcre		*re;
+	pcre_extra	*extra;			// from pcre_study(), may be NULL
+	int			group_count;
+#endif
+
+private:
+	bool		compiled;
+	CompiledRegex(const CompiledRegex &);
+	CompiledRegex &operator=(const CompiledRegex &);
+};
+
+CompiledRegex::CompiledRegex() : compiled(false)
+{
+#if defined (USE_PCRE)
+	re = NULL;
+	extra = NULL;
+	group_count = 0;
+#endif
+}
+
+CompiledRegex::~CompiledRegex()
+{
+	if( !compiled ) {
+		return;
+	}
+#if defined (USE_POSIX_REGEX)
+	regfree( &re );
+#elif defined (USE_PCRE)
+	if( extra ) {
+	#ifdef PCRE_STUDY_JIT_COMPILE
+		pcre_free_study( extra );
+	#else
+		pcre_free( extra );
+	#endif
+	}
+	pcre_free( re );
+#endif
+}
+
+bool CompiledRegex::compile(const char *pattern, int options)
+{
+#if defined (USE_POSIX_REGEX)
+	compiled = ( regcomp( &re, pattern, options ) == 0 );
+#elif defined (USE_PCRE)
+	const char  *error_message;
+	int         error_offset;
+
+	re = pcre_compile( pattern, options, &error_message, &error_offset, NULL );
+	compiled = ( re != NULL );
+	if( compiled ) {
+		pcre_fullinfo( re, NULL, PCRE_INFO_CAPTURECOUNT, &group_count );
+			// the pattern is going to be matched many times, so it is
+			// worth studying (and JIT compiling, where pcre can).
+	#ifdef PCRE_STUDY_JIT_COMPILE
+		extra = pcre_study( re, PCRE_STUDY_JIT_COMPILE, &error_message );
+	#else
+		extra = pcre_study( re, 0, &error_message );
+	#endif
+	}
+#endif
+	return compiled;
+}
+
+// Return the compiled form of pattern, a CompiledRegex, compiling it
+// only if it isn't already in the cache (as kind 0, see regexCache.h).
+// Returns an empty pointer if the pattern is not valid.
+static RegexCacheEntryPtr
+compile_regex( const char *pattern, int options )
+{
+	RegexCacheEntryPtr cre = RegexCacheFind( 0, options, pattern );
+	if( cre ) {
+		return cre;
+	}
+
+		// compile outside of the lock
+	CompiledRegex *compiled = new CompiledRegex;
+	cre.reset( compiled );
+	if( !compiled->compile( pattern, options ) ) {
+		return RegexCacheEntryPtr();
+	}
+	RegexCacheInsert( 0, options, pattern, cre );
+
+	return cre;
+}
+
 static bool regexp_helper(
     const char *pattern,
     const char *target,
@@ -2761,8 +2979,6 @@ static bool regexp_helper(
 	int			status;
 
 #if defined (USE_POSIX_REGEX)
-	regex_t		re;
-
 	const int MAX_REGEX_GROUPS=11;
 	regmatch_t pmatch[MAX_REGEX_GROUPS];
 	size_t      nmatch = MAX_REGEX_GROUPS;
@@ -2781,17 +2997,16 @@ static bool regexp_helper(
     }
 
 		// compile the patern
-	if( regcomp( &re, pattern, options ) != 0 ) {
+	RegexCacheEntryPtr entry = compile_regex( pattern, options );
+	if( !entry ) {
 			// error in pattern
 		result.SetErrorValue( );
 		return( true );
 	}
+	CompiledRegex *cre = static_cast<CompiledRegex *>( entry.get() );
 
 		// test the match
-	status = regexec( &re, target, nmatch, pmatch, 0 );
-
-		// dispose memory created by regcomp()
-	regfree( &re );
+	status = regexec( &cre->re, target, nmatch, pmatch, 0 );
 
 	if( status == 0 && replace ) {
 		string group_buffers[MAX_REGEX_GROUPS];
@@ -2859,10 +3074,6 @@ static bool regexp_helper(
 		return( true );
 	}
 #elif defined (USE_PCRE)
-    const char  *error_message;
-    int         error_offset;
-    pcre        *re;
-
     options     = 0;
     if( have_options ){
         // We look for the options we understand, and ignore
@@ -2882,19 +3093,17 @@ static bool regexp_helper(
         }
     }
 
-    re = pcre_compile( pattern, options, &error_message,
-                      &error_offset, NULL );
-    if ( re == NULL ){
+    RegexCacheEntryPtr entry = compile_regex( pattern, options );
+    if ( !entry ){
 			// error in pattern
 		result.SetErrorValue( );
     } else {
-		int group_count;
-		pcre_fullinfo(re, NULL, PCRE_INFO_CAPTURECOUNT, &group_count);
-		int oveccount = 3 * (group_count + 1); // +1 for the string itself
+		CompiledRegex *cre = static_cast<CompiledRegex *>( entry.get() );
+		int oveccount = 3 * (cre->group_count + 1); // +1 for the string itself
 		int * ovector = (int *) malloc(oveccount * sizeof(int));
 
 
-        status = pcre_exec(re, NULL, target, strlen(target),
+        status = pcre_exec(cre->re, cre->extra, target, strlen(target),
                            0, 0, ovector, oveccount);
         if (status >= 0) {
             result.SetBooleanValue( true );
@@ -2902,8 +3111,6 @@ static bool regexp_helper(
             result.SetBooleanValue( false );
         }
 
-		pcre_free(re);
-
 		if( replace && status<0 ) {
 			result.SetStringValue( "" );
 		}
@@ -0,0 +1,143 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#define BOOST_TEST_MAIN
+#define BOOST_AUTO_TEST_MAIN
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/auto_unit_test.hpp>
+#include <vector>
+#include <iostream>
+#include <string>
+#include <stdio.h>
+#include <time.h>
+
+#include "classad/classad_distribution.h"
+
+using namespace std;
+using namespace classad;
+
+/////////////////////////////////////////////////////////////////
+// Evaluations per second of the regexp() family of functions
+// with and without the cache of compiled patterns.
+//
+// The expressions are evaluated against a set of ads the way
+// a START or Requirements expression is during negotiation.
+
+#define BOOST_TEST_MODULE regex cache test suite
+
+static const char * const testExprs[] = {
+	"regexp(\"^(alice|bob|carol)$\", Owner)",
+	"regexp(\"^slot[0-9]+@exec-[0-9]+\\\\.example\\\\.org$\", Name, \"i\")",
+	"regexps(\"^([a-z]+)-([0-9]+)$\", Machine, \"\\\\2:\\\\1\")",
+	"regexpMember(\"^(tmp|scratch)[0-9]*$\", Filesystems)",
+};
+static const int numExprs = sizeof(testExprs) / sizeof(testExprs[0]);
+
+static void
+make_ads( vector< classad_shared_ptr<ClassAd> > &ads, int count )
+{
+	static const char * const owners[] = { "alice", "bob", "carol", "dave" };
+	char buf[100];
+
+	for( int ix = 0; ix < count; ++ix ) {
+		classad_shared_ptr<ClassAd> ad( new ClassAd );
+		ad->InsertAttr( "Owner", owners[ix % 4] );
+		sprintf( buf, "slot%d@exec-%d.example.org", ix % 8 + 1, ix / 8 );
+		ad->InsertAttr( "Name", buf );
+		sprintf( buf, "exec-%d", ix / 8 );
+		ad->InsertAttr( "Machine", buf );
+		ad->Insert( (ix % 3) ? "Filesystems = { \"home\", \"scratch2\", \"var\" }"
+		                     : "Filesystems = { \"home\", \"var\" }" );
+		ads.push_back( ad );
+	}
+}
+
+// Evaluate every expression against every ad, passes times over; return
+// the evaluations per second, and the string form of all of the results
+// so the two runs can be compared.
+static double
+run_evaluations( vector< classad_shared_ptr<ClassAd> > &ads, int passes, string &results )
+{
+	ClassAdParser parser;
+	ExprTree *exprs[numExprs];
+	for( int ix = 0; ix < numExprs; ++ix ) {
+		exprs[ix] = parser.ParseExpression( testExprs[ix] );
+		BOOST_REQUIRE( exprs[ix] != NULL );
+	}
+
+	ClassAdUnParser unparser;
+	Value val;
+	long evaluations = 0;
+	results.clear();
+
+	clock_t start = clock();
+	for( int pass = 0; pass < passes; ++pass ) {
+		for( size_t ad = 0; ad < ads.size(); ++ad ) {
+			for( int ix = 0; ix < numExprs; ++ix ) {
+				exprs[ix]->SetParentScope( ads[ad].get() );
+				BOOST_REQUIRE( ads[ad]->EvaluateExpr( exprs[ix], val ) );
+				if( pass == 0 ) {
+					unparser.Unparse( results, val );
+					results += ';';
+				}
+				++evaluations;
+			}
+		}
+	}
+	double elapsed = (1.0 * (clock() - start)) / CLOCKS_PER_SEC;
+
+	for( int ix = 0; ix < numExprs; ++ix ) {
+		delete exprs[ix];
+	}
+	return elapsed > 0 ? evaluations / elapsed : 0;
+}
+
+// --------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE( regex_cache_test )
+{
+	vector< classad_shared_ptr<ClassAd> > ads;
+	make_ads( ads, 1000 );
+
+	int cache_size = ClassAdGetRegexCacheSize();
+	string uncached_results, cached_results;
+
+	ClassAdSetRegexCacheSize( 0 );
+	double uncached = run_evaluations( ads, 20, uncached_results );
+
+	ClassAdSetRegexCacheSize( cache_size );
+	double cached = run_evaluations( ads, 20, cached_results );
+
+	cout << "Evaluations/sec without regex cache: " << uncached << endl;
+	cout << "Evaluations/sec with regex cache:    " << cached << endl;
+
+	BOOST_CHECK( uncached_results == cached_results );
+	BOOST_CHECK( cached_results.find( "error" ) == string::npos );
+
+		// a cache of one pattern still gives the right answers
+		// as the patterns push each other out.
+	string small_results;
+	ClassAdSetRegexCacheSize( 1 );
+	run_evaluations( ads, 1, small_results );
+	BOOST_CHECK( small_results == cached_results );
+
+	ClassAdSetRegexCacheSize( cache_size );
+}
+
+//////////////////////////////////////////////////////////////////
@@ -247,6 +247,8 @@ void CollectorDaemon::Init()
 
 	daemonCore->Register_CommandWithPayload(UPDATE_STARTD_AD,"UPDATE_STARTD_AD",
 		(CommandHandler)receive_update,"receive_update",NULL,ADVERTISE_STARTD_PERM);
+	daemonCore->Register_CommandWithPayload(UPDATE_STARTD_ADS,"UPDATE_STARTD_ADS",
+		(CommandHandler)receive_startd_batch,"receive_startd_batch",NULL,ADVERTISE_STARTD_PERM);
 	daemonCore->Register_CommandWithPayload(MERGE_STARTD_AD,"MERGE_STARTD_AD",
 		(CommandHandler)receive_update,"receive_update",NULL,NEGOTIATOR);
 	daemonCore->Register_CommandWithPayload(UPDATE_SCHEDD_AD,"UPDATE_SCHEDD_AD",
@@ -729,10 +731,56 @@ int CollectorDaemon::receive_update(Service* /*s*/, int command, Stream* sock)
 				command);
 		}
 
+			// If this was a delta update we couldn't apply (insert
+			// == -4), returning FALSE closes the connection, and
+			// the daemon will send us the whole ad on a new one.
 		return FALSE;
 
 	}
 
+	process_update(command, cad);
+
+	if( sock->type() == Stream::reli_sock ) {
+			// stash this socket for future updates...
+		return stashSocket( (ReliSock *)sock );
+	}
+
+	// let daemon core clean up the socket
+	return TRUE;
+}
+
+// UPDATE_STARTD_ADS carries the ads of all of a startd's slots; each
+// one is handled just as if it had come in its own UPDATE_STARTD_AD.
+int CollectorDaemon::receive_startd_batch(Service* /*s*/, int /*command*/, Stream* sock)
+{
+	int num_collected = 0;
+
+	condor_sockaddr from = ((Sock*)sock)->peer_addr();
+
+		// process_update() is called on each ad as soon as it is
+		// collected, while the pointer is still good
+	bool ok = collector.collectStartdBatch((Sock*)sock, from, process_update, num_collected);
+
+	daemonCore->dc_stats.AddToAnyProbe("UpdatesReceived", num_collected);
+
+	if( !ok ) {
+			// whatever was collected before the failure stays; the
+			// startd reconnects and sends whole ads
+		return FALSE;
+	}
+
+	if( sock->type() == Stream::reli_sock ) {
+			// stash this socket for future updates...
+		return stashSocket( (ReliSock *)sock );
+	}
+
+	// let daemon core clean up the socket
+	return TRUE;
+}
+
+// What happens to an ad after the CollectorEngine has collected it
+void CollectorDaemon::process_update(int command, ClassAd *cad)
+{
 	/* let the off-line plug-in have at it */
 	offline_plugin_.update ( command, *cad );
 
@@ -749,14 +797,6 @@ int CollectorDaemon::receive_update(Service* /*s*/, int command, Stream* sock)
 	} else if ((command == UPDATE_STARTD_AD) || (command == UPDATE_SUBMITTOR_AD)) {
         send_classad_to_sock(command, cad);
 	}
-
-	if( sock->type() == Stream::reli_sock ) {
-			// stash this socket for future updates...
-		return stashSocket( (ReliSock *)sock );
-	}
-
-	// let daemon core clean up the socket
-	return TRUE;
 }
 
 int CollectorDaemon::receive_update_expect_ack( Service* /*s*/,
@@ -979,8 +1019,10 @@ void CollectorDaemon::process_query_public (AdTypes whichAds,
 	// give them out for specific collector queries, which is registered as
 	// ADMINISTRATOR when PROTECT_COLLECTOR_ADS is true.  This setting is
 	// designed only for use at the UW, and as such this knob is not present
-	// in the param table.
-	if ((whichAds != COLLECTOR_AD) && param_boolean("PROTECT_COLLECTOR_ADS", false)) {
+	// in the param table. It is checked for every query, so the value is
+	// only looked up again after a reconfig.
+	static ParamBoolean protect_collector_ads("PROTECT_COLLECTOR_ADS", false);
+	if ((whichAds != COLLECTOR_AD) && protect_collector_ads.value()) {
 		dprintf(D_FULLDEBUG, "Received query with generic type; filtering collector ads\n");
 		MyString modified_filter;
 		modified_filter.formatstr("(%s) && (MyType =!= \"Collector\")",
@@ -1019,7 +1061,7 @@ void CollectorDaemon::process_query_public (AdTypes whichAds,
 		}
 	}
 
-	if (!collector.walkHashTable (whichAds, query_scanFunc))
+	if (!collector.walkHashTable (whichAds, __filter__, query_scanFunc))
 	{
 		dprintf (D_ALWAYS, "Error sending query response\n");
 	}
@@ -1337,6 +1379,13 @@ void CollectorDaemon::Config()
 		tmp = NULL;
 	}
 
+	tmp = param("COLLECTOR_INDEX_ATTRIBUTES");
+	collector.setIndexAttributes( tmp );
+	if( tmp ) {
+		free( tmp );
+		tmp = NULL;
+	}
+
 	init_classad(i);
 
     // set the appropriate parameters in the collector engine
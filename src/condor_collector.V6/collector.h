@@ -101,6 +101,8 @@ public:
 	static int receive_invalidation(Service*, int, Stream*);
 	static int receive_update(Service*, int, Stream*);
     static int receive_update_expect_ack(Service*, int, Stream*);
+	static int receive_startd_batch(Service*, int, Stream*);
+	static void process_update(int, ClassAd*);
 
 	static void process_query_public(AdTypes, ClassAd*, List<ClassAd>*);
 	static ClassAd * process_global_query( const char *constraint, void *arg );
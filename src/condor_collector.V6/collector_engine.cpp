@@ -36,6 +36,7 @@ extern "C" void event_mgr (void);
 #include "condor_daemon_core.h"
 #include "file_sql.h"
 #include "classad_merge.h"
+#include "string_list.h"
 
 extern FILESQL *FILEObj;
 
@@ -46,7 +47,6 @@ extern FILESQL *FILEObj;
 
 static void killHashTable (CollectorHashTable &);
 static int killGenericHashTable(CollectorHashTable *);
-static void purgeHashTable (CollectorHashTable &);
 
 int 	engine_clientTimeoutHandler (Service *);
 int 	engine_housekeepingHandler  (Service *);
@@ -238,6 +238,7 @@ CollectorEngine::invalidateAds(AdTypes adType, ClassAd &query)
 				dprintf(D_ALWAYS,
 						"\t\t**** Invalidating ad: \"%s\"\n",
 						hkString.Value());
+				indexRemove(*table, ad);
 				delete ad;
 				count++;
 			}
@@ -317,6 +318,176 @@ walkHashTable (AdTypes adType, int (*scanFunction)(ClassAd *))
 	return 1;
 }
 
+int CollectorEngine::
+walkHashTable (AdTypes adType, classad::ExprTree *constraint,
+			   int (*scanFunction)(ClassAd *))
+{
+	if (m_indexes.empty() || !constraint) {
+		return walkHashTable(adType, scanFunction);
+	}
+
+	if (GENERIC_AD == adType) {
+		return walkIndexedGenericTables(constraint, scanFunction);
+	} else if (ANY_AD == adType) {
+		return
+			walkIndexedTable(StorageAds, constraint, scanFunction) &&
+			walkIndexedTable(CkptServerAds, constraint, scanFunction) &&
+			walkIndexedTable(LicenseAds, constraint, scanFunction) &&
+			walkIndexedTable(CollectorAds, constraint, scanFunction) &&
+			walkIndexedTable(StartdAds, constraint, scanFunction) &&
+			walkIndexedTable(ScheddAds, constraint, scanFunction) &&
+			walkIndexedTable(MasterAds, constraint, scanFunction) &&
+			walkIndexedTable(SubmittorAds, constraint, scanFunction) &&
+			walkIndexedTable(NegotiatorAds, constraint, scanFunction) &&
+#ifdef HAVE_EXT_POSTGRESQL
+			walkIndexedTable(QuillAds, constraint, scanFunction) &&
+#endif
+			walkIndexedTable(HadAds, constraint, scanFunction) &&
+			walkIndexedTable(GridAds, constraint, scanFunction) &&
+			walkIndexedTable(XferServiceAds, constraint, scanFunction) &&
+			walkIndexedTable(LeaseManagerAds, constraint, scanFunction) &&
+			walkIndexedGenericTables(constraint, scanFunction);
+	}
+
+	CollectorHashTable *table;
+	CollectorEngine::HashFunc func;
+	if (!LookupByAdType(adType, table, func)) {
+		dprintf (D_ALWAYS, "Unknown type %d\n", adType);
+		return 0;
+	}
+
+	if (!walkIndexedTable(*table, constraint, scanFunction)) {
+		return 0;
+	}
+	return 1;
+}
+
+int CollectorEngine::
+walkIndexedTable (CollectorHashTable &table, classad::ExprTree *constraint,
+				  int (*scanFunction)(ClassAd *))
+{
+	ClassAdAttrIndex *index = getIndex(table);
+	std::set<ClassAd *> candidates;
+	if (!index || !index->candidates(constraint, candidates)) {
+		return table.walk(scanFunction);
+	}
+
+	dprintf(D_FULLDEBUG, "Index narrowed query to %d of %d ads\n",
+			(int)candidates.size(), table.getNumElements());
+
+		// Candidates come back in address order, not hash table order.
+		// Neither order means anything to the client, and queries have
+		// never promised one.
+
+	std::set<ClassAd *>::iterator it;
+	for (it = candidates.begin(); it != candidates.end(); ++it) {
+		if (!scanFunction(*it)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int CollectorEngine::
+walkIndexedGenericTables (classad::ExprTree *constraint,
+						  int (*scanFunction)(ClassAd *))
+{
+	CollectorHashTable *cht = NULL;
+	GenericAds.startIterations();
+	while (GenericAds.iterate(cht)) {
+		if (!walkIndexedTable(*cht, constraint, scanFunction)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void CollectorEngine::
+setIndexAttributes (char const *attrs)
+{
+	StringList attr_list(attrs);
+		// the collector rewrites this one in place, behind the
+		// index's back
+	if (attr_list.contains_anycase(ATTR_LAST_HEARD_FROM)) {
+		dprintf(D_ALWAYS, "Not indexing %s, which changes without an update\n",
+				ATTR_LAST_HEARD_FROM);
+		attr_list.remove_anycase(ATTR_LAST_HEARD_FROM);
+	}
+	char *str = attr_list.print_to_string();
+	std::string new_attrs = str ? str : "";
+	free(str);
+	if (new_attrs == m_index_attrs) {
+		return;
+	}
+	m_index_attrs = new_attrs;
+	m_indexes.clear();
+
+	if (m_index_attrs.empty()) {
+		dprintf(D_FULLDEBUG, "Collector ad indexes disabled\n");
+		return;
+	}
+	dprintf(D_ALWAYS, "Indexing collector ads on: %s\n", m_index_attrs.c_str());
+
+		// index everything we already have
+	CollectorHashTable *tables[] = {
+		&StartdAds, &StartdPrivateAds,
+#ifdef HAVE_EXT_POSTGRESQL
+		&QuillAds,
+#endif
+		&ScheddAds, &SubmittorAds, &LicenseAds, &MasterAds, &StorageAds,
+		&XferServiceAds, &CkptServerAds, &GatewayAds, &CollectorAds,
+		&NegotiatorAds, &HadAds, &LeaseManagerAds, &GridAds
+	};
+	std::vector<CollectorHashTable *> all_tables(tables,
+			tables + sizeof(tables)/sizeof(tables[0]));
+	CollectorHashTable *cht = NULL;
+	GenericAds.startIterations();
+	while (GenericAds.iterate(cht)) {
+		all_tables.push_back(cht);
+	}
+
+	for (size_t i = 0; i < all_tables.size(); i++) {
+		ClassAd *ad;
+		all_tables[i]->startIterations();
+		while (all_tables[i]->iterate(ad)) {
+			indexInsert(*all_tables[i], ad);
+		}
+	}
+}
+
+ClassAdAttrIndex *CollectorEngine::
+getIndex (CollectorHashTable &table)
+{
+	if (m_index_attrs.empty()) {
+		return NULL;
+	}
+	AdIndexMap::iterator it = m_indexes.find(&table);
+	if (it == m_indexes.end()) {
+		it = m_indexes.insert(AdIndexMap::value_type(&table, ClassAdAttrIndex())).first;
+		StringList attrs(m_index_attrs.c_str());
+		it->second.setAttributes(attrs);
+	}
+	return &it->second;
+}
+
+void CollectorEngine::
+indexInsert (CollectorHashTable &table, ClassAd *ad)
+{
+	ClassAdAttrIndex *index = getIndex(table);
+	if (index) {
+		index->insert(ad);
+	}
+}
+
+void CollectorEngine::
+indexRemove (CollectorHashTable &table, ClassAd *ad)
+{
+	AdIndexMap::iterator it = m_indexes.find(&table);
+	if (it != m_indexes.end()) {
+		it->second.remove(ad);
+	}
+}
+
 CollectorHashTable *CollectorEngine::findOrCreateTable(MyString &type)
 {
 	CollectorHashTable *table=0;
@@ -482,8 +653,184 @@ bool CollectorEngine::ValidateClassAd(int command,ClassAd *clientAd,Sock *sock)
 	return true;
 }
 
+// A delta update only carries the attributes that have changed since
+// the ad the daemon last sent us (plus those we need to find that ad),
+// so fill in the rest from our copy.  If we don't have the ad the delta
+// was made against, we fail and the caller drops the connection, which
+// makes the daemon send the whole ad again.
+bool CollectorEngine::
+expandDeltaAd (int command, ClassAd *clientAd)
+{
+	int		base_seq;
+
+	if( !clientAd->LookupInteger( ATTR_UPDATE_DELTA_BASE_SEQUENCE, base_seq ) ) {
+		// the whole ad
+		return true;
+	}
+	clientAd->Delete( ATTR_UPDATE_DELTA_BASE_SEQUENCE );
+
+	CollectorHashTable	*table = NULL;
+	AdNameHashKey		hk;
+	bool				have_key = false;
+	switch( command ) {
+	  case UPDATE_STARTD_AD:
+		table = &StartdAds;
+		have_key = makeStartdAdHashKey( hk, clientAd );
+		break;
+	  case UPDATE_SCHEDD_AD:
+		table = &ScheddAds;
+		have_key = makeScheddAdHashKey( hk, clientAd );
+		break;
+	  case UPDATE_SUBMITTOR_AD:
+		table = &SubmittorAds;
+		have_key = makeScheddAdHashKey( hk, clientAd );
+		break;
+	  default:
+		dprintf( D_ALWAYS, "Delta update not supported for command %d\n",
+				 command );
+		return false;
+	}
+	if( !have_key ) {
+		dprintf( D_ALWAYS, "Could not make hashkey for delta update\n" );
+		return false;
+	}
+
+	HashString	hashString( hk );
+	ClassAd		*old_ad = NULL;
+	int			old_seq, old_stime, new_stime;
+	if( table->lookup( hk, old_ad ) == -1 ) {
+		dprintf( D_ALWAYS, "Delta update for \"%s\" but we have no ad for it; "
+				 "asking for a full update\n", hashString.Value() );
+		return false;
+	}
+	if( !old_ad->LookupInteger( ATTR_UPDATE_SEQUENCE_NUMBER, old_seq ) ||
+		!old_ad->LookupInteger( ATTR_DAEMON_START_TIME, old_stime ) ||
+		!clientAd->LookupInteger( ATTR_DAEMON_START_TIME, new_stime ) ||
+		old_seq != base_seq || old_stime != new_stime )
+	{
+		dprintf( D_ALWAYS, "Delta update for \"%s\" is against update %d, "
+				 "which we don't have; asking for a full update\n",
+				 hashString.Value(), base_seq );
+		return false;
+	}
+
+	StringList	deleted;
+	std::string	deleted_str;
+	if( clientAd->LookupString( ATTR_UPDATE_DELTA_DELETED_ATTRS, deleted_str ) ) {
+		deleted.initializeFromString( deleted_str.c_str() );
+		clientAd->Delete( ATTR_UPDATE_DELTA_DELETED_ATTRS );
+	}
+
+	for( ClassAd::iterator itr = old_ad->begin(); itr != old_ad->end(); itr++ ) {
+		const char *name = itr->first.c_str();
+		if( clientAd->LookupExpr( name ) || deleted.contains_anycase( name ) ) {
+			continue;
+		}
+			// these we add ourselves, so they don't carry over
+		if( strcasecmp( name, ATTR_LAST_HEARD_FROM ) == 0 ||
+			strcasecmp( name, ATTR_AUTHENTICATED_IDENTITY ) == 0 ||
+			strcasecmp( name, ATTR_UPDATESTATS_TOTAL ) == 0 ||
+			strcasecmp( name, ATTR_UPDATESTATS_SEQUENCED ) == 0 ||
+			strcasecmp( name, ATTR_UPDATESTATS_LOST ) == 0 ||
+			strcasecmp( name, ATTR_UPDATESTATS_HISTORY ) == 0 )
+		{
+			continue;
+		}
+		ExprTree *expr = itr->second->Copy();
+		clientAd->Insert( itr->first, expr );
+	}
+
+	return true;
+}
+
+bool CollectorEngine::
+collectStartdBatch (Sock *sock, const condor_sockaddr& from,
+					void (*processAd)(int, ClassAd *), int &num_collected)
+{
+	int		num_slots;
+	ClassAd	shared;
+
+	num_collected = 0;
+
+	sock->timeout(1);
+	sock->decode();
+
+	if( !sock->code(num_slots) || num_slots < 0 || !getClassAd(sock, shared) ) {
+		dprintf (D_ALWAYS,"Command %d on Sock not followed by a batch of ClassAds (or timeout occured)\n",
+				 UPDATE_STARTD_ADS);
+		sock->end_of_message();
+		return false;
+	}
+
+	const char* authn_user = sock->getFullyQualifiedUser();
+
+	for( int i = 0; i < num_slots; i++ ) {
+		ClassAd *clientAd = new ClassAd;
+		ClassAd *pvtAd = new ClassAd;
+		if( !getClassAdNoTypes(sock, *clientAd) || !getClassAd(sock, *pvtAd) ) {
+				// the slots before this one have been collected and
+				// stay collected, but we've lost our place in the
+				// stream, so the connection has to go
+			dprintf (D_ALWAYS,"Failed to read startd ad %d of %d in batched update "
+					 "(%d collected); dropping connection\n",
+					 i+1, num_slots, num_collected);
+			delete clientAd;
+			delete pvtAd;
+			sock->end_of_message();
+			return false;
+		}
+
+			// put back the attributes every slot shares, which the
+			// startd only sent once
+		for( ClassAd::iterator itr = shared.begin(); itr != shared.end(); itr++ ) {
+			if( !clientAd->LookupExpr( itr->first.c_str() ) ) {
+				ExprTree *expr = itr->second->Copy();
+				clientAd->Insert( itr->first, expr );
+			}
+		}
+
+		if (authn_user) {
+			clientAd->Assign("AuthenticatedIdentity", authn_user);
+		} else {
+			clientAd->Delete("AuthenticatedIdentity");
+		}
+
+		int insert = -3;
+		ClassAd *rval = collect(UPDATE_STARTD_AD, clientAd, from, insert, sock, pvtAd);
+		if( rval ) {
+			num_collected++;
+			processAd(UPDATE_STARTD_AD, rval);
+		} else {
+			delete clientAd;
+			if( insert == -4 ) {
+					// a delta we couldn't apply; dropping the connection
+					// makes the startd send whole ads again, so there's
+					// no point in reading the rest of the batch
+				dprintf (D_ALWAYS,"Could not apply startd ad %d of %d in batched update "
+						 "(%d collected); dropping connection\n",
+						 i+1, num_slots, num_collected);
+				sock->end_of_message();
+				return false;
+			}
+				// one bad ad spoils neither the rest of the batch
+				// nor the connection
+			dprintf (D_ALWAYS,
+				"Received malformed ad in batch from command (%d). Ignoring.\n",
+				UPDATE_STARTD_ADS);
+		}
+	}
+
+	if (!sock->end_of_message())
+	{
+		dprintf(D_FULLDEBUG,"Warning: Command %d; maybe shedding data on eom\n",
+				 UPDATE_STARTD_ADS);
+	}
+	return true;
+}
+
 ClassAd *CollectorEngine::
-collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,Sock *sock)
+collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,Sock *sock,
+		 ClassAd *startdPvtAd)
 {
 	ClassAd		*retVal;
 	ClassAd		*pvtAd;
@@ -497,7 +844,14 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 		repeatStartdAds = param_integer("COLLECTOR_REPEAT_STARTD_ADS",0);
 	}
 
+	if( !expandDeltaAd(command,clientAd) ) {
+		insert = -4;
+		delete startdPvtAd;
+		return NULL;
+	}
+
 	if( !ValidateClassAd(command,clientAd,sock) ) {
+		delete startdPvtAd;
 		return NULL;
 	}
 
@@ -524,7 +878,13 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 							  clientAd, hk, hashString, insert, from );
 
 		// if we want to store private ads
-		if (!sock)
+		if (startdPvtAd)
+		{
+				// the caller has already read it off the socket
+			pvtAd = startdPvtAd;
+			startdPvtAd = NULL;
+		}
+		else if (!sock)
 		{
 			dprintf (D_ALWAYS, "Want private ads, but no socket given!\n");
 			break;
@@ -541,29 +901,29 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 				delete pvtAd;
 				break;
 			}
+		}
 
-				// Fix up some stuff in the private ad that we depend on.
-				// We started doing this in 7.2.0, so once we no longer
-				// care about compatibility with stuff from before then,
-				// the startd could stop bothering to send these attributes.
+			// Fix up some stuff in the private ad that we depend on.
+			// We started doing this in 7.2.0, so once we no longer
+			// care about compatibility with stuff from before then,
+			// the startd could stop bothering to send these attributes.
 
-				// Queries of private ads depend on the following:
-			SetMyTypeName( *pvtAd, STARTD_ADTYPE );
+			// Queries of private ads depend on the following:
+		SetMyTypeName( *pvtAd, STARTD_ADTYPE );
 
-				// Negotiator matches up private ad with public ad by
-				// using the following.
-			if( retVal ) {
-				pvtAd->CopyAttribute( ATTR_MY_ADDRESS, retVal );
-				pvtAd->CopyAttribute( ATTR_NAME, retVal );
-			}
+			// Negotiator matches up private ad with public ad by
+			// using the following.
+		if( retVal ) {
+			pvtAd->CopyAttribute( ATTR_MY_ADDRESS, retVal );
+			pvtAd->CopyAttribute( ATTR_NAME, retVal );
+		}
 
 
-			// insert the private ad into its hashtable --- use the same
-			// hash key as the public ad
-			(void) updateClassAd (StartdPrivateAds, "StartdPvtAd  ",
-								  "StartdPvt", pvtAd, hk, hashString, insPvt,
-								  from );
-		}
+		// insert the private ad into its hashtable --- use the same
+		// hash key as the public ad
+		(void) updateClassAd (StartdPrivateAds, "StartdPvtAd  ",
+							  "StartdPvt", pvtAd, hk, hashString, insPvt,
+							  from );
 
 		// create fake duplicates of this ad, each with a different name, if
 		// we are told to do so.  this feature exists for developer
@@ -862,6 +1222,9 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 		retVal = 0;
 	}
 
+	// a private ad we were given but didn't use
+	delete startdPvtAd;
+
 	// return the updated ad
 	return retVal;
 }
@@ -909,6 +1272,7 @@ int CollectorEngine::remove (AdTypes t_AddType, const ClassAd & c_query, bool *q
 				hk.sprint( hkString );
 				iRet = !table->remove(hk);
 				dprintf (D_ALWAYS,"\t\t**** Removed(%d) ad(s): \"%s\"\n", iRet, hkString.Value() );
+				indexRemove(*table, pAd);
 				delete pAd;
 			}
 		}
@@ -933,6 +1297,8 @@ int CollectorEngine::expire( AdTypes adType, const ClassAd & query, bool * query
                 cAd->Assign( ATTR_LAST_HEARD_FROM, 1 );
                 
                 if( CollectorDaemon::offline_plugin_.expire( * cAd ) == true ) {
+                    // the plugin may have rewritten the ad in place
+                    indexInsert( * hTable, cAd );
                     return rVal;
                 }
                 
@@ -947,6 +1313,7 @@ int CollectorEngine::expire( AdTypes adType, const ClassAd & query, bool * query
                 hKey.sprint( hkString );                
                 dprintf( D_ALWAYS, "\t\t**** Removed(%d) stale ad(s): \"%s\"\n", rVal, hkString.Value() );
 
+                indexRemove( * hTable, cAd );
                 delete cAd;
             }
         }
@@ -963,6 +1330,10 @@ remove (AdTypes adType, AdNameHashKey &hk)
 	if (!LookupByAdType(adType, table, func)) {
 		return 0;
 	}
+	ClassAd *ad = NULL;
+	if (table->lookup(hk, ad) != -1) {
+		indexRemove(*table, ad);
+	}
 	return !table->remove(hk);
 }
 	
@@ -1011,6 +1382,7 @@ updateClassAd (CollectorHashTable &hashTable,
 		{
 			EXCEPT ("Error inserting ad (out of memory)");
 		}
+		indexInsert(hashTable, new_ad);
 		
 		insert = 1;
 		
@@ -1031,6 +1403,8 @@ updateClassAd (CollectorHashTable &hashTable,
 		if (hashTable.insert(hk, new_ad) == -1) {
 			EXCEPT( "Error inserting ad" );
 		}
+		indexRemove(hashTable, old_ad);
+		indexInsert(hashTable, new_ad);
 
 		delete old_ad;
 
@@ -1076,6 +1450,7 @@ mergeClassAd (CollectorHashTable &hashTable,
 
 		// Now, finally, merge the new ClassAd into the old one
 		MergeClassAds(old_ad,&new_ad_copy,true);
+		indexInsert(hashTable, old_ad);
 	}
 	delete new_ad;
 	return old_ad;
@@ -1200,7 +1575,9 @@ cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey)
 				   the ad as planned; if it return true, it was likely marked as absent,
 				   so then this ad should NOT be deleted. */
 				if ( CollectorDaemon::offline_plugin_.expire( *ad ) == true ) {
-					// plugin say to not delete this ad, so continue
+					// plugin say to not delete this ad, so continue;
+					// it may have been rewritten in place, though
+					indexInsert(hashTable, ad);
 					continue;
 				} else {
 					dprintf (D_ALWAYS,"\t\t**** Removing stale ad: \"%s\"\n", hkString.Value() );
@@ -1210,6 +1587,7 @@ cleanHashTable (CollectorHashTable &hashTable, time_t now, HashFunc makeKey)
 			{
 				dprintf (D_ALWAYS, "\t\tError while removing ad\n");
 			}
+			indexRemove(hashTable, ad);
 			delete ad;
 		}
 	}
@@ -1293,7 +1671,7 @@ CollectorEngine::LookupByAdType(AdTypes adType,
 }
 
 
-static void
+void CollectorEngine::
 purgeHashTable( CollectorHashTable &table )
 {
 	ClassAd* ad;
@@ -1303,6 +1681,7 @@ purgeHashTable( CollectorHashTable &table )
 		if( table.remove(hk) == -1 ) {
 			dprintf( D_ALWAYS, "\t\tError while removing ad\n" );
 		}		
+		indexRemove(table, ad);
 		delete ad;
 	}
 }
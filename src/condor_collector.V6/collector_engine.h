@@ -26,6 +26,7 @@
 #include "condor_collector.h"
 #include "collector_stats.h"
 #include "hashkey.h"
+#include "classad_attr_index.h"
 
 class CollectorEngine : public Service
 {
@@ -43,7 +44,18 @@ class CollectorEngine : public Service
 
 	// perform the collect operation of the given command
 	ClassAd *collect (int, Sock *, const condor_sockaddr&, int &);
-	ClassAd *collect (int, ClassAd *, const condor_sockaddr&, int &, Sock* = NULL);
+	// for startd ads, the private ad is read from the Sock unless the
+	// caller has already read it; collect() takes ownership of it
+	ClassAd *collect (int, ClassAd *, const condor_sockaddr&, int &, Sock* = NULL,
+					  ClassAd *startdPvtAd = NULL);
+
+	// read the slot ads of an UPDATE_STARTD_ADS message and collect
+	// each one as though it had come in its own UPDATE_STARTD_AD,
+	// handing each collected public ad to processAd before the next
+	// one is read (a later slot's update may replace it); returns
+	// false if the connection must be dropped
+	bool collectStartdBatch (Sock *, const condor_sockaddr&,
+							 void (*processAd)(int, ClassAd *), int &num_collected);
 
 	// lookup classad in the specified table with the given hashkey
 	ClassAd *lookup (AdTypes, AdNameHashKey &);
@@ -72,6 +84,15 @@ class CollectorEngine : public Service
 	// walk specified hash table with the given visit procedure
 	int walkHashTable (AdTypes, int (*)(ClassAd *));
 
+	// as above, but only visit the ads the attribute indexes cannot
+	// rule out for the given constraint; the visit procedure must
+	// still evaluate the constraint itself
+	int walkHashTable (AdTypes, classad::ExprTree *, int (*)(ClassAd *));
+
+	// set the attributes to index (COLLECTOR_INDEX_ATTRIBUTES);
+	// rebuilds all indexes if the list changed
+	void setIndexAttributes( char const *attrs );
+
 	// Publish stats into the collector's ClassAd
 	int publishStats( ClassAd *ad );
 
@@ -123,6 +144,19 @@ class CollectorEngine : public Service
 	static int genericTableWalker(CollectorHashTable *cht);
 	int walkGenericTables(int (*scanFunction)(ClassAd *));
 
+	// attribute indexes, one per hash table; empty if indexing is off
+	typedef std::map<CollectorHashTable *, ClassAdAttrIndex> AdIndexMap;
+	AdIndexMap m_indexes;
+	std::string m_index_attrs;
+	ClassAdAttrIndex *getIndex(CollectorHashTable &table);
+	void indexInsert(CollectorHashTable &table, ClassAd *ad);
+	void indexRemove(CollectorHashTable &table, ClassAd *ad);
+	int walkIndexedTable(CollectorHashTable &table, classad::ExprTree *constraint,
+						 int (*scanFunction)(ClassAd *));
+	int walkIndexedGenericTables(classad::ExprTree *constraint,
+								 int (*scanFunction)(ClassAd *));
+	void purgeHashTable (CollectorHashTable &);
+
 	// relevant variables from the config file
 	int	clientTimeout; 
 	int	machineUpdateInterval;
@@ -148,6 +182,9 @@ class CollectorEngine : public Service
 
 	bool ValidateClassAd(int command,ClassAd *clientAd,Sock *sock);
 
+	// turn a delta update back into a whole ad, using the ad we have
+	bool expandDeltaAd(int command,ClassAd *clientAd);
+
 	// Statistics
 	CollectorStats	*collectorStats;
 
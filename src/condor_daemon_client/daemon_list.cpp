@@ -269,6 +269,53 @@ CollectorList::sendUpdates (int cmd, ClassAd * ad1, ClassAd* ad2, bool nonblocki
 	return success_count;
 }
 
+
+int
+CollectorList::sendUpdates (int cmd, std::vector<ClassAd*> &ads1,
+							std::vector<ClassAd*> &ads2, bool nonblocking) {
+	int success_count = 0;
+
+	this->rewind();
+	DCCollector * daemon;
+	while (this->next(daemon)) {
+		if( daemon->acceptsBatchUpdates(cmd) ) {
+			dprintf( D_FULLDEBUG,
+					 "Trying to update collector %s with %d ads in one batch\n",
+					 daemon->addr(), (int)ads1.size() );
+			if( daemon->sendBatchUpdate(cmd, ads1, ads2) ) {
+				success_count += ads1.size();
+				continue;
+			}
+		}
+		dprintf( D_FULLDEBUG, 
+				 "Trying to update collector %s\n", 
+				 daemon->addr() );
+		for( size_t i = 0; i < ads1.size(); i++ ) {
+			if( daemon->sendUpdate(cmd, ads1[i], ads2[i], nonblocking) ) {
+				success_count++;
+			}
+		}
+	}
+
+	return success_count;
+}
+
+
+bool
+CollectorList::acceptsBatchUpdates (int cmd) {
+	if( this->number() < 1 ) {
+		return false;
+	}
+	this->rewind();
+	DCCollector * daemon;
+	while (this->next(daemon)) {
+		if( ! daemon->acceptsBatchUpdates(cmd) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
 QueryResult
 CollectorList::query(CondorQuery & cQuery, ClassAdList & adList, CondorError *errstack) {
 
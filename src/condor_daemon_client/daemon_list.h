@@ -108,6 +108,16 @@ class CollectorList : public DaemonList {
 		// Send updates to all the collectors
 		// return - number of successfull updates
 	int sendUpdates (int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblocking);
+
+		// Send updates for several ads at once; collectors that
+		// accept batched updates for cmd get them in one message, the
+		// rest get one update per pair of ads
+		// return - number of successfull updates
+	int sendUpdates (int cmd, std::vector<ClassAd*> &ads1,
+					 std::vector<ClassAd*> &ads2, bool nonblocking);
+
+		// Whether every collector accepts batched updates for cmd
+	bool acceptsBatchUpdates (int cmd);
 	
 		// Try querying all the collectors until you get a good one
 	QueryResult query (CondorQuery & query, ClassAdList & adList, CondorError *errstack = 0);
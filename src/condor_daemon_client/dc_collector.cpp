@@ -53,6 +53,7 @@ DCCollector::init( bool needs_reconfig )
 	tcp_collector_port = 0;
 	use_tcp = false;
 	use_nonblocking_update = true;
+	use_delta_updates = true;
 	udp_update_destination = NULL;
 	tcp_update_destination = NULL;
 
@@ -95,6 +96,7 @@ DCCollector::deepCopy( const DCCollector& copy )
 		delete update_rsock;
 		update_rsock = NULL;
 	}
+	clearDeltaBases();
 		/*
 		  for now, we're not going to attempt to copy the update_rsock
 		  from the copy, since i'm not sure i trust ReliSock's copy
@@ -122,6 +124,7 @@ DCCollector::deepCopy( const DCCollector& copy )
 
 	use_tcp = copy.use_tcp;
 	use_nonblocking_update = copy.use_nonblocking_update;
+	use_delta_updates = copy.use_delta_updates;
 
 	up_type = copy.up_type;
 
@@ -165,6 +168,7 @@ DCCollector::reconfig( void )
 					delete( update_rsock );
 					update_rsock = NULL;
 				}
+				clearDeltaBases();
 				delete [] tcp_collector_host;
 				tcp_collector_host = strnewp( tmp );
 			}
@@ -176,6 +180,7 @@ DCCollector::reconfig( void )
 	}
 
 	use_nonblocking_update = param_boolean("NONBLOCKING_COLLECTOR_UPDATE",true);
+	use_delta_updates = param_boolean("UPDATE_COLLECTOR_WITH_DELTAS",true);
 
 	if( ! _addr ) {
 		locate();
@@ -282,6 +287,54 @@ DCCollector::sendUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblocking )
 		nonblocking = false;
 	}
 
+	prepareUpdateAds( ad1, ad2 );
+
+		// We never want to try sending an update to port 0.  If we're
+		// about to try that, and we're trying to talk to a local
+		// collector, we should try re-reading the address file and
+		// re-setting our port.
+	if( _port == 0 ) {
+		dprintf( D_HOSTNAME, "About to update collector with port 0, "
+				 "attempting to re-read address file\n" );
+		if( readAddressFile(_subsys) ) {
+			_port = string_to_port( _addr );
+			tcp_collector_port = _port;
+			if( tcp_collector_addr ) {
+				delete [] tcp_collector_addr;
+			}
+			tcp_collector_addr = strnewp( _addr );
+			parseTCPInfo(); // update use_tcp
+			dprintf( D_HOSTNAME, "Using port %d based on address \"%s\"\n",
+					 _port, _addr );
+		}
+	}
+
+	if( _port <= 0 ) {
+			// If it's still 0, we've got to give up and fail.
+		std::string err_msg;
+		formatstr(err_msg, "Can't send update: invalid collector port (%d)",
+						 _port );
+		newError( CA_COMMUNICATION_ERROR, err_msg.c_str() );
+		return false;
+	}
+
+	if( cmd == UPDATE_COLLECTOR_AD || cmd == INVALIDATE_COLLECTOR_ADS ) {
+			// we *never* want to use TCP to send pool updates to the
+			// developer collector.  so, regardless of what the config
+			// files says, always use UDP for these commands...
+		return sendUDPUpdate( cmd, ad1, ad2, nonblocking );
+	}
+
+	if( use_tcp ) {
+		return sendTCPUpdate( cmd, ad1, ad2, nonblocking );
+	}
+	return sendUDPUpdate( cmd, ad1, ad2, nonblocking );
+}
+
+
+void
+DCCollector::prepareUpdateAds( ClassAd* ad1, ClassAd* ad2 )
+{
 	// Add start time & seq # to the ads before we publish 'em
 	if ( ad1 ) {
 		ad1->Assign(ATTR_DAEMON_START_TIME,(long)startTime);
@@ -314,59 +367,281 @@ DCCollector::sendUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblocking )
         ad2->Assign(ATTR_DETECTED_CPUS, param_integer("DETECTED_CORES", 0));
         ad2->Assign(ATTR_DETECTED_MEMORY, param_integer("DETECTED_MEMORY", 0));
     }
+}
 
-		// We never want to try sending an update to port 0.  If we're
-		// about to try that, and we're trying to talk to a local
-		// collector, we should try re-reading the address file and
-		// re-setting our port.
-	if( _port == 0 ) {
-		dprintf( D_HOSTNAME, "About to update collector with port 0, "
-				 "attempting to re-read address file\n" );
-		if( readAddressFile(_subsys) ) {
-			_port = string_to_port( _addr );
-			tcp_collector_port = _port;
-			if( tcp_collector_addr ) {
-				delete [] tcp_collector_addr;
+
+bool
+DCCollector::acceptsBatchUpdates( int cmd )
+{
+		// Only startd ads are batched, and only over a TCP connection
+		// we already have open, since that is how we learn whether the
+		// collector is new enough to understand UPDATE_STARTD_ADS.
+		// An older collector drops the unknown command without a
+		// word, losing every slot's update, so until we know better
+		// each slot is sent on its own.
+	if( cmd != UPDATE_STARTD_AD || !_is_configured || !use_tcp ) {
+		return false;
+	}
+	return updateSockPeerBuiltSince( 8, 3, 3 );
+}
+
+
+bool
+DCCollector::updateSockPeerBuiltSince( int major, int minor, int subminor )
+{
+	if( !update_rsock ) {
+		return false;
+	}
+	CondorVersionInfo const *peer_version = update_rsock->get_peer_version();
+	return peer_version &&
+		peer_version->built_since_version( major, minor, subminor );
+}
+
+
+	// Attributes the collector needs to find the ad a delta applies
+	// to (see hashkey.cpp), and to check that it is the right one.
+	// These go in every delta, whether they have changed or not.
+static const char * const delta_key_attrs[] = {
+	ATTR_MY_TYPE,
+	ATTR_TARGET_TYPE,
+	ATTR_NAME,
+	ATTR_MACHINE,
+	ATTR_SLOT_ID,
+	ATTR_VIRTUAL_MACHINE_ID,
+	ATTR_MY_ADDRESS,
+	ATTR_STARTD_IP_ADDR,
+	ATTR_SCHEDD_IP_ADDR,
+	ATTR_SCHEDD_NAME,
+	ATTR_DAEMON_START_TIME,
+	ATTR_UPDATE_SEQUENCE_NUMBER,
+	NULL
+};
+
+static bool
+getDeltaKey( int cmd, ClassAd *ad, std::string &key )
+{
+	switch( cmd ) {
+	case UPDATE_STARTD_AD:
+	case UPDATE_SCHEDD_AD:
+	case UPDATE_SUBMITTOR_AD:
+		break;
+	default:
+		return false;
+	}
+	std::string name;
+	if( !ad || !ad->LookupString( ATTR_NAME, name ) ) {
+		return false;
+	}
+	formatstr( key, "%d %s", cmd, name.c_str() );
+	return true;
+}
+
+
+bool
+DCCollector::makeDeltaAd( int cmd, ClassAd* ad, ClassAd &delta )
+{
+	std::string key;
+		// A collector older than 8.3.3 would take the delta for the
+		// whole ad, and lose every attribute that hasn't changed.
+	if( !use_delta_updates || !getDeltaKey( cmd, ad, key ) ||
+		!updateSockPeerBuiltSince( 8, 3, 3 ) )
+	{
+		return false;
+	}
+	std::map< std::string, ClassAd* >::iterator found = delta_bases.find( key );
+	if( found == delta_bases.end() ) {
+		return false;
+	}
+	ClassAd *base = found->second;
+	int base_seq;
+	if( !base->LookupInteger( ATTR_UPDATE_SEQUENCE_NUMBER, base_seq ) ) {
+		return false;
+	}
+
+	for( ClassAd::iterator itr = ad->begin(); itr != ad->end(); itr++ ) {
+		ExprTree *base_expr = base->LookupExpr( itr->first.c_str() );
+		if( base_expr && base_expr->SameAs( itr->second ) ) {
+			continue;
+		}
+		ExprTree *expr = itr->second->Copy();
+		delta.Insert( itr->first, expr );
+	}
+	for( int i = 0; delta_key_attrs[i]; i++ ) {
+		delta.CopyAttribute( delta_key_attrs[i], ad );
+	}
+
+	std::string deleted;
+	for( ClassAd::iterator itr = base->begin(); itr != base->end(); itr++ ) {
+		if( !ad->LookupExpr( itr->first.c_str() ) ) {
+			if( !deleted.empty() ) {
+				deleted += ',';
 			}
-			tcp_collector_addr = strnewp( _addr );
-			parseTCPInfo(); // update use_tcp
-			dprintf( D_HOSTNAME, "Using port %d based on address \"%s\"\n",
-					 _port, _addr );
+			deleted += itr->first;
 		}
 	}
+	if( !deleted.empty() ) {
+		delta.Assign( ATTR_UPDATE_DELTA_DELETED_ATTRS, deleted );
+	}
+	delta.Assign( ATTR_UPDATE_DELTA_BASE_SEQUENCE, base_seq );
+	return true;
+}
 
-	if( _port <= 0 ) {
-			// If it's still 0, we've got to give up and fail.
-		std::string err_msg;
-		formatstr(err_msg, "Can't send update: invalid collector port (%d)",
-						 _port );
-		newError( CA_COMMUNICATION_ERROR, err_msg.c_str() );
-		return false;
+
+void
+DCCollector::saveDeltaBase( int cmd, ClassAd* ad )
+{
+	std::string key;
+	if( !use_delta_updates || !getDeltaKey( cmd, ad, key ) ) {
+		return;
 	}
+	ClassAd *&base = delta_bases[key];
+	delete base;
+	base = new ClassAd( *ad );
+}
 
-	if( cmd == UPDATE_COLLECTOR_AD || cmd == INVALIDATE_COLLECTOR_ADS ) {
-			// we *never* want to use TCP to send pool updates to the
-			// developer collector.  so, regardless of what the config
-			// files says, always use UDP for these commands...
-		return sendUDPUpdate( cmd, ad1, ad2, nonblocking );
+
+bool
+DCCollector::hasDeltaBase( int cmd, ClassAd* ad )
+{
+	std::string key;
+	if( !getDeltaKey( cmd, ad, key ) ) {
+		return false;
 	}
+	return delta_bases.find( key ) != delta_bases.end();
+}
 
-	if( use_tcp ) {
-		return sendTCPUpdate( cmd, ad1, ad2, nonblocking );
+
+void
+DCCollector::clearDeltaBases( void )
+{
+	std::map< std::string, ClassAd* >::iterator itr;
+	for( itr = delta_bases.begin(); itr != delta_bases.end(); itr++ ) {
+		delete itr->second;
 	}
-	return sendUDPUpdate( cmd, ad1, ad2, nonblocking );
+	delta_bases.clear();
 }
 
 
+bool
+DCCollector::sendBatchUpdate( int cmd, std::vector<ClassAd*> &public_ads,
+							  std::vector<ClassAd*> &private_ads )
+{
+	ASSERT( acceptsBatchUpdates( cmd ) );
+	ASSERT( public_ads.size() == private_ads.size() );
+
+	if( public_ads.empty() ) {
+		return true;
+	}
+
+		// Slots the collector already has an ad for only send what
+		// has changed since.
+	std::vector<ClassAd*> update_ads;
+	for( size_t i = 0; i < public_ads.size(); i++ ) {
+		prepareUpdateAds( public_ads[i], private_ads[i] );
+		ClassAd *delta_ad = new ClassAd;
+		if( makeDeltaAd( cmd, public_ads[i], *delta_ad ) ) {
+			update_ads.push_back( delta_ad );
+		} else {
+			delete delta_ad;
+			update_ads.push_back( public_ads[i] );
+		}
+	}
+
+		// Attributes with the same value in every public ad (the
+		// machine's hardware, OS, most of its configuration) are sent
+		// once, and each slot's public ad carries only the rest.
+	ClassAd shared_ad;
+	ClassAd *first_ad = update_ads[0];
+	for( ClassAd::iterator itr = first_ad->begin(); itr != first_ad->end(); itr++ ) {
+		size_t i;
+		for( i = 1; i < update_ads.size(); i++ ) {
+			ExprTree *expr = update_ads[i]->LookupExpr( itr->first.c_str() );
+			if( !expr || !expr->SameAs( itr->second ) ) {
+				break;
+			}
+		}
+		if( i == update_ads.size() ) {
+			ExprTree *expr = itr->second->Copy();
+			shared_ad.Insert( itr->first, expr );
+		}
+	}
+
+	std::vector<ClassAd*> batch_ads;
+	for( size_t i = 0; i < update_ads.size(); i++ ) {
+		ClassAd *slot_ad = new ClassAd;
+		for( ClassAd::iterator itr = update_ads[i]->begin(); itr != update_ads[i]->end(); itr++ ) {
+			if( !shared_ad.LookupExpr( itr->first.c_str() ) ) {
+				ExprTree *expr = itr->second->Copy();
+				slot_ad->Insert( itr->first, expr );
+			}
+		}
+		batch_ads.push_back( slot_ad );
+		batch_ads.push_back( private_ads[i] );
+	}
+
+	dprintf( D_FULLDEBUG, "Sending %d startd ads with %d shared attributes "
+			 "via TCP to collector %s\n", (int)public_ads.size(),
+			 shared_ad.size(), tcp_update_destination );
+
+		// As in sendTCPUpdate(), we code the command ourselves on the
+		// cached socket.  If it has gone bad, we don't reconnect here;
+		// the caller falls back to sending each slot's update, which
+		// sets up a new connection.
+	update_rsock->encode();
+	bool success = update_rsock->put( UPDATE_STARTD_ADS ) &&
+		finishUpdate( this, update_rsock, &shared_ad, NULL, &batch_ads );
+	if( success ) {
+		for( size_t i = 0; i < public_ads.size(); i++ ) {
+			saveDeltaBase( cmd, public_ads[i] );
+		}
+	} else {
+		dprintf( D_FULLDEBUG, "Couldn't send batched update to collector "
+				 "on TCP socket\n" );
+		delete update_rsock;
+		update_rsock = NULL;
+		clearDeltaBases();
+	}
+
+	for( size_t i = 0; i < batch_ads.size(); i += 2 ) {
+		delete batch_ads[i];
+	}
+	for( size_t i = 0; i < update_ads.size(); i++ ) {
+		if( update_ads[i] != public_ads[i] ) {
+			delete update_ads[i];
+		}
+	}
+	return success;
+}
+
 
 bool
-DCCollector::finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd* ad2 )
+DCCollector::finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd* ad2,
+						   std::vector<ClassAd*> *batch_ads )
 {
 	// This is a static function so that we can call it from a
 	// nonblocking startCommand() callback without worrying about
 	// longevity of the DCCollector instance.
 
 	sock->encode();
+	if( batch_ads ) {
+			// UPDATE_STARTD_ADS: the number of slots, the attributes
+			// they share (in ad1), then each slot's public and private
+			// ads.  The public ads get their types from the shared ad.
+		int num_slots = (int)batch_ads->size() / 2;
+		bool ok = sock->code( num_slots ) && putClassAd( sock, *ad1 );
+		for( size_t i = 0; ok && i < batch_ads->size(); i += 2 ) {
+			ok = putClassAd( sock, *(*batch_ads)[i], PUT_CLASSAD_NO_TYPES ) &&
+				putClassAd( sock, *(*batch_ads)[i+1] );
+		}
+		if( !ok ) {
+			if(self) {
+				self->newError( CA_COMMUNICATION_ERROR,
+				                "Failed to send batch of ClassAds to collector" );
+			}
+			return false;
+		}
+		ad1 = ad2 = NULL;
+	}
 	if( ad1 && ! putClassAd(sock, *ad1) ) {
 		if(self) {
 			self->newError( CA_COMMUNICATION_ERROR,
@@ -393,12 +668,14 @@ DCCollector::finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd*
 
 class UpdateData {
 public:
+	int cmd;
 	ClassAd *ad1;
 	ClassAd *ad2;
 	DCCollector *dc_collector;
 	UpdateData *next_in_list;
 
-	UpdateData(ClassAd *cad1, ClassAd *cad2, DCCollector *dc_collect) {
+	UpdateData(int command, ClassAd *cad1, ClassAd *cad2, DCCollector *dc_collect) {
+		this->cmd = command;
 		this->ad1 = NULL;
 		this->ad2 = NULL;
 		this->dc_collector = dc_collect;
@@ -470,9 +747,12 @@ public:
 			if(sock) who = sock->get_sinful_peer();
 			dprintf(D_ALWAYS,"Failed to send non-blocking update to %s.\n",who);
 		}
-		else if(sock && sock->type() == Sock::reli_sock) {
+		else if(sock && sock->type() == Sock::reli_sock && ud->dc_collector) {
+			// Now that the collector has this ad, later updates of it
+			// can be deltas.
+			ud->dc_collector->saveDeltaBase(ud->cmd, ud->ad1);
 			// We keep the TCP socket around for sending more updates.
-			if(ud->dc_collector && ud->dc_collector->update_rsock == NULL) {
+			if(ud->dc_collector->update_rsock == NULL) {
 				ud->dc_collector->update_rsock = (ReliSock *)sock;
 				sock = NULL;
 			}
@@ -505,7 +785,7 @@ DCCollector::sendUDPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblockin
 	}
 
 	if(nonblocking) {
-		UpdateData *ud = new UpdateData(ad1,ad2,this);
+		UpdateData *ud = new UpdateData(cmd,ad1,ad2,this);
 		startCommand_nonblocking(cmd, Sock::safe_sock, 20, NULL, UpdateData::startUpdateCallback, ud, NULL, raw_protocol );
 		return true;
 	}
@@ -553,9 +833,17 @@ DCCollector::sendTCPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblockin
 		// since finishUpdate() assumes we've already sent the command
 		// int, and since we do *NOT* want to use startCommand() again
 		// on a cached TCP socket, just code the int ourselves...
+		// If the collector already has this ad, we only need to send
+		// the attributes that have changed.
+	ClassAd delta_ad;
+	ClassAd *update_ad = ad1;
+	if( makeDeltaAd( cmd, ad1, delta_ad ) ) {
+		update_ad = &delta_ad;
+	}
 	update_rsock->encode();
 	update_rsock->put( cmd );
-	if( finishUpdate(this, update_rsock, ad1, ad2) ) {
+	if( finishUpdate(this, update_rsock, update_ad, ad2) ) {
+		saveDeltaBase( cmd, ad1 );
 		return true;
 	}
 	dprintf( D_FULLDEBUG, 
@@ -563,6 +851,10 @@ DCCollector::sendTCPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblockin
 			 "starting new connection\n" );
 	delete update_rsock;
 	update_rsock = NULL;
+		// Either the connection went away or the collector closed it
+		// because it couldn't apply a delta; either way, it gets
+		// whole ads until we have a new connection to it.
+	clearDeltaBases();
 	return initiateTCPUpdate( cmd, ad1, ad2, nonblocking );
 }
 
@@ -576,7 +868,9 @@ DCCollector::initiateTCPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblo
 		update_rsock = NULL;
 	}
 	if(nonblocking) {
-		UpdateData *ud = new UpdateData(ad1,ad2,this);
+			// the delta base is saved by the callback, once the
+			// update has been sent
+		UpdateData *ud = new UpdateData(cmd,ad1,ad2,this);
 		startCommand_nonblocking(cmd, Sock::reli_sock, 20, NULL, UpdateData::startUpdateCallback, ud );
 		return true;
 	}
@@ -588,7 +882,11 @@ DCCollector::initiateTCPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblo
 		return false;
 	}
 	update_rsock = (ReliSock *)sock;
-	return finishUpdate( this, update_rsock, ad1, ad2 );
+	if( !finishUpdate( this, update_rsock, ad1, ad2 ) ) {
+		return false;
+	}
+	saveDeltaBase( cmd, ad1 );
+	return true;
 }
 
 
@@ -890,6 +1188,7 @@ DCCollector::~DCCollector( void )
 	if( update_rsock ) {
 		delete( update_rsock );
 	}
+	clearDeltaBases();
 	if( adSeqMan ) {
 		delete( adSeqMan );
 	}
@@ -113,6 +113,34 @@ public:
 		*/
 	bool sendUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblocking );
 
+		/** Whether this collector can be sent updates with the given
+			command in one batch using sendBatchUpdate().  This is
+			only true for UPDATE_STARTD_AD, once we have a TCP
+			connection open to a collector that is 8.3.3 or newer.
+		*/
+	bool acceptsBatchUpdates( int cmd );
+
+		/** Send the public and private ads of several slots to this
+			collector in one UPDATE_STARTD_ADS message, with the
+			attributes all of the public ads have in common sent only
+			once.  Only call this if acceptsBatchUpdates() is true.
+			@param cmd UPDATE_STARTD_AD
+			@param public_ads The public ad of each slot
+			@param private_ads The private ad of each slot, in the
+			same order
+			@return false if the update couldn't be sent, in which
+			case the caller should send each slot's ads with
+			sendUpdate() instead
+		*/
+	bool sendBatchUpdate( int cmd, std::vector<ClassAd*> &public_ads,
+						  std::vector<ClassAd*> &private_ads );
+
+		/** Whether the next update of this ad with this command may
+			be sent as a delta, i.e. whether we know of a copy of it
+			that made it to the collector.
+		*/
+	bool hasDeltaBase( int cmd, ClassAd* ad );
+
 	void reconfig( void );
 
 	const char* updateDestination( void );
@@ -142,6 +170,7 @@ private:
 	int tcp_collector_port;
 	bool use_tcp;
 	bool use_nonblocking_update;
+	bool use_delta_updates;
 	UpdateType up_type;
 
 	class UpdateData *pending_update_list;
@@ -150,7 +179,26 @@ private:
 	bool sendTCPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblocking );
 	bool sendUDPUpdate( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblocking );
 
-	static bool finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd* ad2 );
+	static bool finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd* ad2,
+							  std::vector<ClassAd*> *batch_ads = NULL );
+
+	void prepareUpdateAds( ClassAd* ad1, ClassAd* ad2 );
+
+		// Whether the collector at the other end of update_rsock was
+		// built since the given version, i.e. understands the batched
+		// or delta updates that version introduced.
+	bool updateSockPeerBuiltSince( int major, int minor, int subminor );
+
+		// Delta updates: once the collector has an ad from us, we
+		// only send it the attributes that have changed since.  The
+		// ads we last sent (as far as we know, what the collector
+		// has) are kept here, keyed by update command and name.
+		// They are thrown away whenever update_rsock is, since the
+		// collector drops the connection when it can't apply a delta.
+	std::map< std::string, ClassAd* > delta_bases;
+	bool makeDeltaAd( int cmd, ClassAd* ad, ClassAd &delta );
+	void saveDeltaBase( int cmd, ClassAd* ad );
+	void clearDeltaBases( void );
 
 	void parseTCPInfo( void );
 	void initDestinationStrings( void );
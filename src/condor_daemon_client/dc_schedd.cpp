@@ -1831,3 +1831,58 @@ bool DCSchedd::recycleShadow( int previous_job_exit_reason, ClassAd **new_job_ad
 
 	return true;
 }
+
+bool DCSchedd::shadowJobExit( int cluster, int proc, bool killed, int exit_reason, MyString &error_msg )
+{
+	int timeout = 300;
+	CondorError errstack;
+
+	ReliSock sock;
+	if( !connectSock(&sock,timeout,&errstack) ) {
+		error_msg.formatstr("Failed to connect to schedd: %s",
+						  errstack.getFullText().c_str());
+		return false;
+	}
+
+	if( !startCommand(SHADOW_JOB_EXIT, &sock, timeout, &errstack) ) {
+		error_msg.formatstr("Failed to send SHADOW_JOB_EXIT to schedd: %s",
+						  errstack.getFullText().c_str());
+		return false;
+	}
+
+	if( !forceAuthentication(&sock, &errstack) ) {
+		error_msg.formatstr("Failed to authenticate: %s",
+						  errstack.getFullText().c_str());
+		return false;
+	}
+
+	sock.encode();
+	int mypid = getpid();
+	int exited = killed ? 0 : 1;
+	if( !sock.put( mypid ) ||
+		!sock.put( cluster ) ||
+		!sock.put( proc ) ||
+		!sock.put( exited ) ||
+		!sock.put( exit_reason ) ||
+		!sock.end_of_message() )
+	{
+		error_msg = "Failed to send job exit reason";
+		return false;
+	}
+
+	sock.decode();
+	int ok = 0;
+	if( !sock.get( ok ) ||
+		!sock.end_of_message() )
+	{
+		error_msg = "Failed to receive reply";
+		return false;
+	}
+	if( !ok ) {
+		error_msg.formatstr("Schedd refused exit reason for job %d.%d",
+						  cluster, proc);
+		return false;
+	}
+
+	return true;
+}
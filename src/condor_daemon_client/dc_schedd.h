@@ -386,6 +386,13 @@ public:
 		// If no new job found, returns true with *new_job_ad=NULL
 	bool recycleShadow( int previous_job_exit_reason, ClassAd **new_job_ad, MyString &error_msg );
 
+		// Used by a shadow that is running more than one job to tell
+		// the schedd that one of them is done.  If killed is true,
+		// the job's shadow went away without an exit reason, as if it
+		// had been killed by a signal.
+		// Returns false on error (see error_msg)
+	bool shadowJobExit( int cluster, int proc, bool killed, int exit_reason, MyString &error_msg );
+
 private:
 		/** This method actually does all the brains for all versions
 			of holdJobs(), removeJobs(), and releaseJobs().  This
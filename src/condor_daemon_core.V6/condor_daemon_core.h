@@ -66,6 +66,7 @@
 
 #include "../condor_procd/proc_family_io.h"
 class ProcFamilyInterface;
+class Selector;
 
 #if defined(WIN32)
 #include "pipe.WINDOWS.h"
@@ -1470,6 +1471,19 @@ class DaemonCore : public Service
 	int sendUpdates(int cmd, ClassAd* ad1, ClassAd* ad2 = NULL,
 					bool nonblock = false);
 
+		/**
+		   As above, but for the ads of several slots at once; a
+		   startd's slots can be sent to a new enough collector in a
+		   single message.
+		   @param cmd The update command to send (UPDATE_STARTD_AD)
+		   @param ads1 The primary ClassAds to send.
+		   @param ads2 The matching secondary ClassAds.
+		   @param nonblock Should the update use non-blocking communication.
+		   @return The number of successful updates that were sent.
+		*/
+	int sendUpdates(int cmd, std::vector<ClassAd*> &ads1,
+					std::vector<ClassAd*> &ads2, bool nonblock = false);
+
 		/**
 		   Indicates if this daemon wants to be restarted by its
 		   parent or not.  Usually true, unless one of the
@@ -1545,6 +1559,8 @@ class DaemonCore : public Service
 	   //stats_entry_recent<int64_t> SockBytes;      //  number of bytes passed though the socket (can we do this?)
 	   //stats_entry_recent<int64_t> PipeBytes;      //  number of bytes passed though the socket
 	   stats_entry_recent<int> DebugOuts;      //  number of dprintf calls that were written to output.
+	   stats_entry_recent<int> DebugAsyncDelayed; //  number of dprintf calls that waited for room in the DEBUG_ASYNC buffer
+	   stats_entry_recent<int> DebugAsyncDropped; //  number of dprintf calls dropped because the DEBUG_ASYNC buffer was full
       #ifdef WIN32
 	   stats_entry_recent<int> AsyncPipe;      //  number of times async_pipe was signalled
       #endif
@@ -1641,6 +1657,39 @@ class DaemonCore : public Service
     int m_iMaxAcceptsPerCycle; ///< maximum number of inbound connections to accept per loop
 	int m_iMaxReapsPerCycle; // maximum number reapers to invoke per event loop
 
+		// The selector used by Driver().  It lives as long as we do, so
+		// that an epoll backend can keep its kernel interest list
+		// between iterations.  With epoll, sockets and pipes are added
+		// to and removed from it as they are registered and cancelled,
+		// and as the state of a socket entry changes (when it is
+		// serviced), rather than all of them being added before every
+		// select; Driver() then only looks at the entries whose fds
+		// came back ready, or whose deadline has passed.
+	Selector *m_selector;
+	bool m_persistent_selector;
+		// fd -> sockTable index, and fd -> pipeHandleTable index, for
+		// the fds in a persistent selector (-1 if none)
+	std::vector<int> m_selector_fd_sock;
+	std::vector<int> m_selector_fd_pipe;
+		// pipeHandleTable index -> pipeTable index (-1 if none)
+	std::vector<int> m_pipe_slot;
+		// no registered socket has a deadline earlier than this (0 for
+		// no deadline).  a socket's deadline is looked at when its
+		// entry is updated, or when it is set (see NoteSockDeadline());
+		// when this time passes, every socket is checked to find the
+		// ones that timed out and the next deadline.
+	time_t m_selector_min_deadline;
+		// the sockTable and pipeHandleTable indices to look at in this
+		// pass of Driver()
+	std::vector<int> m_ready_socks;
+	std::vector<int> m_ready_pipes;
+	void ForgetSelectorFd( int fd );
+	static void NoteSockDeadline( time_t deadline );
+	void UpdateSelectorSock( int i );
+	void AddSelectorPipe( int i );
+	void RemoveSelectorPipe( int i );
+	int PipeSlot( int index );
+
     void Inherit( void );  // called in main()
 	void InitDCCommandSocket( int command_port );  // called in main()
 	void SetDaemonSockName( char const *sock_name );
@@ -1800,6 +1849,7 @@ class DaemonCore : public Service
 		HandlerType		handler_type;
 		int				servicing_tid;	// tid servicing this socket
 		bool            is_command_sock;
+		int				selector_fd;	// fd we gave a persistent selector
     };
     void              DumpSocketTable(int, const char* = NULL);
     int               maxSocket;  // number of socket handlers to start with
@@ -2053,6 +2103,13 @@ class DaemonCore : public Service
 	bool evalExpr( ClassAd* ad, const char* param_name,
 				   const char* attr_name, const char* message );
 
+		/**
+		   Evaluate DAEMON_SHUTDOWN_FAST and DAEMON_SHUTDOWN against
+		   an ad we are about to send to the collector, and start
+		   shutting down if either is TRUE.
+		*/
+	void evalShutdownExprs( ClassAd* ad );
+
 	CollectorList* m_collector_list;
 
 		/**
@@ -33,6 +33,8 @@
 #include "condor_constants.h"
 #include "dc_service.h"
 #include "condor_timeslice.h"
+#include "HashTable.h"
+#include <vector>
 
 #ifdef WIN32
 #include <time.h>
@@ -84,7 +86,8 @@ struct tagTimer {
     /** Not_Yet_Documented */ TimerHandler             handler;
     /** Not_Yet_Documented */ TimerHandlercpp          handlercpp;
     /** Not_Yet_Documented */ class Service*    service; 
-    /** Not_Yet_Documented */ struct tagTimer*  next;
+    /** Position in the timer heap */ int     heap_index;
+    /** Insertion order, breaks ties in when */ unsigned long sequence;
     /** Not_Yet_Documented */ char*             event_descrip;
     /** Not_Yet_Documented */ void*             data_ptr;
     /** Not_Yet_Documented */ Timeslice *       timeslice;
@@ -214,6 +217,9 @@ class TimerManager
 
     /// Not_Yet_Documented.
     void Start();
+
+	/// The one TimerManager in this process (owned by DaemonCore).
+	static TimerManager &GetTimerManager();
     
   private:
     
@@ -227,19 +233,29 @@ class TimerManager
                   unsigned   period          =  0,
 				  const Timeslice *timeslice = NULL);
 
-	void RemoveTimer( Timer *timer, Timer *prev );
+	void RemoveTimer( Timer *timer );
 	void InsertTimer( Timer *new_timer );
 	void DeleteTimer( Timer *timer );
 
 	/*
 	  @param id The id of the timer to find
-	  @param prev If not NULL, this will be set to previous timer in list
 	  @return pointer to timer with specified id or NULL if not found
 	 */
-	Timer *GetTimer( int id, Timer **prev );
-
-    Timer*  timer_list;
-	Timer*  list_tail;
+	Timer *GetTimer( int id );
+
+		// Timers are kept in a binary min-heap ordered on (when, sequence),
+		// so the next timer to fire is always timer_heap[0].  sequence is
+		// assigned on every insert, which keeps timers with the same "when"
+		// in the order they were (re)inserted, as the old sorted list did.
+	bool TimerBefore( const Timer *a, const Timer *b ) const;
+	void HeapSet( int index, Timer *timer );
+	void SiftUp( int index );
+	void SiftDown( int index );
+	Timer *FirstTimer() const { return timer_heap.empty() ? NULL : timer_heap[0]; }
+
+	std::vector<Timer*> timer_heap;
+	HashTable<int,Timer*> timer_table;	// id -> timer, for timers in the heap
+	unsigned long next_sequence;
     int     timer_ids;
     Timer*  in_timeout;
     bool    did_reset;
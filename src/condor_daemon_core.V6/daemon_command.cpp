@@ -908,14 +908,20 @@ DaemonCommandProtocol::CommandProtocolResult DaemonCommandProtocol::ReadCommand(
 							return CommandProtocolFinished;
 						}
 
-						unsigned char* rkey = Condor_Crypt_Base::randomKey(24);
-						unsigned char  rbuf[24];
+							// AES-256 takes a full 32 byte key; padding
+							// out a shorter one would only repeat it
+						int keylen = 24;
+						if (toupper(crypto_method[0]) == 'A') {
+							keylen = AESGCM_KEY_SIZE;
+						}
+						unsigned char* rkey = Condor_Crypt_Base::randomKey(keylen);
+						unsigned char  rbuf[AESGCM_KEY_SIZE];
 						if (rkey) {
-							memcpy (rbuf, rkey, 24);
+							memcpy (rbuf, rkey, keylen);
 							// this was malloced in randomKey
 							free (rkey);
 						} else {
-							memset (rbuf, 0, 24);
+							memset (rbuf, 0, keylen);
 							dprintf ( D_ALWAYS, "DC_AUTHENTICATE: unable to generate key for request from %s - no crypto available!\n", m_sock->peer_description() );							
 							free( crypto_method );
 							crypto_method = NULL;
@@ -926,16 +932,20 @@ DaemonCommandProtocol::CommandProtocolResult DaemonCommandProtocol::ReadCommand(
 						switch (toupper(crypto_method[0])) {
 							case 'B': // blowfish
 								dprintf (D_SECURITY, "DC_AUTHENTICATE: generating BLOWFISH key for session %s...\n", m_sid);
-								m_key = new KeyInfo(rbuf, 24, CONDOR_BLOWFISH);
+								m_key = new KeyInfo(rbuf, keylen, CONDOR_BLOWFISH);
 								break;
 							case '3': // 3des
 							case 'T': // Tripledes
 								dprintf (D_SECURITY, "DC_AUTHENTICATE: generating 3DES key for session %s...\n", m_sid);
-								m_key = new KeyInfo(rbuf, 24, CONDOR_3DES);
+								m_key = new KeyInfo(rbuf, keylen, CONDOR_3DES);
+								break;
+							case 'A': // AES-GCM
+								dprintf (D_SECURITY, "DC_AUTHENTICATE: generating AESGCM key for session %s...\n", m_sid);
+								m_key = new KeyInfo(rbuf, keylen, CONDOR_AESGCM);
 								break;
 							default:
 								dprintf (D_SECURITY, "DC_AUTHENTICATE: generating RANDOM key for session %s...\n", m_sid);
-								m_key = new KeyInfo(rbuf, 24);
+								m_key = new KeyInfo(rbuf, keylen);
 								break;
 						}
 
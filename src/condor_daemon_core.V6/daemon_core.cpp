@@ -31,6 +31,8 @@
 
 #include "condor_socket_types.h"
 
+#include <algorithm>
+
 #if HAVE_CLONE
 #include <sched.h>
 #include <sys/syscall.h>
@@ -383,6 +385,9 @@ DaemonCore::DaemonCore(int PidSize, int ComSize,int SigSize,
 	super_dc_ssock = NULL;
 	m_iMaxReapsPerCycle = 1;
     m_iMaxAcceptsPerCycle = 1;
+	m_selector = NULL;
+	m_persistent_selector = false;
+	m_selector_min_deadline = 0;
 
 	inheritedSocks[0] = NULL;
 	inServiceCommandSocket_flag = FALSE;
@@ -469,6 +474,11 @@ DaemonCore::~DaemonCore()
 		m_shared_port_endpoint = NULL;
 	}
 
+	if( m_selector ) {
+		delete m_selector;
+		m_selector = NULL;
+	}
+
 #ifndef WIN32
 	close(async_pipe[1]);
 	close(async_pipe[0]);
@@ -1499,6 +1509,8 @@ int DaemonCore::Register_Socket(Stream *iosock, const char* iosock_descrip,
 		}
 	}
 
+	ForgetSelectorFd( ((Sock *)iosock)->get_file_desc() );
+
 	// Found a blank entry at index i. Now add in the new data.
 	(*sockTable)[i].servicing_tid = 0;
 	(*sockTable)[i].remove_asap = false;
@@ -1561,6 +1573,8 @@ int DaemonCore::Register_Socket(Stream *iosock, const char* iosock_descrip,
 	// Update curr_regdataptr for SetDataPtr()
 	curr_regdataptr = &((*sockTable)[i].data_ptr);
 
+	UpdateSelectorSock( i );
+
 	// Conditionally dump what our table looks like
 	DumpSocketTable(D_FULLDEBUG | D_DAEMONCORE);
 
@@ -1610,6 +1624,7 @@ int DaemonCore::Cancel_Socket( Stream* insock, void *prev_entry)
 		// Log a message
 		dprintf(D_DAEMONCORE,"Cancel_Socket: cancelled socket %d <%s> %p\n",
 				i,(*sockTable)[i].iosock_descrip, (*sockTable)[i].iosock );
+		ForgetSelectorFd( ((Sock *)insock)->get_file_desc() );
 		// Remove entry; mark it is available for next add via iosock=NULL
 		(*sockTable)[i].iosock = NULL;
 		free( (*sockTable)[i].iosock_descrip );
@@ -1633,6 +1648,8 @@ int DaemonCore::Cancel_Socket( Stream* insock, void *prev_entry)
 		(*sockTable)[i].remove_asap = true;
 	}
 
+	UpdateSelectorSock( i );
+
 	if ( !prev_entry ) {
 		nRegisteredSocks--;		// decrement count of active sockets
 	}
@@ -1907,6 +1924,10 @@ int DaemonCore::Register_Pipe(int pipe_end, const char* pipe_descrip,
 
     dc_stats.New("Pipe", handler_descrip, AS_COUNT | IS_RCT | IF_NONZERO | IF_VERBOSEPUB);
 
+#ifndef WIN32
+	ForgetSelectorFd( (*pipeHandleTable)[index] );
+#endif
+
 	// Found a blank entry at index i. Now add in the new data.
 	(*pipeTable)[i].pentry = NULL;
 	(*pipeTable)[i].call_handler = false;
@@ -1933,6 +1954,12 @@ int DaemonCore::Register_Pipe(int pipe_end, const char* pipe_descrip,
 	// Increment the counter of total number of entries
 	nPipe++;
 
+	if ( index >= (int)m_pipe_slot.size() ) {
+		m_pipe_slot.resize( index + 1, -1 );
+	}
+	m_pipe_slot[index] = i;
+	AddSelectorPipe( i );
+
 	// Update curr_regdataptr for SetDataPtr()
 	curr_regdataptr = &((*pipeTable)[i].data_ptr);
 
@@ -2003,6 +2030,12 @@ int DaemonCore::Cancel_Pipe( int pipe_end )
 			"Cancel_Pipe: cancelled pipe end %d <%s> (entry=%d)\n",
 			pipe_end,(*pipeTable)[i].pipe_descrip, i );
 
+#ifndef WIN32
+	ForgetSelectorFd( (*pipeHandleTable)[index] );
+#endif
+	RemoveSelectorPipe( i );
+	m_pipe_slot[index] = -1;
+
 	// Remove entry, move the last one in the list into this spot
 	(*pipeTable)[i].index = -1;
 	free( (*pipeTable)[i].pipe_descrip );
@@ -2043,6 +2076,7 @@ int DaemonCore::Cancel_Pipe( int pipe_end )
 	if ( i < nPipe - 1 ) {
             // if not the last entry in the table, move the last one here
 		(*pipeTable)[i] = (*pipeTable)[nPipe - 1];
+		m_pipe_slot[(*pipeTable)[i].index] = i;
 		(*pipeTable)[nPipe - 1].index = -1;
 		(*pipeTable)[nPipe - 1].pipe_descrip = NULL;
 		(*pipeTable)[nPipe - 1].handler_descrip = NULL;
@@ -3043,7 +3077,7 @@ DaemonCore::Do_Wake_up_select()
 // incoming messages or requests and invoke corresponding handlers.
 void DaemonCore::Driver()
 {
-	Selector	selector;
+	Selector	recheck_selector;
 	int			i;
 	int			tmpErrno;
 	time_t		timeout;
@@ -3104,6 +3138,29 @@ void DaemonCore::Driver()
 		dprintf( D_ALWAYS, "Done with stdout & stderr tests\n" );
 	}
 
+	if ( !m_selector ) {
+		m_selector = new Selector;
+		if ( param_boolean( "DAEMON_CORE_USE_EPOLL", true ) &&
+			 m_selector->enable_epoll() )
+		{
+				// From now on, sockets and pipes are added to and
+				// removed from the selector as they come and go.
+				// Bring in the ones registered before we got here.
+			m_persistent_selector = true;
+			Stream::set_deadline_observer( NoteSockDeadline );
+			for ( i = 0; i < nSock; i++ ) {
+				UpdateSelectorSock( i );
+			}
+			for ( i = 0; i < nPipe; i++ ) {
+				AddSelectorPipe( i );
+			}
+#ifndef WIN32
+			m_selector->add_fd( async_pipe[0], Selector::IO_READ );
+#endif
+		}
+	}
+	Selector &selector = *m_selector;
+
 	double runtime = UtcTime::getTimeDouble();
 	double group_runtime = runtime;
     double pump_cycle_begin_time = runtime;
@@ -3194,10 +3251,15 @@ void DaemonCore::Driver()
 
 		// Setup what socket descriptors to select on.  We recompute this
 		// every time because 1) some timeout handler may have removed/added
-		// sockets, and 2) it ain't that expensive....
-		selector.reset();
-		min_deadline = 0;
-		for (i = 0; i < nSock; i++) {
+		// sockets, and 2) it ain't that expensive....  A persistent
+		// selector already has them all, since sockets and pipes update
+		// it whenever they change.
+		min_deadline = m_selector_min_deadline;
+		if ( !m_persistent_selector ) {
+			selector.reset();
+			min_deadline = 0;
+		}
+		for (i = 0; !m_persistent_selector && i < nSock; i++) {
 				// NOTE: keep the following logic for building the
 				// fdset in sync with DaemonCore::ServiceCommandSocket()
 
@@ -3261,7 +3323,7 @@ void DaemonCore::Driver()
 #if !defined(WIN32)
 		// Add the registered pipe fds into the list of descriptors to
 		// select on.
-		for (i = 0; i < nPipe; i++) {
+		for (i = 0; !m_persistent_selector && i < nPipe; i++) {
 			if ( (*pipeTable)[i].index != -1 ) {	// if a valid entry....
 				int pipefd = (*pipeHandleTable)[(*pipeTable)[i].index];
 				switch( (*pipeTable)[i].handler_type ) {
@@ -3290,7 +3352,9 @@ void DaemonCore::Driver()
 		} 
 		selector.add_fd( async_pipe[0].get_file_desc() , Selector::IO_READ );
 #else
-		selector.add_fd( async_pipe[0], Selector::IO_READ );
+		if ( !m_persistent_selector ) {
+			selector.add_fd( async_pipe[0], Selector::IO_READ );
+		}
 #endif
 
 		// Let other threads run while we are waiting on select
@@ -3435,8 +3499,55 @@ void DaemonCore::Driver()
 				dprintf(D_ALWAYS,"Received a superuser command\n");
 			}
 
+			// Work out which socket table entries to look at.  With a
+			// persistent selector, that is just the ones whose fds are
+			// ready, plus any whose deadline has passed.
+			m_ready_socks.clear();
+			if ( m_persistent_selector ) {
+				const std::vector<int> &ready_fds = *selector.ready_fds();
+				for ( size_t k = 0; k < ready_fds.size(); k++ ) {
+					int fd = ready_fds[k];
+					if ( fd < (int)m_selector_fd_sock.size() &&
+						 m_selector_fd_sock[fd] != -1 )
+					{
+						m_ready_socks.push_back( m_selector_fd_sock[fd] );
+					}
+				}
+				if ( m_selector_min_deadline && m_selector_min_deadline < now ) {
+					m_selector_min_deadline = 0;
+					for ( i = 0; i < nSock; i++ ) {
+						if ( (*sockTable)[i].iosock == NULL ||
+							 (*sockTable)[i].servicing_tid != 0 ||
+							 (*sockTable)[i].remove_asap ||
+							 (*sockTable)[i].is_reverse_connect_pending )
+						{
+							continue;
+						}
+						time_t deadline = (*sockTable)[i].iosock->get_deadline();
+						if ( deadline && deadline < now ) {
+							m_ready_socks.push_back( i );
+						}
+						if ( deadline && ( m_selector_min_deadline == 0 ||
+										   deadline < m_selector_min_deadline ) )
+						{
+							m_selector_min_deadline = deadline;
+						}
+					}
+				}
+					// call the handlers in table order, as we do
+					// without a persistent selector
+				std::sort( m_ready_socks.begin(), m_ready_socks.end() );
+				m_ready_socks.erase( std::unique( m_ready_socks.begin(), m_ready_socks.end() ),
+									 m_ready_socks.end() );
+			} else {
+				for ( i = 0; i < nSock; i++ ) {
+					m_ready_socks.push_back( i );
+				}
+			}
+
 			// scan through the socket table to find which ones select() set
-			for(i = 0; i < nSock; i++) {
+			for ( size_t k = 0; k < m_ready_socks.size(); k++ ) {
+				i = m_ready_socks[k];
 				if ( (*sockTable)[i].iosock && 
 					 (*sockTable)[i].servicing_tid==0 &&
 					 (*sockTable)[i].remove_asap == false ) 
@@ -3498,8 +3609,24 @@ void DaemonCore::Driver()
             dc_stats.SocketRuntime += (runtime - group_runtime);
             group_runtime = runtime;
 
-			// scan through the pipe table to find which ones select() set
-			for(i = 0; i < nPipe; i++) {
+			// scan through the pipe table to find which ones select() set,
+			// and list them by their pipeHandleTable index, which stays
+			// the same even if an earlier handler cancels another pipe.
+			m_ready_pipes.clear();
+			if ( m_persistent_selector ) {
+				const std::vector<int> &ready_fds = *selector.ready_fds();
+				for ( size_t k = 0; k < ready_fds.size(); k++ ) {
+					int fd = ready_fds[k];
+					if ( fd < (int)m_selector_fd_pipe.size() &&
+						 m_selector_fd_pipe[fd] != -1 )
+					{
+						i = PipeSlot( m_selector_fd_pipe[fd] );
+						(*pipeTable)[i].call_handler = true;
+						m_ready_pipes.push_back( m_selector_fd_pipe[fd] );
+					}
+				}
+			}
+			for(i = 0; !m_persistent_selector && i < nPipe; i++) {
 				if ( (*pipeTable)[i].index != -1 ) {	// if a valid entry...
 					// figure out if we should call a handler.
 					(*pipeTable)[i].call_handler = false;
@@ -3523,14 +3650,18 @@ void DaemonCore::Driver()
 						(*pipeTable)[i].call_handler = true;
 					}
 #endif
+					if ( (*pipeTable)[i].call_handler ) {
+						m_ready_pipes.push_back( (*pipeTable)[i].index );
+					}
 				}	// end of if valid pipe entry
 			}	// end of for loop through all pipe entries
 
 
-			// Now loop through all pipe entries, calling handlers if required.
+			// Now loop through the ready pipe entries, calling handlers if required.
             runtime = UtcTime::getTimeDouble();
-			for(i = 0; i < nPipe; i++) {
-				if ( (*pipeTable)[i].index != -1 ) {	// if a valid entry...
+			for ( size_t k = 0; k < m_ready_pipes.size(); k++ ) {
+				i = PipeSlot( m_ready_pipes[k] );
+				if ( i != -1 ) {	// unless an earlier handler cancelled it...
 
 					if ( (*pipeTable)[i].call_handler ) {
 
@@ -3564,12 +3695,14 @@ void DaemonCore::Driver()
 
 #else
 							// UNIX
+							// Use a separate selector, so the main one
+							// keeps its registrations for the next pass.
 							int pipefd = (*pipeHandleTable)[(*pipeTable)[i].index];
-							selector.reset();
-							selector.set_timeout( 0 );
-							selector.add_fd( pipefd, Selector::IO_READ );
-							selector.execute();
-							if ( selector.timed_out() ) {
+							recheck_selector.reset();
+							recheck_selector.set_timeout( 0 );
+							recheck_selector.add_fd( pipefd, Selector::IO_READ );
+							recheck_selector.execute();
+							if ( recheck_selector.timed_out() ) {
 								// nothing available, try the next entry...
 								continue;
 							}
@@ -3625,25 +3758,18 @@ void DaemonCore::Driver()
                         // update per-handler runtime statistics
                         runtime = dc_stats.AddRuntime((*pipeTable)[i].handler_descrip, runtime);
 
-						if ( (*pipeTable)[i].call_handler == true ) {
-							// looks like the handler called Cancel_Pipe(),
-							// and now entry i no longer points to what we
-							// think it points to.  Decrement i now, so when
-							// we loop back we do not miss calling a handler.
-							i--;
-						}
-
 					}	// if call_handler is True
 				}	// if valid entry in pipeTable
-			}	// for 0 thru nPipe checking if call_handler is true
+			}	// for each ready pipe checking if call_handler is true
 
 
             runtime = UtcTime::getTimeDouble();
             dc_stats.PipeRuntime += (runtime - group_runtime);
             group_runtime = runtime;
 
-			// Now loop through all sock entries, calling handlers if required.
-			for(i = 0; i < nSock; i++) {
+			// Now loop through the ready sock entries, calling handlers if required.
+			for ( size_t k = 0; k < m_ready_socks.size(); k++ ) {
+				i = m_ready_socks[k];
 				if ( (*sockTable)[i].iosock ) {	// if a valid entry...
 
 					if ( (*sockTable)[i].call_handler ) {
@@ -3660,13 +3786,13 @@ void DaemonCore::Driver()
 							// read on the pipe could block?  to prevent this, we need
 							// to check one more time to make certain the pipe is ready
 							// for reading.
-							selector.reset();
-							selector.set_timeout( 0 );// set timeout for a poll
-							selector.add_fd( (*sockTable)[i].iosock->get_file_desc(),
+							recheck_selector.reset();
+							recheck_selector.set_timeout( 0 );// set timeout for a poll
+							recheck_selector.add_fd( (*sockTable)[i].iosock->get_file_desc(),
 											 Selector::IO_READ );
 
-							selector.execute();
-							if ( selector.timed_out() ) {
+							recheck_selector.execute();
+							if ( recheck_selector.timed_out() ) {
 								// nothing available, try the next entry...
 								continue;
 							}
@@ -3699,7 +3825,18 @@ void DaemonCore::Driver()
 
 					}	// if call_handler is True
 				}	// if valid entry in sockTable
-			}	// for 0 thru nSock checking if call_handler is true
+			}	// for each ready sock checking if call_handler is true
+
+				// Handlers may have changed what a socket waits for (a
+				// connect finished, servicing started or ended, a new
+				// deadline), so refresh what the selector holds for them.
+			if ( m_persistent_selector ) {
+				for ( size_t k = 0; k < m_ready_socks.size(); k++ ) {
+					if ( m_ready_socks[k] < nSock ) {
+						UpdateSelectorSock( m_ready_socks[k] );
+					}
+				}
+			}
 
             runtime = UtcTime::getTimeDouble();
             dc_stats.SocketRuntime += (runtime - group_runtime);
@@ -3714,6 +3851,162 @@ void DaemonCore::Driver()
 	}	// end of infinite for loop
 }
 
+void
+DaemonCore::ForgetSelectorFd( int fd )
+{
+	if ( m_selector && fd >= 0 ) {
+		m_selector->forget_fd( fd );
+	}
+}
+
+	// A socket's deadline is only looked at when its entry is updated,
+	// but a handler or timer may move it up at any time.  Sockets that
+	// aren't registered get here too, which at worst wakes us early.
+void
+DaemonCore::NoteSockDeadline( time_t deadline )
+{
+	if ( !daemonCore || !daemonCore->m_persistent_selector ) {
+		return;
+	}
+	time_t &min_deadline = daemonCore->m_selector_min_deadline;
+	if ( min_deadline == 0 || deadline < min_deadline ) {
+		min_deadline = deadline;
+	}
+}
+
+void
+DaemonCore::UpdateSelectorSock( int i )
+{
+	if ( !m_persistent_selector || i < 0 ) {
+		return;
+	}
+	SockEnt &ent = (*sockTable)[i];
+
+		// NOTE: keep the following logic in sync with the non-persistent
+		// fdset setup in DaemonCore::Driver()
+	int fd = -1;
+	bool want_read = false, want_write = false, want_except = false;
+	if ( ent.iosock && ent.servicing_tid == 0 && !ent.remove_asap &&
+		 !ent.is_reverse_connect_pending )
+	{
+		fd = ent.iosock->get_file_desc();
+		if ( ent.is_connect_pending ) {
+			want_write = want_except = true;
+		} else {
+			want_read = ent.handler_type == HANDLE_READ ||
+				ent.handler_type == HANDLE_READ_WRITE;
+			want_write = ent.handler_type == HANDLE_WRITE ||
+				ent.handler_type == HANDLE_READ_WRITE;
+		}
+		time_t deadline = ent.iosock->get_deadline();
+		if ( deadline && ( m_selector_min_deadline == 0 ||
+						   deadline < m_selector_min_deadline ) )
+		{
+			m_selector_min_deadline = deadline;
+		}
+	}
+
+	int old_fd = ent.selector_fd;
+	if ( old_fd >= 0 && old_fd < (int)m_selector_fd_sock.size() &&
+		 m_selector_fd_sock[old_fd] == i )
+	{
+		m_selector->delete_fd( old_fd, Selector::IO_READ );
+		m_selector->delete_fd( old_fd, Selector::IO_WRITE );
+		m_selector->delete_fd( old_fd, Selector::IO_EXCEPT );
+		m_selector_fd_sock[old_fd] = -1;
+	}
+	ent.selector_fd = -1;
+	if ( fd < 0 ) {
+		return;
+	}
+
+	ent.selector_fd = fd;
+	if ( ent.is_connect_pending ) {
+			// A failed connect is retried with a new socket, which
+			// Sock puts on the same fd number as the old one.  Closing
+			// the old one took it out of the kernel's epoll set, so
+			// whatever the selector thinks is there must be added anew.
+		m_selector->forget_fd( fd );
+	}
+	if ( fd >= (int)m_selector_fd_sock.size() ) {
+		m_selector_fd_sock.resize( fd + 1, -1 );
+	}
+	m_selector_fd_sock[fd] = i;
+	if ( want_read ) {
+		m_selector->add_fd( fd, Selector::IO_READ );
+	}
+	if ( want_write ) {
+		m_selector->add_fd( fd, Selector::IO_WRITE );
+	}
+	if ( want_except ) {
+		m_selector->add_fd( fd, Selector::IO_EXCEPT );
+	}
+}
+
+void
+DaemonCore::AddSelectorPipe( int i )
+{
+#if !defined(WIN32)
+	if ( !m_persistent_selector || (*pipeTable)[i].index == -1 ) {
+		return;
+	}
+	int index = (*pipeTable)[i].index;
+	int fd = (*pipeHandleTable)[index];
+	if ( fd < 0 ) {
+		return;
+	}
+	if ( fd >= (int)m_selector_fd_pipe.size() ) {
+		m_selector_fd_pipe.resize( fd + 1, -1 );
+	}
+	m_selector_fd_pipe[fd] = index;
+	switch( (*pipeTable)[i].handler_type ) {
+	case HANDLE_READ:
+		m_selector->add_fd( fd, Selector::IO_READ );
+		break;
+	case HANDLE_WRITE:
+		m_selector->add_fd( fd, Selector::IO_WRITE );
+		break;
+	case HANDLE_READ_WRITE:
+		m_selector->add_fd( fd, Selector::IO_READ );
+		m_selector->add_fd( fd, Selector::IO_WRITE );
+		break;
+	}
+#else
+	(void)i;
+#endif
+}
+
+void
+DaemonCore::RemoveSelectorPipe( int i )
+{
+#if !defined(WIN32)
+	if ( !m_persistent_selector || (*pipeTable)[i].index == -1 ) {
+		return;
+	}
+	int index = (*pipeTable)[i].index;
+	int fd = (*pipeHandleTable)[index];
+	if ( fd < 0 || fd >= (int)m_selector_fd_pipe.size() ||
+		 m_selector_fd_pipe[fd] != index )
+	{
+		return;
+	}
+	m_selector->delete_fd( fd, Selector::IO_READ );
+	m_selector->delete_fd( fd, Selector::IO_WRITE );
+	m_selector_fd_pipe[fd] = -1;
+#else
+	(void)i;
+#endif
+}
+
+int
+DaemonCore::PipeSlot( int index )
+{
+	if ( index < 0 || index >= (int)m_pipe_slot.size() ) {
+		return -1;
+	}
+	return m_pipe_slot[index];
+}
+
 bool
 DaemonCore::SocketIsRegistered( Stream *sock )
 {
@@ -3917,6 +4210,7 @@ DaemonCore::CallSocketHandler_worker( int i, bool default_to_HandleCommand, Stre
 				CondorThreads::get_handle()->get_tid() ) 
 		{
 				(*sockTable)[i].servicing_tid = 0;
+				UpdateSelectorSock( i );
 				// need to potentially add this sock to select
 				daemonCore->Wake_up_select();	
 		}
@@ -10435,9 +10729,34 @@ DaemonCore::sendUpdates( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblock )
 	ASSERT(ad1);
 	ASSERT(m_collector_list);
 
+	evalShutdownExprs(ad1);
+
+		// Even if we just decided to shut ourselves down, we should
+		// still send the updates originally requested by the caller.
+	return m_collector_list->sendUpdates(cmd, ad1, ad2, nonblock);
+}
+
+
+int
+DaemonCore::sendUpdates( int cmd, std::vector<ClassAd*> &ads1,
+						 std::vector<ClassAd*> &ads2, bool nonblock )
+{
+	ASSERT(m_collector_list);
+	ASSERT(ads1.size() == ads2.size());
+
+	for( size_t i = 0; i < ads1.size(); i++ ) {
+		evalShutdownExprs(ads1[i]);
+	}
+	return m_collector_list->sendUpdates(cmd, ads1, ads2, nonblock);
+}
+
+
+void
+DaemonCore::evalShutdownExprs( ClassAd* ad )
+{
 		// Now's our chance to evaluate the DAEMON_SHUTDOWN expressions.
 	if (!m_in_daemon_shutdown_fast &&
-		evalExpr(ad1, "DAEMON_SHUTDOWN_FAST", ATTR_DAEMON_SHUTDOWN_FAST,
+		evalExpr(ad, "DAEMON_SHUTDOWN_FAST", ATTR_DAEMON_SHUTDOWN_FAST,
 				 "starting fast shutdown"))	{
 			// Daemon wants to quickly shut itself down and not restart.
 		m_wants_restart = false;
@@ -10445,16 +10764,12 @@ DaemonCore::sendUpdates( int cmd, ClassAd* ad1, ClassAd* ad2, bool nonblock )
 		daemonCore->Send_Signal( daemonCore->getpid(), SIGQUIT );
 	}
 	else if (!m_in_daemon_shutdown &&
-			 evalExpr(ad1, "DAEMON_SHUTDOWN", ATTR_DAEMON_SHUTDOWN,
+			 evalExpr(ad, "DAEMON_SHUTDOWN", ATTR_DAEMON_SHUTDOWN,
 					  "starting graceful shutdown")) {
 		m_wants_restart = false;
 		m_in_daemon_shutdown = true;
 		daemonCore->Send_Signal( daemonCore->getpid(), SIGTERM );
 	}
-
-		// Even if we just decided to shut ourselves down, we should
-		// still send the updates originally requested by the caller.
-	return m_collector_list->sendUpdates(cmd, ad1, ad2, nonblock);
 }
 
 
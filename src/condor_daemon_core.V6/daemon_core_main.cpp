@@ -1332,6 +1332,18 @@ handle_config_val( Service*, int idCmd, Stream* stream )
 				ad.Assign("StringBytes", stats.cbStrings);
 				ad.Assign("TablesBytes", stats.cbTables);
 				ad.Assign("Sorted", stats.cSorted);
+
+				// the params looked up most often, as "NAME:count" pairs,
+				// to show which lookups are worth caching
+				std::vector<std::string> names;
+				std::vector<int> counts;
+				int cNames = param_most_used(10, names, counts);
+				std::string most_used;
+				for (int ii = 0; ii < cNames; ++ii) {
+					if (ii) most_used += ", ";
+					formatstr_cat(most_used, "%s:%d", names[ii].c_str(), counts[ii]);
+				}
+				ad.Assign("MostUsed", most_used);
 				if ( ! putClassAd(stream, ad)) {
 					dprintf(D_ALWAYS, "Can't send param stats ad for DC_CONFIG_VAL\n");
 					retval = false;
@@ -44,6 +44,15 @@ static void self_monitor()
     daemonCore->monitor_data.CollectData();
     daemonCore->dc_stats.Tick(daemonCore->monitor_data.last_sample_time);
     daemonCore->dc_stats.DebugOuts += dprintf_getCount();
+
+    static long long last_async_delayed = 0;
+    static long long last_async_dropped = 0;
+    long long async_delayed = 0, async_dropped = 0;
+    dprintf_get_async_stats(NULL, &async_delayed, &async_dropped);
+    daemonCore->dc_stats.DebugAsyncDelayed += (int)(async_delayed - last_async_delayed);
+    daemonCore->dc_stats.DebugAsyncDropped += (int)(async_dropped - last_async_dropped);
+    last_async_delayed = async_delayed;
+    last_async_dropped = async_dropped;
 }
 
 SelfMonitorData::SelfMonitorData()
@@ -211,6 +220,8 @@ void DaemonCore::Stats::Init()
    //DC_STATS_ADD_RECENT(Pool, SockBytes,     IF_BASICPUB);
    //DC_STATS_ADD_RECENT(Pool, PipeBytes,     IF_BASICPUB);
    DC_STATS_ADD_RECENT(Pool, DebugOuts,     IF_VERBOSEPUB);
+   DC_STATS_ADD_RECENT(Pool, DebugAsyncDelayed, IF_VERBOSEPUB);
+   DC_STATS_ADD_RECENT(Pool, DebugAsyncDropped, IF_VERBOSEPUB);
    DC_STATS_ADD_RECENT(Pool, PumpCycle,     IF_VERBOSEPUB);
    DC_STATS_ADD_DEF(Pool, Commands, IF_BASICPUB);
 
@@ -247,6 +258,8 @@ void DaemonCore::Stats::Init()
    //DC_STATS_PUB_DEBUG(Pool, SockBytes,     IF_BASICPUB);
    //DC_STATS_PUB_DEBUG(Pool, PipeBytes,     IF_BASICPUB);
    DC_STATS_PUB_DEBUG(Pool, DebugOuts,     IF_VERBOSEPUB);
+   DC_STATS_PUB_DEBUG(Pool, DebugAsyncDelayed, IF_VERBOSEPUB);
+   DC_STATS_PUB_DEBUG(Pool, DebugAsyncDropped, IF_VERBOSEPUB);
    DC_STATS_PUB_DEBUG(Pool, PumpCycle,     IF_VERBOSEPUB);
 
 
@@ -23,6 +23,7 @@
 #include "condor_common.h"
 #include "condor_debug.h"
 #include "condor_daemon_core.h"
+#include <algorithm>
 
 static const char* DEFAULT_INDENT = "DaemonCore--> ";
 
@@ -45,14 +46,14 @@ extern void **curr_regdataptr;
 MSC_DISABLE_WARNING(6211)
 
 
-TimerManager::TimerManager()
+TimerManager::TimerManager() :
+	timer_table( 64, hashFuncInt, rejectDuplicateKeys )
 {
 	if(_t)
 	{
 		EXCEPT("TimerManager object exists!");
 	}
-	timer_list = NULL;
-	list_tail = NULL;
+	next_sequence = 0;
 	timer_ids = 0;
 	in_timeout = NULL;
 	_t = this; 
@@ -65,6 +66,12 @@ TimerManager::~TimerManager()
 	CancelAllTimers();
 }
 
+TimerManager &TimerManager::GetTimerManager()
+{
+	ASSERT( _t );
+	return *_t;
+}
+
 int TimerManager::NewTimer(unsigned deltawhen, TimerHandler handler, 
 						   Release release, const char* event_descrip,
 						   unsigned period)
@@ -170,7 +177,7 @@ bool TimerManager::ResetTimerTimeslice(int id, Timeslice const &new_timeslice)
 
 bool TimerManager::GetTimerTimeslice(int id, Timeslice &timeslice)
 {
-	Timer *timer_ptr = GetTimer( id, NULL );
+	Timer *timer_ptr = GetTimer( id );
 	if( !timer_ptr || !timer_ptr->timeslice ) {
 		return false;
 	}
@@ -183,21 +190,15 @@ int TimerManager::ResetTimer(int id, unsigned when, unsigned period,
 							 Timeslice const *new_timeslice)
 {
 	Timer*			timer_ptr;
-	Timer*			trail_ptr;
 
 	dprintf( D_DAEMONCORE,
 			 "In reset_timer(), id=%d, time=%d, period=%d\n",id,when,period);
-	if (timer_list == NULL) {
+	if (timer_heap.empty()) {
 		dprintf( D_DAEMONCORE, "Reseting Timer from empty list!\n");
 		return -1;
 	}
 
-	timer_ptr = timer_list;
-	trail_ptr = NULL;
-	while ( timer_ptr && timer_ptr->id != id ) {
-		trail_ptr = timer_ptr;
-		timer_ptr = timer_ptr->next;
-	}
+	timer_ptr = GetTimer( id );
 
 	if ( timer_ptr == NULL ) {
 		dprintf( D_ALWAYS, "Timer %d not found\n",id );
@@ -256,7 +257,7 @@ int TimerManager::ResetTimer(int id, unsigned when, unsigned period,
 	}
 	timer_ptr->period = period;
 
-	RemoveTimer( timer_ptr, trail_ptr );
+	RemoveTimer( timer_ptr );
 	InsertTimer( timer_ptr );
 
 	if ( in_timeout == timer_ptr ) {
@@ -271,27 +272,21 @@ int TimerManager::ResetTimer(int id, unsigned when, unsigned period,
 int TimerManager::CancelTimer(int id)
 {
 	Timer*		timer_ptr;
-	Timer*		trail_ptr;
 
 	dprintf( D_DAEMONCORE, "In cancel_timer(), id=%d\n",id);
-	if (timer_list == NULL) {
+	if (timer_heap.empty()) {
 		dprintf( D_DAEMONCORE, "Removing Timer from empty list!\n");
 		return -1;
 	}
 
-	timer_ptr = timer_list;
-	trail_ptr = NULL;
-	while ( timer_ptr && timer_ptr->id != id ) {
-		trail_ptr = timer_ptr;
-		timer_ptr = timer_ptr->next;
-	}
+	timer_ptr = GetTimer( id );
 
 	if ( timer_ptr == NULL ) {
 		dprintf( D_ALWAYS, "Timer %d not found\n",id );
 		return -1;
 	}
 
-	RemoveTimer( timer_ptr, trail_ptr );
+	RemoveTimer( timer_ptr );
 
 	if ( in_timeout == timer_ptr ) {
 		// We're inside the handler for this timer. Don't delete it,
@@ -309,9 +304,15 @@ void TimerManager::CancelAllTimers()
 {
 	Timer		*timer_ptr;
 
-	while( timer_list != NULL ) {
-		timer_ptr = timer_list;
-		timer_list = timer_list->next;
+		// Empty the heap first, so nothing a release function does can
+		// see a half-deleted timer.
+	std::vector<Timer*> timers;
+	timers.swap( timer_heap );
+	timer_table.clear();
+
+	for( size_t i = 0; i < timers.size(); i++ ) {
+		timer_ptr = timers[i];
+		timer_ptr->heap_index = -1;
 		if( in_timeout == timer_ptr ) {
 				// We get here if somebody calls exit from inside a timer.
 			did_cancel = true;
@@ -320,8 +321,6 @@ void TimerManager::CancelAllTimers()
 			DeleteTimer( timer_ptr );
 		}
 	}
-	timer_list = NULL;
-	list_tail = NULL;
 }
 
 // Timeout() is called when a select() time out.  Returns number of seconds
@@ -339,10 +338,10 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 
 	if ( in_timeout != NULL ) {
 		dprintf(D_DAEMONCORE,"DaemonCore Timeout() called and in_timeout is non-NULL\n");
-		if ( timer_list == NULL ) {
+		if ( timer_heap.empty() ) {
 			result = 0;
 		} else {
-			result = (timer_list->when) - time(NULL);
+			result = (FirstTimer()->when) - time(NULL);
 		}
 		if ( result < 0 ) {
 			result = 0;
@@ -352,7 +351,7 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 		
 	dprintf( D_DAEMONCORE, "In DaemonCore Timeout()\n");
 
-	if (timer_list == NULL) {
+	if (timer_heap.empty()) {
 		dprintf( D_DAEMONCORE, "Empty timer list, nothing to do\n" );
 	}
 
@@ -363,18 +362,18 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 
 	// loop until all handlers that should have been called by now or before
 	// are invoked and renewed if periodic.  Remember that NewTimer and CancelTimer
-	// keep the timer_list happily sorted on "when" for us.  We use "now" as a 
+	// keep the timer_heap ordered on "when" for us.  We use "now" as a 
 	// variable so that if some of these handler functions run for a long time,
 	// we do not sit in this loop forever.
 	// we make certain we do not call more than "max_fires" handlers in a 
 	// single timeout --- this ensures that timers don't starve out the rest
 	// of daemonCore if a timer handler resets itself to 0.
-	while( (timer_list != NULL) && (timer_list->when <= now ) && 
+	while( (!timer_heap.empty()) && (FirstTimer()->when <= now ) && 
 		   (num_fires++ < MAX_FIRES_PER_TIMEOUT)) 
 	{
 		// DumpTimerList(D_DAEMONCORE | D_FULLDEBUG);
 
-		in_timeout = timer_list;
+		in_timeout = FirstTimer();
 
 		// In some cases, resuming from a suspend can cause the system
 		// clock to become temporarily skewed, causing crazy things to 
@@ -452,7 +451,9 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 		}
 
         // Make sure we didn't leak our priv state
-		daemonCore->CheckPrivState();
+		if ( daemonCore ) {
+			daemonCore->CheckPrivState();
+		}
 
 		// Clear curr_dataptr
 		curr_dataptr = NULL;
@@ -468,12 +469,10 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 			// If a new timer was added at a time in the past
 			// (possible when resetting a timeslice timer), then
 			// it may have landed before the timer we just processed,
-			// meaning that we cannot assume prev==NULL in the call
-			// to RemoveTimer() below.
+			// meaning that we cannot assume it is still first in line.
 
-			Timer *prev = NULL;
-			ASSERT( GetTimer(in_timeout->id,&prev) == in_timeout );
-			RemoveTimer( in_timeout, prev );
+			ASSERT( GetTimer(in_timeout->id) == in_timeout );
+			RemoveTimer( in_timeout );
 
 			if ( in_timeout->period > 0 || in_timeout->timeslice ) {
 				in_timeout->period_started = time(NULL);
@@ -495,13 +494,13 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 
 	// set result to number of seconds until next event.  get an update on the
 	// time from time() in case the handlers we called above took significant time.
-	if ( timer_list == NULL ) {
+	if ( timer_heap.empty() ) {
 		// we set result to be -1 so that we do not busy poll.
 		// a -1 return value will tell the DaemonCore:Driver to use select with
 		// no timeout.
 		result = -1;
 	} else {
-		result = (timer_list->when) - time(NULL);
+		result = (FirstTimer()->when) - time(NULL);
 		if (result < 0)
 			result = 0;
 	}
@@ -515,6 +514,16 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 #define IS_ZERO(_value_) \
 	(  ( (_value_) >= -0.000001 ) && ( (_value_) <= 0.000001 )  )
 
+// Orders timers for DumpTimerList() the same way the heap does.
+struct TimerDumpOrder {
+	bool operator()( const Timer *a, const Timer *b ) const {
+		if ( a->when != b->when ) {
+			return a->when < b->when;
+		}
+		return a->sequence < b->sequence;
+	}
+};
+
 void TimerManager::DumpTimerList(int flag, const char* indent)
 {
 	Timer		*timer_ptr;
@@ -534,8 +543,13 @@ void TimerManager::DumpTimerList(int flag, const char* indent)
 	dprintf(flag, "\n");
 	dprintf(flag, "%sTimers\n", indent);
 	dprintf(flag, "%s~~~~~~\n", indent);
-	for(timer_ptr = timer_list; timer_ptr != NULL; timer_ptr = timer_ptr->next)
+
+		// the heap is only partially ordered; list timers in firing order
+	std::vector<Timer*> timers( timer_heap );
+	std::sort( timers.begin(), timers.end(), TimerDumpOrder() );
+	for( size_t i = 0; i < timers.size(); i++ )
 	{
+		timer_ptr = timers[i];
 		if ( timer_ptr->event_descrip )
 			ptmp = timer_ptr->event_descrip;
 		else
@@ -602,68 +616,95 @@ void TimerManager::Start()
 	}
 }
 
-void TimerManager::RemoveTimer( Timer *timer, Timer *prev )
+bool TimerManager::TimerBefore( const Timer *a, const Timer *b ) const
 {
-	if ( timer == NULL || ( prev && prev->next != timer ) ||
-		 ( !prev && timer != timer_list ) ) {
-		EXCEPT( "Bad call to TimerManager::RemoveTimer()!\n" );
+	// Equal "when" is broken by insertion order, so a timer that keeps
+	// resetting itself to zero goes behind the others that are due and
+	// we "round-robin" across them.
+	if ( a->when != b->when ) {
+		return a->when < b->when;
 	}
+	return a->sequence < b->sequence;
+}
+
+void TimerManager::HeapSet( int index, Timer *timer )
+{
+	timer_heap[index] = timer;
+	timer->heap_index = index;
+}
 
-	if ( timer == timer_list ) {
-		timer_list = timer_list->next;
+void TimerManager::SiftUp( int index )
+{
+	Timer *timer = timer_heap[index];
+	while ( index > 0 ) {
+		int parent = (index - 1) / 2;
+		if ( !TimerBefore( timer, timer_heap[parent] ) ) {
+			break;
+		}
+		HeapSet( index, timer_heap[parent] );
+		index = parent;
+	}
+	HeapSet( index, timer );
+}
+
+void TimerManager::SiftDown( int index )
+{
+	int count = (int)timer_heap.size();
+	Timer *timer = timer_heap[index];
+	for (;;) {
+		int child = 2 * index + 1;
+		if ( child >= count ) {
+			break;
+		}
+		if ( child + 1 < count &&
+			 TimerBefore( timer_heap[child + 1], timer_heap[child] ) ) {
+			child++;
+		}
+		if ( !TimerBefore( timer_heap[child], timer ) ) {
+			break;
+		}
+		HeapSet( index, timer_heap[child] );
+		index = child;
 	}
-	if ( timer == list_tail ) {
-		list_tail = prev;
+	HeapSet( index, timer );
+}
+
+void TimerManager::RemoveTimer( Timer *timer )
+{
+	if ( timer == NULL || timer->heap_index < 0 ||
+		 timer->heap_index >= (int)timer_heap.size() ||
+		 timer_heap[timer->heap_index] != timer ) {
+		EXCEPT( "Bad call to TimerManager::RemoveTimer()!\n" );
 	}
-	if ( prev ) {
-		prev->next = timer->next;
+
+	int index = timer->heap_index;
+	Timer *last = timer_heap.back();
+	timer_heap.pop_back();
+	if ( last != timer ) {
+		// move the last timer into the hole and restore heap order
+		HeapSet( index, last );
+		if ( index > 0 && TimerBefore( last, timer_heap[(index - 1) / 2] ) ) {
+			SiftUp( index );
+		} else {
+			SiftDown( index );
+		}
 	}
+	timer->heap_index = -1;
+	timer_table.remove( timer->id );
 }
 
 void TimerManager::InsertTimer( Timer *new_timer )
 {
-	if ( timer_list == NULL ) {
-		// list is empty, place ours in front
-		timer_list = new_timer;
-		list_tail = new_timer;
-		new_timer->next = NULL;
+	new_timer->sequence = next_sequence++;
+	timer_heap.push_back( new_timer );
+	SiftUp( (int)timer_heap.size() - 1 );
+	if ( timer_table.insert( new_timer->id, new_timer ) != 0 ) {
+		EXCEPT( "TimerManager: timer %d inserted twice!", new_timer->id );
+	}
+
+	if ( timer_heap[0] == new_timer && daemonCore ) {
 			// since we have a new first timer, we must wake up select
 		daemonCore->Wake_up_select();
-	} else {
-		// list is not empty, so keep timer_list ordered from soonest to
-		// farthest (i.e. sorted on "when").
-		// Note: when doing the comparisons, we always use "<" instead
-		// of "<=" -- this makes certain we "round-robin" across 
-		// timers that constantly reset themselves to zero.
-		if ( new_timer->when < timer_list->when ) {
-			// make the this new timer first in line
-			new_timer->next = timer_list;
-			timer_list = new_timer;
-			// since we have a new first timer, we must wake up select
-			daemonCore->Wake_up_select();
-		} else if ( new_timer->when == TIME_T_NEVER ) {
-			// Our new timer goes to the very back of the list.
-			new_timer->next = NULL;
-			list_tail->next = new_timer;
-			list_tail = new_timer;
-		} else {
-			Timer* timer_ptr;
-			Timer* trail_ptr = NULL;
-			for (timer_ptr = timer_list; timer_ptr != NULL; 
-				 timer_ptr = timer_ptr->next ) 
-			{
-				if (new_timer->when < timer_ptr->when) {
-					break;
-				}
-				trail_ptr = timer_ptr;
-			}
-			ASSERT( trail_ptr );
-			new_timer->next = timer_ptr;
-			trail_ptr->next = new_timer;
-			if ( trail_ptr == list_tail ) {
-				list_tail = new_timer;
-			}
-		}
 	}
 }
 
@@ -689,18 +730,11 @@ void TimerManager::DeleteTimer( Timer *timer )
 	delete timer;
 }
 
-Timer *TimerManager::GetTimer( int id, Timer **prev )
+Timer *TimerManager::GetTimer( int id )
 {
-	Timer *timer_ptr = timer_list;
-	if( prev ) {
-		*prev = NULL;
+	Timer *timer_ptr = NULL;
+	if ( timer_table.lookup( id, timer_ptr ) != 0 ) {
+		return NULL;
 	}
-	while ( timer_ptr && timer_ptr->id != id ) {
-		if( prev ) {
-			*prev = timer_ptr;
-		}
-		timer_ptr = timer_ptr->next;
-	}
-
 	return timer_ptr;
 }
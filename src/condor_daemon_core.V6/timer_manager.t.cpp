@@ -0,0 +1,153 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/*
+  Microbenchmark for the DaemonCore TimerManager.
+
+  Registers the requested number of one-shot timers spread over the
+  next hour, resets each of them to a new random time, cancels every
+  other one, and then makes the rest due and fires them all through
+  Timeout().  Also checks that timers with the same deadline fire in
+  the order they were registered.
+
+  usage: timer_manager_bench [-timers <n>]   (default: 100000)
+*/
+
+#include "condor_common.h"
+#include "condor_config.h"
+#include "condor_debug.h"
+#include "condor_daemon_core.h"
+#include "subsystem_info.h"
+#include "utc_time.h"
+
+static int fired = 0;
+static std::vector<int> fire_order;
+
+static void
+count_fire()
+{
+	fired++;
+}
+
+class OrderedTimer : public Service {
+ public:
+	int order;
+	void Fire() { fire_order.push_back( order ); }
+};
+
+static void
+report( const char *phase, int ops, double seconds )
+{
+	printf( "%-8s %10d %10.3f %12.0f\n", phase, ops, seconds,
+			seconds > 0 ? ops / seconds : 0.0 );
+}
+
+int
+main( int argc, const char **argv )
+{
+	set_mySubSystem( "TEST_TIMER_MANAGER", SUBSYSTEM_TYPE_TOOL );
+	config();
+	dprintf_set_tool_debug( "TOOL", 0 );
+
+	int count = 100000;
+	for ( int i = 1; i < argc; i++ ) {
+		if ( strcmp( argv[i], "-timers" ) == 0 && i+1 < argc ) {
+			count = atoi( argv[++i] );
+		} else {
+			fprintf( stderr, "usage: %s [-timers <n>]\n", argv[0] );
+			return 1;
+		}
+	}
+	if ( count < 2 ) {
+		count = 2;
+	}
+
+	TimerManager &tm = TimerManager::GetTimerManager();
+	std::vector<int> ids( count );
+	srand( 42 );
+
+	double begin = UtcTime::getTimeDouble();
+	for ( int i = 0; i < count; i++ ) {
+		ids[i] = tm.NewTimer( 60 + rand() % 3600, count_fire, "bench" );
+		if ( ids[i] < 0 ) {
+			fprintf( stderr, "NewTimer() failed\n" );
+			return 1;
+		}
+	}
+	double insert_secs = UtcTime::getTimeDouble() - begin;
+
+	begin = UtcTime::getTimeDouble();
+	for ( int i = 0; i < count; i++ ) {
+		tm.ResetTimer( ids[i], 60 + rand() % 3600 );
+	}
+	double reset_secs = UtcTime::getTimeDouble() - begin;
+
+	begin = UtcTime::getTimeDouble();
+	int cancelled = 0;
+	for ( int i = 0; i < count; i += 2 ) {
+		if ( tm.CancelTimer( ids[i] ) != 0 ) {
+			fprintf( stderr, "CancelTimer(%d) failed\n", ids[i] );
+			return 1;
+		}
+		cancelled++;
+	}
+	double cancel_secs = UtcTime::getTimeDouble() - begin;
+
+		// make the rest due now; Timeout() fires a few per call
+	for ( int i = 1; i < count; i += 2 ) {
+		tm.ResetTimer( ids[i], 0 );
+	}
+	begin = UtcTime::getTimeDouble();
+	int num_fired = 0;
+	do {
+		tm.Timeout( &num_fired );
+	} while ( num_fired > 0 );
+	double fire_secs = UtcTime::getTimeDouble() - begin;
+
+	int expected = count - cancelled;
+	if ( fired != expected ) {
+		fprintf( stderr, "fired %d timers, expected %d\n", fired, expected );
+		return 1;
+	}
+
+		// timers with equal deadlines must fire first-come first-served
+	const int order_count = 10;
+	OrderedTimer ordered[order_count];
+	for ( int i = 0; i < order_count; i++ ) {
+		ordered[i].order = i;
+		tm.NewTimer( &ordered[i], 0, (TimerHandlercpp)&OrderedTimer::Fire,
+					 "order" );
+	}
+	do {
+		tm.Timeout( &num_fired );
+	} while ( num_fired > 0 );
+	for ( int i = 0; i < order_count; i++ ) {
+		if ( (int)fire_order.size() != order_count || fire_order[i] != i ) {
+			fprintf( stderr, "timers with equal deadlines fired out of order\n" );
+			return 1;
+		}
+	}
+
+	printf( "%-8s %10s %10s %12s\n", "phase", "timers", "seconds", "ops/s" );
+	report( "insert", count, insert_secs );
+	report( "reset", count, reset_secs );
+	report( "cancel", cancelled, cancel_secs );
+	report( "fire", expected, fire_secs );
+	return 0;
+}
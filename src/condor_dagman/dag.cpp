@@ -243,6 +243,12 @@ Dag::~Dag()
       _jobs.DeleteCurrent();
     }
 
+    _joinNodes.Rewind();
+    while( (job = _joinNodes.Next()) ) {
+      delete job;
+      _joinNodes.DeleteCurrent();
+    }
+
     delete _preScriptQ;
     delete _postScriptQ;
     delete _submitQ;
@@ -411,6 +417,31 @@ Dag::AddDependency( Job* parent, Job* child )
     return true;
 }
 
+//-------------------------------------------------------------------------
+Job *
+Dag::AddJoinNode()
+{
+		// Join node names only show up in debug output and the dot
+		// file, but they should still be unique across splices.
+	static int joinCount = 0;
+	MyString name;
+	name.formatstr( "_join_%d", joinCount++ );
+
+	Job *join = new Job( Job::TYPE_CONDOR, name.Value(), "", "" );
+	join->SetJoin( true );
+	join->SetNoop( true );
+
+		// Join nodes are found by ID when walking the dependencies,
+		// but never by name.
+	int insertResult = _nodeIDHash.insert( join->GetJobID(), join );
+	ASSERT( insertResult == 0 );
+	_joinNodes.Append( join );
+
+	debug_printf( DEBUG_DEBUG_2, "Dag::AddJoinNode() created %s\n",
+				join->GetJobName() );
+	return join;
+}
+
 //-------------------------------------------------------------------------
 Job * Dag::FindNodeByNodeID (const JobID_t jobID) const {
 	Job *	job = NULL;
@@ -1519,6 +1550,10 @@ Dag::SubmitReadyJobs(const Dagman &dm)
 
 	int numSubmitsThisCycle = 0;
 
+		// Node jobs to be submitted together at the end of this cycle.
+	CondorSubmitBatch submitBatch;
+	std::vector<Job*> batchedJobs;
+
 		// Check whether we have to wait longer before submitting again
 		// (if a previous submit attempt failed).
 	if ( _nextSubmitTime && time(NULL) < _nextSubmitTime) {
@@ -1641,8 +1676,17 @@ Dag::SubmitReadyJobs(const Dagman &dm)
 				didLogSleep = true;
 			}
 
+				// Submit what is batched so far before any node that
+				// can't be batched, so that submit events still appear
+				// in the order we submitted.
+			if ( !batchedJobs.empty() && !CanBatchSubmit( job ) ) {
+				numSubmitsThisCycle -= SubmitBatchedJobs( dm, submitBatch,
+							batchedJobs );
+			}
+
     		CondorID condorID(0,0,0);
-			submit_result_t submit_result = SubmitNodeJob( dm, job, condorID );
+			submit_result_t submit_result = SubmitNodeJob( dm, job, condorID,
+						dm._batchSubmit ? &submitBatch : NULL );
 	
 				// Note: if instead of switch here so we can use break
 				// to break out of while loop.
@@ -1650,6 +1694,14 @@ Dag::SubmitReadyJobs(const Dagman &dm)
 				ProcessSuccessfulSubmit( job, condorID );
     			numSubmitsThisCycle++;
 
+			} else if ( submit_result == SUBMIT_RESULT_BATCHED ) {
+					// Count the job now so that maxjobs and category
+					// throttles apply to the rest of this cycle;
+					// SubmitBatchedJobs() takes it back out.
+				UpdateJobCounts( job, 1 );
+				batchedJobs.push_back( job );
+    			numSubmitsThisCycle++;
+
 			} else if ( submit_result == SUBMIT_RESULT_FAILED || submit_result == SUBMIT_RESULT_NO_SUBMIT ) {
 				ProcessFailedSubmit( job, dm.max_submit_attempts );
 				break; // break out of while loop
@@ -1659,6 +1711,8 @@ Dag::SubmitReadyJobs(const Dagman &dm)
 		}
 	}
 
+	numSubmitsThisCycle -= SubmitBatchedJobs( dm, submitBatch, batchedJobs );
+
 		// Put any deferred jobs back into the ready queue for next time.
 	deferredJobs.Rewind();
 	Job *job;
@@ -2315,19 +2369,38 @@ void Dag::WriteRescue (const char * rescue_file, const char * dagFile,
     	it.ToBeforeFirst();
     	while (it.Next(job)) {
 
-        	set<JobID_t> & _queue = job->GetQueueRef(Job::Q_CHILDREN);
-        	if (!_queue.empty()) {
-            	fprintf(fp, "PARENT %s CHILD", job->GetJobName());
+			JobIDList & _queue = job->GetQueueRef(Job::Q_CHILDREN);
+			bool wroteParent = false;
 
-				set<JobID_t>::const_iterator qit;
-				for (qit = _queue.begin(); qit != _queue.end(); qit++) {
-                	Job * child = FindNodeByNodeID( *qit );
-                	ASSERT( child != NULL );
-                	fprintf(fp, " %s", child->GetJobName());
+			JobIDList::const_iterator qit;
+			for (qit = _queue.begin(); qit != _queue.end(); qit++) {
+				Job * child = FindNodeByNodeID( *qit );
+				ASSERT( child != NULL );
+					// Edges through join nodes are written below.
+				if ( child->GetJoin() ) {
+					continue;
 				}
-            	fprintf(fp, "\n");
-        	}
-    	}
+				if ( !wroteParent ) {
+					fprintf(fp, "PARENT %s CHILD", job->GetJobName());
+					wroteParent = true;
+				}
+				fprintf(fp, " %s", child->GetJobName());
+			}
+			if ( wroteParent ) {
+				fprintf(fp, "\n");
+			}
+		}
+
+			// Write each join node as the PARENT ... CHILD ... line
+			// it came from, so we don't write out every edge.
+		_joinNodes.Rewind();
+		while ( (job = _joinNodes.Next()) ) {
+			fprintf(fp, "PARENT");
+			WriteNodeList( fp, job->GetQueueRef(Job::Q_PARENTS) );
+			fprintf(fp, " CHILD");
+			WriteNodeList( fp, job->GetQueueRef(Job::Q_CHILDREN) );
+			fprintf(fp, "\n");
+		}
 	}
 
 	//
@@ -2340,6 +2413,18 @@ void Dag::WriteRescue (const char * rescue_file, const char * dagFile,
     fclose( fp );
 }
 
+//-----------------------------------------------------------------------------
+void
+Dag::WriteNodeList( FILE *fp, const JobIDList &nodes ) const
+{
+	JobIDList::const_iterator it;
+	for ( it = nodes.begin(); it != nodes.end(); it++ ) {
+		Job *node = FindNodeByNodeID( *it );
+		ASSERT( node != NULL );
+		fprintf( fp, " %s", node->GetJobName() );
+	}
+}
+
 //-----------------------------------------------------------------------------
 void
 Dag::WriteNodeToRescue( FILE *fp, Job *node, bool reset_retries_upon_rescue,
@@ -2495,7 +2580,7 @@ Dag::TerminateJob( Job* job, bool recovery, bool bootstrap )
 		// this is a little ugly, but since this function can be
 		// called multiple times for the same job, we need to be
 		// careful not to double-count...
-	if( job->countedAsDone == false ) {
+	if( job->countedAsDone == false && !job->GetJoin() ) {
 		_numNodesDone++;
 		_metrics->NodeFinished( job->GetDagFile() != NULL, true );
 		job->countedAsDone = true;
@@ -2506,9 +2591,9 @@ Dag::TerminateJob( Job* job, bool recovery, bool bootstrap )
     // Report termination to all child jobs by removing parent's ID from
     // each child's waiting queue.
     //
-    set<JobID_t> & qp = job->GetQueueRef(Job::Q_CHILDREN);
+    JobIDList & qp = job->GetQueueRef(Job::Q_CHILDREN);
 
-	set<JobID_t>::const_iterator qit;
+	JobIDList::const_iterator qit;
 	for (qit = qp.begin(); qit != qp.end(); qit++) {
         Job * child = FindNodeByNodeID( *qit );
         ASSERT( child != NULL );
@@ -2516,6 +2601,16 @@ Dag::TerminateJob( Job* job, bool recovery, bool bootstrap )
 		if ( child->GetStatus() == Job::STATUS_READY &&
 			child->IsEmpty( Job::Q_WAITING ) ) {
 
+				// A join node is done as soon as its parents are, and
+				// that's when its own children hear about it.  Its
+				// parents' priorities are settled by now, so this is
+				// when it takes on its priority.
+			if ( child->GetJoin() ) {
+				child->FixPriority( *this );
+				TerminateJob( child, recovery, bootstrap );
+				continue;
+			}
+
 				// If we're bootstrapping, we don't want to do anything
 				// here.
 			if ( !bootstrap ) {
@@ -2631,8 +2726,8 @@ Dag::DFSVisit (Job * job)
 	job->_visited = true; 
 	
 	//Get the children of current job	
-	set<JobID_t> & children = job->GetQueueRef(Job::Q_CHILDREN);
-	set<JobID_t>::const_iterator child_itr;
+	JobIDList & children = job->GetQueueRef(Job::Q_CHILDREN);
+	JobIDList::const_iterator child_itr;
 
 	for (child_itr = children.begin(); child_itr != children.end(); child_itr++)
 	{
@@ -2666,25 +2761,27 @@ Dag::isCycle ()
 			DFSVisit (job);	
 	}	
 
-	//Detect cycle
-	joblist.ToBeforeFirst();	
-	while (joblist.Next(job))
-	{
-
-		set<JobID_t> &cset = job->GetQueueRef(Job::Q_CHILDREN);
-		set<JobID_t>::const_iterator cit;
+	//Detect cycle (the edges into and out of join nodes count, too)
+	for (int pass = 0; pass < 2; pass++) {
+		ListIterator <Job> edgelist (pass == 0 ? _jobs : _joinNodes);
+		edgelist.ToBeforeFirst();
+		while (edgelist.Next(job))
+		{
+			JobIDList &cset = job->GetQueueRef(Job::Q_CHILDREN);
+			JobIDList::const_iterator cit;
 
-		for(cit = cset.begin(); cit != cset.end(); cit++) {
-			Job * child = FindNodeByNodeID( *cit );
+			for(cit = cset.begin(); cit != cset.end(); cit++) {
+				Job * child = FindNodeByNodeID( *cit );
 
-			//No child's DFS order should be smaller than parent's
-			if (child->_dfsOrder >= job->_dfsOrder) {
+				//No child's DFS order should be smaller than parent's
+				if (child->_dfsOrder >= job->_dfsOrder) {
 #ifdef REPORT_CYCLE	
-				debug_printf (DEBUG_QUIET, 
-							  "Cycle in the graph possibly involving jobs %s and %s\n",
-							  job->GetJobName(), child->GetJobName());
+					debug_printf (DEBUG_QUIET, 
+								  "Cycle in the graph possibly involving jobs %s and %s\n",
+								  job->GetJobName(), child->GetJobName());
 #endif 			
-				cycle = true;
+					cycle = true;
+				}
 			}
 		}
 	}
@@ -2722,11 +2819,20 @@ Dag::ParentListString( Job *node, const char delim ) const
 	const char* parent_name = NULL;
 	MyString parents_str;
 
-	set<JobID_t> &parent_list = node->GetQueueRef( Job::Q_PARENTS );
-	set<JobID_t>::const_iterator pit;
+	JobIDList &parent_list = node->GetQueueRef( Job::Q_PARENTS );
+	JobIDList::const_iterator pit;
 
 	for (pit = parent_list.begin(); pit != parent_list.end(); pit++) {
 		parent = FindNodeByNodeID( *pit );
+		if ( parent->GetJoin() ) {
+				// List the nodes the join node stands in for.
+			MyString join_parents = ParentListString( parent, delim );
+			if( ! parents_str.IsEmpty() && ! join_parents.IsEmpty() ) {
+				parents_str += delim;
+			}
+			parents_str += join_parents;
+			continue;
+		}
 		parent_name = parent->GetJobName();
 		ASSERT( parent_name );
 		if( ! parents_str.IsEmpty() ) {
@@ -3407,27 +3513,38 @@ void
 Dag::DumpDotFileArcs(FILE *temp_dot_file)
 {
 	Job                          *parent;
-	ListIterator <Job>           joblist (_jobs);
-
-	joblist.ToBeforeFirst();	
-	while (joblist.Next(parent)) {
-		Job        *child;
-		SimpleListIterator <JobID_t> child_list;
-		const char                   *parent_name;
-		const char                   *child_name;
+	ListIterator <Job>           joinlist (_joinNodes);
+
+		// Join nodes are drawn as points, so that a PARENT ... CHILD ...
+		// statement with many nodes on both sides doesn't turn into
+		// one arc per (parent, child) pair.
+	joinlist.ToBeforeFirst();
+	while (joinlist.Next(parent)) {
+		fprintf(temp_dot_file, "    \"%s\" [shape=point];\n",
+				parent->GetJobName());
+	}
+
+	for (int pass = 0; pass < 2; pass++) {
+		ListIterator <Job> joblist (pass == 0 ? _jobs : _joinNodes);
+		joblist.ToBeforeFirst();
+		while (joblist.Next(parent)) {
+			Job                          *child;
+			const char                   *parent_name;
+			const char                   *child_name;
 		
-		parent_name = parent->GetJobName();
+			parent_name = parent->GetJobName();
 
-		set<JobID_t> &cset = parent->GetQueueRef(Job::Q_CHILDREN);
-		set<JobID_t>::const_iterator cit;
+			JobIDList &cset = parent->GetQueueRef(Job::Q_CHILDREN);
+			JobIDList::const_iterator cit;
 
-		for (cit = cset.begin(); cit != cset.end(); cit++) {
-			child = FindNodeByNodeID( *cit );
+			for (cit = cset.begin(); cit != cset.end(); cit++) {
+				child = FindNodeByNodeID( *cit );
 			
-			child_name  = child->GetJobName();
-			if (parent_name != NULL && child_name != NULL) {
-				fprintf(temp_dot_file, "    \"%s\" -> \"%s\";\n",
-						parent_name, child_name);
+				child_name  = child->GetJobName();
+				if (parent_name != NULL && child_name != NULL) {
+					fprintf(temp_dot_file, "    \"%s\" -> \"%s\";\n",
+							parent_name, child_name);
+				}
 			}
 		}
 	}
@@ -3979,7 +4096,8 @@ priority_swapper::~priority_swapper()
 }
 
 Dag::submit_result_t
-Dag::SubmitNodeJob( const Dagman &dm, Job *node, CondorID &condorID )
+Dag::SubmitNodeJob( const Dagman &dm, Job *node, CondorID &condorID,
+			CondorSubmitBatch *batch )
 {
 	submit_result_t result = SUBMIT_RESULT_NO_SUBMIT;
 
@@ -4068,6 +4186,18 @@ Dag::SubmitNodeJob( const Dagman &dm, Job *node, CondorID &condorID )
 					// to condor_submit(), fixes a memory leak(!).
 					// wenger 2008-12-18
 				MyString parents = ParentListString( node );
+				if ( batch ) {
+					if ( batch->Add( dm, node->GetCmdFile(),
+								node->GetJobName(), parents,
+								node->varsFromDag, node->GetRetries(),
+								node->GetDirectory(), logFile,
+								ProhibitMultiJobs(),
+								node->NumChildren() > 0 &&
+								dm._claim_hold_time > 0 ) ) {
+						return SUBMIT_RESULT_BATCHED;
+					}
+					return SUBMIT_RESULT_FAILED;
+				}
       			submit_success = condor_submit( dm, node->GetCmdFile(), condorID,
 							node->GetJobName(), parents,
 							node->varsFromDag, node->GetRetries(),
@@ -4099,6 +4229,51 @@ Dag::SubmitNodeJob( const Dagman &dm, Job *node, CondorID &condorID )
 	return result;
 }
 
+//---------------------------------------------------------------------------
+bool
+Dag::CanBatchSubmit( Job *node ) const
+{
+	return node->JobType() == Job::TYPE_CONDOR && !node->GetNoop();
+}
+
+//---------------------------------------------------------------------------
+int
+Dag::SubmitBatchedJobs( const Dagman &dm, CondorSubmitBatch &batch,
+			std::vector<Job*> &nodes )
+{
+	if ( nodes.empty() ) {
+		return 0;
+	}
+	ASSERT( batch.Count() == (int)nodes.size() );
+
+	MyString batchFile = dm.primaryDagFile + ".submit_batch";
+	batch.Submit( dm, batchFile.Value() );
+
+	for ( size_t i = 0; i < nodes.size(); i++ ) {
+		UpdateJobCounts( nodes[i], -1 );
+		if ( batch.Succeeded( i ) ) {
+			ProcessSuccessfulSubmit( nodes[i], batch.GetCondorID( i ) );
+		}
+	}
+
+		// Failures are handled after all of the successes, and all of
+		// them together count as one failed submit attempt as far as
+		// the submit back-off is concerned.
+	int submitDelay = _nextSubmitDelay;
+	int numFailed = 0;
+	for ( size_t i = 0; i < nodes.size(); i++ ) {
+		if ( !batch.Succeeded( i ) ) {
+			_nextSubmitDelay = submitDelay;
+			ProcessFailedSubmit( nodes[i], dm.max_submit_attempts );
+			numFailed++;
+		}
+	}
+
+	batch.Clear();
+	nodes.clear();
+	return numFailed;
+}
+
 //---------------------------------------------------------------------------
 void
 Dag::ProcessSuccessfulSubmit( Job *node, const CondorID &condorID )
@@ -4388,8 +4563,16 @@ Dag::RelinquishNodeOwnership(void)
 		_jobs.DeleteCurrent();
 	}
 
+	// 2. Copy the join nodes
+	ExtArray<Job*> *joinNodes = new ExtArray<Job*>();
+	_joinNodes.Rewind();
+	while( (job = _joinNodes.Next()) ) {
+		joinNodes->add(job);
+		_joinNodes.DeleteCurrent();
+	}
+
 	// shove it into a packet and give it back
-	return new OwnedMaterials(nodes, &_catThrottles, _reject,
+	return new OwnedMaterials(nodes, joinNodes, &_catThrottles, _reject,
 				_firstRejectLoc);
 }
 
@@ -4546,6 +4729,18 @@ Dag::AssumeOwnershipofNodes(const MyString &spliceName, OwnedMaterials *om)
 		}
 	}
 
+	// 3a. Take the join nodes, too; they only need to be found by id.
+	ExtArray<Job*> *joinNodes = om->joinNodes;
+	for (i = 0; i < joinNodes->length(); i++) {
+		_joinNodes.Append((*joinNodes)[i]);
+		key_id = (*joinNodes)[i]->GetJobID();
+		if (_nodeIDHash.insert(key_id, (*joinNodes)[i]) != 0) {
+			debug_error(1, DEBUG_QUIET, 
+				"Found job id collision while taking ownership of join "
+				"node: %s\n", (*joinNodes)[i]->GetJobName());
+		}
+	}
+
 	// 4. Copy any reject info from the splice.
 	if ( om->_reject ) {
 		SetReject( om->_firstRejectLoc );
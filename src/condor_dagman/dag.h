@@ -37,6 +37,7 @@
 #include "MyString.h"
 #include "dagman_recursive_submit.h"
 #include "jobstate_log.h"
+#include <vector>
 
 // NOTE: must be kept in sync with Job::job_type_t
 enum Log_source{
@@ -53,6 +54,7 @@ enum SpliceLayer {
 class Dagman;
 class MyString;
 class DagmanMetrics;
+class CondorSubmitBatch;
 
 // used for RelinquishNodeOwnership and AssumeOwnershipofNodes
 // This class owns the containers with which it was constructed, but
@@ -65,16 +67,19 @@ class OwnedMaterials
 	public:
 		// this structure owns the containers passed to it, but not the memory 
 		// contained in the containers...
-		OwnedMaterials(ExtArray<Job*> *a, ThrottleByCategory *tr,
+		OwnedMaterials(ExtArray<Job*> *a, ExtArray<Job*> *j,
+				ThrottleByCategory *tr,
 				bool reject, MyString firstRejectLoc ) :
-				nodes (a), throttles (tr), _reject(reject),
+				nodes (a), joinNodes (j), throttles (tr), _reject(reject),
 				_firstRejectLoc(firstRejectLoc) {};
 		~OwnedMaterials() 
 		{
 			delete nodes;
+			delete joinNodes;
 		};
 
 	ExtArray<Job*> *nodes;
+	ExtArray<Job*> *joinNodes;
 	ThrottleByCategory *throttles;
 	bool _reject;
 	MyString _firstRejectLoc;
@@ -183,6 +188,16 @@ class Dag {
         @return true: successful, false: failure
     */
     bool AddDependency (Job * parent, Job * child);
+
+    /** Create a join node, to be made the child of each parent and the
+        parent of each child of a PARENT ... CHILD ... statement with
+        many nodes on both sides.  That takes one edge per node in the
+        statement rather than one per (parent, child) pair.  The join
+        node is never run or counted as a node of the DAG; it is marked
+        done as soon as all of its parents are.
+        @return the new join node (owned by this Dag)
+    */
+    Job * AddJoinNode();
   
     /** Blocks until the Condor Log file grows.
         @return true: log file grew, false: timeout or shrinkage
@@ -192,6 +207,32 @@ class Dag {
     bool DetectCondorLogGrowth();
     bool DetectDaPLogGrowth();            //<--DAP
 
+		/** Ask to be notified when a node job's log is written to,
+			so that new events can be read without waiting for the
+			next log scan (see ReadMultipleUserLogs).
+			@return true if notification is available
+		*/
+	bool EnableCondorLogNotification()
+				{ return _condorLogRdr.enableFileNotification(); }
+
+		/** @return the descriptor that becomes readable when a node
+			job's log is written to, or -1
+		*/
+	int CondorLogNotificationFd() const
+				{ return _condorLogRdr.fileNotificationFd(); }
+
+		/** Tell the log reader that the caller closes the descriptor
+			above now (once the Dag is gone), not the log reader.
+		*/
+	void DisownCondorLogNotificationFd()
+				{ _condorLogRdr.disownFileNotificationFd(); }
+
+		/** Clear pending log notifications.
+			@return true iff a node job's log may have grown
+		*/
+	bool DrainCondorLogNotifications()
+				{ return _condorLogRdr.drainFileNotifications(); }
+
     /** Force the Dag to process all new events in the condor log file.
         This may cause the state of some jobs to change.
 
@@ -818,6 +859,7 @@ class Dag {
 		SUBMIT_RESULT_OK,
 		SUBMIT_RESULT_FAILED,
 		SUBMIT_RESULT_NO_SUBMIT,
+		SUBMIT_RESULT_BATCHED,
 	} submit_result_t;
 
 	/** Submit the Condor or Stork job for a node, including doing
@@ -826,10 +868,27 @@ class Dag {
 		@param the appropriate Dagman object
 		@param the node for which to submit a job
 		@param reference to hold the Condor ID the job is assigned
+		@param batch if not NULL, Condor node jobs are added to this
+			batch instead of being submitted (SUBMIT_RESULT_BATCHED
+			is returned); see SubmitBatchedJobs()
 		@return submit_result_t (see above)
 	*/
 	submit_result_t SubmitNodeJob( const Dagman &dm, Job *node,
-				CondorID &condorID );
+				CondorID &condorID, CondorSubmitBatch *batch = NULL );
+
+	/** Whether SubmitNodeJob() would add this node's job to a batch.
+	*/
+	bool CanBatchSubmit( Job *node ) const;
+
+	/** Submit the node jobs collected in a batch by SubmitNodeJob(),
+		and do the post-processing of each submit.
+		@param the appropriate Dagman object
+		@param the batch of node jobs
+		@param the nodes, in the order they were added to the batch
+		@return the number of node jobs whose submit failed
+	*/
+	int SubmitBatchedJobs( const Dagman &dm, CondorSubmitBatch &batch,
+				std::vector<Job*> &nodes );
 
 	/** Do the post-processing of a successful submit of a Condor or
 		Stork job.
@@ -954,6 +1013,13 @@ class Dag {
 	void WriteNodeToRescue( FILE *fp, Job *node,
 				bool reset_retries_upon_rescue, bool isPartial );
 
+		/** Write the names of the given nodes to a rescue DAG, each
+			preceded by a space.
+			@param fp: the file to write to
+			@param nodes: the IDs of the nodes to write
+		*/
+	void WriteNodeList( FILE *fp, const JobIDList &nodes ) const;
+
 		// True iff the final node is ready to be run, is running,
 		// or has been run (including PRE and POST scripts, if any).
 	bool _finalNodeRun;
@@ -971,6 +1037,9 @@ protected:
     /// List of Job objects
     List<Job>     _jobs;
 
+    /// Join nodes (see AddJoinNode()); these are not in _jobs
+    List<Job>     _joinNodes;
+
 private:
 		// Note: the final node is in the _jobs list; this pointer is just
 		// for convenience.
@@ -111,7 +111,11 @@ Dagman::Dagman() :
 	submit_delay (0),
 	max_submit_attempts (6),
 	max_submits_per_interval (5), // so Coverity is happy
+	_batchSubmit (true),
 	m_user_log_scan_interval (5),
+	m_use_inotify (true),
+	m_event_timer_id (-1),
+	m_log_notify_pipe (-1),
 	primaryDagFile (""),
 	multiDags (false),
 	startup_cycle_detect (false), // so Coverity is happy
@@ -229,12 +233,20 @@ Dagman::Config()
 	debug_printf( DEBUG_NORMAL, "DAGMAN_MAX_SUBMITS_PER_INTERVAL setting: %d\n",
 				max_submits_per_interval );
 
+	_batchSubmit = param_boolean( "DAGMAN_BATCH_SUBMIT", _batchSubmit );
+	debug_printf( DEBUG_NORMAL, "DAGMAN_BATCH_SUBMIT setting: %s\n",
+				_batchSubmit ? "True" : "False" );
+
 	m_user_log_scan_interval =
 		param_integer( "DAGMAN_USER_LOG_SCAN_INTERVAL",
 		m_user_log_scan_interval, 1, INT_MAX);
 	debug_printf( DEBUG_NORMAL, "DAGMAN_USER_LOG_SCAN_INTERVAL setting: %d\n",
 				m_user_log_scan_interval );
 
+	m_use_inotify = param_boolean( "DAGMAN_USE_INOTIFY", m_use_inotify );
+	debug_printf( DEBUG_NORMAL, "DAGMAN_USE_INOTIFY setting: %s\n",
+				m_use_inotify ? "True" : "False" );
+
 	_defaultPriority = param_integer("DAGMAN_DEFAULT_PRIORITY", 0, INT_MIN,
 		INT_MAX, false);
 	debug_printf( DEBUG_NORMAL, "DAGMAN_DEFAULT_PRIORITY setting: %d\n",
@@ -572,6 +584,7 @@ void ExitSuccess() {
 }
 
 void condor_event_timer();
+int condor_log_notify_handler( Service *, int );
 
 /****** FOR TESTING *******
 int main_testing_stub( Service *, int ) {
@@ -1242,9 +1255,41 @@ void main_init (int argc, char ** const argv) {
     }
 
     debug_printf( DEBUG_VERBOSE, "Registering condor_event_timer...\n" );
-    daemonCore->Register_Timer( 1, dagman.m_user_log_scan_interval, 
+    dagman.m_event_timer_id = daemonCore->Register_Timer( 1,
+				dagman.m_user_log_scan_interval,
 				condor_event_timer, "condor_event_timer" );
 
+	if ( dagman.m_use_inotify ) {
+		if ( dagman.dag->EnableCondorLogNotification() ) {
+				// Let DaemonCore select on the inotify descriptor.
+			int pipe_end = daemonCore->Inherit_Pipe(
+						dagman.dag->CondorLogNotificationFd(),
+						false, true, true );
+			if ( pipe_end != -1 ) {
+					// from here on, it gets closed through DaemonCore,
+					// in Dagman::CleanUp()
+				dagman.dag->DisownCondorLogNotificationFd();
+				dagman.m_log_notify_pipe = pipe_end;
+			}
+			if ( pipe_end == -1 || daemonCore->Register_Pipe( pipe_end,
+						"node job log notification",
+						(PipeHandler)&condor_log_notify_handler,
+						"condor_log_notify_handler" ) == -1 ) {
+				debug_printf( DEBUG_NORMAL, "Warning: failed to register "
+							"node job log notification; falling back to "
+							"scanning logs every %d seconds\n",
+							dagman.m_user_log_scan_interval );
+			} else {
+				debug_printf( DEBUG_VERBOSE, "Using inotify to detect "
+							"node job log changes\n" );
+			}
+		} else {
+			debug_printf( DEBUG_NORMAL, "inotify not available; "
+						"scanning logs every %d seconds\n",
+						dagman.m_user_log_scan_interval );
+		}
+	}
+
 	dagman.dag->SetPendingNodeReportInterval(
 				dagman.pendingReportInterval );
 }
@@ -1398,6 +1443,17 @@ print_status() {
 	}
 }
 
+// Called when a node job's log has been written to: rather than waiting
+// for the next log scan, run condor_event_timer() right away (resetting
+// the timer lets a burst of writes coalesce into one scan).
+int condor_log_notify_handler( Service *, int ) {
+	if ( dagman.dag->DrainCondorLogNotifications() ) {
+		daemonCore->Reset_Timer( dagman.m_event_timer_id, 0,
+					dagman.m_user_log_scan_interval );
+	}
+	return TRUE;
+}
+
 void condor_event_timer () {
 
 	ASSERT( dagman.dag != NULL );
@@ -1437,6 +1493,7 @@ void condor_event_timer () {
 
 	// If the log has grown
 	if( dagman.dag->DetectCondorLogGrowth() ) {
+		int prevReady = dagman.dag->NumNodesReady();
 		if( dagman.dag->ProcessLogEvents( CONDORLOG ) == false ) {
 			debug_printf( DEBUG_NORMAL,
 						"ProcessLogEvents(CONDORLOG) returned false\n" );
@@ -1444,6 +1501,15 @@ void condor_event_timer () {
 			main_shutdown_rescue( EXIT_ERROR, Dag::DAG_STATUS_ERROR );
 			return;
 		}
+
+			// When log notification is in use, don't make the nodes
+			// that just became ready wait a whole scan interval to be
+			// submitted.
+		if( dagman.dag->CondorLogNotificationFd() >= 0 &&
+					dagman.dag->NumNodesReady() > prevReady ) {
+			daemonCore->Reset_Timer( dagman.m_event_timer_id, 0,
+						dagman.m_user_log_scan_interval );
+		}
 	}
 
 	if( dagman.dag->DetectDaPLogGrowth() ) {
@@ -45,6 +45,13 @@ class Dagman {
 		if ( dag != NULL ) {
 			delete dag; 
 			dag = NULL;
+		}
+			// after the Dag, whose log reader still watches through it
+		if ( m_log_notify_pipe != -1 ) {
+			if ( daemonCore ) {
+				daemonCore->Close_Pipe( m_log_notify_pipe );
+			}
+			m_log_notify_pipe = -1;
 		}
 		delete _dagmanClassad;
 		_dagmanClassad = NULL;
@@ -83,6 +90,9 @@ class Dagman {
 		// maximum number of jobs to submit in a single periodic timer
 		// interval
     int max_submits_per_interval;
+		// whether to submit the node jobs of each submit interval
+		// with a single condor_submit (one schedd transaction)
+	bool _batchSubmit;
 
 		// How long dagman waits before checking the log files to see if
 		// some events happened. With very short running jobs in a linear
@@ -91,6 +101,19 @@ class Dagman {
 		// configure that to be much faster with a minimum of 1 second.
 	int m_user_log_scan_interval;
 
+		// Whether to use inotify (Linux only) to wake up as soon as a
+		// node job's log is written to, rather than waiting for the
+		// next log scan; the log scan is still done as a fallback.
+	bool m_use_inotify;
+
+		// ID of the condor_event_timer, so that we can run it right
+		// away when a log changes.
+	int m_event_timer_id;
+
+		// DaemonCore pipe end for the node job log notification
+		// descriptor, or -1; we close it, see CleanUp().
+	int m_log_notify_pipe;
+
 		// "Primary" DAG file -- if we have multiple DAG files this is
 		// the first one.  The lock file name, rescue DAG name, etc., 
 		// are based on this name.
@@ -243,22 +243,19 @@ do_submit( ArgList &args, CondorID &condorID, Job::job_type_t jobType,
 }
 
 //-------------------------------------------------------------------------
-bool
-condor_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
-			   const char* DAGNodeName, MyString &DAGParentNodeNames,
-			   List<Job::NodeVar> *vars, int retry,
-			   const char* directory, const char *workflowLogFile,
-			   bool prohibitMultiJobs, bool hold_claim )
+/** Append the condor_submit arguments for a node job (everything that
+	follows the name of the condor_submit executable) to args.  Must be
+	called from the node's directory.  See condor_submit() in submit.h
+	for the other parameters.
+	@return true on success, false on failure
+*/
+static bool
+append_condor_submit_args( ArgList &args, const Dagman &dm,
+			const char* cmdFile, const char* DAGNodeName,
+			MyString &DAGParentNodeNames, List<Job::NodeVar> *vars,
+			int retry, const char* directory, const char *workflowLogFile,
+			bool prohibitMultiJobs, bool hold_claim )
 {
-	TmpDir		tmpDir;
-	MyString	errMsg;
-	if ( !tmpDir.Cd2TmpDir( directory, errMsg ) ) {
-		debug_printf( DEBUG_QUIET,
-				"Could not change to node directory %s: %s\n",
-				directory, errMsg.Value() );
-		return false;
-	}
-
 	if ( prohibitMultiJobs ) {
 		MyString	errorMsg;
 		int queueCount = MultiLogFiles::getQueueCountFromSubmitFile(
@@ -285,8 +282,6 @@ condor_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
 		}
 	}
 
-	ArgList args;
-
 	// construct arguments to condor_submit to add attributes to the
 	// job classad which identify the job's node name in the DAG, the
 	// node names of its parents in the DAG, and the job ID of DAGMan
@@ -300,8 +295,6 @@ condor_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
 	// submit many DAGs to the same schedd, all the ready jobs from
 	// one DAG complete before any jobs from another begin.
 
-	args.AppendArg( dm.condorSubmitExe );
-
 	args.AppendArg( "-a" );
 	MyString nodeName = MyString(ATTR_DAG_NODE_NAME_ALT) + " = " + DAGNodeName;
 	args.AppendArg( nodeName.Value() );
@@ -435,6 +428,30 @@ condor_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
 
 	args.AppendArg( cmdFile );
 
+	return true;
+}
+
+//-------------------------------------------------------------------------
+/** Run condor_submit with the given node arguments (as built by
+	append_condor_submit_args()) in the given directory.
+*/
+static bool
+run_condor_submit( const Dagman &dm, ArgList &nodeArgs, CondorID &condorID,
+			const char* directory )
+{
+	TmpDir		tmpDir;
+	MyString	errMsg;
+	if ( !tmpDir.Cd2TmpDir( directory, errMsg ) ) {
+		debug_printf( DEBUG_QUIET,
+				"Could not change to node directory %s: %s\n",
+				directory, errMsg.Value() );
+		return false;
+	}
+
+	ArgList args;
+	args.AppendArg( dm.condorSubmitExe );
+	args.AppendArgsFromArgList( nodeArgs );
+
 	bool success = do_submit( args, condorID, Job::TYPE_CONDOR,
 				dm.prohibitMultiJobs );
 
@@ -448,6 +465,252 @@ condor_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
 	return success;
 }
 
+//-------------------------------------------------------------------------
+/** Build the condor_submit arguments for a node job from its node
+	directory.
+*/
+static bool
+get_condor_submit_args( ArgList &args, const Dagman &dm,
+			const char* cmdFile, const char* DAGNodeName,
+			MyString &DAGParentNodeNames, List<Job::NodeVar> *vars,
+			int retry, const char* directory, const char *workflowLogFile,
+			bool prohibitMultiJobs, bool hold_claim )
+{
+	TmpDir		tmpDir;
+	MyString	errMsg;
+	if ( !tmpDir.Cd2TmpDir( directory, errMsg ) ) {
+		debug_printf( DEBUG_QUIET,
+				"Could not change to node directory %s: %s\n",
+				directory, errMsg.Value() );
+		return false;
+	}
+
+	bool success = append_condor_submit_args( args, dm, cmdFile,
+				DAGNodeName, DAGParentNodeNames, vars, retry, directory,
+				workflowLogFile, prohibitMultiJobs, hold_claim );
+
+	if ( !tmpDir.Cd2MainDir( errMsg ) ) {
+		debug_printf( DEBUG_QUIET,
+				"Could not change to original directory: %s\n",
+				errMsg.Value() );
+		success = false;
+	}
+
+	return success;
+}
+
+//-------------------------------------------------------------------------
+bool
+condor_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
+			   const char* DAGNodeName, MyString &DAGParentNodeNames,
+			   List<Job::NodeVar> *vars, int retry,
+			   const char* directory, const char *workflowLogFile,
+			   bool prohibitMultiJobs, bool hold_claim )
+{
+	ArgList nodeArgs;
+	if ( !get_condor_submit_args( nodeArgs, dm, cmdFile, DAGNodeName,
+				DAGParentNodeNames, vars, retry, directory, workflowLogFile,
+				prohibitMultiJobs, hold_claim ) ) {
+		return false;
+	}
+
+	return run_condor_submit( dm, nodeArgs, condorID, directory );
+}
+
+//-------------------------------------------------------------------------
+CondorSubmitBatch::~CondorSubmitBatch()
+{
+	Clear();
+}
+
+//-------------------------------------------------------------------------
+void
+CondorSubmitBatch::Clear()
+{
+	for ( size_t i = 0; i < _entries.size(); i++ ) {
+		delete _entries[i];
+	}
+	_entries.clear();
+}
+
+//-------------------------------------------------------------------------
+bool
+CondorSubmitBatch::Add( const Dagman &dm, const char* cmdFile,
+			const char* DAGNodeName, MyString &DAGParentNodeNames,
+			List<Job::NodeVar> *vars, int retry, const char* directory,
+			const char *workflowLogFile, bool prohibitMultiJobs,
+			bool hold_claim )
+{
+	Entry *entry = new Entry;
+	entry->directory = directory ? directory : "";
+	entry->success = false;
+	entry->condorID = CondorID( 0, 0, 0 );
+	if ( !get_condor_submit_args( entry->args, dm, cmdFile, DAGNodeName,
+				DAGParentNodeNames, vars, retry, directory, workflowLogFile,
+				prohibitMultiJobs, hold_claim ) ) {
+		delete entry;
+		return false;
+	}
+	_entries.push_back( entry );
+	return true;
+}
+
+//-------------------------------------------------------------------------
+bool
+CondorSubmitBatch::Succeeded( int index ) const
+{
+	ASSERT( index >= 0 && index < Count() );
+	return _entries[index]->success;
+}
+
+//-------------------------------------------------------------------------
+const CondorID &
+CondorSubmitBatch::GetCondorID( int index ) const
+{
+	ASSERT( index >= 0 && index < Count() );
+	return _entries[index]->condorID;
+}
+
+//-------------------------------------------------------------------------
+void
+CondorSubmitBatch::Submit( const Dagman &dm, const char *batchFile )
+{
+	if ( Count() > 1 && SubmitAll( dm, batchFile ) ) {
+		return;
+	}
+
+		// Entries the batch reported a cluster for are in the queue
+		// already; submitting them again would run their nodes twice.
+	int remaining = 0;
+	for ( size_t i = 0; i < _entries.size(); i++ ) {
+		if ( !_entries[i]->success ) {
+			remaining++;
+		}
+	}
+	if ( Count() > 1 && remaining > 0 ) {
+		debug_printf( DEBUG_NORMAL, "Batch submit failed; submitting the "
+					"%d of %d node jobs it did not submit one at a time\n",
+					remaining, Count() );
+	}
+	for ( size_t i = 0; i < _entries.size(); i++ ) {
+		Entry *entry = _entries[i];
+		if ( entry->success ) {
+			continue;
+		}
+		entry->success = run_condor_submit( dm, entry->args,
+					entry->condorID, entry->directory.Value() );
+	}
+}
+
+//-------------------------------------------------------------------------
+/** Submit every entry with one condor_submit -batch, which puts all of
+	the jobs into the queue in a single transaction.  Each entry becomes
+	one line of the batch file: the node directory followed by the
+	entry's condor_submit arguments.  condor_submit reports each entry's
+	cluster on a line of the form "<entry>: N job(s) submitted to cluster
+	M." once the transaction is committed.  Every entry reported that
+	way is marked as submitted, even if condor_submit fails afterwards.
+	@return true iff every entry was submitted
+*/
+bool
+CondorSubmitBatch::SubmitAll( const Dagman &dm, const char *batchFile )
+{
+	FILE *fp = safe_fopen_wrapper_follow( batchFile, "w" );
+	if ( fp == NULL ) {
+		debug_printf( DEBUG_NORMAL, "Could not open batch submit file %s: "
+					"%s\n", batchFile, strerror( errno ) );
+		return false;
+	}
+	bool wrote = true;
+	for ( size_t i = 0; wrote && i < _entries.size(); i++ ) {
+		ArgList line;
+		line.AppendArg( _entries[i]->directory.Value() );
+		line.AppendArgsFromArgList( _entries[i]->args );
+		MyString lineStr;
+		MyString errMsg;
+			// An argument containing a newline can't be sent in the
+			// line-oriented batch file.
+		if ( !line.GetArgsStringV2Raw( &lineStr, &errMsg ) ||
+					lineStr.FindChar( '\n' ) >= 0 ) {
+			debug_printf( DEBUG_NORMAL, "Cannot batch submit arguments "
+						"for node job %d: %s\n", (int)i, errMsg.Value() );
+			wrote = false;
+		} else if ( fprintf( fp, "%s\n", lineStr.Value() ) < 0 ) {
+			wrote = false;
+		}
+	}
+	if ( fclose( fp ) != 0 || !wrote ) {
+		unlink( batchFile );
+		return false;
+	}
+
+	ArgList args;
+	args.AppendArg( dm.condorSubmitExe );
+	args.AppendArg( "-batch" );
+	args.AppendArg( batchFile );
+	MyString cmd;
+	args.GetArgsStringForDisplay( &cmd );
+	debug_printf( DEBUG_VERBOSE, "submitting: %s (%d node jobs)\n",
+				cmd.Value(), Count() );
+
+	fp = my_popen( args, "r", TRUE );
+	if ( fp == NULL ) {
+		debug_printf( DEBUG_NORMAL,
+					"ERROR: my_popen(%s) in SubmitAll() failed!\n",
+					cmd.Value() );
+		unlink( batchFile );
+		return false;
+	}
+
+	std::vector<int> clusters( _entries.size(), -1 );
+	std::vector<int> procCounts( _entries.size(), 0 );
+	char buffer[UTIL_MAX_LINE_LENGTH];
+	while ( fgets( buffer, UTIL_MAX_LINE_LENGTH, fp ) ) {
+		MyString buf_line = buffer;
+		buf_line.chomp();
+		debug_printf( DEBUG_VERBOSE, "From submit: %s\n", buf_line.Value() );
+		int entry, jobProcCount, cluster;
+		if ( 3 == sscanf( buffer, " %d: %d job(s) submitted to cluster %d",
+					&entry, &jobProcCount, &cluster ) &&
+					entry >= 0 && entry < Count() ) {
+			clusters[entry] = cluster;
+			procCounts[entry] = jobProcCount;
+		}
+	}
+	int status = my_pclose( fp );
+	unlink( batchFile );
+
+	bool all_submitted = true;
+	for ( size_t i = 0; i < _entries.size(); i++ ) {
+		Entry *entry = _entries[i];
+		if ( clusters[i] < 0 ) {
+			debug_printf( DEBUG_NORMAL, "ERROR: batch submit output did not "
+						"include a cluster for node job %d\n", (int)i );
+			all_submitted = false;
+			continue;
+		}
+		entry->condorID._cluster = clusters[i];
+		entry->success = true;
+
+			// Check for multiple job procs if configured to disallow that.
+		if ( dm.prohibitMultiJobs && procCounts[i] > 1 ) {
+			debug_printf( DEBUG_NORMAL, "Submit generated %d job procs; "
+						"disallowed by DAGMAN_PROHIBIT_MULTI_JOBS setting\n",
+						procCounts[i] );
+			main_shutdown_rescue( EXIT_ERROR, Dag::DAG_STATUS_ERROR );
+		}
+	}
+
+	if ( status != 0 ) {
+		debug_printf( DEBUG_NORMAL, "ERROR while running \"%s\": "
+					"condor_submit exited with status %d\n",
+					cmd.Value(), status );
+		all_submitted = false;
+	}
+
+	return all_submitted;
+}
+
 //-------------------------------------------------------------------------
 bool
 stork_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
@@ -27,7 +27,7 @@
 #include "throttle_by_category.h"
 #include "dag.h"
 #include "dagman_metrics.h"
-#include <set>
+#include <algorithm>
 
 static const char *JOB_TAG_NAME = "+job_tag_name";
 static const char *PEGASUS_SITE = "+pegasus_site";
@@ -94,7 +94,8 @@ Job::~Job() {
 //---------------------------------------------------------------------------
 Job::Job( const job_type_t jobType, const char* jobName,
 			const char *directory, const char* cmdFile ) :
-	_jobType( jobType ), _preskip( PRE_SKIP_INVALID ), _final( false )
+	_jobType( jobType ), _preskip( PRE_SKIP_INVALID ), _final( false ),
+	_join( false )
 {
 	ASSERT( jobName != NULL );
 	ASSERT( cmdFile != NULL );
@@ -187,10 +188,13 @@ Job::PrefixDirectory(MyString &prefix)
 //---------------------------------------------------------------------------
 bool Job::Remove (const queue_t queue, const JobID_t jobID)
 {
-	if (_queues[queue].erase(jobID) == 0) {
+	JobIDList &q = _queues[queue];
+	JobIDList::iterator it = std::lower_bound( q.begin(), q.end(), jobID );
+	if ( it == q.end() || *it != jobID ) {
 		return false; // element not found
 	}
 
+	q.erase( it );
 	return true;
 }  
 
@@ -237,7 +241,7 @@ void Job::Dump ( const Dag *dag ) const {
     for (int i = 0 ; i < 3 ; i++) {
         dprintf( D_ALWAYS, "%15s: ", queue_t_names[i] );
 
-		std::set<JobID_t>::const_iterator qit;
+		JobIDList::const_iterator qit;
 		for (qit = _queues[i].begin(); qit != _queues[i].end(); qit++) {
 			Job *node = dag->Dag::FindNodeByNodeID( *qit );
 			dprintf( D_ALWAYS | D_NOHEADER, "%s, ", node->GetJobName() );
@@ -479,17 +483,19 @@ Job::TerminateFailure()
 bool
 Job::Add( const queue_t queue, const JobID_t jobID )
 {
-	std::pair<std::set<JobID_t>::iterator, bool> ret;
+	JobIDList &q = _queues[queue];
 
-	ret = _queues[queue].insert(jobID);
-
-	if (ret.second == false) {
+		// IDs are handed out in increasing order, so a DAG file
+		// usually gives us each list in order and this is an append.
+	JobIDList::iterator it = std::lower_bound( q.begin(), q.end(), jobID );
+	if ( it != q.end() && *it == jobID ) {
 		dprintf( D_ALWAYS,
 				 "ERROR: can't add Job ID %d to DAG: already present!",
 				 jobID );
 		return false;
 	}
 
+	q.insert( it, jobID );
 	return true;
 }
 
@@ -576,40 +582,22 @@ Job::GetStatusName() const
 
 bool
 Job::HasChild( Job* child ) {
-	JobID_t cid;
-	std::set<JobID_t>::iterator it;
-
 	if( !child ) {
 		return false;
 	}
 
-	cid = child->GetJobID();
-	it = _queues[Q_CHILDREN].find(cid);
-
-	if (it == _queues[Q_CHILDREN].end()) {
-		return false;
-	}
-
-	return true;
+	return std::binary_search( _queues[Q_CHILDREN].begin(),
+				_queues[Q_CHILDREN].end(), child->GetJobID() );
 }
 
 bool
 Job::HasParent( Job* parent ) {
-	JobID_t pid;
-	std::set<JobID_t>::iterator it;
-
 	if( !parent ) {
 		return false;
 	}
 
-	pid = parent->GetJobID();
-	it = _queues[Q_PARENTS].find(pid);
-
-	if (it == _queues[Q_PARENTS].end()) {
-		return false;
-	}
-
-	return true;
+	return std::binary_search( _queues[Q_PARENTS].begin(),
+				_queues[Q_PARENTS].end(), parent->GetJobID() );
 }
 
 
@@ -660,7 +648,7 @@ Job::RemoveDependency( queue_t queue, JobID_t job )
 bool
 Job::RemoveDependency( queue_t queue, JobID_t job, MyString &whynot )
 {
-	if (_queues[queue].erase(job) == 0)
+	if ( !Remove( queue, job ) )
 	{
 		whynot = "no such dependency";
 		return false;
@@ -984,11 +972,15 @@ Job::GetPreSkip() const
 
 // DAGman fixes the default priorities in Dag::SetDefaultPriorities
 
+// A join node has no priority of its own; it picks up the priorities of
+// the nodes it joins once, when it completes (see Dag::TerminateJob()),
+// and its children just read that.
+
 void
 Job::FixPriority(Dag& dag)
 {
-	std::set<JobID_t> parents = GetQueueRef(Q_PARENTS);
-	for(std::set<JobID_t>::iterator p = parents.begin(); p != parents.end(); ++p){
+	JobIDList &parents = GetQueueRef(Q_PARENTS);
+	for(JobIDList::iterator p = parents.begin(); p != parents.end(); ++p){
 		Job* parent = dag.FindNodeByNodeID(*p);
 		if( parent->_hasNodePriority ) {
 			// Nothing to do if parent priority is small
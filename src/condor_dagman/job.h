@@ -30,7 +30,7 @@
 #include "throttle_by_category.h"
 #include "read_multiple_logs.h"
 #include "CondorError.h"
-#include <set>
+#include <vector>
 
 class ThrottleByCategory;
 class Dag;
@@ -46,6 +46,11 @@ class DagmanMetrics;
 
 typedef int JobID_t;
 
+	// A list of node IDs, kept sorted so that lookups are a binary
+	// search.  This costs one JobID_t per edge, where a std::set costs
+	// a whole tree node, which matters for DAGs with millions of edges.
+typedef std::vector<JobID_t> JobIDList;
+
 /**  The job class represents a job in the DAG and its state in the Condor
      system.  A job is given a name, a CondorID, and three queues.  The
      parents queue is a list of parent jobs that this one depends on.  That
@@ -189,12 +194,17 @@ class Job {
 	bool GetFinal() const { return _final; }
 	void SetNoop( bool value ) { _noop = value; }
 	bool GetNoop( void ) const { return _noop; }
+		// A join node is never run, and is not part of the DAG as far
+		// as the user can see (see Dag::AddJoinNode()); it just stands
+		// in for the edges of a PARENT ... CHILD ... statement.
+	void SetJoin( bool value ) { _join = value; }
+	bool GetJoin() const { return _join; }
 
 	Script * _scriptPre;
 	Script * _scriptPost;
 
     ///
-    inline std::set<JobID_t> & GetQueueRef (const queue_t queue) {
+    inline JobIDList & GetQueueRef (const queue_t queue) {
         return _queues[queue];
     }
 
@@ -602,7 +612,7 @@ private:
 		waiting -> Jobs on which the current Job is waiting for output
     */ 
 	
-	std::set<JobID_t> _queues[3];
+	JobIDList _queues[3];
 
     /*	The ID of this job.  This serves as a primary key for Jobs, where each
 		Job's ID is unique from all the rest 
@@ -639,6 +649,9 @@ private:
 		// to Condor).
 	bool _noop;
 
+		// Whether this is a join node.
+	bool _join;
+
 		// The job tag for this node ("-" if nothing is specified;
 		// can also be "local").
 	char *_jobTag;
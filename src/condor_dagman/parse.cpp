@@ -847,6 +847,47 @@ parse_parent(
 	//
 	// Now add all the dependencies
 	//
+
+		// If there are several nodes on both sides, it takes fewer
+		// edges to go through a join node than to make every child
+		// depend on every parent (for a big DAG, the difference can
+		// be gigabytes of memory).
+	int numParents = parents.Number();
+	int numChildren = children.Number();
+	if ( numParents > 1 && numChildren > 1 &&
+				numParents * (double)numChildren > numParents + numChildren ) {
+		Job *join = dag->AddJoinNode();
+		debug_printf( DEBUG_DEBUG_1, "%s (line %d): using join node %s for "
+					"%d parent(s) and %d child(ren)\n", filename, lineNumber,
+					join->GetJobName(), numParents, numChildren );
+
+		Job *node;
+		parents.Rewind();
+		while ((node = parents.Next()) != NULL) {
+			if (!dag->AddDependency (node, join)) {
+				debug_printf( DEBUG_QUIET, "ERROR: %s (line %d) failed"
+						" to add dependency for parent node \"%s\"\n",
+						filename, lineNumber, node->GetJobName() );
+				return false;
+			}
+		}
+			// If the parents are all done already (e.g., in a rescue
+			// DAG), so is the join node -- otherwise a child that is
+			// also done couldn't be given the join node as a parent.
+		if ( join->IsEmpty( Job::Q_WAITING ) ) {
+			join->SetStatus( Job::STATUS_DONE );
+		}
+		children.Rewind();
+		while ((node = children.Next()) != NULL) {
+			if (!dag->AddDependency (join, node)) {
+				debug_printf( DEBUG_QUIET, "ERROR: %s (line %d) failed"
+						" to add dependency for child node \"%s\"\n",
+						filename, lineNumber, node->GetJobName() );
+				return false;
+			}
+		}
+		return true;
+	}
 	
 	Job *parent;
 	parents.Rewind();
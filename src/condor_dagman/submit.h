@@ -22,6 +22,8 @@
 #define CONDOR_SUBMIT_H
 
 #include "condor_id.h"
+#include "condor_arglist.h"
+#include <vector>
 
 /** Submits a job to condor using popen().  This is a very primitive method
     to submitting a job, and SHOULD be replacable by a Condor Submit API.
@@ -58,6 +60,59 @@ bool condor_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
 					const char* directory, const char *worflowLogFile,
 					bool prohibitMultiJobs, bool hold_claim );
 
+/** Collects node jobs to be submitted together.  Add() takes the same
+	arguments as condor_submit() above but only prepares the submit;
+	Submit() then runs a single condor_submit -batch for all of the
+	jobs, so that the schedd connection, authentication and transaction
+	are shared by all of them.  If the batch submit fails, each job that
+	it did not report as submitted is submitted on its own as
+	condor_submit() would.
+*/
+class CondorSubmitBatch {
+public:
+	CondorSubmitBatch() {}
+	~CondorSubmitBatch();
+
+		/** @return true on success, false if the job could not be
+			prepared (it is not added in that case)
+		*/
+	bool Add( const Dagman &dm, const char* cmdFile,
+				const char* DAGNodeName, MyString &DAGParentNodeNames,
+				List<Job::NodeVar> *vars, int retry,
+				const char* directory, const char *workflowLogFile,
+				bool prohibitMultiJobs, bool hold_claim );
+
+	int Count() const { return (int)_entries.size(); }
+
+		/** Submit all of the jobs added so far.
+			@param dm the appropriate Dagman object
+			@param batchFile scratch file in which to pass the jobs to
+				condor_submit
+		*/
+	void Submit( const Dagman &dm, const char *batchFile );
+
+		/** Results of Submit() for the index'th job added. */
+	bool Succeeded( int index ) const;
+	const CondorID &GetCondorID( int index ) const;
+
+	void Clear();
+
+private:
+	bool SubmitAll( const Dagman &dm, const char *batchFile );
+
+	struct Entry {
+		MyString directory;
+		ArgList args;
+		bool success;
+		CondorID condorID;
+	};
+	std::vector<Entry *> _entries;
+
+		// not implemented
+	CondorSubmitBatch( const CondorSubmitBatch & );
+	CondorSubmitBatch &operator=( const CondorSubmitBatch & );
+};
+
 bool stork_submit( const Dagman &dm, const char* cmdFile, CondorID& condorID,
 				   const char* DAGNodeName, const char* directory );
 
@@ -32,6 +32,7 @@ void sanity_check();
 #endif /* not WIN32 */
 
 class Condor_MD_MAC;
+class Condor_Crypt_AESGCM;
 
 class Buf {
 	
@@ -82,6 +83,14 @@ public:
         bool computeMD(char * checkSUM, Condor_MD_MAC * checker);
         bool verifyMD(char * checkSUM, Condor_MD_MAC * checker);
 
+		// AES-GMAC counterparts of computeMD()/verifyMD().  The tag
+		// also covers the normal packet header, and the data starts
+		// at offset (the header is reserved at the front when sending).
+	bool computeGMAC(char * tag, const char * iv, const char * hdr, int hdr_len,
+					 int offset, Condor_Crypt_AESGCM * checker);
+	bool verifyGMAC(const char * tag, const char * iv, const char * hdr, int hdr_len,
+					Condor_Crypt_AESGCM * checker);
+
 	void swap(Buf &);
 
 private:
@@ -252,6 +252,7 @@
 #define ATTR_HAS_JOB_AD_FROM_FILE  "HasJobAdFromFile"
 #define ATTR_HAS_JOB_DEFERRAL  "HasJobDeferral"
 #define ATTR_HAS_MPI  "HasMPI"
+#define ATTR_HAS_MULTI_JOB  "HasMultiJob"
 #define ATTR_HAS_OLD_VANILLA  "HasOldVanilla"
 #define ATTR_HAS_PVM  "HasPVM"
 #define ATTR_HAS_RECONNECT  "HasReconnect"
@@ -334,6 +335,11 @@
 #define ATTR_JOB_MANAGED  "Managed"
 #define ATTR_JOB_MANAGED_MANAGER  "ManagedManager"
 #define ATTR_JOB_MATCHED  "Matched"
+#define ATTR_JOB_MATERIALIZE_ATTRS  "JobMaterializeAttrs"
+#define ATTR_JOB_MATERIALIZE_ATTR_PREFIX  "JobMaterializeAttr"
+#define ATTR_JOB_MATERIALIZE_LIMIT  "JobMaterializeLimit"
+#define ATTR_JOB_MATERIALIZE_MAX_IDLE  "JobMaterializeMaxIdle"
+#define ATTR_JOB_MATERIALIZE_NEXT_PROC_ID  "JobMaterializeNextProcId"
 #define ATTR_JOB_NONESSENTIAL  "Nonessential"
 #define ATTR_JOB_NOOP  "IsNoopJob"
 #define ATTR_JOB_NOOP_EXIT_SIGNAL  "NoopJobExitSignal"
@@ -674,6 +680,8 @@
 #define ATTR_UID_DOMAIN  "UidDomain"
 #define ATTR_ULOG_FILE  "UserLog"
 #define ATTR_ULOG_USE_XML  "UserLogUseXML"
+#define ATTR_UPDATE_DELTA_BASE_SEQUENCE  "UpdateDeltaBaseSequence"
+#define ATTR_UPDATE_DELTA_DELETED_ATTRS  "UpdateDeltaDeletedAttrs"
 #define ATTR_UPDATE_INTERVAL  "UpdateInterval"
 #define ATTR_CLASSAD_LIFETIME  "ClassAdLifetime"
 #define ATTR_UPDATE_PRIO  "UpdatePrio"
@@ -177,6 +177,8 @@ NAMETABLE_DIRECTIVE:TABLE:DCTranslation
 #define QUERY_JOB_ADS (SCHED_VERS+116)
 #define SWAP_CLAIM_AND_ACTIVATION (SCHED_VERS+117) // swap claim & activation between two STARTD resources, for moving a job into a 'transfer' slot.
 #define SEND_RESOURCE_REQUEST_LIST	(SCHED_VERS+118)     // used in negotiation protocol
+#define SHADOW_JOB_EXIT (SCHED_VERS+119) // schedd: a shadow running many jobs reports that one of them is done
+#define UPDATE_JOB_ATTRS (SCHED_VERS+120) // schedd: batch of job attribute updates from a shadow, on a connection it keeps open
 
 // values used for "HowFast" in the draining request
 #define DRAIN_GRACEFUL 0
@@ -325,6 +327,8 @@ const int QUERY_GENERIC_ADS = 74;
 const int SHARED_PORT_CONNECT = 75;
 const int SHARED_PORT_PASS_SOCK = 76;
 
+const int UPDATE_STARTD_ADS = 77;	// all of a startd's slots in one message
+
 /* these comments are used to control command_table_generator.pl
 NAMETABLE_DIRECTIVE:END_SECTION:collector
 */
@@ -143,6 +143,65 @@ typedef struct macro_set {
 	bool string_is_double_param(const char * string, double& result, ClassAd *me = NULL, ClassAd *target = NULL, const char * name=NULL, int* err_reason=NULL);
 	bool string_is_long_param(const char * string, long long& result, ClassAd *me = NULL, ClassAd *target = NULL, const char * name=NULL, int* err_reason=NULL);
 
+	// returns a number that changes every time the configuration is cleared,
+	// (re)loaded or has a value inserted, so that code that keeps the result
+	// of a param lookup around can tell when it needs to look again.
+	unsigned int param_generation();
+
+	// fills in the names and use counts of the (at most) max_names params
+	// that have been looked up most often since the configuration was loaded,
+	// most used first, and returns the number of names filled in. this is for
+	// finding the params that are worth caching with the classes below.
+	int param_most_used(int max_names, std::vector<std::string> & names, std::vector<int> & counts);
+
+	// A config value that is looked up and parsed by the usual param_*
+	// function the first time it is needed after each (re)config, and
+	// is read from memory after that. use one of these (usually a static)
+	// instead of calling param_boolean() etc. in code that runs very often,
+	// such as once per query.
+	class ParamBoolean {
+	public:
+		ParamBoolean(const char * name, bool default_value)
+			: m_name(name), m_default(default_value), m_value(default_value), m_generation(0) {}
+		bool value() { if (m_generation != param_generation()) refresh(); return m_value; }
+	private:
+		void refresh();
+		const char * m_name;
+		bool m_default;
+		bool m_value;
+		unsigned int m_generation;
+	};
+
+	class ParamInteger {
+	public:
+		ParamInteger(const char * name, int default_value, int min_value = INT_MIN, int max_value = INT_MAX)
+			: m_name(name), m_default(default_value), m_min(min_value), m_max(max_value),
+			  m_value(default_value), m_generation(0) {}
+		int value() { if (m_generation != param_generation()) refresh(); return m_value; }
+	private:
+		void refresh();
+		const char * m_name;
+		int m_default;
+		int m_min;
+		int m_max;
+		int m_value;
+		unsigned int m_generation;
+	};
+
+	// value() returns NULL if the param is not defined or is empty
+	class ParamString {
+	public:
+		ParamString(const char * name)
+			: m_name(name), m_defined(false), m_generation(0) {}
+		const char * value() { if (m_generation != param_generation()) refresh(); return m_defined ? m_value.c_str() : NULL; }
+	private:
+		void refresh();
+		const char * m_name;
+		std::string m_value;
+		bool m_defined;
+		unsigned int m_generation;
+	};
+
 #if 1
 	const char * param_get_location(const MACRO_META * pmet, MyString & value);
 #else
@@ -86,6 +86,38 @@ class Condor_Crypt_Base {
                          unsigned char *& output, 
                          int&             output_len) = 0;
 
+    virtual int pendingIVLength() { return 0; }
+    //------------------------------------------
+    // PURPOSE: Some protocols (AES-GCM) begin every stream,
+    //          i.e. everything encrypted between two calls
+    //          to resetState(), with a random IV that is sent
+    //          in the clear ahead of the first encrypted byte
+    // REQUIRE: None
+    // RETURNS: length of the IV that must be sent or received
+    //          before the next encrypt/decrypt, or 0
+    //------------------------------------------
+
+    virtual bool startStream(unsigned char * /*iv*/, bool /*encrypting*/) { return false; }
+    //------------------------------------------
+    // PURPOSE: Begin a stream. When encrypting, a new IV is
+    //          chosen and stored in iv; when decrypting, iv is
+    //          the one the peer sent
+    // REQUIRE: iv -- pendingIVLength() bytes
+    // RETURNS: true -- success; false -- failure
+    //------------------------------------------
+
+    virtual int streamTagLength() { return 0; }
+    virtual bool finishStream(unsigned char * /*tag*/) { return false; }
+    //------------------------------------------
+    // PURPOSE: For protocols with authenticated encryption,
+    //          end the current stream. The encrypting side
+    //          stores the tag in tag; the decrypting side
+    //          checks the tag the peer sent. Either way the
+    //          next stream needs a new IV.
+    // REQUIRE: tag -- streamTagLength() bytes
+    // RETURNS: true -- success (tag matches); false -- failure
+    //------------------------------------------
+
  protected:
     static int encryptedSize(int inputLength, int blockSize = 8);
     //------------------------------------------
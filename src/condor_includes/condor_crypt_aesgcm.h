@@ -0,0 +1,123 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef CONDOR_CRYPTO_AESGCM_H
+#define CONDOR_CRYPTO_AESGCM_H
+
+static const int AESGCM_KEY_SIZE = 32;	// AES-256
+static const int AESGCM_IV_SIZE = 12;
+static const int AESGCM_TAG_SIZE = 16;
+
+#ifdef HAVE_EXT_OPENSSL
+
+#include "condor_common.h"
+#include "condor_crypt.h"          // base class
+#include <openssl/evp.h>
+
+//----------------------------------------------------------------------
+// AES-256 in Galois/Counter mode, through the OpenSSL EVP interface so
+// that AES-NI and carry-less multiply are used where the CPU has them.
+//
+// As a stream cipher this is the counter mode half of GCM: every stream
+// begins with a random IV sent in the clear (see startStream()), and a
+// stream that is finished with finishStream() also carries the GCM tag
+// over everything encrypted in it.  The same key is used by ReliSock
+// to compute an AES-GMAC tag for each packet in place of the MD5 MAC
+// (see computeMAC()).
+//----------------------------------------------------------------------
+class Condor_Crypt_AESGCM : public Condor_Crypt_Base {
+
+ public:
+    Condor_Crypt_AESGCM(const KeyInfo& key);
+    //------------------------------------------
+    // PURPOSE: Cryto base class constructor
+    // REQUIRE: keyLength = 32, shorter keys are padded
+    // RETURNS: None
+    //------------------------------------------
+
+    ~Condor_Crypt_AESGCM();
+    //------------------------------------------
+    // PURPOSE: Crypto base class destructor
+    // REQUIRE: None
+    // RETURNS: None
+    //------------------------------------------
+
+    void resetState();
+
+    bool encrypt(unsigned char *  input,
+                 int              input_len,
+                 unsigned char *& output,
+                 int&             output_len);
+
+    bool decrypt(unsigned char *  input,
+                 int              input_len,
+                 unsigned char *& output,
+                 int&             output_len);
+
+    int pendingIVLength();
+
+    bool startStream(unsigned char * iv, bool encrypting);
+
+    int streamTagLength();
+
+    bool finishStream(unsigned char * tag);
+
+    bool computeMAC(const unsigned char * iv,
+                    const unsigned char * header, int header_len,
+                    const unsigned char * data, int data_len,
+                    unsigned char * tag);
+    //------------------------------------------
+    // PURPOSE: Compute the AES-GMAC tag of a packet
+    // REQUIRE: iv -- AESGCM_IV_SIZE bytes, never reused with this key
+    //          tag -- room for AESGCM_TAG_SIZE bytes
+    // RETURNS: true -- success; false -- failure
+    //------------------------------------------
+
+    bool verifyMAC(const unsigned char * iv,
+                   const unsigned char * header, int header_len,
+                   const unsigned char * data, int data_len,
+                   const unsigned char * tag);
+    //------------------------------------------
+    // PURPOSE: Check the AES-GMAC tag of a packet
+    // REQUIRE: same as computeMAC
+    // RETURNS: true -- match; false -- not match
+    //------------------------------------------
+
+ private:
+    Condor_Crypt_AESGCM();
+    //------------------------------------------
+    // Private constructor
+    //------------------------------------------
+
+    enum StreamState {
+        STREAM_NONE,
+        STREAM_ENCRYPT,
+        STREAM_DECRYPT
+    };
+
+    EVP_CIPHER_CTX *  streamCtx_;
+    EVP_CIPHER_CTX *  macCtx_;
+    StreamState       streamState_;
+};
+
+
+#endif /* HAVE_EXT_OPENSSL */
+
+#endif /* CONDOR_CRYPTO_AESGCM_H */
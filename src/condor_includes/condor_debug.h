@@ -237,6 +237,15 @@ double dprintf_get_lock_delay(void);
 */
 int dprintf_getCount(void);
 
+/* when DEBUG_ASYNC is enabled, wait until every queued message has
+   been written to its log file */
+void dprintf_async_flush(void);
+
+/* get counts of messages queued for the DEBUG_ASYNC writer, of messages
+   that had to wait for room in its buffer, and of messages dropped
+   because there was no room (for statistics) */
+void dprintf_get_async_stats(long long *queued, long long *delayed, long long *dropped);
+
 /* flush the buffered output that is created when TOOL_DEBUG_ON_ERROR is set
  */
 int dprintf_WriteOnErrorBuffer(FILE * out, int fClearBuffer);
@@ -25,6 +25,7 @@
 // to have any effect.
 #include <string>
 #include <map>
+#include <vector>
 #if _MSC_VER && (_MSC_VER < 1600)
 typedef _Longlong int64_t;
 #else
@@ -136,6 +137,17 @@ const char* _format_global_header(int cat_and_flags, int hdr_flags, DebugHeaderI
 void _dprintf_global_func(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message, DebugFileInfo* dbgInfo);
 void _dprintf_to_buffer(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message, DebugFileInfo* dbgInfo);
 
+// asynchronous writing of FILE_OUT logs (DEBUG_ASYNC), see dprintf_async.cpp
+extern int DebugAsync;
+extern int DebugAsyncBufferSize;
+bool _dprintf_async_active(void);
+// queue a message for the writer thread, returns false if the caller should write it
+bool _dprintf_async_write(int ixOutput, DebugFileInfo &it, int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message);
+void _dprintf_async_start(std::vector<DebugFileInfo> &logs, int buffer_size);
+void _dprintf_async_stop(void);
+// bounded wait for the writer thread, safe to call from a fatal signal handler
+void _dprintf_async_crash_flush(void);
+
 #ifdef WIN32
 //Output to dbg string
 void dprintf_to_outdbgstr(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message, DebugFileInfo* dbgInfo);
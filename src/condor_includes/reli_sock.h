@@ -27,6 +27,7 @@
 #include "condor_system.h"
 #include "condor_ipverify.h"
 #include "condor_md.h"
+#include "condor_crypt_aesgcm.h"
 
 #include <memory>
 
@@ -41,6 +42,7 @@ int relisock_gsi_put(void *arg,  void *buf, size_t size);
 
 class Authentication;
 class Condor_MD_MAC;
+class Condor_Crypt_AESGCM;
 /** The ReliSock class implements the Sock interface with TCP. */
 
 #define GET_FILE_OPEN_FAILED -2
@@ -157,6 +159,15 @@ public:
     ///
 	int get_bytes_nobuffer(char *buffer, int max_length, int receive_size=1);
 
+		/** With authenticated encryption, end the stream of data sent
+			by put_bytes_nobuffer() with its tag, or read the tag at the
+			end of the data received by get_bytes_nobuffer() and check
+			it.  Does nothing if there is no such stream in progress.
+			@return TRUE on success, FALSE on failure
+		*/
+	int put_stream_tag_nobuffer();
+	int get_stream_tag_nobuffer();
+
     /// returns <0 on failure, 0 for ok
 	//  failure codes: GET_FILE_OPEN_FAILED  (errno contains specific error)
 	//                 GET_FILE_WRITE_FAILED (errno contains specific error)
@@ -284,6 +295,14 @@ protected:
 	char * serialize() const;	// save state into buffer
 
 	int prepare_for_nobuffering( stream_coding = stream_unknown);
+#if defined(LINUX)
+		// Zero-copy body of put_file() using sendfile().  Returns
+		// 1 on success, 0 if sendfile() is not usable for this fd
+		// (caller falls back to read/write from offset+total), or
+		// -1 on a network failure.
+	int put_file_sendfile( int fd, filesize_t offset, filesize_t bytes_to_send,
+						   filesize_t &total, class DCTransferQueue *xfer_q );
+#endif
 	int perform_authenticate( bool with_key, KeyInfo *& key, 
 							  const char* methods, CondorError* errstack,
 							  int auth_timeout, bool non_blocking, char **method_used );
@@ -295,9 +314,12 @@ protected:
 
 	class RcvMsg {
 		
-		char m_partial_cksum[MAC_SIZE];
+			// header of a partially read packet: the normal 5 bytes,
+			// then the AES-GMAC IV if any, then the MAC
+		char m_partial_hdr[5 + AESGCM_IV_SIZE + MAC_SIZE];
                 CONDOR_MD_MODE  mode_;
                 Condor_MD_MAC * mdChecker_;
+		Condor_Crypt_AESGCM * gmacChecker_;
 		ReliSock      * p_sock; //preserve parent pointer to use for condor_read/write
 		bool		m_partial_packet; // A partial packet is stored.
 		size_t		m_remaining_read_length; // Length remaining on a partial packet
@@ -313,11 +335,18 @@ protected:
 		int			ready;
 		bool m_closed;
 		bool init_MD(CONDOR_MD_MODE mode, KeyInfo * key);
+		int header_size() const;
 	} rcv_msg;
 
 	class SndMsg {
                 CONDOR_MD_MODE  mode_;
                 Condor_MD_MAC * mdChecker_;
+		Condor_Crypt_AESGCM * gmacChecker_;
+			// IV for the next packet's AES-GMAC: random when the
+			// key is set, with a packet count in the last 4 bytes
+		unsigned char m_gmac_iv[AESGCM_IV_SIZE];
+		unsigned int m_gmac_count;
+		void init_gmac_iv();
 		ReliSock      * p_sock;
 		Buf		*m_out_buf;
 		void stash_packet();
@@ -340,6 +369,7 @@ protected:
 		}
 
         bool init_MD(CONDOR_MD_MODE mode, KeyInfo * key);
+		int header_size() const;
 
 
 	} snd_msg;
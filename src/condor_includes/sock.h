@@ -490,6 +490,17 @@ protected:
 	const KeyInfo& get_crypto_key() const;
 	const KeyInfo& get_md_key() const;
 	void resetCrypto();
+		// Protocols such as AES-GCM send an IV in the clear ahead of
+		// the first byte encrypted after resetCrypto().  pendingCryptoIV()
+		// is the length of the IV owed (0 if none); startCryptoStream()
+		// makes a new one to send, or accepts the one received.
+	int pendingCryptoIV();
+	bool startCryptoStream(unsigned char * iv, bool encrypting);
+		// Length of the authentication tag that will end the current
+		// encrypted stream, or 0 if there is none; finishCryptoStream()
+		// makes the tag to send, or checks the one received.
+	int cryptoStreamTagLength();
+	bool finishCryptoStream(unsigned char * tag);
 	virtual bool canEncrypt();
 
 	/*
@@ -538,6 +538,12 @@ public:
 	/// The special value 0 indicates no deadline.
 	void set_deadline(time_t t);
 
+	/// Set a function to be called with the new deadline whenever
+	/// any stream's deadline is set (NULL for none).  DaemonCore uses
+	/// this to learn of deadlines set on sockets it is already
+	/// waiting on.
+	static void set_deadline_observer(void (*observer)(time_t));
+
 	/// Returns the current deadline time.
 	/// The special value 0 indicates no deadline.
 	virtual time_t get_deadline();
@@ -658,6 +664,7 @@ protected:
 	CondorVersionInfo *m_peer_version;
 
 	time_t m_deadline_time;
+	static void (*deadline_observer)(time_t);
 	static int timeout_multiplier;
 	bool ignore_timeout_multiplier;
 };
@@ -24,6 +24,7 @@
 #include "condor_io.h"
 #include "condor_debug.h"
 #include "condor_md.h"
+#include "condor_crypt_aesgcm.h"
 #include "condor_rw.h"
 
 unsigned long num_created = 0;
@@ -320,6 +321,36 @@ bool Buf::verifyMD(char * checkSUM, Condor_MD_MAC * checker)
     return checker->verifyMD((unsigned char *) checkSUM);
 }
 
+bool Buf::computeGMAC(char * tag, const char * iv, const char * hdr, int hdr_len,
+					  int offset, Condor_Crypt_AESGCM * checker)
+{
+#ifdef HAVE_EXT_OPENSSL
+	alloc_buf();
+
+	return checker->computeMAC((const unsigned char *) iv,
+							   (const unsigned char *) hdr, hdr_len,
+							   (const unsigned char *) &(_dta[offset]), _dta_sz - offset,
+							   (unsigned char *) tag);
+#else
+	return false;
+#endif
+}
+
+bool Buf::verifyGMAC(const char * tag, const char * iv, const char * hdr, int hdr_len,
+					 Condor_Crypt_AESGCM * checker)
+{
+#ifdef HAVE_EXT_OPENSSL
+	alloc_buf();
+
+	return checker->verifyMAC((const unsigned char *) iv,
+							  (const unsigned char *) hdr, hdr_len,
+							  (const unsigned char *) _dta, _dta_sz,
+							  (const unsigned char *) tag);
+#else
+	return false;
+#endif
+}
+
 void Buf::swap(Buf &other)
 {
 	char * tmp_dta = _dta;
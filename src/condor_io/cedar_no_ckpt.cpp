@@ -46,9 +46,14 @@
 #include "condor_fsync.h"
 #include "dc_transfer_queue.h"
 
+#include "selector.h"
+
 #ifdef WIN32
 #include <mswsock.h>	// For TransmitFile()
 #endif
+#if defined(LINUX)
+#include <sys/sendfile.h>
+#endif
 
 const unsigned int PUT_FILE_EOM_NUM = 666;
 
@@ -264,6 +269,14 @@ ReliSock::get_file( filesize_t *size, int fd,
 		}
 	}
 
+		// With authenticated encryption (AES-GCM), the sender ends
+		// the file data with a tag over all of it.
+	if ( total == bytes_to_receive && !get_stream_tag_nobuffer() ) {
+		dprintf( D_ALWAYS, "get_file(): ERROR: integrity check of "
+				 "received data failed\n" );
+		return -1;
+	}
+
 	if ( filesize == 0 ) {
 		if ( !get(eom_num) || eom_num != PUT_FILE_EOM_NUM ) {
 			dprintf( D_ALWAYS, "get_file: Zero-length file check failed!\n" );
@@ -357,6 +370,132 @@ ReliSock::put_file( filesize_t *size, const char *source, filesize_t offset, fil
 	return result;
 }
 
+#if defined(LINUX)
+int
+ReliSock::put_file_sendfile( int fd, filesize_t offset, filesize_t bytes_to_send,
+							 filesize_t &total, DCTransferQueue *xfer_q )
+{
+		// sendfile() writes straight to the socket, so anything still
+		// sitting in our buffers (i.e. the file size) must go first.
+	if ( !prepare_for_nobuffering(stream_encode) ) {
+		dprintf(D_ALWAYS,
+				"ReliSock: put_file: failed to drain buffers!\n");
+		return -1;
+	}
+
+		// Put the socket in non-blocking mode for the duration, so
+		// that we can enforce our timeout the same way condor_write()
+		// does, by waiting in select() rather than in sendfile().
+	int fcntl_flags = fcntl(_sock, F_GETFL);
+	if ( fcntl_flags < 0 ) {
+		return 0;
+	}
+	if ( (fcntl_flags & O_NONBLOCK) == 0 &&
+		 fcntl(_sock, F_SETFL, fcntl_flags | O_NONBLOCK) == -1 )
+	{
+		return 0;
+	}
+
+	Selector selector;
+	selector.add_fd( _sock, Selector::IO_WRITE );
+
+		// Send in bounded chunks, so the transfer queue gets
+		// progress reports during large transfers.
+	const filesize_t chunk_size = 4 * 1024 * 1024;
+	off_t file_offset = (off_t)(offset + total);
+	time_t deadline = _timeout > 0 ? time(NULL) + _timeout : 0;
+	int result = 1;
+
+	while ( total < bytes_to_send ) {
+		UtcTime t1;
+		UtcTime t2;
+		if( xfer_q ) {
+			t1.getTime();
+		}
+
+		size_t want = (size_t)MIN( chunk_size, bytes_to_send - total );
+		ssize_t nw = sendfile( _sock, fd, &file_offset, want );
+
+		if ( nw < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( nw < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ) {
+			if ( deadline ) {
+				time_t now = time(NULL);
+				if ( now >= deadline ) {
+					dprintf( D_ALWAYS, "ReliSock: put_file: timed out "
+							 "sending file to %s\n", peer_description() );
+					result = -1;
+					break;
+				}
+				selector.set_timeout( deadline - now );
+			}
+			selector.execute();
+			if( xfer_q ) {
+				t2.getTime();
+				xfer_q->AddUsecNetWrite(t2.difference_usec(t1));
+			}
+			if ( selector.timed_out() ) {
+				dprintf( D_ALWAYS, "ReliSock: put_file: timed out "
+						 "sending file to %s\n", peer_description() );
+				result = -1;
+				break;
+			}
+			continue;
+		}
+		if ( nw < 0 ) {
+			int the_errno = errno;
+			if ( the_errno == EINVAL || the_errno == ENOSYS ||
+				 the_errno == EOPNOTSUPP )
+			{
+					// This kind of file can't be sent with sendfile();
+					// let the caller finish it the slow way.
+				dprintf( D_FULLDEBUG, "ReliSock: put_file: sendfile() "
+						 "not usable (errno=%d %s), falling back to "
+						 "read/write\n", the_errno, strerror(the_errno) );
+				result = 0;
+				break;
+			}
+			dprintf( D_ALWAYS, "ReliSock: put_file: sendfile() to %s "
+					 "failed after " FILESIZE_T_FORMAT " bytes, "
+					 "errno=%d %s\n", peer_description(), total,
+					 the_errno, strerror(the_errno) );
+			result = -1;
+			break;
+		}
+		if ( nw == 0 ) {
+				// File is shorter than it was when we stat'ed it.
+				// The caller reports the short transfer.
+			break;
+		}
+
+		if( xfer_q ) {
+				// We don't know how much of the time was spent reading
+				// from disk vs. writing to the network, so we just report
+				// it all as network i/o time, as with TransmitFile().
+			t2.getTime();
+			xfer_q->AddUsecNetWrite(t2.difference_usec(t1));
+			xfer_q->AddBytesSent(nw);
+			xfer_q->ConsiderSendingReport(t2.seconds());
+		}
+		total += nw;
+		_bytes_sent += nw;
+		if ( _timeout > 0 ) {
+			deadline = time(NULL) + _timeout;
+		}
+	}
+
+	if ( (fcntl_flags & O_NONBLOCK) == 0 &&
+		 fcntl(_sock, F_SETFL, fcntl_flags) == -1 )
+	{
+		dprintf( D_ALWAYS, "ReliSock: put_file: failed to restore "
+				 "blocking mode on socket, errno=%d\n", errno );
+		result = -1;
+	}
+	return result;
+}
+#endif
+
 MSC_DISABLE_WARNING(6262) // function uses 64k of stack
 int
 ReliSock::put_file( filesize_t *size, int fd, filesize_t offset, filesize_t max_bytes, DCTransferQueue *xfer_q )
@@ -475,10 +614,27 @@ ReliSock::put_file( filesize_t *size, int fd, filesize_t offset, filesize_t max_
 		}
 #endif
 
+#if defined(LINUX)
+		// On Linux, if we don't need encryption or integrity checking,
+		// let the kernel copy the file straight to the socket.
+		if ( !get_encryption() && !isOutgoing_MD5_on() &&
+			 param_boolean("FILE_TRANSFER_USE_SENDFILE", true) )
+		{
+			int rc = put_file_sendfile( fd, offset, bytes_to_send, total, xfer_q );
+			if ( rc < 0 ) {
+				return -1;
+			}
+			if ( total > 0 && total < bytes_to_send ) {
+					// sendfile() does not move the file position
+				lseek( fd, offset + total, SEEK_SET );
+			}
+		}
+#endif
+
 		char buf[65536];
 		int nbytes, nrd;
 
-		// On Unix, always send the file using put_bytes_nobuffer().
+		// Otherwise, send the file using put_bytes_nobuffer().
 		// Note that on Win32, we use this method as well if encryption 
 		// is required.
 		while (total < bytes_to_send) {
@@ -520,6 +676,14 @@ ReliSock::put_file( filesize_t *size, int fd, filesize_t offset, filesize_t max_
 			}
 			total += nbytes;
 		}
+
+			// With authenticated encryption (AES-GCM), end the
+			// file data with a tag over all of it.
+		if ( total == bytes_to_send && !put_stream_tag_nobuffer() ) {
+			dprintf( D_ALWAYS, "ReliSock::put_file: failed to send "
+					 "integrity tag\n" );
+			return -1;
+		}
 	
 	} // end of if filesize > 0
 
@@ -0,0 +1,245 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "condor_common.h"
+#include "condor_crypt_aesgcm.h"
+#include "condor_debug.h"
+
+#ifdef HAVE_EXT_OPENSSL
+
+#include <openssl/crypto.h>
+
+Condor_Crypt_AESGCM :: Condor_Crypt_AESGCM(const KeyInfo& key)
+#if !defined(SKIP_AUTHENTICATION)
+    : Condor_Crypt_Base(CONDOR_AESGCM, key),
+      streamCtx_(NULL),
+      macCtx_(NULL),
+      streamState_(STREAM_NONE)
+{
+    KeyInfo k(key);
+
+		// AES-256 requires a key of 32 bytes, so pad the
+		// key out to at least 32 bytes if needed
+	unsigned char * keyData = k.getPaddedKeyData(AESGCM_KEY_SIZE);
+	ASSERT(keyData);
+
+		// The key schedule is set up once; each stream and
+		// each packet MAC only supplies a new IV.
+    streamCtx_ = EVP_CIPHER_CTX_new();
+    macCtx_ = EVP_CIPHER_CTX_new();
+    ASSERT(streamCtx_ && macCtx_);
+    if (!EVP_CipherInit_ex(streamCtx_, EVP_aes_256_gcm(), NULL, keyData, NULL, 1) ||
+        !EVP_CipherInit_ex(macCtx_, EVP_aes_256_gcm(), NULL, keyData, NULL, 1)) {
+        EXCEPT("AES-GCM: failed to initialize cipher context");
+    }
+
+	memset(keyData, 0, AESGCM_KEY_SIZE);
+	free(keyData);
+}
+#else
+    : streamCtx_(NULL),
+      macCtx_(NULL),
+      streamState_(STREAM_NONE)
+{
+}
+#endif
+
+Condor_Crypt_AESGCM :: ~Condor_Crypt_AESGCM()
+{
+    if (streamCtx_) {
+        EVP_CIPHER_CTX_free(streamCtx_);
+    }
+    if (macCtx_) {
+        EVP_CIPHER_CTX_free(macCtx_);
+    }
+}
+
+void Condor_Crypt_AESGCM:: resetState()
+{
+    streamState_ = STREAM_NONE;
+}
+
+int Condor_Crypt_AESGCM :: pendingIVLength()
+{
+    return (streamState_ == STREAM_NONE) ? AESGCM_IV_SIZE : 0;
+}
+
+bool Condor_Crypt_AESGCM :: startStream(unsigned char * iv, bool encrypting)
+{
+#if !defined(SKIP_AUTHENTICATION)
+    if (encrypting) {
+        unsigned char * random_iv = randomKey(AESGCM_IV_SIZE);
+        if (!random_iv) {
+            return false;
+        }
+        memcpy(iv, random_iv, AESGCM_IV_SIZE);
+        free(random_iv);
+    }
+
+    if (!EVP_CipherInit_ex(streamCtx_, NULL, NULL, NULL, iv, encrypting ? 1 : 0)) {
+        dprintf(D_SECURITY, "AES-GCM: failed to start stream\n");
+        streamState_ = STREAM_NONE;
+        return false;
+    }
+    streamState_ = encrypting ? STREAM_ENCRYPT : STREAM_DECRYPT;
+    return true;
+#else
+    return false;
+#endif
+}
+
+int Condor_Crypt_AESGCM :: streamTagLength()
+{
+    return AESGCM_TAG_SIZE;
+}
+
+bool Condor_Crypt_AESGCM :: finishStream(unsigned char * tag)
+{
+#if !defined(SKIP_AUTHENTICATION)
+    unsigned char final_block[32];
+    int final_len = 0;
+    bool result = false;
+
+    switch (streamState_) {
+    case STREAM_ENCRYPT:
+        result = EVP_EncryptFinal_ex(streamCtx_, final_block, &final_len) &&
+            EVP_CIPHER_CTX_ctrl(streamCtx_, EVP_CTRL_GCM_GET_TAG, AESGCM_TAG_SIZE, tag);
+        break;
+    case STREAM_DECRYPT:
+        result = EVP_CIPHER_CTX_ctrl(streamCtx_, EVP_CTRL_GCM_SET_TAG, AESGCM_TAG_SIZE, tag) &&
+            EVP_DecryptFinal_ex(streamCtx_, final_block, &final_len) > 0;
+        break;
+    default:
+        break;
+    }
+
+    streamState_ = STREAM_NONE;
+    return result;
+#else
+    return true;
+#endif
+}
+
+bool Condor_Crypt_AESGCM :: encrypt(unsigned char *  input,
+                                    int              input_len,
+                                    unsigned char *& output,
+                                    int&             output_len)
+{
+#if !defined(SKIP_AUTHENTICATION)
+    output = NULL;
+    output_len = 0;
+
+    if (streamState_ != STREAM_ENCRYPT) {
+        dprintf(D_SECURITY, "AES-GCM: encrypt called without an IV\n");
+        return false;
+    }
+
+    output = (unsigned char *) malloc(input_len > 0 ? input_len : 1);
+    if (!output) {
+        return false;
+    }
+
+    if (!EVP_EncryptUpdate(streamCtx_, output, &output_len, input, input_len) ||
+        output_len != input_len) {
+        free(output);
+        output = NULL;
+        output_len = 0;
+        return false;
+    }
+    return true;
+#else
+	return true;
+#endif
+}
+
+bool Condor_Crypt_AESGCM :: decrypt(unsigned char *  input,
+                                    int              input_len,
+                                    unsigned char *& output,
+                                    int&             output_len)
+{
+#if !defined(SKIP_AUTHENTICATION)
+    output = NULL;
+    output_len = 0;
+
+    if (streamState_ != STREAM_DECRYPT) {
+        dprintf(D_SECURITY, "AES-GCM: decrypt called without an IV\n");
+        return false;
+    }
+
+    output = (unsigned char *) malloc(input_len > 0 ? input_len : 1);
+    if (!output) {
+        return false;
+    }
+
+    if (!EVP_DecryptUpdate(streamCtx_, output, &output_len, input, input_len) ||
+        output_len != input_len) {
+        free(output);
+        output = NULL;
+        output_len = 0;
+        return false;
+    }
+    return true;
+#else
+	return true;
+#endif
+}
+
+bool Condor_Crypt_AESGCM :: computeMAC(const unsigned char * iv,
+                                       const unsigned char * header, int header_len,
+                                       const unsigned char * data, int data_len,
+                                       unsigned char * tag)
+{
+#if !defined(SKIP_AUTHENTICATION)
+    unsigned char final_block[32];
+    int len = 0;
+
+		// GMAC is GCM with everything passed as additional
+		// authenticated data and nothing encrypted.
+    return EVP_EncryptInit_ex(macCtx_, NULL, NULL, NULL, iv) &&
+        EVP_EncryptUpdate(macCtx_, NULL, &len, header, header_len) &&
+        EVP_EncryptUpdate(macCtx_, NULL, &len, data, data_len) &&
+        EVP_EncryptFinal_ex(macCtx_, final_block, &len) &&
+        EVP_CIPHER_CTX_ctrl(macCtx_, EVP_CTRL_GCM_GET_TAG, AESGCM_TAG_SIZE, tag);
+#else
+    return true;
+#endif
+}
+
+bool Condor_Crypt_AESGCM :: verifyMAC(const unsigned char * iv,
+                                      const unsigned char * header, int header_len,
+                                      const unsigned char * data, int data_len,
+                                      const unsigned char * tag)
+{
+    unsigned char expected[AESGCM_TAG_SIZE];
+
+    if (!computeMAC(iv, header, header_len, data, data_len, expected)) {
+        return false;
+    }
+    return CRYPTO_memcmp(expected, tag, AESGCM_TAG_SIZE) == 0;
+}
+
+Condor_Crypt_AESGCM :: Condor_Crypt_AESGCM()
+    : streamCtx_(NULL),
+      macCtx_(NULL),
+      streamState_(STREAM_NONE)
+{
+}
+
+#endif /*HAVE_EXT_OPENSSL*/
@@ -2787,7 +2787,9 @@ MyString SecMan::getDefaultAuthenticationMethods() {
 
 MyString SecMan::getDefaultCryptoMethods() {
 #ifdef HAVE_EXT_OPENSSL
-	return "3DES,BLOWFISH";
+		// AESGCM is last so that it is only chosen where it is
+		// preferred by configuration; see CreateNonNegotiatedSecuritySession()
+	return "3DES,BLOWFISH,AESGCM";
 #else
 	return "";
 #endif
@@ -2889,6 +2891,8 @@ Protocol CryptProtocolNameToEnum(char const *name) {
 	case '3': // 3des
 	case 'T': // Tripledes
 		return CONDOR_3DES;
+	case 'A': // AES-GCM
+		return CONDOR_AESGCM;
 	default:
 		return CONDOR_NO_PROTOCOL;
 	}
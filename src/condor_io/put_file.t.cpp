@@ -0,0 +1,259 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/*
+  Loopback throughput benchmark for ReliSock::put_file()/get_file().
+
+  Writes a scratch file of the requested size, forks a receiver that
+  connects back over loopback and get_file()s each copy into /dev/null,
+  and times put_file() with FILE_TRANSFER_USE_SENDFILE off and on, and
+  then with encryption and integrity checks on under each crypto method.
+  The file is sent once untimed first so all runs read it from page cache.
+
+  usage: put_file_bench [-iterations <n>] [-mb <size>] [-dir <scratch dir>]
+  (default: 10 iterations of a 256 MB file in /tmp)
+*/
+
+#include "condor_common.h"
+#include "condor_config.h"
+#include "condor_debug.h"
+#include "condor_io.h"
+#include "subsystem_info.h"
+#include "utc_time.h"
+
+static unsigned char bench_key[24] = {
+	0x31, 0x41, 0x59, 0x26, 0x53, 0x58, 0x97, 0x93,
+	0x23, 0x84, 0x62, 0x64, 0x33, 0x83, 0x27, 0x95,
+	0x02, 0x88, 0x41, 0x97, 0x16, 0x93, 0x99, 0x37
+};
+
+	// Both ends switch to the same key after the message that
+	// announces the next round, the way a security session does.
+static void
+set_crypto( ReliSock *sock, Protocol protocol )
+{
+	if ( protocol == CONDOR_NO_PROTOCOL ) {
+		sock->set_MD_mode( MD_OFF );
+		sock->set_crypto_key( false, NULL );
+		return;
+	}
+	KeyInfo key( bench_key, sizeof(bench_key), protocol );
+	sock->set_MD_mode( MD_ALWAYS_ON, &key );
+	sock->set_crypto_key( true, &key );
+}
+
+static bool
+receive_files( char const *sinful )
+{
+	ReliSock sock;
+	if ( !sock.connect( sinful ) ) {
+		fprintf( stderr, "receiver: failed to connect to %s\n", sinful );
+		return false;
+	}
+	int null_fd = safe_open_wrapper_follow( "/dev/null", O_WRONLY );
+	if ( null_fd < 0 ) {
+		fprintf( stderr, "receiver: cannot open /dev/null\n" );
+		return false;
+	}
+
+	bool ok = true;
+	while ( ok ) {
+		int protocol = 0, count = 0;
+		sock.decode();
+		if ( !sock.code( protocol ) || !sock.code( count ) ||
+			 !sock.end_of_message() ) {
+			ok = false;
+			break;
+		}
+		if ( count <= 0 ) {
+			break;
+		}
+		set_crypto( &sock, (Protocol)protocol );
+
+		for ( int i = 0; ok && i < count; i++ ) {
+			filesize_t size = 0;
+			sock.decode();
+			if ( sock.get_file( &size, null_fd ) < 0 ) {
+				fprintf( stderr, "receiver: get_file() failed\n" );
+				ok = false;
+				break;
+			}
+			int ack = 1;
+			sock.encode();
+			if ( !sock.code( ack ) || !sock.end_of_message() ) {
+				ok = false;
+			}
+		}
+	}
+	close( null_fd );
+	return ok;
+}
+
+static bool
+send_files( ReliSock *sock, int fd, Protocol protocol, int count, double &seconds )
+{
+	int proto = (int)protocol;
+	sock->encode();
+	if ( !sock->code( proto ) || !sock->code( count ) || !sock->end_of_message() ) {
+		fprintf( stderr, "sender: failed to start round\n" );
+		return false;
+	}
+	if ( count <= 0 ) {
+		return true;
+	}
+	set_crypto( sock, protocol );
+
+	double begin = UtcTime::getTimeDouble();
+	for ( int i = 0; i < count; i++ ) {
+		filesize_t size = 0;
+		lseek( fd, 0, SEEK_SET );
+		sock->encode();
+		if ( sock->put_file( &size, fd ) < 0 ) {
+			fprintf( stderr, "sender: put_file() failed\n" );
+			return false;
+		}
+		int ack = 0;
+		sock->decode();
+		if ( !sock->code( ack ) || !sock->end_of_message() || ack != 1 ) {
+			fprintf( stderr, "sender: no acknowledgement from receiver\n" );
+			return false;
+		}
+	}
+	seconds = UtcTime::getTimeDouble() - begin;
+	return true;
+}
+
+int
+main( int argc, const char **argv )
+{
+	set_mySubSystem( "TEST_PUT_FILE", SUBSYSTEM_TYPE_TOOL );
+	config();
+	dprintf_set_tool_debug( "TOOL", 0 );
+
+	int iterations = 10;
+	int megabytes = 256;
+	const char *dir = "/tmp";
+	for ( int i = 1; i < argc; i++ ) {
+		if ( strcmp( argv[i], "-iterations" ) == 0 && i+1 < argc ) {
+			iterations = atoi( argv[++i] );
+		} else if ( strcmp( argv[i], "-mb" ) == 0 && i+1 < argc ) {
+			megabytes = atoi( argv[++i] );
+		} else if ( strcmp( argv[i], "-dir" ) == 0 && i+1 < argc ) {
+			dir = argv[++i];
+		} else {
+			fprintf( stderr, "usage: %s [-iterations <n>] [-mb <size>] "
+					 "[-dir <scratch dir>]\n", argv[0] );
+			return 1;
+		}
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+	if ( megabytes < 1 ) {
+		megabytes = 1;
+	}
+
+	std::string path;
+	formatstr( path, "%s/put_file_bench.%d", dir, (int)getpid() );
+	int fd = safe_open_wrapper_follow( path.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0600 );
+	if ( fd < 0 ) {
+		fprintf( stderr, "cannot create %s: %s\n", path.c_str(), strerror(errno) );
+		return 1;
+	}
+	unlink( path.c_str() );
+
+	char block[65536];
+	for ( size_t i = 0; i < sizeof(block); i++ ) {
+		block[i] = (char)(rand() & 0xff);
+	}
+	for ( int i = 0; i < megabytes * 16; i++ ) {
+		if ( write( fd, block, sizeof(block) ) != (ssize_t)sizeof(block) ) {
+			fprintf( stderr, "cannot write %s: %s\n", path.c_str(), strerror(errno) );
+			return 1;
+		}
+	}
+
+	ReliSock listener;
+	if ( !listener.bind( false, 0, true ) || !listener.listen() ) {
+		fprintf( stderr, "cannot listen on loopback\n" );
+		return 1;
+	}
+	std::string sinful = listener.get_sinful();
+
+	pid_t pid = fork();
+	if ( pid < 0 ) {
+		fprintf( stderr, "fork() failed: %s\n", strerror(errno) );
+		return 1;
+	}
+	if ( pid == 0 ) {
+		_exit( receive_files( sinful.c_str() ) ? 0 : 1 );
+	}
+
+	ReliSock *sock = listener.accept();
+	bool ok = sock != NULL;
+
+	static const struct {
+		char const *name;
+		Protocol protocol;
+	} crypto_methods[] = {
+		{ "BLOWFISH", CONDOR_BLOWFISH },
+		{ "3DES", CONDOR_3DES },
+		{ "AESGCM", CONDOR_AESGCM },
+	};
+	const int num_methods = sizeof(crypto_methods) / sizeof(crypto_methods[0]);
+
+	double warm = 0, buffered = 0, zero_copy = 0;
+	double encrypted[num_methods];
+	if ( ok ) {
+		param_insert( "FILE_TRANSFER_USE_SENDFILE", "false" );
+		ok = send_files( sock, fd, CONDOR_NO_PROTOCOL, 1, warm ) &&
+			send_files( sock, fd, CONDOR_NO_PROTOCOL, iterations, buffered );
+	}
+	if ( ok ) {
+		param_insert( "FILE_TRANSFER_USE_SENDFILE", "true" );
+		ok = send_files( sock, fd, CONDOR_NO_PROTOCOL, iterations, zero_copy );
+	}
+	for ( int m = 0; ok && m < num_methods; m++ ) {
+		ok = send_files( sock, fd, crypto_methods[m].protocol, iterations, encrypted[m] );
+	}
+	if ( ok ) {
+		double unused;
+		ok = send_files( sock, fd, CONDOR_NO_PROTOCOL, 0, unused );
+	}
+
+	delete sock;
+	int status = 0;
+	waitpid( pid, &status, 0 );
+	close( fd );
+
+	if ( !ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+		fprintf( stderr, "benchmark failed\n" );
+		return 1;
+	}
+
+	double mb = (double)megabytes * iterations;
+	printf( "%-12s %10s %10s\n", "method", "seconds", "MB/s" );
+	printf( "%-12s %10.3f %10.1f\n", "read/write", buffered, mb / buffered );
+	printf( "%-12s %10.3f %10.1f\n", "sendfile", zero_copy, mb / zero_copy );
+	for ( int m = 0; m < num_methods; m++ ) {
+		printf( "%-12s %10.3f %10.1f\n", crypto_methods[m].name,
+				encrypted[m], mb / encrypted[m] );
+	}
+	return 0;
+}
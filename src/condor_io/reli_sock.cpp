@@ -32,7 +32,10 @@
 #include "condor_sockfunc.h"
 
 #define NORMAL_HEADER_SIZE 5
-#define MAX_HEADER_SIZE MAC_SIZE + NORMAL_HEADER_SIZE
+#define MD_HEADER_SIZE (NORMAL_HEADER_SIZE + MAC_SIZE)
+	// with an AES-GCM key, the MAC is followed by the GMAC IV
+#define GMAC_HEADER_SIZE (MD_HEADER_SIZE + AESGCM_IV_SIZE)
+#define MAX_HEADER_SIZE GMAC_HEADER_SIZE
 
 /**************************************************************/
 
@@ -324,18 +327,8 @@ ReliSock::put_bytes_nobuffer( char *buffer, int length, int send_size )
 	int pagesize = 65536;  // Optimize large writes to be page sized.
 	char * cur;
 	unsigned char * buf = NULL;
-        
-	// First, encrypt the data if necessary
-	if (get_encryption()) {
-		if (!wrap((unsigned char *) buffer, length,  buf , l_out)) { 
-			dprintf(D_SECURITY, "Encryption failed\n");
-			goto error;
-		}
-		cur = (char *)buf;
-	}
-	else {
-		cur = buffer;
-	}
+	unsigned char iv[AESGCM_IV_SIZE];
+	int iv_len = 0;
 
 	// Tell peer how big the transfer is going to be, if requested.
 	// Note: send_size param is 1 (true) by default.
@@ -351,6 +344,29 @@ ReliSock::put_bytes_nobuffer( char *buffer, int length, int send_size )
             goto error;
 	}
 
+	// Then encrypt the data if necessary.  This comes after the
+	// end_of_message() above, which resets the crypto state.  If the
+	// protocol starts its stream with an IV, the IV is sent first.
+	if (get_encryption()) {
+		iv_len = pendingCryptoIV();
+		ASSERT( iv_len <= (int)sizeof(iv) );
+		if (iv_len > 0 && !startCryptoStream(iv, true)) {
+			goto error;
+		}
+		if (!wrap((unsigned char *) buffer, length,  buf , l_out)) { 
+			dprintf(D_SECURITY, "Encryption failed\n");
+			goto error;
+		}
+		if (iv_len > 0 &&
+			condor_write(peer_description(), _sock, (char *)iv, iv_len, _timeout) < 0) {
+			goto error;
+		}
+		cur = (char *)buf;
+	}
+	else {
+		cur = buffer;
+	}
+
 	// Optimize transfer by writing in pagesized chunks.
 	for(i = 0; i < length;)
 	{
@@ -393,6 +409,8 @@ ReliSock::get_bytes_nobuffer(char *buffer, int max_length, int receive_size)
 	int result;
 	int length;
     unsigned char * buf = NULL;
+	unsigned char iv[AESGCM_IV_SIZE];
+	int iv_len = 0;
 
 	ASSERT(buffer != NULL);
 	ASSERT(max_length > 0);
@@ -420,6 +438,19 @@ ReliSock::get_bytes_nobuffer(char *buffer, int max_length, int receive_size)
                 goto error;
 	}
 
+	// Read the IV that starts the encrypted stream, if there is one
+	if (get_encryption()) {
+		iv_len = pendingCryptoIV();
+		ASSERT( iv_len <= (int)sizeof(iv) );
+		if (iv_len > 0 &&
+			(condor_read(peer_description(), _sock, (char *)iv, iv_len, _timeout) != iv_len ||
+			 !startCryptoStream(iv, false))) {
+			dprintf(D_ALWAYS,
+				"ReliSock::get_bytes_nobuffer: Failed to start decryption.\n");
+			goto error;
+		}
+	}
+
 	result = condor_read(peer_description(), _sock, buffer, length, _timeout);
 
 	
@@ -431,7 +462,10 @@ ReliSock::get_bytes_nobuffer(char *buffer, int max_length, int receive_size)
 	else {
 		// See if it needs to be decrypted
 		if (get_encryption()) {
-			unwrap((unsigned char *) buffer, result, buf, length);  // I am reusing length
+			if (!unwrap((unsigned char *) buffer, result, buf, length)) {  // I am reusing length
+				dprintf(D_SECURITY, "Decryption failed\n");
+				goto error;
+			}
 			memcpy(buffer, buf, result);
 			free(buf);
 		}
@@ -442,6 +476,51 @@ ReliSock::get_bytes_nobuffer(char *buffer, int max_length, int receive_size)
         return -1;
 }
 
+int
+ReliSock::put_stream_tag_nobuffer()
+{
+	unsigned char tag[AESGCM_TAG_SIZE];
+	int tag_len = cryptoStreamTagLength();
+
+	if ( tag_len <= 0 ) {
+		return TRUE;
+	}
+	ASSERT( tag_len <= (int)sizeof(tag) );
+
+	if ( !finishCryptoStream(tag) ||
+		 condor_write(peer_description(), _sock, (char *)tag, tag_len, _timeout) < 0 ) {
+		dprintf(D_ALWAYS, "ReliSock::put_stream_tag_nobuffer: Send failed.\n");
+		return FALSE;
+	}
+	_bytes_sent += tag_len;
+	return TRUE;
+}
+
+int
+ReliSock::get_stream_tag_nobuffer()
+{
+	unsigned char tag[AESGCM_TAG_SIZE];
+	int tag_len = cryptoStreamTagLength();
+
+	if ( tag_len <= 0 ) {
+		return TRUE;
+	}
+	ASSERT( tag_len <= (int)sizeof(tag) );
+
+	if ( condor_read(peer_description(), _sock, (char *)tag, tag_len, _timeout) != tag_len ) {
+		dprintf(D_ALWAYS, "ReliSock::get_stream_tag_nobuffer: Receive failed.\n");
+		return FALSE;
+	}
+	_bytes_recvd += tag_len;
+
+	if ( !finishCryptoStream(tag) ) {
+		dprintf(D_ALWAYS, "ReliSock::get_stream_tag_nobuffer: "
+				"Encrypted data failed its integrity check!\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
 
 int 
 ReliSock::handle_incoming_packet()
@@ -578,13 +657,20 @@ const char * ReliSock :: isIncomingDataMD5ed()
 int 
 ReliSock::put_bytes(const void *data, int sz)
 {
-	int		tw=0, header_size = isOutgoing_MD5_on() ? MAX_HEADER_SIZE:NORMAL_HEADER_SIZE;
+	int		tw=0, header_size = snd_msg.header_size();
 	int		nw, l_out;
         unsigned char * dta = NULL;
+	int		iv_len = 0;
 
         // Check to see if we need to encrypt
         // Okay, this is a bug! H.W. 9/25/2001
         if (get_encryption()) {
+			unsigned char iv[AESGCM_IV_SIZE];
+			iv_len = pendingCryptoIV();
+			ASSERT( iv_len <= (int)sizeof(iv) );
+			if (iv_len > 0 && !startCryptoStream(iv, true)) {
+				return -1;
+			}
             if (!wrap((unsigned char *)const_cast<void*>(data), sz, dta , l_out)) { 
                 dprintf(D_SECURITY, "Encryption failed\n");
 				if (dta != NULL)
@@ -594,6 +680,20 @@ ReliSock::put_bytes(const void *data, int sz)
 				}
                 return -1;  // encryption failed!
             }
+				// the IV that starts the stream goes out in the clear
+				// ahead of the first encrypted bytes
+			if (iv_len > 0) {
+				unsigned char * with_iv = (unsigned char *) malloc(iv_len + sz);
+				if (!with_iv) {
+					free(dta);
+					return -1;
+				}
+				memcpy(with_iv, iv, iv_len);
+				memcpy(with_iv + iv_len, dta, sz);
+				free(dta);
+				dta = with_iv;
+				sz += iv_len;
+			}
         }
         else {
             if((dta = (unsigned char *) malloc(sz)) != 0)
@@ -647,7 +747,7 @@ ReliSock::put_bytes(const void *data, int sz)
 		dta = NULL;
 	}
 
-	return nw;
+	return nw - iv_len;
 }
 
 
@@ -671,11 +771,25 @@ ReliSock::get_bytes(void *dta, int max_sz)
 		}
 	}
 
+	if (get_encryption()) {
+		unsigned char iv[AESGCM_IV_SIZE];
+		int iv_len = pendingCryptoIV();
+		ASSERT( iv_len <= (int)sizeof(iv) );
+		if (iv_len > 0 &&
+			(rcv_msg.buf.get(iv, iv_len) != iv_len || !startCryptoStream(iv, false))) {
+			dprintf(D_ALWAYS, "IO: Failed to read IV of encrypted data\n");
+			return FALSE;
+		}
+	}
+
 	bytes = rcv_msg.buf.get(dta, max_sz);
 
 	if (bytes > 0) {
             if (get_encryption()) {
-                unwrap((unsigned char *) dta, bytes, data, length);
+                if (!unwrap((unsigned char *) dta, bytes, data, length)) {
+                    dprintf(D_SECURITY, "Decryption failed\n");
+                    return FALSE;
+                }
                 memcpy(dta, data, bytes);
                 free(data);
             }
@@ -718,17 +832,34 @@ bool ReliSock::RcvMsg::init_MD(CONDOR_MD_MODE mode, KeyInfo * key)
     mode_ = mode;
     delete mdChecker_;
 	mdChecker_ = 0;
+	delete gmacChecker_;
+	gmacChecker_ = 0;
 
     if (key) {
+#ifdef HAVE_EXT_OPENSSL
+		if (key->getProtocol() == CONDOR_AESGCM) {
+			gmacChecker_ = new Condor_Crypt_AESGCM(*key);
+		}
+		else
+#endif
         mdChecker_ = new Condor_MD_MAC(key);
     }
 
     return true;
 }
 
+int ReliSock::RcvMsg::header_size() const
+{
+	if (mode_ == MD_OFF) {
+		return NORMAL_HEADER_SIZE;
+	}
+	return gmacChecker_ ? GMAC_HEADER_SIZE : MD_HEADER_SIZE;
+}
+
 ReliSock::RcvMsg :: RcvMsg() : 
     mode_(MD_OFF),
     mdChecker_(0), 
+	gmacChecker_(0),
 	p_sock(0),
 	m_partial_packet(false),
 	m_remaining_read_length(0),
@@ -737,33 +868,34 @@ ReliSock::RcvMsg :: RcvMsg() :
 	ready(0),
 	m_closed(false)
 {
-	memset( m_partial_cksum, 0, sizeof(m_partial_cksum) );
+	memset( m_partial_hdr, 0, sizeof(m_partial_hdr) );
 }
 
 ReliSock::RcvMsg::~RcvMsg()
 {
     delete mdChecker_;
+	delete gmacChecker_;
 }
 
 int ReliSock::RcvMsg::rcv_packet( char const *peer_description, SOCKET _sock, int _timeout)
 {
 	char	        hdr[MAX_HEADER_SIZE];
-	char *cksum_ptr = &hdr[5];
+	char *hdr_ptr = hdr;
 	int		len, len_t, header_size;
 	int		tmp_len;
 	int		retval;
 
+	header_size = this->header_size();
+
 	// We read the partial packet in a previous read; try to finish it and
 	// then skip down to packet verification.
 	if (m_partial_packet) {
 		m_partial_packet = false;
 		len = m_remaining_read_length;
-		cksum_ptr = m_partial_cksum;
+		hdr_ptr = m_partial_hdr;
 		goto read_packet;
 	}
 
-	header_size = (mode_ != MD_OFF) ? MAX_HEADER_SIZE : NORMAL_HEADER_SIZE;
-
 	retval = condor_read(peer_description,_sock,hdr,header_size,_timeout, 0, p_sock->is_non_blocking());
 	if ( retval == 0 ) {   // 0 means that the read would have blocked; unlike a normal read(), condor_read
 	                       // returns -2 if the socket has been closed.
@@ -825,8 +957,8 @@ read_packet:
 		if (p_sock->is_non_blocking() && (tmp_len >= 0)) {
 			m_partial_packet = true;
 			m_remaining_read_length = len - tmp_len;
-			if ( mode_ != MD_OFF && cksum_ptr != m_partial_cksum ) {
-				memcpy( m_partial_cksum, cksum_ptr, sizeof(m_partial_cksum) );
+			if ( mode_ != MD_OFF && hdr_ptr != m_partial_hdr ) {
+				memcpy( m_partial_hdr, hdr_ptr, header_size );
 			}
 			return 2;
 		} else {
@@ -840,7 +972,15 @@ read_packet:
 
         // Now, check MD
         if (mode_ != MD_OFF) {
-            if (!m_tmp->verifyMD(cksum_ptr, mdChecker_)) {
+            bool verified;
+            if (gmacChecker_) {
+                verified = m_tmp->verifyGMAC(&hdr_ptr[NORMAL_HEADER_SIZE], &hdr_ptr[MD_HEADER_SIZE],
+                                             hdr_ptr, NORMAL_HEADER_SIZE, gmacChecker_);
+            }
+            else {
+                verified = m_tmp->verifyMD(&hdr_ptr[NORMAL_HEADER_SIZE], mdChecker_);
+            }
+            if (!verified) {
                 delete m_tmp;
 		m_tmp = NULL;
                 dprintf(D_ALWAYS, "IO: Message Digest/MAC verification failed!\n");
@@ -865,14 +1005,18 @@ read_packet:
 ReliSock::SndMsg::SndMsg() : 
     mode_(MD_OFF), 
     mdChecker_(0),
+	gmacChecker_(0),
+	m_gmac_count(0),
 	p_sock(0),
 	m_out_buf(NULL)
 {
+	memset( m_gmac_iv, 0, sizeof(m_gmac_iv) );
 }
 
 ReliSock::SndMsg::~SndMsg() 
 {
     delete mdChecker_;
+	delete gmacChecker_;
 }
 
 int ReliSock::SndMsg::finish_packet(const char *peer_description, int sock, int timeout)
@@ -930,7 +1074,7 @@ int ReliSock::SndMsg::snd_packet( char const *peer_description, int _sock, int e
 	int		len, header_size;
 	int		ns;
 
-	header_size = (mode_ != MD_OFF) ? MAX_HEADER_SIZE : NORMAL_HEADER_SIZE;
+	header_size = this->header_size();
 	hdr[0] = (char) end;
 	ns = buf.num_used() - header_size;
 	len = (int) htonl(ns);
@@ -938,7 +1082,23 @@ int ReliSock::SndMsg::snd_packet( char const *peer_description, int _sock, int e
 	memcpy(&hdr[1], &len, 4);
 
 	if (mode_ != MD_OFF) {
-		if (!buf.computeMD(&hdr[5], mdChecker_)) {
+		bool computed;
+		if (gmacChecker_) {
+				// a new IV for every packet; start over from a
+				// new random one if the count ever wraps
+			if (++m_gmac_count == 0) {
+				init_gmac_iv();
+			}
+			unsigned int count = htonl(m_gmac_count);
+			memcpy(&m_gmac_iv[AESGCM_IV_SIZE - 4], &count, 4);
+			memcpy(&hdr[MD_HEADER_SIZE], m_gmac_iv, AESGCM_IV_SIZE);
+			computed = buf.computeGMAC(&hdr[NORMAL_HEADER_SIZE], &hdr[MD_HEADER_SIZE],
+									   hdr, NORMAL_HEADER_SIZE, header_size, gmacChecker_);
+		}
+		else {
+			computed = buf.computeMD(&hdr[NORMAL_HEADER_SIZE], mdChecker_);
+		}
+		if (!computed) {
 			dprintf(D_ALWAYS, "IO: Failed to compute Message Digest/MAC\n");
 			return FALSE;
 		}
@@ -971,14 +1131,40 @@ bool ReliSock::SndMsg::init_MD(CONDOR_MD_MODE mode, KeyInfo * key)
     mode_ = mode;
     delete mdChecker_;
 	mdChecker_ = 0;
+	delete gmacChecker_;
+	gmacChecker_ = 0;
 
     if (key) {
+#ifdef HAVE_EXT_OPENSSL
+		if (key->getProtocol() == CONDOR_AESGCM) {
+			gmacChecker_ = new Condor_Crypt_AESGCM(*key);
+			init_gmac_iv();
+		}
+		else
+#endif
         mdChecker_ = new Condor_MD_MAC(key);
     }
 
     return true;
 }
 
+int ReliSock::SndMsg::header_size() const
+{
+	if (mode_ == MD_OFF) {
+		return NORMAL_HEADER_SIZE;
+	}
+	return gmacChecker_ ? GMAC_HEADER_SIZE : MD_HEADER_SIZE;
+}
+
+void ReliSock::SndMsg::init_gmac_iv()
+{
+	unsigned char * random_iv = Condor_Crypt_Base::randomKey(AESGCM_IV_SIZE);
+	ASSERT( random_iv );
+	memcpy( m_gmac_iv, random_iv, AESGCM_IV_SIZE );
+	free( random_iv );
+	m_gmac_count = 0;
+}
+
 #ifndef WIN32
 	// interface no longer supported
 int 
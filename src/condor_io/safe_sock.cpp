@@ -32,6 +32,7 @@
 #include "condor_netdb.h"
 #include "selector.h"
 #include "condor_sockfunc.h"
+#include "condor_crypt_aesgcm.h"
 
 _condorMsgID SafeSock::_outMsgID = {0, 0, 0, 0};
 unsigned long SafeSock::_noMsgs = 0;
@@ -398,6 +399,7 @@ int SafeSock::put_bytes(const void *data, int sz)
 {
 	int bytesPut, l_out;
     unsigned char * dta = 0;
+	int iv_len = 0;
 
     //char str[10000];
     //str[0] = 0;
@@ -407,10 +409,27 @@ int SafeSock::put_bytes(const void *data, int sz)
     // Check to see if we need to encrypt
     // This works only because putn will actually put all 
     if (get_encryption()) {
+		unsigned char iv[AESGCM_IV_SIZE];
+		iv_len = pendingCryptoIV();
+		ASSERT( iv_len <= (int)sizeof(iv) );
+		if (iv_len > 0 && !startCryptoStream(iv, true)) {
+			return -1;
+		}
         if (!wrap((unsigned char *)const_cast<void*>(data), sz, dta , l_out)) { 
             dprintf(D_SECURITY, "Encryption failed\n");
             return -1;  // encryption failed!
         }
+			// the IV that starts the stream goes out in the clear
+			// ahead of the first encrypted bytes
+		if (iv_len > 0) {
+			unsigned char * with_iv = (unsigned char *) malloc(iv_len + sz);
+			ASSERT( with_iv );
+			memcpy(with_iv, iv, iv_len);
+			memcpy(with_iv + iv_len, dta, sz);
+			free(dta);
+			dta = with_iv;
+			sz += iv_len;
+		}
     }
     else {
         dta = (unsigned char *) malloc(sz);
@@ -430,7 +449,7 @@ int SafeSock::put_bytes(const void *data, int sz)
     
     free(dta);
     
-	return bytesPut;
+	return bytesPut - iv_len;
 }
 
 
@@ -470,6 +489,23 @@ int SafeSock::get_bytes(void *dta, int size)
 	int readSize, length;
     unsigned char * dec;
 
+		// read the IV that starts the encrypted stream, if there is one
+	if (get_encryption()) {
+		unsigned char iv[AESGCM_IV_SIZE];
+		int iv_len = pendingCryptoIV();
+		ASSERT( iv_len <= (int)sizeof(iv) );
+		if (iv_len > 0) {
+			int ivSize = _longMsg ? _longMsg->getn((char *)iv, iv_len)
+			                      : _shortMsg.getn((char *)iv, iv_len);
+			if (ivSize != iv_len || !startCryptoStream(iv, false)) {
+				free(tempBuf);
+				dprintf(D_NETWORK,
+				        "SafeSock::get_bytes - failed to read IV of encrypted data\n");
+				return -1;
+			}
+		}
+	}
+
 	if(_longMsg) {
         // long message 
         readSize = _longMsg->getn(tempBuf, size);
@@ -486,7 +522,11 @@ int SafeSock::get_bytes(void *dta, int size)
 
 	if(readSize == size) {
             if (get_encryption()) {
-                unwrap((unsigned char *) tempBuf, readSize, dec, length);
+                if (!unwrap((unsigned char *) tempBuf, readSize, dec, length)) {
+                    free(tempBuf);
+                    dprintf(D_NETWORK, "SafeSock::get_bytes - decryption failed\n");
+                    return -1;
+                }
                 memcpy(dta, dec, readSize);
                 free(dec);
             }
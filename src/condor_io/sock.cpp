@@ -51,6 +51,7 @@
 #ifdef HAVE_EXT_OPENSSL
 #include "condor_crypt_blowfish.h"
 #include "condor_crypt_3des.h"
+#include "condor_crypt_aesgcm.h"
 #include "condor_md.h"                // Message authentication stuff
 #endif
 
@@ -2656,6 +2657,48 @@ void Sock::resetCrypto()
 #endif
 }
 
+int Sock::pendingCryptoIV()
+{
+#ifdef HAVE_EXT_OPENSSL
+  if (crypto_) {
+    return crypto_->pendingIVLength();
+  }
+#endif
+  return 0;
+}
+
+bool Sock::startCryptoStream(unsigned char * iv, bool encrypting)
+{
+#ifdef HAVE_EXT_OPENSSL
+  if (crypto_ && crypto_->startStream(iv, encrypting)) {
+    return true;
+  }
+#endif
+  dprintf(D_SECURITY, "Failed to start %s crypto stream\n",
+          encrypting ? "outgoing" : "incoming");
+  return false;
+}
+
+int Sock::cryptoStreamTagLength()
+{
+#ifdef HAVE_EXT_OPENSSL
+  if (crypto_ && get_encryption() && !crypto_->pendingIVLength()) {
+    return crypto_->streamTagLength();
+  }
+#endif
+  return 0;
+}
+
+bool Sock::finishCryptoStream(unsigned char * tag)
+{
+#ifdef HAVE_EXT_OPENSSL
+  if (crypto_) {
+    return crypto_->finishStream(tag);
+  }
+#endif
+  return false;
+}
+
 bool 
 Sock::initialize_crypto(KeyInfo * key) 
 {
@@ -2676,6 +2719,10 @@ Sock::initialize_crypto(KeyInfo * key)
 			setCryptoMethodUsed("3DES");
             crypto_ = new Condor_Crypt_3des(*key);
             break;
+        case CONDOR_AESGCM:
+			setCryptoMethodUsed("AESGCM");
+            crypto_ = new Condor_Crypt_AESGCM(*key);
+            break;
 #endif
         default:
             break;
@@ -33,6 +33,7 @@ int getcount = 0;
 
 // initialize static data members
 int Stream::timeout_multiplier = 0;
+void (*Stream::deadline_observer)(time_t) = NULL;
 
 #if 0
 static int shipcount =0;
@@ -2100,12 +2101,24 @@ Stream::set_deadline_timeout(int t)
 		}
 		m_deadline_time = time(NULL) + t;
 	}
+	if( m_deadline_time && deadline_observer ) {
+		deadline_observer( m_deadline_time );
+	}
 }
 
 void
 Stream::set_deadline(time_t t)
 {
 	m_deadline_time = t;
+	if( m_deadline_time && deadline_observer ) {
+		deadline_observer( m_deadline_time );
+	}
+}
+
+void
+Stream::set_deadline_observer(void (*observer)(time_t))
+{
+	deadline_observer = observer;
 }
 
 time_t
@@ -0,0 +1,218 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "compat_classad.h"
+#include "match_workers.h"
+
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+
+struct MatchWorkerStart {
+	MatchWorkerPool *pool;
+	int worker;
+};
+
+static pthread_mutex_t match_worker_guard_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+MatchWorkerGuard::MatchWorkerGuard()
+{
+	pthread_mutex_lock( &match_worker_guard_mutex );
+}
+
+MatchWorkerGuard::~MatchWorkerGuard()
+{
+	pthread_mutex_unlock( &match_worker_guard_mutex );
+}
+
+MatchWorkerPool::MatchWorkerPool( int nworkers )
+	: m_shutdown(false), m_generation(0), m_func(NULL), m_arg(NULL),
+	  m_count(0), m_chunk(1), m_next(0), m_busy(0)
+{
+	pthread_mutex_init( &m_mutex, NULL );
+	pthread_cond_init( &m_work_cond, NULL );
+	pthread_cond_init( &m_done_cond, NULL );
+
+		// Signals belong to DaemonCore in the main thread; keep them
+		// all blocked in the workers.
+	sigset_t all, old;
+	sigfillset( &all );
+	pthread_sigmask( SIG_SETMASK, &all, &old );
+
+	for( int i = 1; i < nworkers; i++ ) {
+		MatchWorkerStart *start = new MatchWorkerStart;
+		start->pool = this;
+		start->worker = i;
+		pthread_t tid;
+		int rc = pthread_create( &tid, NULL, threadMain, start );
+		if( rc != 0 ) {
+			dprintf( D_ALWAYS, "Failed to start match worker thread %d: %s\n",
+					 i, strerror(rc) );
+			delete start;
+			break;
+		}
+		m_threads.push_back( tid );
+	}
+
+	pthread_sigmask( SIG_SETMASK, &old, NULL );
+
+	dprintf( D_ALWAYS, "Started %d match worker threads\n",
+			 (int)m_threads.size() );
+}
+
+MatchWorkerPool::~MatchWorkerPool()
+{
+	pthread_mutex_lock( &m_mutex );
+	m_shutdown = true;
+	pthread_cond_broadcast( &m_work_cond );
+	pthread_mutex_unlock( &m_mutex );
+
+	for( size_t i = 0; i < m_threads.size(); i++ ) {
+		pthread_join( m_threads[i], NULL );
+	}
+
+	pthread_cond_destroy( &m_done_cond );
+	pthread_cond_destroy( &m_work_cond );
+	pthread_mutex_destroy( &m_mutex );
+}
+
+int
+MatchWorkerPool::size() const
+{
+	return (int)m_threads.size() + 1;
+}
+
+void *
+MatchWorkerPool::threadMain( void *arg )
+{
+	MatchWorkerStart *start = (MatchWorkerStart *)arg;
+	MatchWorkerPool *pool = start->pool;
+	int worker = start->worker;
+	delete start;
+
+	unsigned seen = 0;
+	pthread_mutex_lock( &pool->m_mutex );
+	while( true ) {
+		while( !pool->m_shutdown && pool->m_generation == seen ) {
+			pthread_cond_wait( &pool->m_work_cond, &pool->m_mutex );
+		}
+		if( pool->m_shutdown ) {
+			break;
+		}
+		seen = pool->m_generation;
+		pool->m_busy++;
+		pthread_mutex_unlock( &pool->m_mutex );
+
+		pool->work( worker );
+
+		pthread_mutex_lock( &pool->m_mutex );
+		if( --pool->m_busy == 0 ) {
+			pthread_cond_signal( &pool->m_done_cond );
+		}
+	}
+	pthread_mutex_unlock( &pool->m_mutex );
+
+		// the match ad is per thread, so nobody else will free ours
+	compat_classad::deleteTheMatchAd();
+	return NULL;
+}
+
+	// Take chunks until there are none left.
+void
+MatchWorkerPool::work( int worker )
+{
+	while( true ) {
+		pthread_mutex_lock( &m_mutex );
+		int begin = m_next;
+		m_next += m_chunk;
+		pthread_mutex_unlock( &m_mutex );
+
+		if( begin >= m_count ) {
+			return;
+		}
+		int end = begin + m_chunk;
+		if( end > m_count ) {
+			end = m_count;
+		}
+		m_func( m_arg, worker, begin, end );
+	}
+}
+
+void
+MatchWorkerPool::run( WorkFunc func, void *arg, int count, int chunk )
+{
+	if( chunk < 1 ) {
+		chunk = 1;
+	}
+
+	pthread_mutex_lock( &m_mutex );
+	m_func = func;
+	m_arg = arg;
+	m_count = count;
+	m_chunk = chunk;
+	m_next = 0;
+	m_generation++;
+	pthread_cond_broadcast( &m_work_cond );
+	pthread_mutex_unlock( &m_mutex );
+
+	work( 0 );
+
+		// A worker that has not woken up yet by now will find nothing
+		// left to do, but it still counts itself busy until it sees
+		// that, so wait for everyone to be idle before returning.
+	pthread_mutex_lock( &m_mutex );
+	while( m_busy > 0 ) {
+		pthread_cond_wait( &m_done_cond, &m_mutex );
+	}
+	m_func = NULL;
+	m_arg = NULL;
+	pthread_mutex_unlock( &m_mutex );
+}
+
+#else /* no pthreads */
+
+MatchWorkerGuard::MatchWorkerGuard()
+{
+}
+
+MatchWorkerGuard::~MatchWorkerGuard()
+{
+}
+
+MatchWorkerPool::MatchWorkerPool( int /*nworkers*/ )
+{
+}
+
+MatchWorkerPool::~MatchWorkerPool()
+{
+}
+
+int
+MatchWorkerPool::size() const
+{
+	return 1;
+}
+
+void
+MatchWorkerPool::run( WorkFunc func, void *arg, int count, int /*chunk*/ )
+{
+	func( arg, 0, 0, count );
+}
+
+#endif
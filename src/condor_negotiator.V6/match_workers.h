@@ -0,0 +1,88 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _MATCH_WORKERS_H
+#define _MATCH_WORKERS_H
+
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+#include <pthread.h>
+#include <vector>
+#endif
+
+/**
+ * A fixed pool of threads used by the negotiator to scan offers in
+ * parallel (NEGOTIATOR_MATCH_THREADS).
+ *
+ * run() splits [0,count) into chunks and hands them out to the pool
+ * threads and the calling thread, returning once every chunk is done.
+ * The work function must not call dprintf(), param() or anything else
+ * that is not safe outside the main thread; it is told which of the
+ * size() workers it is running as, so it can use per-worker state.
+ *
+ * Without pthreads, run() simply does all the work in the caller.
+ */
+class MatchWorkerPool {
+ public:
+	typedef void (*WorkFunc)( void *arg, int worker, int begin, int end );
+
+		// nworkers includes the calling thread
+	MatchWorkerPool( int nworkers );
+	~MatchWorkerPool();
+
+		// number of workers actually available, including the caller
+	int size() const;
+
+	void run( WorkFunc func, void *arg, int count, int chunk );
+
+ private:
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+	static void *threadMain( void *arg );
+	void work( int worker );
+
+	std::vector<pthread_t> m_threads;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_work_cond;
+	pthread_cond_t m_done_cond;
+	bool m_shutdown;
+
+		// the current job; all protected by m_mutex
+	unsigned m_generation;
+	WorkFunc m_func;
+	void *m_arg;
+	int m_count;
+	int m_chunk;
+	int m_next;
+	int m_busy;
+#endif
+};
+
+/**
+ * Serializes code that the match workers can reach through ClassAd
+ * evaluation but that is not thread safe, such as the negotiator's
+ * ClassAd functions that consult the accountant.  The main thread is
+ * waiting in run() while the workers are busy, so this only has to
+ * keep the workers away from each other.
+ */
+class MatchWorkerGuard {
+ public:
+	MatchWorkerGuard();
+	~MatchWorkerGuard();
+};
+
+#endif
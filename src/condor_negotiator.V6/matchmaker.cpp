@@ -190,6 +190,7 @@ bool ResourcesInUseByUser_classad_func( const char * /*name*/,
 		return true;
 	}
 
+	MatchWorkerGuard guard;
 	float usage = matchmaker_for_classad_func->getAccountant().GetWeightedResourcesUsed(user.c_str());
 
 	result.SetRealValue( usage );
@@ -227,6 +228,7 @@ bool ResourcesInUseByUsersGroup_classad_func( const char * /*name*/,
 	float group_quota = 0;
 	float group_usage = 0;
     string group_name;
+	MatchWorkerGuard guard;
 	if( !matchmaker_for_classad_func->getGroupInfoFromUserId(user.c_str(),group_name,group_quota,group_usage) ) {
 		result.SetErrorValue();
 		return true;
@@ -265,12 +267,14 @@ Matchmaker ()
 	stashedAds = new AdHash(1000, HashFunc);
 
 	MatchList = NULL;
-	cachedAutoCluster = -1;
-	cachedName = NULL;
-	cachedAddr = NULL;
+	matchListCacheEntries = 0;
+	matchListCacheMaxEntries = 0;
+	matchListGeneration = 0;
 
 	want_globaljobprio = false;
 	want_matchlist_caching = false;
+	match_threads = 1;
+	match_workers = NULL;
 	ConsiderPreemption = true;
 	ConsiderEarlyPreemption = false;
 	want_nonblocking_startd_contact = true;
@@ -306,9 +310,6 @@ Matchmaker ()
 	rejForSubmitterLimit = 0;
 	rejForConcurrencyLimit = 0;
 
-	cachedPrio = 0;
-	cachedOnlyForStartdRank = false;
-
 		// just assign default values
 	want_inform_startd = true;
 	preemption_req_unstable = true;
@@ -344,11 +345,8 @@ Matchmaker::
 	delete NegotiatorPreJobRank;
 	delete NegotiatorPostJobRank;
 	delete sockCache;
-	if (MatchList) {
-		delete MatchList;
-	}
-	if ( cachedName ) free(cachedName);
-	if ( cachedAddr ) free(cachedAddr);
+	delete match_workers;
+	DeleteMatchList();
 
 	if (NegotiatorName) free (NegotiatorName);
 	if (publicAd) delete publicAd;
@@ -637,6 +635,25 @@ reinitialize ()
 
 	want_globaljobprio = param_boolean("USE_GLOBAL_JOB_PRIOS",false);
 	want_matchlist_caching = param_boolean("NEGOTIATOR_MATCHLIST_CACHING",true);
+	matchListCacheMaxEntries = param_integer("NEGOTIATOR_MATCHLIST_CACHE_SIZE",1000000,0);
+	DeleteMatchList();
+
+	int new_match_threads = param_integer("NEGOTIATOR_MATCH_THREADS", 1, 1, 1024);
+	if (new_match_threads != match_threads || (match_threads > 1 && !match_workers)) {
+		delete match_workers;
+		match_workers = NULL;
+		match_threads = new_match_threads;
+		if (match_threads > 1) {
+			match_workers = new MatchWorkerPool(match_threads);
+			if (match_workers->size() < 2) {
+				dprintf(D_ALWAYS, "No match worker threads available; "
+						"matching offers serially\n");
+				delete match_workers;
+				match_workers = NULL;
+			}
+		}
+	}
+	dprintf(D_ALWAYS, "NEGOTIATOR_MATCH_THREADS = %d\n", match_threads);
 	ConsiderPreemption = param_boolean("NEGOTIATOR_CONSIDER_PREEMPTION",true);
 	ConsiderEarlyPreemption = param_boolean("NEGOTIATOR_CONSIDER_EARLY_PREEMPTION",false);
 	if( ConsiderEarlyPreemption && !ConsiderPreemption ) {
@@ -1210,10 +1227,9 @@ negotiationTime ()
 
 	GotRescheduleCmd=false;  // Reset the reschedule cmd flag
 
-	// We need to nuke our MatchList from the previous negotiation cycle,
-	// since a different set of machines may now be available.
-	if (MatchList) delete MatchList;
-	MatchList = NULL;
+	// We need to nuke our MatchList cache from the previous negotiation
+	// cycle, since a different set of machines may now be available.
+	DeleteMatchList();
 
 	// ----- Get all required ads from the collector
     time_t start_time_phase1 = time(NULL);
@@ -2510,11 +2526,9 @@ negotiateWithGroup ( int untrimmed_num_startds,
             dprintf(D_ALWAYS, "Group %s is using its quota %g - halting negotiation\n", groupName, groupQuota);
             break;
         }
-			// invalidate the MatchList cache, because even if it is valid
-			// for the next user+auto_cluster being considered, we might
-			// have thrown out matches due to SlotWeight being too high
-			// given the schedd limit computed in the previous pie spin
-		DeleteMatchList();
+			// Note that the MatchList cache stays valid from one pie spin
+			// to the next: offers the submitter limit did not permit in
+			// the previous spin were left on the lists.
 
         // filter submitters with no idle jobs to avoid unneeded computations and log output
         if (!ConsiderPreemption) {
@@ -3849,8 +3863,10 @@ negotiate(char const* groupName, char const *scheddName, const ClassAd &daemonAd
 
 			// 2e(iii). if the matchmaking protocol failed, do not consider the
 			//			startd again for this negotiation cycle.
-			if (result == MM_BAD_MATCH)
+			if (result == MM_BAD_MATCH) {
 				startdAds.Remove (offer);
+				invalidateMatchListOffer(offer);
+			}
 
 			// 2e(iv).  if the matchmaking protocol failed to talk to the 
 			//			schedd, invalidate the connection and return
@@ -3913,6 +3929,9 @@ negotiate(char const* groupName, char const *scheddName, const ClassAd &daemonAd
             // traditional match cost is just slot weight expression
             match_cost = accountant.GetSlotWeight(offer);
         }
+        // Whether or not the offer is still in startdAds, any other match
+        // lists holding it were built from its state before this match.
+        invalidateMatchListOffer(offer);
         dprintf(D_FULLDEBUG, "Match completed, match cost= %g\n", match_cost);
 
 		limitUsed += match_cost;
@@ -3947,28 +3966,197 @@ updateNegCycleEndTime(time_t startTime, ClassAd *submitter) {
 	submitter->Insert(buffer.Value());
 }
 
+	// If deferred_errors is given, failures are appended to it rather
+	// than logged, for callers that are not in the main thread.
 float Matchmaker::
 EvalNegotiatorMatchRank(char const *expr_name,ExprTree *expr,
-                        ClassAd &request,ClassAd *resource)
+                        ClassAd &request,ClassAd *resource,
+                        std::string *deferred_errors)
 {
 	classad::Value result;
 	float rank = -(FLT_MAX);
+	char const *error = NULL;
 
 	if(expr && EvalExprTree(expr,resource,&request,result)) {
 		double val;
 		if( result.IsNumber(val) ) {
 			rank = (float)val;
 		} else {
-			dprintf(D_ALWAYS, "Failed to evaluate %s "
-			                  "expression to a float.\n",expr_name);
+			error = "Failed to evaluate %s expression to a float.\n";
 		}
 	} else if(expr) {
-		dprintf(D_ALWAYS, "Failed to evaluate %s "
-		                  "expression.\n",expr_name);
+		error = "Failed to evaluate %s expression.\n";
+	}
+	if( error ) {
+		if( deferred_errors ) {
+			formatstr_cat(*deferred_errors, error, expr_name);
+		} else {
+			dprintf(D_ALWAYS, error, expr_name);
+		}
 	}
 	return rank;
 }
 
+	// What one match worker uses to evaluate offers, so that no two
+	// threads ever evaluate against the same ads or expression trees.
+	// Offer ads are not copied; each one is only looked at by the
+	// worker that owns its chunk.
+struct OfferEvalContext {
+	OfferEvalContext(ClassAd &req, ExprTree *std_cond, ExprTree *prio_cond,
+					 ExprTree *preempt_req, ExprTree *pre_job_rank,
+					 ExprTree *post_job_rank, ExprTree *preempt_rank)
+		: request(req)
+	{
+		rankCondStd = std_cond ? std_cond->Copy() : NULL;
+		rankCondPrioPreempt = prio_cond ? prio_cond->Copy() : NULL;
+		PreemptionReq = preempt_req ? preempt_req->Copy() : NULL;
+		NegotiatorPreJobRank = pre_job_rank ? pre_job_rank->Copy() : NULL;
+		NegotiatorPostJobRank = post_job_rank ? post_job_rank->Copy() : NULL;
+		PreemptionRank = preempt_rank ? preempt_rank->Copy() : NULL;
+	}
+	~OfferEvalContext()
+	{
+		delete rankCondStd;
+		delete rankCondPrioPreempt;
+		delete PreemptionReq;
+		delete NegotiatorPreJobRank;
+		delete NegotiatorPostJobRank;
+		delete PreemptionRank;
+	}
+
+	ClassAd request;
+	ExprTree *rankCondStd;
+	ExprTree *rankCondPrioPreempt;
+	ExprTree *PreemptionReq;
+	ExprTree *NegotiatorPreJobRank;
+	ExprTree *NegotiatorPostJobRank;
+	ExprTree *PreemptionRank;
+};
+
+struct OfferEvalJob {
+	std::vector<ClassAd *> offers;
+	std::vector<Matchmaker::OfferEval> *evals;
+	std::vector<OfferEvalContext *> contexts;
+	bool only_for_startdrank;
+};
+
+static bool
+EvalMatchCondition(ExprTree *expr, ClassAd *offer, ClassAd &request)
+{
+	classad::Value result;
+	bool val;
+	return EvalExprTree(expr, offer, &request, result) &&
+		result.IsBooleanValue(val) && val;
+}
+
+	// Runs in the match worker threads; must stay free of dprintf(),
+	// param() and the accountant.  Mirrors the per-offer evaluations
+	// in matchmakingAlgorithm(), which has the final say.
+void Matchmaker::
+evaluateOffers(void *arg, int worker, int begin, int end)
+{
+	OfferEvalJob *job = (OfferEvalJob *)arg;
+	OfferEvalContext &ctx = *job->contexts[worker];
+
+	for (int i = begin; i < end; i++) {
+		ClassAd *offer = job->offers[i];
+		OfferEval &eval = (*job->evals)[i];
+
+			// consumption policies rewrite the request while matching
+		if (cp_supports_policy(*offer)) {
+			eval.evaluated = false;
+			continue;
+		}
+		eval.evaluated = true;
+		eval.isAMatch = IsAMatch(&ctx.request, offer);
+		if (!eval.isAMatch) {
+			continue;
+		}
+
+		string remoteUser;
+		if (!offer->LookupString(ATTR_PREEMPTING_ACCOUNTING_GROUP, remoteUser)) {
+			if (!offer->LookupString(ATTR_PREEMPTING_USER, remoteUser)) {
+				if (!offer->LookupString(ATTR_ACCOUNTING_GROUP, remoteUser)) {
+					offer->LookupString(ATTR_REMOTE_USER, remoteUser);
+				}
+			}
+		}
+		bool has_remote_user = (remoteUser != "");
+		if (!has_remote_user && job->only_for_startdrank) {
+			continue;
+		}
+
+		eval.rankCondStd = false;
+		eval.rankCondPrioPreempt = false;
+		eval.preemptionReq = false;
+		if (has_remote_user) {
+			eval.rankCondStd = EvalMatchCondition(ctx.rankCondStd, offer, ctx.request);
+			if (!eval.rankCondStd && !job->only_for_startdrank) {
+				eval.preemptionReq = !ctx.PreemptionReq ||
+					EvalMatchCondition(ctx.PreemptionReq, offer, ctx.request);
+				eval.rankCondPrioPreempt =
+					EvalMatchCondition(ctx.rankCondPrioPreempt, offer, ctx.request);
+			}
+		}
+
+		eval.preJobRank = EvalNegotiatorMatchRank(
+			"NEGOTIATOR_PRE_JOB_RANK", ctx.NegotiatorPreJobRank,
+			ctx.request, offer, &eval.rankErrors);
+
+		float tmp;
+		if (!ctx.request.EvalFloat(ATTR_RANK, offer, tmp)) {
+			tmp = 0.0;
+		}
+		eval.jobRank = tmp;
+
+		eval.postJobRank = EvalNegotiatorMatchRank(
+			"NEGOTIATOR_POST_JOB_RANK", ctx.NegotiatorPostJobRank,
+			ctx.request, offer, &eval.rankErrors);
+
+		eval.preemptRank = -(FLT_MAX);
+		if (has_remote_user) {
+			eval.preemptRank = EvalNegotiatorMatchRank(
+				"PREEMPTION_RANK", ctx.PreemptionRank,
+				ctx.request, offer, &eval.preemptRankErrors);
+		}
+	}
+}
+
+void Matchmaker::
+preevaluateOffers(ClassAd &request, ClassAdListDoesNotDeleteAds &startdAds,
+				  bool only_for_startdrank, std::vector<OfferEval> &evals)
+{
+	OfferEvalJob job;
+	job.evals = &evals;
+	job.only_for_startdrank = only_for_startdrank;
+
+	ClassAd *offer;
+	job.offers.reserve(startdAds.Length());
+	startdAds.Open();
+	while ((offer = startdAds.Next())) {
+		job.offers.push_back(offer);
+	}
+	startdAds.Close();
+
+	evals.clear();
+	evals.resize(job.offers.size());
+
+		// copies are made here, since the ClassAd library's expression
+		// cache is not thread safe
+	for (int i = 0; i < match_workers->size(); i++) {
+		job.contexts.push_back(new OfferEvalContext(request,
+			rankCondStd, rankCondPrioPreempt, PreemptionReq,
+			NegotiatorPreJobRank, NegotiatorPostJobRank, PreemptionRank));
+	}
+
+		// small chunks, since offers vary a lot in how long they take
+	match_workers->run(evaluateOffers, &job, (int)job.offers.size(), 64);
+
+	for (size_t i = 0; i < job.contexts.size(); i++) {
+		delete job.contexts[i];
+	}
+}
+
 bool Matchmaker::
 SubmitterLimitPermits(ClassAd* request, ClassAd* candidate, double used, double allowed, double pieLeft) {
     double match_cost = 0;
@@ -4086,88 +4274,78 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 
 	request.LookupInteger(ATTR_AUTO_CLUSTER_ID, requestAutoCluster);
 
-		// If this incoming job is from the same user, same schedd,
-		// and is in the same autocluster, and we have a MatchList cache,
-		// then we can just pop off
-		// the top entry in our MatchList if we have one.  The 
+		// If we have already seen a job from the same user, same schedd,
+		// and in the same autocluster this cycle, and we have a MatchList
+		// cached for it, then we can just take
+		// the top entry off of that MatchList.  The 
 		// MatchList is essentially just a sorted cache of the machine
 		// ads that match jobs of this type (i.e. same autocluster).
-	if ( MatchList &&
-		 cachedAutoCluster != -1 &&
-		 cachedAutoCluster == requestAutoCluster &&
-		 cachedPrio == preemptPrio &&
-		 cachedOnlyForStartdRank == only_for_startdrank &&
-		 strcmp(cachedName,scheddName)==0 &&
-		 strcmp(cachedAddr,scheddAddr)==0 &&
-		 MatchList->cache_still_valid(request,PreemptionReq,PreemptionRank,
-					preemption_req_unstable,preemption_rank_unstable) )
-	{
-		// we can use cached information.  pop off the best
-		// candidate from our sorted list.
-		while( (cached_bestSoFar = MatchList->pop_candidate()) ) {
-            int t = 0;
-            cached_bestSoFar->LookupInteger(ATTR_PREEMPT_STATE_, t);
-            PreemptState pstate = PreemptState(t);
-			if ((pstate != NO_PREEMPTION) && SubmitterLimitPermits(&request, cached_bestSoFar, limitUsed, submitterLimit, pieLeft)) {
-				break;
-			} else if (SubmitterLimitPermits(&request, cached_bestSoFar, limitUsedUnclaimed, submitterLimitUnclaimed, pieLeft)) {
-				break;
-            }
-			MatchList->increment_rejForSubmitterLimit();
-		}
-		dprintf(D_FULLDEBUG,"Attempting to use cached MatchList: %s (MatchList length: %d, Autocluster: %d, Schedd Name: %s, Schedd Address: %s)\n",
-			cached_bestSoFar?"Succeeded.":"Failed",
-			MatchList->length(),
-			requestAutoCluster,
-			scheddName,
-			scheddAddr
-			);
-		if ( ! cached_bestSoFar ) {
-				// if we don't have a candidate, fill in
-				// all the rejection reason counts.
-			MatchList->get_diagnostics(
-				rejForNetwork,
-				rejForNetworkShare,
-				rejForConcurrencyLimit,
-				rejPreemptForPrio,
-				rejPreemptForPolicy,
-				rejPreemptForRank,
-				rejForSubmitterLimit);
-		}
-			//  TODO  - compare results, reserve net bandwidth
-		if ( cached_bestSoFar ) {
-			int cluster_id_new;
-			int proc_id_new;
-			int estimated_upload_time;
-			std::string slot_name;
-			request.LookupInteger(ATTR_CLUSTER_ID, cluster_id_new);
-			request.LookupInteger(ATTR_PROC_ID, proc_id_new);
-			cached_bestSoFar->LookupInteger("EstimatedUploadFileTransferTime", estimated_upload_time);
-			cached_bestSoFar->EvaluateAttrString("Name", slot_name);
-			dprintf(D_FULLDEBUG, "Exp: cluster id %d, proc id %d, estimated upload time %d, slot name %s\n", cluster_id_new, proc_id_new, estimated_upload_time, slot_name.c_str());
+	MatchListKey matchListKey(scheddName, scheddAddr, requestAutoCluster,
+							  preemptPrio, only_for_startdrank);
+	MatchList = NULL;
+	MatchListCache::iterator cached = matchListCache.end();
+	if ( requestAutoCluster != -1 ) {
+		cached = matchListCache.find(matchListKey);
+	}
+	if ( cached != matchListCache.end() ) {
+		MatchList = cached->second;
+		bool still_valid = true;
+		cached_bestSoFar = takeMatchListCandidate(MatchList, request,
+			limitUsed, submitterLimit, limitUsedUnclaimed,
+			submitterLimitUnclaimed, pieLeft, true, still_valid);
+		if ( still_valid ) {
+			dprintf(D_FULLDEBUG,"Attempting to use cached MatchList: %s (MatchList length: %d, Autocluster: %d, Schedd Name: %s, Schedd Address: %s)\n",
+				cached_bestSoFar?"Succeeded.":"Failed",
+				MatchList->length(),
+				requestAutoCluster,
+				scheddName,
+				scheddAddr
+				);
+			if ( ! cached_bestSoFar ) {
+					// if we don't have a candidate, fill in
+					// all the rejection reason counts.  Concurrency
+					// limits were checked afresh above, so do not let
+					// the count saved with the list overwrite that.
+				int cachedRejForConcurrencyLimit = 0;
+				MatchList->get_diagnostics(
+					rejForNetwork,
+					rejForNetworkShare,
+					cachedRejForConcurrencyLimit,
+					rejPreemptForPrio,
+					rejPreemptForPolicy,
+					rejPreemptForRank);
+			}
+				//  TODO  - compare results, reserve net bandwidth
+			if ( cached_bestSoFar ) {
+				int cluster_id_new;
+				int proc_id_new;
+				int estimated_upload_time;
+				std::string slot_name;
+				request.LookupInteger(ATTR_CLUSTER_ID, cluster_id_new);
+				request.LookupInteger(ATTR_PROC_ID, proc_id_new);
+				cached_bestSoFar->LookupInteger("EstimatedUploadFileTransferTime", estimated_upload_time);
+				cached_bestSoFar->EvaluateAttrString("Name", slot_name);
+				dprintf(D_FULLDEBUG, "Exp: cluster id %d, proc id %d, estimated upload time %d, slot name %s\n", cluster_id_new, proc_id_new, estimated_upload_time, slot_name.c_str());
+			}
+			return cached_bestSoFar;
 		}
-		return cached_bestSoFar;
-	}
 
-		// Delete our old MatchList, since we know that if we made it here
-		// we no longer are dealing with a job from the same autocluster.
-		// (someday we will store it in case we see another job with
-		// the same autocluster, but we aren't that smart yet...)
-	DeleteMatchList();
+			// This list can no longer be trusted; build a new one below.
+		matchListCacheEntries -= MatchList->length();
+		delete MatchList;
+		MatchList = NULL;
+		matchListCache.erase(cached);
+	}
 
 		// Create a new MatchList cache if desired via config file,
 		// and the job ad contains autocluster info,
 		// and there are machines potentially available to consider.		
 	if ( want_matchlist_caching &&		// desired via config file
+		 matchListCacheMaxEntries > 0 &&	// NEGOTIATOR_MATCHLIST_CACHE_SIZE=0 disables it
 		 requestAutoCluster != -1 &&	// job ad contains autocluster info
 		 startdAds.Length() > 0 )		// machines available
 	{
-		MatchList = new MatchListType( startdAds.Length() );
-		cachedAutoCluster = requestAutoCluster;
-		cachedPrio = preemptPrio;
-		cachedOnlyForStartdRank = only_for_startdrank;
-		cachedName = strdup(scheddName);
-		cachedAddr = strdup(scheddAddr);
+		MatchList = new MatchListType( matchListGeneration );
 	}
 
 
@@ -4179,39 +4357,67 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 	rejPreemptForRank = 0;
 	rejForSubmitterLimit = 0;
 
+		// With match worker threads, evaluate matches and ranks of all
+		// offers in parallel first.  Everything that depends on the
+		// accountant or on earlier offers still happens below.
+	std::vector<OfferEval> offerEvals;
+	if ( match_workers &&
+		 startdAds.Length() >= 4 * match_workers->size() )
+	{
+		double scan_start = _condor_debug_get_time_double();
+		preevaluateOffers(request, startdAds, only_for_startdrank, offerEvals);
+		dprintf(D_FULLDEBUG, "Evaluated %d offers with %d match threads in %.3fs\n",
+				(int)offerEvals.size(), match_workers->size(),
+				_condor_debug_get_time_double() - scan_start);
+	}
+
 	// scan the offer ads
+	int offer_index = -1;
 	startdAds.Open ();
 	while ((candidate = startdAds.Next ())) {
+		offer_index++;
+		OfferEval *pre = NULL;
+		if ( offer_index < (int)offerEvals.size() &&
+			 offerEvals[offer_index].evaluated ) {
+			pre = &offerEvals[offer_index];
+		}
 
 		if( IsDebugVerbose(D_MACHINE) ) {
 			dprintf(D_MACHINE,"Testing whether the job matches with the following machine ad:\n");
 			dPrintAd(D_MACHINE, *candidate);
 		}
 
-        consumption_map_t consumption;
-        bool has_cp = cp_supports_policy(*candidate);
-        bool cp_sufficient = true;
-        if (has_cp) {
-            // replace RequestXxx attributes (temporarily) with values derived from
-            // the consumption policy, so that Requirements expressions evaluate in a
-            // manner consistent with the check on CP resources 
-            cp_override_requested(request, *candidate, consumption);
-            cp_sufficient = cp_sufficient_assets(*candidate, consumption);
-        }
+		bool is_a_match;
+		if ( pre ) {
+			is_a_match = pre->isAMatch;
+		} else {
+            consumption_map_t consumption;
+            bool has_cp = cp_supports_policy(*candidate);
+            bool cp_sufficient = true;
+            if (has_cp) {
+                // replace RequestXxx attributes (temporarily) with values derived from
+                // the consumption policy, so that Requirements expressions evaluate in a
+                // manner consistent with the check on CP resources 
+                cp_override_requested(request, *candidate, consumption);
+                cp_sufficient = cp_sufficient_assets(*candidate, consumption);
+            }
 
-		// The candidate offer and request must match.
-        // When candidate supports a consumption policy, then resources
-        // requested via consumption policy must also be available from
-        // the resource
-		bool is_a_match = cp_sufficient && IsAMatch(&request, candidate);
+			// The candidate offer and request must match.
+            // When candidate supports a consumption policy, then resources
+            // requested via consumption policy must also be available from
+            // the resource
+			is_a_match = cp_sufficient && IsAMatch(&request, candidate);
 
-        if (has_cp) {
-            // put original values back for RequestXxx attributes
-            cp_restore_requested(request, consumption);
-        }
+            if (has_cp) {
+                // put original values back for RequestXxx attributes
+                cp_restore_requested(request, consumption);
+            }
+		}
 
 		bool pslotRankMatch = false;
 		if (!is_a_match) {
+				// nothing else was evaluated for this offer
+			pre = NULL;
 			if (param_boolean("ALLOW_PSLOT_PREEMPTION", true)) {
 				is_a_match = pslotMultiMatch(&request, candidate);
 				pslotRankMatch = true;
@@ -4273,8 +4479,9 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 						machine_name.Value(), cluster_id, proc_id);
 				continue;
 			}
-			if ( !(EvalExprTree(rankCondStd, candidate, &request, result) && 
-				   result.IsBooleanValue(val) && val) ) {
+			if ( !(pre ? pre->rankCondStd :
+				   (EvalExprTree(rankCondStd, candidate, &request, result) && 
+				   result.IsBooleanValue(val) && val)) ) {
 					// offer does not strictly prefer this request.
 					// try the next offer since only_for_statdrank flag is set
 
@@ -4294,8 +4501,9 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 		//       tested above for the only condition we care about.
 		if ( (remoteUser != "") &&
 			 (!only_for_startdrank) ) {
-			if( EvalExprTree(rankCondStd, candidate, &request, result) && 
-				result.IsBooleanValue(val) && val ) {
+			if( pre ? pre->rankCondStd :
+				(EvalExprTree(rankCondStd, candidate, &request, result) && 
+				result.IsBooleanValue(val) && val) ) {
 					// offer strictly prefers this request to the one
 					// currently being serviced; preempt for rank
 				candidatePreemptState = RANK_PREEMPTION;
@@ -4308,8 +4516,9 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 					// (1) we need to make sure that PreemptionReq's hold (i.e.,
 					// if the PreemptionReq expression isn't true, dont preempt)
 				if (PreemptionReq && 
-					!(EvalExprTree(PreemptionReq,candidate,&request,result) &&
-					  result.IsBooleanValue(val) && val) ) {
+					!(pre ? pre->preemptionReq :
+					  (EvalExprTree(PreemptionReq,candidate,&request,result) &&
+					  result.IsBooleanValue(val) && val)) ) {
 					rejPreemptForPolicy++;
 					dprintf(D_MACHINE,
 							"PREEMPTION_REQUIREMENTS prevents job %d.%d from claiming %s.\n",
@@ -4319,8 +4528,9 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 					// (2) we need to make sure that the machine ranks the job
 					// at least as well as the one it is currently running 
 					// (i.e., rankCondPrioPreempt holds)
-				if(!(EvalExprTree(rankCondPrioPreempt,candidate,&request,result)&&
-					 result.IsBooleanValue(val) && val ) ) {
+				if(!(pre ? pre->rankCondPrioPreempt :
+					 (EvalExprTree(rankCondPrioPreempt,candidate,&request,result)&&
+					 result.IsBooleanValue(val) && val) ) ) {
 						// machine doesn't like this job as much -- find another
 					rejPreemptForRank++;
 					dprintf(D_MACHINE,
@@ -4347,8 +4557,13 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 		   yet another machine. HOWEVER, do NOT perform this submitter limit
 		   check if we are negotiating only for startd rank, since startd rank
 		   preemptions should be allowed regardless of user priorities. 
+		   When building a MatchList, this check is left to
+		   takeMatchListCandidate(), so the list is still complete
+		   when the submitter limit grows.
 	    */
-        if ((candidatePreemptState == PRIO_PREEMPTION) && !SubmitterLimitPermits(&request, candidate, limitUsed, submitterLimit, pieLeft)) {
+        if (MatchList) {
+            // checked when the candidate is taken off the list
+        } else if ((candidatePreemptState == PRIO_PREEMPTION) && !SubmitterLimitPermits(&request, candidate, limitUsed, submitterLimit, pieLeft)) {
             rejForSubmitterLimit++;
             continue;
         } else if ((candidatePreemptState == NO_PREEMPTION) && !SubmitterLimitPermits(&request, candidate, limitUsedUnclaimed, submitterLimitUnclaimed, pieLeft)) {
@@ -4359,25 +4574,41 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 		sPrintAd(candidate_classad_str, *candidate);
 		dprintf(D_FULLDEBUG, "The worker node candidate classad is: %s\n", candidate_classad_str.Value());
 
-		candidatePreJobRankValue = EvalNegotiatorMatchRank(
-		  "NEGOTIATOR_PRE_JOB_RANK",NegotiatorPreJobRank,
-		  request,candidate);
-
-		// calculate the request's rank of the offer
-		if(!request.EvalFloat(ATTR_RANK,candidate,tmp)) {
-			tmp = 0.0;
-		}
-		candidateRankValue = tmp;
+		if ( pre ) {
+			if ( !pre->rankErrors.empty() ) {
+				dprintf(D_ALWAYS, "%s", pre->rankErrors.c_str());
+			}
+			candidatePreJobRankValue = pre->preJobRank;
+			candidateRankValue = pre->jobRank;
+			candidatePostJobRankValue = pre->postJobRank;
+			candidatePreemptRankValue = -(FLT_MAX);
+			if(candidatePreemptState != NO_PREEMPTION) {
+				if ( !pre->preemptRankErrors.empty() ) {
+					dprintf(D_ALWAYS, "%s", pre->preemptRankErrors.c_str());
+				}
+				candidatePreemptRankValue = pre->preemptRank;
+			}
+		} else {
+			candidatePreJobRankValue = EvalNegotiatorMatchRank(
+			  "NEGOTIATOR_PRE_JOB_RANK",NegotiatorPreJobRank,
+			  request,candidate);
 
-		candidatePostJobRankValue = EvalNegotiatorMatchRank(
-		  "NEGOTIATOR_POST_JOB_RANK",NegotiatorPostJobRank,
-		  request,candidate);
+			// calculate the request's rank of the offer
+			if(!request.EvalFloat(ATTR_RANK,candidate,tmp)) {
+				tmp = 0.0;
+			}
+			candidateRankValue = tmp;
 
-		candidatePreemptRankValue = -(FLT_MAX);
-		if(candidatePreemptState != NO_PREEMPTION) {
-			candidatePreemptRankValue = EvalNegotiatorMatchRank(
-			  "PREEMPTION_RANK",PreemptionRank,
+			candidatePostJobRankValue = EvalNegotiatorMatchRank(
+			  "NEGOTIATOR_POST_JOB_RANK",NegotiatorPostJobRank,
 			  request,candidate);
+
+			candidatePreemptRankValue = -(FLT_MAX);
+			if(candidatePreemptState != NO_PREEMPTION) {
+				candidatePreemptRankValue = EvalNegotiatorMatchRank(
+				  "PREEMPTION_RANK",PreemptionRank,
+				  request,candidate);
+			}
 		}
 
 		if ( MatchList ) {
@@ -4389,6 +4620,8 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 					candidatePreemptRankValue,
 					candidatePreemptState
 					);
+				// the best one is taken off the sorted list below
+			continue;
 		}
 
 		// NOTE!!!   IF YOU CHANGE THE LOGIC OF THE BELOW LEXICOGRAPHIC
@@ -4445,8 +4678,7 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 	if ( MatchList ) {
 		MatchList->set_diagnostics(rejForNetwork, rejForNetworkShare, 
 		    rejForConcurrencyLimit,
-			rejPreemptForPrio, rejPreemptForPolicy, rejPreemptForRank,
-			rejForSubmitterLimit);
+			rejPreemptForPrio, rejPreemptForPolicy, rejPreemptForRank);
 			// only bother sorting if there is more than one entry
 		if ( MatchList->length() > 1 ) {
 			dprintf(D_FULLDEBUG,"Start of sorting MatchList (len=%d)\n",
@@ -4454,8 +4686,31 @@ matchmakingAlgorithm(const char *scheddName, const char *scheddAddr, const Class
 			MatchList->sort();
 			dprintf(D_FULLDEBUG,"Finished sorting MatchList\n");
 		}
-		// Pop top candidate off the list to hand out as best match
-		bestSoFar = MatchList->pop_candidate();
+
+			// Keep the list for later jobs of this autocluster, making
+			// room for it first if the cache has grown too large.
+		if ( matchListCacheEntries + MatchList->length() > matchListCacheMaxEntries &&
+			 !matchListCache.empty() )
+		{
+			dprintf(D_FULLDEBUG,"Discarding %d cached MatchLists (%d entries, NEGOTIATOR_MATCHLIST_CACHE_SIZE=%d)\n",
+				(int)matchListCache.size(), matchListCacheEntries,
+				matchListCacheMaxEntries);
+			for ( MatchListCache::iterator it = matchListCache.begin();
+				  it != matchListCache.end(); ++it )
+			{
+				delete it->second;
+			}
+			matchListCache.clear();
+			matchListCacheEntries = 0;
+		}
+		matchListCache[matchListKey] = MatchList;
+		matchListCacheEntries += MatchList->length();
+
+		// Take top candidate off the list to hand out as best match
+		bool still_valid = true;
+		bestSoFar = takeMatchListCandidate(MatchList, request,
+			limitUsed, submitterLimit, limitUsedUnclaimed,
+			submitterLimitUnclaimed, pieLeft, false, still_valid);
 	}
 
 	if(!bestSoFar)
@@ -5104,99 +5359,64 @@ unsigned int Matchmaker::HashFunc(const MyString &Key) {
 }
 
 Matchmaker::MatchListType::
-MatchListType(int maxlen)
+MatchListType(unsigned generation)
 {
-	ASSERT(maxlen > 0);
-	AdListArray = new AdListEntry[maxlen];
-	ASSERT(AdListArray);
-	adListMaxLen = maxlen;
 	already_sorted = false;
 	adListLen = 0;
 	adListHead = 0;
+	m_generation = generation;
 	m_rejForNetwork = 0; 
 	m_rejForNetworkShare = 0;
 	m_rejForConcurrencyLimit = 0;
 	m_rejPreemptForPrio = 0;
 	m_rejPreemptForPolicy = 0; 
 	m_rejPreemptForRank = 0;
-	m_rejForSubmitterLimit = 0;
-	m_submitterLimit = 0.0f;
 }
 
 Matchmaker::MatchListType::
 ~MatchListType()
 {
-	if (AdListArray) {
-		delete [] AdListArray;
-	}
 }
 
 
-#if 0
 Matchmaker::AdListEntry* Matchmaker::MatchListType::
-peek_candidate()
+next_candidate(int &pos)
 {
-	ClassAd* candidate = NULL;
-	int temp_adListHead = adListHead;
-
-	while ( temp_adListHead < adListLen && !candidate ) {
-		candidate = AdListArray[temp_adListHead].ad;
-		temp_adListHead++;
+	if ( pos < adListHead ) {
+		pos = adListHead;
 	}
-
-	if ( candidate ) {
-		temp_adListHead--;
-		ASSERT( temp_adListHead >= 0 );
-		return AdListArray[temp_adListHead];
-	} else {
-		return NULL;
+	while ( pos < (int)AdListArray.size() ) {
+		if ( AdListArray[pos].ad ) {
+			return &AdListArray[pos];
+		}
+		pos++;
 	}
+	return NULL;
 }
-#endif
 
-ClassAd* Matchmaker::MatchListType::
-pop_candidate()
+void Matchmaker::MatchListType::
+remove_candidate(int pos)
 {
-	ClassAd* candidate = NULL;
-
-	while ( adListHead < adListLen && !candidate ) {
-		candidate = AdListArray[adListHead].ad;
+	ASSERT( pos >= 0 && pos < (int)AdListArray.size() );
+	if ( !AdListArray[pos].ad ) {
+		return;
+	}
+	AdListArray[pos].ad = NULL;
+	adListLen--;
+	while ( adListHead < (int)AdListArray.size() && !AdListArray[adListHead].ad ) {
 		adListHead++;
 	}
-
-	return candidate;
 }
 
 bool Matchmaker::MatchListType::
-cache_still_valid(ClassAd &request, ExprTree *preemption_req, ExprTree *preemption_rank,
+candidate_still_valid(AdListEntry *next_entry, ClassAd &request,
+				  ExprTree *preemption_req, ExprTree *preemption_rank,
 				  bool preemption_req_unstable, bool preemption_rank_unstable)
 {
-	AdListEntry* next_entry = NULL;
-
 	if ( !preemption_req_unstable && !preemption_rank_unstable ) {
 		return true;
 	}
 
-	// Set next_entry to be a "peek" at the next entry on
-	// our cached match list, i.e. don't actually pop it off our list.
-	{
-		ClassAd* candidate = NULL;
-		int temp_adListHead = adListHead;
-
-		while ( temp_adListHead < adListLen && !candidate ) {
-			candidate = AdListArray[temp_adListHead].ad;
-			temp_adListHead++;
-		}
-
-		if ( candidate ) {
-			temp_adListHead--;
-			ASSERT( temp_adListHead >= 0 );
-			next_entry =  &AdListArray[temp_adListHead];
-		} else {
-			next_entry = NULL;
-		}
-	}
-
 	if ( preemption_req_unstable ) 
 	{
 		if ( !next_entry ) {
@@ -5245,8 +5465,7 @@ get_diagnostics(int & rejForNetwork,
 					int & rejForConcurrencyLimit,
 					int & rejPreemptForPrio,
 					int & rejPreemptForPolicy,
-				    int & rejPreemptForRank,
-				    int & rejForSubmitterLimit)
+				    int & rejPreemptForRank)
 {
 	rejForNetwork = m_rejForNetwork;
 	rejForNetworkShare = m_rejForNetworkShare;
@@ -5254,7 +5473,6 @@ get_diagnostics(int & rejForNetwork,
 	rejPreemptForPrio = m_rejPreemptForPrio;
 	rejPreemptForPolicy = m_rejPreemptForPolicy;
 	rejPreemptForRank = m_rejPreemptForRank;
-	rejForSubmitterLimit = m_rejForSubmitterLimit;
 }
 
 void Matchmaker::MatchListType::
@@ -5263,8 +5481,7 @@ set_diagnostics(int rejForNetwork,
 					int rejForConcurrencyLimit,
 					int rejPreemptForPrio,
 					int rejPreemptForPolicy,
-				    int rejPreemptForRank,
-				    int rejForSubmitterLimit)
+				    int rejPreemptForRank)
 {
 	m_rejForNetwork = rejForNetwork;
 	m_rejForNetworkShare = rejForNetworkShare;
@@ -5272,7 +5489,6 @@ set_diagnostics(int rejForNetwork,
 	m_rejPreemptForPrio = rejPreemptForPrio;
 	m_rejPreemptForPolicy = rejPreemptForPolicy;
 	m_rejPreemptForRank = rejPreemptForRank;
-	m_rejForSubmitterLimit = rejForSubmitterLimit;
 }
 
 void Matchmaker::MatchListType::
@@ -5283,21 +5499,17 @@ add_candidate(ClassAd * candidate,
 					double candidatePreemptRankValue,
 					PreemptState candidatePreemptState)
 {
-	ASSERT(AdListArray);
-	ASSERT(adListLen < adListMaxLen);  // don't write off end of array!
-
-	AdListArray[adListLen].ad = candidate;
-	AdListArray[adListLen].RankValue = candidateRankValue;
-	AdListArray[adListLen].PreJobRankValue = candidatePreJobRankValue;
-	AdListArray[adListLen].PostJobRankValue = candidatePostJobRankValue;
-	AdListArray[adListLen].PreemptRankValue = candidatePreemptRankValue;
-	AdListArray[adListLen].PreemptStateValue = candidatePreemptState;
-
-    // This hack allows me to avoid mucking with the pseudo-que-like semantics of MatchListType, 
-    // which ought to be replaced with something cleaner like std::deque<AdListEntry>
-    if (NULL != AdListArray[adListLen].ad) {
-        AdListArray[adListLen].ad->Assign(ATTR_PREEMPT_STATE_, int(candidatePreemptState));
-    }
+	ASSERT(candidate);
+	ASSERT(!already_sorted);
+
+	AdListEntry entry;
+	entry.ad = candidate;
+	entry.RankValue = candidateRankValue;
+	entry.PreJobRankValue = candidatePreJobRankValue;
+	entry.PostJobRankValue = candidatePostJobRankValue;
+	entry.PreemptRankValue = candidatePreemptRankValue;
+	entry.PreemptStateValue = candidatePreemptState;
+	AdListArray.push_back(entry);
 
 	adListLen++;
 }
@@ -5305,19 +5517,99 @@ add_candidate(ClassAd * candidate,
 
 void Matchmaker::DeleteMatchList()
 {
-	if( MatchList ) {
-		delete MatchList;
-		MatchList = NULL;
+	for ( MatchListCache::iterator it = matchListCache.begin();
+		  it != matchListCache.end(); ++it )
+	{
+		delete it->second;
+	}
+	matchListCache.clear();
+	matchListCacheEntries = 0;
+	invalidatedOffers.clear();
+	MatchList = NULL;
+}
+
+bool Matchmaker::MatchListKey::
+operator<(const MatchListKey &other) const
+{
+	if ( autoCluster != other.autoCluster ) {
+		return autoCluster < other.autoCluster;
+	}
+	if ( preemptPrio != other.preemptPrio ) {
+		return preemptPrio < other.preemptPrio;
+	}
+	if ( onlyForStartdRank != other.onlyForStartdRank ) {
+		return onlyForStartdRank < other.onlyForStartdRank;
+	}
+	int cmp = scheddName.compare(other.scheddName);
+	if ( cmp != 0 ) {
+		return cmp < 0;
+	}
+	return scheddAddr < other.scheddAddr;
+}
+
+void Matchmaker::
+invalidateMatchListOffer(ClassAd *offer)
+{
+	if ( matchListCache.empty() ) {
+		return;
 	}
-	cachedAutoCluster = -1;
-	if ( cachedName ) {
-		free(cachedName);
-		cachedName = NULL;
+		// Lists created up to now have a generation no newer than the
+		// current one; they will skip this offer, later lists will not.
+	invalidatedOffers[offer] = ++matchListGeneration;
+}
+
+ClassAd *Matchmaker::
+takeMatchListCandidate(MatchListType *list, ClassAd &request,
+					   double limitUsed, double submitterLimit,
+					   double limitUsedUnclaimed, double submitterLimitUnclaimed,
+					   double pieLeft, bool check_stability, bool &still_valid)
+{
+	AdListEntry *entry = NULL;
+	int pos = 0;
+
+	still_valid = true;
+	rejForSubmitterLimit = 0;
+
+	while ( (entry = list->next_candidate(pos)) ) {
+		std::map<ClassAd*,unsigned>::iterator inv = invalidatedOffers.find(entry->ad);
+		if ( inv != invalidatedOffers.end() && inv->second > list->generation() ) {
+				// matched since this list was made
+			list->remove_candidate(pos);
+			matchListCacheEntries--;
+			continue;
+		}
+
+			// same submitter limit test as in matchmakingAlgorithm()
+		bool permitted = true;
+		if ( entry->PreemptStateValue == PRIO_PREEMPTION ) {
+			permitted = SubmitterLimitPermits(&request, entry->ad, limitUsed, submitterLimit, pieLeft);
+		} else if ( entry->PreemptStateValue == NO_PREEMPTION ) {
+			permitted = SubmitterLimitPermits(&request, entry->ad, limitUsedUnclaimed, submitterLimitUnclaimed, pieLeft);
+		}
+		if ( permitted ) {
+			break;
+		}
+			// leave it on the list for the next spin of the pie
+		rejForSubmitterLimit++;
+		pos++;
+	}
+
+	if ( check_stability &&
+		 !list->candidate_still_valid(entry, request, PreemptionReq, PreemptionRank,
+									  preemption_req_unstable, preemption_rank_unstable) )
+	{
+		still_valid = false;
+		return NULL;
 	}
-	if ( cachedAddr ) {
-		free(cachedAddr);
-		cachedAddr = NULL;
+	if ( !entry ) {
+		return NULL;
 	}
+
+	ClassAd *candidate = entry->ad;
+	candidate->Assign(ATTR_PREEMPT_STATE_, int(entry->PreemptStateValue));
+	list->remove_candidate(pos);
+	matchListCacheEntries--;
+	return candidate;
 }
 
 int Matchmaker::MatchListType::
@@ -5397,7 +5689,9 @@ sort()
 
 	// Note: since we must use static members, sort() is
 	// _NOT_ thread safe!!!
-	qsort(AdListArray,adListLen,sizeof(AdListEntry),sort_compare);
+	if ( !AdListArray.empty() ) {
+		qsort(&AdListArray[0],AdListArray.size(),sizeof(AdListEntry),sort_compare);
+	}
 
 	already_sorted = true;
 }
@@ -28,6 +28,7 @@
 #include "dc_collector.h"
 #include "condor_ver_info.h"
 #include "matchmaker_negotiate.h"
+#include "match_workers.h"
 
 #include <vector>
 #include <string>
@@ -139,12 +140,33 @@ class Matchmaker : public Service
 			// the order of values in this enumeration is important!
 		enum PreemptState {PRIO_PREEMPTION,RANK_PREEMPTION,NO_PREEMPTION};
 
+		// Results of the expensive, side-effect free part of
+		// matchmakingAlgorithm() for one offer, worked out for all
+		// offers up front by the match worker threads.  The rest of
+		// the algorithm then runs in the main thread, in offer order,
+		// so the outcome is the same as without threads.
+		struct OfferEval {
+			bool evaluated;             // false: do it all serially
+			bool isAMatch;
+				// the rest is only set if isAMatch
+			bool rankCondStd;           // only if there is a remote user
+			bool rankCondPrioPreempt;   //   "
+			bool preemptionReq;         //   "
+			float preJobRank;
+			float jobRank;
+			float postJobRank;
+			float preemptRank;          // only if there is a remote user
+			std::string rankErrors;     // messages for the main thread
+			std::string preemptRankErrors;
+		};
+
 		/// Invalidate our negotiator ad at the collector(s).
 		void invalidateNegotiatorAd( void );
 
 		Accountant & getAccountant() { return accountant; }
 		static float EvalNegotiatorMatchRank(char const *expr_name,ExprTree *expr,
-		                              ClassAd &request,ClassAd *resource);
+		                              ClassAd &request,ClassAd *resource,
+		                              std::string *deferred_errors = NULL);
 
 		bool getGroupInfoFromUserId(const char* user, string& groupName, float& groupQuota, float& groupUsage);
 
@@ -309,6 +331,13 @@ class Matchmaker : public Service
 		int trimStartdAds_ShutdownLogic(ClassAdListDoesNotDeleteAds &startdAds);
 
 		bool SubmitterLimitPermits(ClassAd* request, ClassAd* candidate, double used, double allowed, double pieLeft);
+
+		void preevaluateOffers(ClassAd &request,
+							   ClassAdListDoesNotDeleteAds &startdAds,
+							   bool only_for_startdrank,
+							   std::vector<OfferEval> &evals);
+		static void evaluateOffers(void *arg, int worker, int begin, int end);
+
 		double sumSlotWeights(ClassAdListDoesNotDeleteAds &startdAds,double *minSlotWeight, ExprTree* constraint);
 
 		/* ODBC insert functions */
@@ -333,6 +362,8 @@ class Matchmaker : public Service
 		ExprTree *NegotiatorPostJobRank; // rank applied after job rank
 		bool want_globaljobprio;	// cached value of config knob USE_GLOBAL_JOB_PRIOS
 		bool want_matchlist_caching;	// should we cache matches per autocluster?
+		int match_threads;				// NEGOTIATOR_MATCH_THREADS
+		MatchWorkerPool *match_workers;	// NULL if match_threads <= 1
 		bool ConsiderPreemption; // if false, negotiation is faster (default=true)
 		bool ConsiderEarlyPreemption; // if false, do not preempt slots that still have retirement time
 		/// Should the negotiator inform startds of matches?
@@ -417,32 +448,38 @@ class Matchmaker : public Service
 		// a given user and schedd.
 		// When a job ad arrives, we store all machine ads that
 		// match into this object --- a 'match list'.   We then
-		// sort this list, and 'pop' off the top candidate.
-		// Then if the next job the negotiator considers is the
-		// same autocluster, we can just pop the next candidate
-		// off of this list instead of traversing through all the
-		// machine ads and resorting.
+		// sort this list, and take off the top candidate.
+		// Then if we see another job from the same autocluster,
+		// user and schedd later in the cycle (even after other
+		// submitters were negotiated with), we can just take the
+		// next candidate off of this list instead of traversing
+		// through all the machine ads and resorting.
+		// Candidates the submitter limit does not permit right now
+		// stay on the list, so it remains usable on the next spin
+		// of the pie.
 		class MatchListType
 		{
 		public:
 
-			ClassAd* pop_candidate();
-			bool cache_still_valid(ClassAd &request,ExprTree *preemption_req,
-				ExprTree *preemption_rank,bool preemption_req_unstable, bool preemption_rank_unstable);
+				// the first remaining entry at or after pos, which is
+				// updated to its index; NULL if there are none left
+			AdListEntry* next_candidate(int &pos);
+			void remove_candidate(int pos);
+			bool candidate_still_valid(AdListEntry *entry, ClassAd &request,
+				ExprTree *preemption_req, ExprTree *preemption_rank,
+				bool preemption_req_unstable, bool preemption_rank_unstable);
 			void get_diagnostics(int & rejForNetwork,
 					int & rejForNetworkShare,
 					int & rejForConcurrencyLimit,
 					int & rejPreemptForPrio,
 					int & rejPreemptForPolicy,
-					int & rejPreemptForRank,
-					int & rejForSubmitterLimit);
+					int & rejPreemptForRank);
 			void set_diagnostics(int rejForNetwork,
 					int rejForNetworkShare,
 					int rejForConcurrencyLimit,
 					int rejPreemptForPrio,
 					int rejPreemptForPolicy,
-					int rejPreemptForRank,
-					int rejForSubmitterLimit);
+					int rejPreemptForRank);
 			void add_candidate(ClassAd* candidate,
 					double candidateRankValue,
 					double candidatePreJobRankValue,
@@ -450,23 +487,20 @@ class Matchmaker : public Service
 					double candidatePreemptRankValue,
 					PreemptState candidatePreemptState);
 			void sort();
-			int length() { return adListLen - adListHead; }
+			int length() { return adListLen; }
+			unsigned generation() { return m_generation; }
 
-			MatchListType(int maxlen);
+			MatchListType(unsigned generation);
 			~MatchListType();
 
-			void increment_rejForSubmitterLimit() { m_rejForSubmitterLimit++; }
-
-
 		private:
 			
-			// AdListEntry* peek_candidate();
 			static int sort_compare(const void*, const void*);
-			AdListEntry* AdListArray;			
-			int adListMaxLen;	// max length of AdListArray
-			int adListLen;		// current length of AdListArray
-			int adListHead;
+			std::vector<AdListEntry> AdListArray;
+			int adListLen;		// number of entries not yet removed
+			int adListHead;		// no entries remain before this index
 			bool already_sorted;
+			unsigned m_generation;	// see Matchmaker::invalidateMatchListOffer()
 			// rejection reasons
 			int m_rejForNetwork; 		//   - limited network capacity?
 			int m_rejForNetworkShare;	//   - limited network fair-share?
@@ -474,17 +508,40 @@ class Matchmaker : public Service
 			int m_rejPreemptForPrio;	//   - insufficient prio to preempt?
 			int m_rejPreemptForPolicy; //   - PREEMPTION_REQUIREMENTS == False?
 			int m_rejPreemptForRank;    //   - startd RANKs new job lower?
-			int m_rejForSubmitterLimit;     //  - not enough group quota?
-			float m_submitterLimit;
-			
-			
 		};
-		MatchListType* MatchList;
-		int cachedAutoCluster;
-		char* cachedName;
-		char* cachedAddr;
-		double cachedPrio;
-		bool cachedOnlyForStartdRank;
+
+		struct MatchListKey {
+			MatchListKey(const char *name, const char *addr, int autocluster,
+						 double prio, bool only_for_startdrank)
+				: scheddName(name), scheddAddr(addr), autoCluster(autocluster),
+				  preemptPrio(prio), onlyForStartdRank(only_for_startdrank) {}
+			bool operator<(const MatchListKey &other) const;
+
+			string scheddName;
+			string scheddAddr;
+			int autoCluster;
+			double preemptPrio;
+			bool onlyForStartdRank;
+		};
+		typedef std::map<MatchListKey, MatchListType*> MatchListCache;
+
+			// Take the best candidate off of a match list that the
+			// submitter limit permits.  Sets still_valid to false if
+			// check_stability is set and the list must be rebuilt.
+		ClassAd *takeMatchListCandidate(MatchListType *list, ClassAd &request,
+			double limitUsed, double submitterLimit,
+			double limitUsedUnclaimed, double submitterLimitUnclaimed,
+			double pieLeft, bool check_stability, bool &still_valid);
+			// Called when an offer is matched (or found to be bad),
+			// so that cached match lists built before then skip it.
+		void invalidateMatchListOffer(ClassAd *offer);
+
+		MatchListType* MatchList;	// the list for the current request
+		MatchListCache matchListCache;
+		int matchListCacheEntries;	// total length of lists when created
+		int matchListCacheMaxEntries;	// NEGOTIATOR_MATCHLIST_CACHE_SIZE
+		unsigned matchListGeneration;
+		std::map<ClassAd*, unsigned> invalidatedOffers;
 
         // set at startup/restart/reinit
         GroupEntry* hgq_root_group;
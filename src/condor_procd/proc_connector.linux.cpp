@@ -0,0 +1,234 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "proc_connector.linux.h"
+
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+// how much room to ask for in our socket's receive buffer. every
+// event is a little under 100 bytes, so this lets a few tens of
+// thousands of events queue up in between snapshots before the
+// kernel starts dropping them
+//
+static const int PROC_CONNECTOR_RCVBUF = 4 * 1024 * 1024;
+
+// the event types we care about. these are part of the kernel ABI, but
+// depending on the kernel headers the enum that names them is either
+// nested in struct proc_event or not, so it's easier to spell them
+// out here
+//
+static const unsigned PROC_CONNECTOR_FORK = 0x00000001;
+static const unsigned PROC_CONNECTOR_EXEC = 0x00000002;
+static const unsigned PROC_CONNECTOR_EXIT = 0x80000000;
+
+ProcConnector::ProcConnector() :
+	m_sock(-1)
+{
+}
+
+ProcConnector::~ProcConnector()
+{
+	if (m_sock != -1) {
+		close(m_sock);
+	}
+}
+
+bool
+ProcConnector::listen()
+{
+	ASSERT(m_sock == -1);
+
+	m_sock = socket(PF_NETLINK, SOCK_DGRAM, NETLINK_CONNECTOR);
+	if (m_sock == -1) {
+		dprintf(D_ALWAYS,
+		        "ProcConnector: socket error: %s (%d)\n",
+		        strerror(errno),
+		        errno);
+		return false;
+	}
+
+	// we never block waiting for events; drain() just takes
+	// whatever has queued up
+	//
+	int flags = fcntl(m_sock, F_GETFL, 0);
+	if ((flags == -1) || (fcntl(m_sock, F_SETFL, flags | O_NONBLOCK) == -1)) {
+		dprintf(D_ALWAYS,
+		        "ProcConnector: fcntl error: %s (%d)\n",
+		        strerror(errno),
+		        errno);
+		close(m_sock);
+		m_sock = -1;
+		return false;
+	}
+
+	// try to get a receive buffer big enough to hold all the events
+	// that happen in between snapshots. SO_RCVBUFFORCE ignores the
+	// rmem_max limit but needs CAP_NET_ADMIN, which we need anyway
+	//
+	int rcvbuf = PROC_CONNECTOR_RCVBUF;
+	if (setsockopt(m_sock, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) == -1) {
+		setsockopt(m_sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	}
+
+	struct sockaddr_nl addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = CN_IDX_PROC;
+	addr.nl_pid = 0;
+	if (bind(m_sock, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+		dprintf(D_ALWAYS,
+		        "ProcConnector: bind error: %s (%d)\n",
+		        strerror(errno),
+		        errno);
+		close(m_sock);
+		m_sock = -1;
+		return false;
+	}
+
+	// now tell the kernel we want process events
+	//
+	char buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+	memset(buf, 0, sizeof(buf));
+	struct nlmsghdr* hdr = (struct nlmsghdr*)buf;
+	hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+	hdr->nlmsg_type = NLMSG_DONE;
+	hdr->nlmsg_pid = getpid();
+	struct cn_msg* msg = (struct cn_msg*)NLMSG_DATA(hdr);
+	msg->id.idx = CN_IDX_PROC;
+	msg->id.val = CN_VAL_PROC;
+	msg->len = sizeof(enum proc_cn_mcast_op);
+	*(enum proc_cn_mcast_op*)msg->data = PROC_CN_MCAST_LISTEN;
+	if (send(m_sock, buf, hdr->nlmsg_len, 0) == -1) {
+		dprintf(D_ALWAYS,
+		        "ProcConnector: error subscribing to process events: %s (%d)\n",
+		        strerror(errno),
+		        errno);
+		close(m_sock);
+		m_sock = -1;
+		return false;
+	}
+
+	dprintf(D_ALWAYS, "ProcConnector: listening for process events\n");
+	return true;
+}
+
+bool
+ProcConnector::drain(std::set<pid_t>& started, std::set<pid_t>& exited)
+{
+	ASSERT(m_sock != -1);
+
+	bool complete = true;
+	char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+	while (true) {
+
+		struct sockaddr_nl from;
+		socklen_t from_len = sizeof(from);
+		int len = recvfrom(m_sock,
+		                   buf,
+		                   sizeof(buf),
+		                   0,
+		                   (struct sockaddr*)&from,
+		                   &from_len);
+		if (len == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			if (errno == ENOBUFS) {
+				// the kernel has thrown away some events; keep
+				// reading so that the next snapshot starts out
+				// with an empty socket
+				//
+				dprintf(D_ALWAYS,
+				        "ProcConnector: receive buffer overflowed; "
+				            "events were lost\n");
+				complete = false;
+				continue;
+			}
+			dprintf(D_ALWAYS,
+			        "ProcConnector: recv error: %s (%d)\n",
+			        strerror(errno),
+			        errno);
+			return false;
+		}
+
+		// only the kernel gets to tell us about processes
+		//
+		if (from.nl_pid != 0) {
+			continue;
+		}
+
+		struct nlmsghdr* hdr = (struct nlmsghdr*)buf;
+		for ( ; NLMSG_OK(hdr, len); hdr = NLMSG_NEXT(hdr, len)) {
+
+			if (hdr->nlmsg_type == NLMSG_NOOP) {
+				continue;
+			}
+			if (hdr->nlmsg_type == NLMSG_ERROR ||
+			    hdr->nlmsg_type == NLMSG_OVERRUN)
+			{
+				complete = false;
+				continue;
+			}
+
+			struct cn_msg* msg = (struct cn_msg*)NLMSG_DATA(hdr);
+			if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC) {
+				continue;
+			}
+
+			struct proc_event* ev = (struct proc_event*)msg->data;
+			switch ((unsigned)ev->what) {
+				case PROC_CONNECTOR_FORK:
+					// a new thread shows up as a fork whose pid is
+					// not its thread group id; we only care about
+					// new processes
+					//
+					if (ev->event_data.fork.child_pid ==
+					    ev->event_data.fork.child_tgid)
+					{
+						started.insert(ev->event_data.fork.child_tgid);
+					}
+					break;
+
+				case PROC_CONNECTOR_EXEC:
+					started.insert(ev->event_data.exec.process_tgid);
+					break;
+
+				case PROC_CONNECTOR_EXIT:
+					if (ev->event_data.exit.process_pid ==
+					    ev->event_data.exit.process_tgid)
+					{
+						exited.insert(ev->event_data.exit.process_tgid);
+					}
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+
+	return complete;
+}
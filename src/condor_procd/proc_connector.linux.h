@@ -0,0 +1,60 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _PROC_CONNECTOR_H
+#define _PROC_CONNECTOR_H
+
+#include <set>
+
+// a subscription to the Linux kernel's process event connector
+// (cn_proc), which multicasts a message over netlink whenever a
+// process forks, execs, or exits. the ProcFamilyMonitor uses this to
+// find out which processes have come and gone since the last snapshot
+// without having to read /proc/<pid>/stat for every process on the
+// system. listening requires CAP_NET_ADMIN
+//
+class ProcConnector {
+
+public:
+
+	ProcConnector();
+	~ProcConnector();
+
+	// open the netlink socket and ask the kernel to start sending
+	// us process events. returns false if this isn't possible (e.g.
+	// no permission, or a kernel built without CONFIG_PROC_EVENTS)
+	//
+	bool listen();
+
+	// read all the events that have arrived since the last call.
+	// processes that were created or that exec'd are added to the
+	// first set; processes that exited are added to the second. only
+	// whole processes (thread group leaders) are reported. returns
+	// false if events may have been lost (the kernel drops them if
+	// our socket buffer fills up), in which case the caller needs to
+	// fall back on looking at every process on the system
+	//
+	bool drain(std::set<pid_t>& started, std::set<pid_t>& exited);
+
+private:
+
+	int m_sock;
+};
+
+#endif
@@ -924,6 +924,41 @@ ProcFamily::remove_exited_processes()
 	}
 }
 
+void
+ProcFamily::refresh_members()
+{
+	ProcFamilyMember* member = m_member_list;
+	while (member != NULL) {
+		procInfo* pi = NULL;
+		int status;
+		int ret = ProcAPI::getProcInfo(member->m_proc_info->pid, pi, status);
+		if ((ret == PROCAPI_SUCCESS) &&
+		    (pi->birthday == member->m_proc_info->birthday))
+		{
+			member->still_alive(pi);
+		}
+		else {
+			// either gone or the PID has been reused; leave the
+			// member for remove_exited_processes to clean up
+			//
+			delete pi;
+		}
+		member = member->m_next;
+	}
+}
+
+void
+ProcFamily::assume_alive(const std::set<pid_t>& exited)
+{
+	ProcFamilyMember* member = m_member_list;
+	while (member != NULL) {
+		if (exited.find(member->m_proc_info->pid) == exited.end()) {
+			member->m_still_alive = true;
+		}
+		member = member->m_next;
+	}
+}
+
 void
 ProcFamily::fold_into_parent(ProcFamily* parent)
 {
@@ -24,6 +24,7 @@
 #include "../condor_procapi/procapi.h"
 #include "proc_family_member.h"
 #include "proc_family_io.h"
+#include <set>
 
 #if defined(HAVE_EXT_LIBCGROUP)
 #include "../condor_starter.V6.1/cgroup.linux.h"
@@ -105,6 +106,16 @@ public:
 	//
 	void remove_exited_processes();
 
+	// used by the ProcFamilyMonitor's incremental snapshots, in place
+	// of a full process scan: refresh_members re-reads the procInfo
+	// for each of our members and marks those that are still around
+	// (as ProcFamilyMember::still_alive would); assume_alive marks all
+	// members except those in the given set of exited PIDs without
+	// looking at them
+	//
+	void refresh_members();
+	void assume_alive(const std::set<pid_t>& exited);
+
 	// our monitor is about to delete us, so we need to offload any
 	// members we have in our list to our parent (passed in)
 	//
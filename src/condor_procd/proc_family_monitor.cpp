@@ -31,6 +31,7 @@
 
 #if defined(LINUX)
 #include "group_tracker.linux.h"
+#include "proc_connector.linux.h"
 #endif
 
 #if defined(HAVE_EXT_LIBCGROUP)
@@ -58,6 +59,8 @@ ProcFamilyMonitor::ProcFamilyMonitor(pid_t pid,
 	ASSERT(m_pid_tracker != NULL);
 #if defined(LINUX)
 	m_group_tracker = NULL;
+	m_proc_connector = NULL;
+	m_proc_connector_synced = false;
 #endif
 #if defined(HAVE_EXT_LIBCGROUP)
 	m_cgroup_tracker = NULL;
@@ -123,6 +126,9 @@ ProcFamilyMonitor::~ProcFamilyMonitor()
 	if (m_group_tracker != NULL) {
 		delete m_group_tracker;
 	}
+	if (m_proc_connector != NULL) {
+		delete m_proc_connector;
+	}
 #endif
 #if defined(HAVE_EXT_LIBCGROUP)
 	if (m_cgroup_tracker != NULL) {
@@ -145,6 +151,27 @@ ProcFamilyMonitor::enable_group_tracking(gid_t min_tracking_gid,
 									   allocating);
 	ASSERT(m_group_tracker != NULL);
 }
+
+void
+ProcFamilyMonitor::enable_proc_connector()
+{
+	ASSERT(m_proc_connector == NULL);
+	m_proc_connector = new ProcConnector;
+	ASSERT(m_proc_connector != NULL);
+	if (!m_proc_connector->listen()) {
+		dprintf(D_ALWAYS,
+		        "unable to get process events from the kernel; "
+		            "scanning all processes on every snapshot\n");
+		delete m_proc_connector;
+		m_proc_connector = NULL;
+		return;
+	}
+
+	// we don't know what happened before we started listening, so
+	// the next snapshot needs to be a full one
+	//
+	m_proc_connector_synced = false;
+}
 #endif
 
 #if defined(HAVE_EXT_LIBCGROUP)
@@ -540,12 +567,24 @@ ProcFamilyMonitor::snapshot()
 {
 	dprintf(D_ALWAYS, "taking a snapshot...\n");
 
-	// get a snapshot of all processes on the system
+	// if we're getting process events from the kernel, we only need
+	// to look at the processes that have changed (plus the ones in our
+	// families, for their usage); otherwise, get a snapshot of all
+	// processes on the system
 	// TODO: should we do something here if ProcAPI returns a NULL result?
 	// (the algorithm below will handle it just fine, but its probably an
 	// indication that something is wrong)
 	//
-	procInfo* pi_list = ProcAPI::getProcInfoList();
+	procInfo* pi_list = NULL;
+	bool incremental = false;
+#if defined(LINUX)
+	if (m_proc_connector != NULL) {
+		incremental = get_changed_processes(pi_list);
+	}
+#endif
+	if (!incremental) {
+		pi_list = ProcAPI::getProcInfoList();
+	}
 
 	// print info about all procInfo allocations
 	//
@@ -606,7 +645,8 @@ ProcFamilyMonitor::snapshot()
 
 	// now tell all our ProcFamily objects to get rid of the family members
 	// that are no longer on the system (i.e. those that did not get the
-	// still_alive method of ProcFamilyMember called in the loop above)
+	// still_alive method of ProcFamilyMember called in the loop above, or
+	// marked by get_changed_processes)
 	//
 	remove_exited_processes(m_tree);
 	m_everybody_else->remove_exited_processes();
@@ -850,6 +890,70 @@ ProcFamilyMonitor::remove_exited_processes(Tree<ProcFamily*>* tree)
 	}
 }
 
+#if defined(LINUX)
+bool
+ProcFamilyMonitor::get_changed_processes(procInfo*& pi_list)
+{
+	std::set<pid_t> started;
+	std::set<pid_t> exited;
+	if (!m_proc_connector->drain(started, exited)) {
+		m_proc_connector_synced = false;
+	}
+
+	// if we've missed any events, fall back on a full scan. events
+	// that arrive from here on will be consistent with it
+	//
+	if (!m_proc_connector_synced) {
+		dprintf(D_FULLDEBUG, "proc connector: taking a full snapshot\n");
+		m_proc_connector_synced = true;
+		return false;
+	}
+
+	// processes in our families need their procInfo kept up to date
+	// for usage reporting and max image size bookkeeping; everything
+	// else is only of interest if it has started or exited
+	//
+	refresh_members(m_tree);
+	m_everybody_else->assume_alive(exited);
+
+	// processes that started (or exec'd) since the last snapshot go on
+	// the list for the normal snapshot logic to sort out. some may
+	// already be gone, or be ones we know about (after an exec)
+	//
+	pi_list = NULL;
+	std::set<pid_t>::iterator it;
+	for (it = started.begin(); it != started.end(); it++) {
+		procInfo* pi = NULL;
+		int status;
+		if (ProcAPI::getProcInfo(*it, pi, status) == PROCAPI_SUCCESS) {
+			pi->next = pi_list;
+			pi_list = pi;
+		}
+		else {
+			delete pi;
+		}
+	}
+
+	dprintf(D_FULLDEBUG,
+	        "proc connector: %u processes started, %u exited\n",
+	        (unsigned)started.size(),
+	        (unsigned)exited.size());
+	return true;
+}
+
+void
+ProcFamilyMonitor::refresh_members(Tree<ProcFamily*>* tree)
+{
+	tree->get_data()->refresh_members();
+
+	Tree<ProcFamily*>* child = tree->get_child();
+	while (child != NULL) {
+		refresh_members(child);
+		child = child->get_sibling();
+	}
+}
+#endif
+
 void
 ProcFamilyMonitor::delete_unwatched_families(Tree<ProcFamily*>* tree)
 {
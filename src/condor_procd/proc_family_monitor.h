@@ -31,6 +31,7 @@
 class PIDTracker;
 #if defined(LINUX)
 class GroupTracker;
+class ProcConnector;
 #endif
 #if defined(HAVE_EXT_LIBCGROUP)
 class CGroupTracker;
@@ -58,6 +59,13 @@ public:
 	//
 	void enable_group_tracking(gid_t min_tracking_gid, 
 			gid_t max_tracking_gid, bool allocating);
+
+	// use the kernel's process event connector to find out which
+	// processes have started and exited since the last snapshot,
+	// so that snapshots only need to look at those processes and
+	// at the ones in the families we're tracking
+	//
+	void enable_proc_connector();
 #endif
 
 	// create a "subfamily", which can then be signalled and accounted
@@ -185,6 +193,27 @@ private:
 	EnvironmentTracker* m_environment_tracker;
 	ParentTracker*      m_parent_tracker;
 
+#if defined(LINUX)
+	// if non-NULL, our subscription to process events. until
+	// m_proc_connector_synced is set, a full scan of the system is
+	// needed to catch up on processes we may not have heard about
+	//
+	ProcConnector*      m_proc_connector;
+	bool                m_proc_connector_synced;
+
+	// for an incremental snapshot: refresh the members of our tracked
+	// families, assume everything else is still around unless we've
+	// heard that it exited, and return a procInfo list of processes
+	// that have started since the last snapshot. returns false if a
+	// full scan is needed instead
+	//
+	bool get_changed_processes(procInfo*& pi_list);
+
+	// call refresh_members on all ProcFamily objects we're managing
+	//
+	void refresh_members(Tree<ProcFamily*>*);
+#endif
+
 	// find the minimum of all the ProcFamilys' requested "maximum
 	// snapshot intervals"
 	//
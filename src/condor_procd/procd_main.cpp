@@ -63,6 +63,11 @@ static int max_snapshot_interval = 60;
 //
 static gid_t min_tracking_gid = 0;
 static gid_t max_tracking_gid = 0;
+
+// set to true if -N was given: use the kernel's process event connector
+// to find new and exited processes instead of scanning them all
+//
+static bool use_proc_connector = false;
 #endif
 
 #if defined(WIN32)
@@ -121,6 +126,9 @@ usage(void)
 	"                         If -E is specified then procd_ctl must be used\n"
 	"                         to allocate gids which must then be in this\n"
 	"                         range.\n"
+	"  -N                     Use the kernel's process event connector to\n"
+	"                         follow process creation and exit, so that\n"
+	"                         snapshots only read tracked processes.\n"
 	"  -I <glexec-kill-path> <glexec-path> <glexec-retries> <glexec-retry-delay>\n"
 	"                         Specify the binary which will send a signal\n"
 	"                         to a pid and the glexec binary which will run\n"
@@ -265,6 +273,12 @@ parse_command_line(int argc, char* argv[])
 				index++;
 				max_tracking_gid = (gid_t)atoi(argv[index]);
 				break;
+
+			// process events via the netlink proc connector
+			//
+			case 'N':
+				use_proc_connector = true;
+				break;
 #endif
 
 #if defined(WIN32)
@@ -508,6 +522,10 @@ main(int argc, char* argv[])
 			max_tracking_gid,
 			use_external_gid_association ? false : true);
 	}
+
+	if (use_proc_connector) {
+		monitor.enable_proc_connector();
+	}
 #endif
 
 #if defined(HAVE_EXT_LIBCGROUP)
@@ -0,0 +1,131 @@
+###########################################################################
+#
+#  Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+#  University of Wisconsin-Madison, WI.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License"); you
+#  may not use this file except in compliance with the License.  You may
+#  obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+###########################################################################
+
+# measures how long the ProcD takes to do a snapshot on a busy machine.
+# a number of "background" processes that are not in any family the ProcD
+# tracks are started first, then a "job" whose family has some number of
+# processes. the ProcD is started to track the job and asked to take
+# snapshots over and over; the average time per snapshot is reported. run
+# it from the directory holding condor_procd and procd_ctl:
+#
+#   python procd_test_snapshot_cost.py [-N] [<background> [<tracked> [<count>]]]
+#
+# -N is passed through to the ProcD so that it uses the Linux proc
+# connector (which requires running as root); compare the results with and
+# without it. the defaults are 10000 background processes, 100 tracked
+# processes, and 20 snapshots. since each snapshot is requested with a run
+# of procd_ctl, the time to do an empty snapshot (with no background
+# processes) is a useful baseline.
+
+import os
+import signal
+import subprocess
+import sys
+import time
+
+from procd_test_controller import ProcDInterface
+
+# start the given number of sleeping processes in their own process group
+# and return the group ID. the processes are orphaned so that they are
+# children of init and not part of any family the ProcD is tracking
+def start_background(count):
+    r, w = os.pipe()
+    pid = os.fork()
+    if pid == 0:
+        os.close(r)
+        os.setsid()
+        for i in range(count):
+            if os.fork() == 0:
+                os.close(w)
+                os.execvp('sleep', ('sleep', '100000'))
+        os.write(w, '%d\n' % os.getpid())
+        os._exit(0)
+    os.close(w)
+    pgid = int(os.fdopen(r).readline())
+    os.waitpid(pid, 0)
+    return pgid
+
+# start a "job": a shell that starts the given number of sleeping
+# processes and waits for them
+def start_job(count):
+    return subprocess.Popen(('sh', '-c',
+                             'for i in `seq %d`; do sleep 100000 & done; wait' %
+                                 count),
+                            preexec_fn = os.setsid)
+
+def main(argv):
+    procd_args = []
+    if argv and argv[0] == '-N':
+        procd_args.append('-N')
+        argv = argv[1:]
+    background = 10000
+    tracked = 100
+    count = 20
+    if len(argv) > 0:
+        background = int(argv[0])
+    if len(argv) > 1:
+        tracked = int(argv[1])
+    if len(argv) > 2:
+        count = int(argv[2])
+
+    print 'starting %d background processes' % background
+    pgid = start_background(background)
+    print 'starting a job with %d processes' % tracked
+    job = start_job(tracked)
+    procd = None
+    try:
+        # give the job's processes a chance to get going
+        time.sleep(1 + tracked / 1000)
+
+        pipe_name = 'procd_pipe'
+        procd = subprocess.Popen(['./condor_procd',
+                                  '-A', pipe_name,
+                                  '-L', 'procd_log',
+                                  '-S', '-1',
+                                  '-P', str(job.pid)] + procd_args,
+                                 stderr = subprocess.PIPE)
+
+        # the ProcD closes stderr once it is accepting connections
+        procd.stderr.read()
+        procd_interface = ProcDInterface(pipe_name)
+
+        # the first snapshot after starting up is always a full one
+        procd_interface.snapshot()
+
+        start = time.time()
+        for i in range(count):
+            procd_interface.snapshot()
+        elapsed = time.time() - start
+
+        print '%d snapshots: %.3f seconds total, %.1f ms per snapshot' % \
+            (count, elapsed, 1000.0 * elapsed / count)
+
+        procd_interface.quit()
+        procd.wait()
+        procd = None
+    finally:
+        if procd is not None:
+            os.kill(procd.pid, signal.SIGKILL)
+        os.killpg(job.pid, signal.SIGKILL)
+        job.wait()
+        os.killpg(pgid, signal.SIGKILL)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,99 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "proc.h"
+#include "prio_rec.h"
+
+PrioRecIndex::PrioRecIndex() :
+	m_by_id( 1024, hashFuncPROC_ID, rejectDuplicateKeys )
+{
+}
+
+PrioRecIndex::~PrioRecIndex()
+{
+	Clear();
+}
+
+void
+PrioRecIndex::Unlink( prio_rec *rec )
+{
+	m_all.erase( rec );
+
+	std::map<std::string,Queue>::iterator it = m_by_owner.find( rec->owner );
+	if( it != m_by_owner.end() ) {
+		it->second.erase( rec );
+		if( it->second.empty() ) {
+			m_by_owner.erase( it );
+		}
+	}
+}
+
+void
+PrioRecIndex::Update( prio_rec const &rec )
+{
+	prio_rec *existing = NULL;
+	if( m_by_id.lookup( rec.id, existing ) == 0 ) {
+			// take it out while its sort key changes
+		Unlink( existing );
+		*existing = rec;
+	}
+	else {
+		existing = new prio_rec( rec );
+		m_by_id.insert( rec.id, existing );
+	}
+
+	m_all.insert( existing );
+	m_by_owner[existing->owner].insert( existing );
+}
+
+void
+PrioRecIndex::Remove( PROC_ID const &id )
+{
+	prio_rec *existing = NULL;
+	if( m_by_id.lookup( id, existing ) != 0 ) {
+		return;
+	}
+	Unlink( existing );
+	m_by_id.remove( id );
+	delete existing;
+}
+
+void
+PrioRecIndex::Clear()
+{
+	Queue::iterator it;
+	for( it = m_all.begin(); it != m_all.end(); it++ ) {
+		delete *it;
+	}
+	m_all.clear();
+	m_by_owner.clear();
+	m_by_id.clear();
+}
+
+PrioRecIndex::Queue const *
+PrioRecIndex::ForOwner( char const *owner ) const
+{
+	std::map<std::string,Queue>::const_iterator it = m_by_owner.find( owner );
+	if( it == m_by_owner.end() ) {
+		return NULL;
+	}
+	return &it->second;
+}
@@ -26,7 +26,11 @@
 #ifndef _PRIO_REC_H_
 #define _PRIO_REC_H_
 
-const 	int		INITIAL_MAX_PRIO_REC = 2048;
+#include "HashTable.h"
+#include <map>
+#include <set>
+#include <string>
+
 
 /* this record contains all the parameters required for
  * assigning priorities to all jobs */
@@ -55,4 +59,45 @@ public:
 	}
 };
 
+extern "C" int prio_compar(prio_rec*, prio_rec*);
+
+struct prio_rec_less {
+	bool operator()( prio_rec *a, prio_rec *b ) const {
+		return prio_compar( a, b ) < 0;
+	}
+};
+
+/* The runnable jobs in the queue, kept in priority order both as a
+ * whole and per owner, so that the schedd can update a single job's
+ * record when the job changes instead of rebuilding and re-sorting
+ * the whole list.  A record's position depends on its contents, so
+ * records must be changed with Update(), never in place. */
+class PrioRecIndex {
+public:
+	typedef std::set<prio_rec*,prio_rec_less> Queue;
+
+	PrioRecIndex();
+	~PrioRecIndex();
+
+		// Add the job described by rec, or replace its existing record.
+	void Update( prio_rec const &rec );
+		// Drop the job's record, if it has one.
+	void Remove( PROC_ID const &id );
+	void Clear();
+
+	int Count() const { return (int)m_all.size(); }
+		// All records, highest priority first.
+	Queue const &All() const { return m_all; }
+		// The records of one owner (as in prio_rec::owner), highest
+		// priority first, or NULL if the owner has none.
+	Queue const *ForOwner( char const *owner ) const;
+
+private:
+	void Unlink( prio_rec *rec );
+
+	Queue m_all;
+	std::map<std::string,Queue> m_by_owner;
+	HashTable<PROC_ID,prio_rec*> m_by_id;
+};
+
 #endif
@@ -31,6 +31,8 @@
 #include "log.h"
 #include "classad_collection.h"
 #include "prio_rec.h"
+#include "classad_attr_index.h"
+#include <algorithm>
 #include "condor_attributes.h"
 #include "condor_uid.h"
 #include "condor_adtypes.h"
@@ -75,10 +77,6 @@ extern char *Name;
 extern Scheduler scheduler;
 extern DedicatedScheduler dedicated_scheduler;
 
-extern "C" {
-	int	prio_compar(prio_rec*, prio_rec*);
-}
-
 extern  void    cleanup_ckpt_files(int, int, const char*);
 extern	bool	service_this_universe(int, ClassAd *);
 extern	bool	jobExternallyManaged(ClassAd * ad);
@@ -118,12 +116,368 @@ const double PrioRecRebuildMaxTimeSlice = 0.05;
 const double PrioRecRebuildMaxTimeSliceWhenNoMatchFound = 0.1;
 const double PrioRecRebuildMaxInterval = 20 * 60;
 Timeslice   PrioRecArrayTimeslice;
-prio_rec	PrioRecArray[INITIAL_MAX_PRIO_REC];
-prio_rec	* PrioRec = &PrioRecArray[0];
-int			N_PrioRecs = 0;
+static time_t PrioRecLastRebuild = 0;
+PrioRecIndex PrioRecs;
 HashTable<int,int> *PrioRecAutoClusterRejected = NULL;
 
-static int 	MAX_PRIO_REC=INITIAL_MAX_PRIO_REC ;	// INITIAL_MAX_* in prio_rec.h
+	// Jobs whose entry in PrioRecs may be out of date, because something
+	// that get_job_prio() looks at has changed.  Changes made inside a
+	// transaction are collected separately and only count once the
+	// transaction commits, since until then the job ad does not show them.
+static HashTable<PROC_ID,int> PrioRecChangedJobs(hashFuncPROC_ID);
+static HashTable<PROC_ID,int> PrioRecChangedJobsInTransaction(hashFuncPROC_ID);
+static bool PrioRecRebuildAfterTransaction = false;
+
+	// Attributes that decide whether and where a job sits in PrioRecs.
+static const char *PrioRecAttrs[] = {
+	ATTR_JOB_STATUS,
+	ATTR_JOB_PRIO,
+	ATTR_PRE_JOB_PRIO1,
+	ATTR_PRE_JOB_PRIO2,
+	ATTR_POST_JOB_PRIO1,
+	ATTR_POST_JOB_PRIO2,
+	ATTR_Q_DATE,
+	ATTR_OWNER,
+	ATTR_ACCOUNTING_GROUP,
+	ATTR_NICE_USER,
+	ATTR_CURRENT_HOSTS,
+	ATTR_MAX_HOSTS,
+	ATTR_JOB_UNIVERSE,
+	ATTR_WANT_MATCHING,
+	ATTR_JOB_MANAGED,
+	ATTR_GRID_RESOURCE,
+	NULL
+};
+
+static bool
+IsPrioRecAttr( const char *attr_name )
+{
+	for( int i = 0; PrioRecAttrs[i]; i++ ) {
+		if( strcasecmp( attr_name, PrioRecAttrs[i] ) == 0 ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Note that the PrioRecs entry of the given job may be stale.  A change
+// to a cluster ad may affect every job in the cluster, so that forces
+// a full rebuild.
+static void
+NotePrioRecChange( int cluster_id, int proc_id )
+{
+	bool in_transaction = JobQueue->InTransaction();
+	if( proc_id < 0 ) {
+		if( in_transaction ) {
+			PrioRecRebuildAfterTransaction = true;
+		}
+		else {
+			DirtyPrioRecArray();
+		}
+		return;
+	}
+
+	PROC_ID id;
+	id.cluster = cluster_id;
+	id.proc = proc_id;
+	if( in_transaction ) {
+		PrioRecChangedJobsInTransaction.insert( id, 1 );
+	}
+	else {
+		PrioRecChangedJobs.insert( id, 1 );
+	}
+}
+
+static void
+CommitPrioRecChanges()
+{
+	PROC_ID id;
+	int junk;
+	PrioRecChangedJobsInTransaction.startIterations();
+	while( PrioRecChangedJobsInTransaction.iterate( id, junk ) ) {
+		PrioRecChangedJobs.insert( id, 1 );
+	}
+	PrioRecChangedJobsInTransaction.clear();
+
+	if( PrioRecRebuildAfterTransaction ) {
+		PrioRecRebuildAfterTransaction = false;
+		DirtyPrioRecArray();
+	}
+}
+
+static void
+AbortPrioRecChanges()
+{
+	PrioRecChangedJobsInTransaction.clear();
+	PrioRecRebuildAfterTransaction = false;
+}
+
+	// Jobs whose contribution to the schedd's job counts may be out of
+	// date; see Scheduler::count_jobs().  Unlike PrioRecs, any attribute
+	// counts, since SLOT_WEIGHT may look at anything in the job ad.
+	// Clusters whose cluster ad changed stand for all of their jobs.
+static HashTable<PROC_ID,int> JobCountChangedJobs(hashFuncPROC_ID);
+static HashTable<PROC_ID,int> JobCountChangedJobsInTransaction(hashFuncPROC_ID);
+static std::set<int> JobCountChangedClusters;
+static std::set<int> JobCountChangedClustersInTransaction;
+
+static void
+NoteJobCountChange( int cluster_id, int proc_id )
+{
+	bool in_transaction = JobQueue->InTransaction();
+	if( proc_id < 0 ) {
+		if( in_transaction ) {
+			JobCountChangedClustersInTransaction.insert( cluster_id );
+		}
+		else {
+			JobCountChangedClusters.insert( cluster_id );
+		}
+		return;
+	}
+
+	PROC_ID id;
+	id.cluster = cluster_id;
+	id.proc = proc_id;
+	if( in_transaction ) {
+		JobCountChangedJobsInTransaction.insert( id, 1 );
+	}
+	else {
+		JobCountChangedJobs.insert( id, 1 );
+	}
+}
+
+static void
+CommitJobCountChanges()
+{
+	PROC_ID id;
+	int junk;
+	JobCountChangedJobsInTransaction.startIterations();
+	while( JobCountChangedJobsInTransaction.iterate( id, junk ) ) {
+		JobCountChangedJobs.insert( id, 1 );
+	}
+	JobCountChangedJobsInTransaction.clear();
+
+	JobCountChangedClusters.insert(
+		JobCountChangedClustersInTransaction.begin(),
+		JobCountChangedClustersInTransaction.end() );
+	JobCountChangedClustersInTransaction.clear();
+}
+
+static void
+AbortJobCountChanges()
+{
+	JobCountChangedJobsInTransaction.clear();
+	JobCountChangedClustersInTransaction.clear();
+}
+
+void
+TakeJobCountChanges( std::vector<PROC_ID> &jobs, std::set<int> &clusters )
+{
+	PROC_ID id;
+	int junk;
+	jobs.clear();
+	jobs.reserve( JobCountChangedJobs.getNumElements() );
+	JobCountChangedJobs.startIterations();
+	while( JobCountChangedJobs.iterate( id, junk ) ) {
+		jobs.push_back( id );
+	}
+	JobCountChangedJobs.clear();
+
+	clusters.clear();
+	clusters.swap( JobCountChangedClusters );
+}
+
+	// Secondary indexes on the job attributes listed in
+	// SCHEDD_JOB_QUEUE_INDEX_ATTRIBUTES, used to find the jobs that may
+	// match a constraint without evaluating it against every job in the
+	// queue.  The index is built once the queue has been loaded and kept
+	// up to date much like PrioRecs: changes to committed jobs are noted,
+	// changes made inside a transaction only once it commits, and the
+	// noted jobs are refiled by UpdateJobQueueIndex() before the next
+	// lookup.
+typedef std::map<PROC_ID,ClassAd *,JobIdLess> IndexedJobMap;
+
+static ClassAdAttrIndex JobQueueIndex;
+static std::string JobQueueIndexAttrs;
+	// the ad each job is filed under in JobQueueIndex
+static IndexedJobMap JobQueueIndexedJobs;
+static HashTable<PROC_ID,int> JobQueueIndexChangedJobs(hashFuncPROC_ID);
+static HashTable<PROC_ID,int> JobQueueIndexChangedJobsInTransaction(hashFuncPROC_ID);
+	// Clusters whose cluster ad changed.  Procs see the cluster ad's
+	// attributes through chaining, so all of them need to be refiled.
+static std::set<int> JobQueueIndexChangedClusters;
+static std::set<int> JobQueueIndexChangedClustersInTransaction;
+
+static bool
+IsJobQueueIndexAttr( const char *attr_name )
+{
+	return JobQueueIndex.hasAttributes() && JobQueueIndex.isIndexed( attr_name );
+}
+
+static void
+NoteJobQueueIndexChange( int cluster_id, int proc_id )
+{
+	if( !JobQueueIndex.hasAttributes() ) {
+		return;
+	}
+	bool in_transaction = JobQueue->InTransaction();
+	if( proc_id < 0 ) {
+		if( in_transaction ) {
+			JobQueueIndexChangedClustersInTransaction.insert( cluster_id );
+		}
+		else {
+			JobQueueIndexChangedClusters.insert( cluster_id );
+		}
+		return;
+	}
+
+	PROC_ID id;
+	id.cluster = cluster_id;
+	id.proc = proc_id;
+	if( in_transaction ) {
+		JobQueueIndexChangedJobsInTransaction.insert( id, 1 );
+	}
+	else {
+		JobQueueIndexChangedJobs.insert( id, 1 );
+	}
+}
+
+static void
+CommitJobQueueIndexChanges()
+{
+	PROC_ID id;
+	int junk;
+	JobQueueIndexChangedJobsInTransaction.startIterations();
+	while( JobQueueIndexChangedJobsInTransaction.iterate( id, junk ) ) {
+		JobQueueIndexChangedJobs.insert( id, 1 );
+	}
+	JobQueueIndexChangedJobsInTransaction.clear();
+
+	JobQueueIndexChangedClusters.insert(
+		JobQueueIndexChangedClustersInTransaction.begin(),
+		JobQueueIndexChangedClustersInTransaction.end() );
+	JobQueueIndexChangedClustersInTransaction.clear();
+}
+
+static void
+AbortJobQueueIndexChanges()
+{
+	JobQueueIndexChangedJobsInTransaction.clear();
+	JobQueueIndexChangedClustersInTransaction.clear();
+}
+
+	// File every job in the queue from scratch.
+static void
+BuildJobQueueIndex()
+{
+	JobQueueIndex.clear();
+	JobQueueIndexedJobs.clear();
+	JobQueueIndexChangedJobs.clear();
+	JobQueueIndexChangedClusters.clear();
+
+	if( !JobQueue || !JobQueueIndex.hasAttributes() ) {
+		return;
+	}
+
+	double begin = UtcTime::getTimeDouble();
+	ClassAd *ad;
+	HashKey key;
+	PROC_ID id;
+	JobQueue->StartIterateAllClassAds();
+	while( JobQueue->IterateAllClassAds( ad, key ) ) {
+		if( !StrToProcId( key.value(), id.cluster, id.proc ) ||
+			id.cluster <= 0 || id.proc < 0 )
+		{
+			continue;	// header and cluster ads
+		}
+		JobQueueIndex.insert( ad );
+		JobQueueIndexedJobs[id] = ad;
+	}
+	dprintf( D_FULLDEBUG, "Indexed %d jobs on %s in %.3fs\n",
+			 JobQueueIndex.size(), JobQueueIndexAttrs.c_str(),
+			 UtcTime::getTimeDouble() - begin );
+}
+
+	// Refile the jobs noted by NoteJobQueueIndexChange().  This costs
+	// time in proportion to the number of changed jobs.
+static void
+UpdateJobQueueIndex()
+{
+	PROC_ID id;
+	int junk;
+	IndexedJobMap::iterator it;
+
+		// Unfile every changed job before filing any of them again,
+		// since a new job's ad may have been allocated where the ad of
+		// a destroyed one used to be.
+	JobQueueIndexChangedJobs.startIterations();
+	while( JobQueueIndexChangedJobs.iterate( id, junk ) ) {
+		it = JobQueueIndexedJobs.find( id );
+		if( it != JobQueueIndexedJobs.end() ) {
+			JobQueueIndex.remove( it->second );
+			JobQueueIndexedJobs.erase( it );
+		}
+	}
+
+	char key[PROC_ID_STR_BUFLEN];
+	ClassAd *ad;
+	JobQueueIndexChangedJobs.startIterations();
+	while( JobQueueIndexChangedJobs.iterate( id, junk ) ) {
+		ProcIdToStr( id.cluster, id.proc, key );
+		if( JobQueue->LookupClassAd( key, ad ) ) {
+			JobQueueIndex.insert( ad );
+			JobQueueIndexedJobs[id] = ad;
+		}
+	}
+	JobQueueIndexChangedJobs.clear();
+
+	std::set<int>::iterator cluster;
+	for( cluster = JobQueueIndexChangedClusters.begin();
+		 cluster != JobQueueIndexChangedClusters.end();
+		 cluster++ )
+	{
+		id.cluster = *cluster;
+		id.proc = -1;
+		for( it = JobQueueIndexedJobs.lower_bound( id );
+			 it != JobQueueIndexedJobs.end() && it->first.cluster == *cluster;
+			 it++ )
+		{
+			JobQueueIndex.update( it->second );
+		}
+	}
+	JobQueueIndexChangedClusters.clear();
+}
+
+	// Find the jobs that may match the given constraint, in job id order.
+	// Returns false if the index cannot narrow it down, in which case
+	// every job has to be considered.
+static bool
+JobQueueIndexCandidates( classad::ExprTree *constraint, std::vector<PROC_ID> &ids )
+{
+	ids.clear();
+	if( !JobQueue || !constraint || !JobQueueIndex.hasAttributes() ) {
+		return false;
+	}
+	UpdateJobQueueIndex();
+
+	std::set<ClassAd *> ads;
+	if( !JobQueueIndex.candidates( constraint, ads ) ) {
+		return false;
+	}
+
+	ids.reserve( ads.size() );
+	std::set<ClassAd *>::iterator it;
+	for( it = ads.begin(); it != ads.end(); it++ ) {
+		PROC_ID id;
+		if( (*it)->LookupInteger( ATTR_CLUSTER_ID, id.cluster ) &&
+			(*it)->LookupInteger( ATTR_PROC_ID, id.proc ) )
+		{
+			ids.push_back( id );
+		}
+	}
+	std::sort( ids.begin(), ids.end(), JobIdLess() );
+	return true;
+}
 
 const char HeaderKey[] = "0.0";
 
@@ -138,10 +492,37 @@ typedef HashTable<int, int> ClusterSizeHashTable_t;
 static ClusterSizeHashTable_t *ClusterSizeHashTable = 0;
 static int TotalJobsCount = 0;
 
+	// Clusters whose remaining procs the schedd creates itself, a few
+	// at a time, from the template condor_submit left in the cluster ad
+	// (late materialization).  The value is the lowest proc id that may
+	// still be in the queue, so counting a cluster's idle procs only
+	// looks at the ones materialized since.
+static std::map<int,int> JobFactories;
+static int materialize_jobs_timer_id = -1;
+static void ScheduleMaterializeJobs( int delay );
+static void HandleMaterializeJobsTimer();
+
 static int flush_job_queue_log_timer_id = -1;
 static int dirty_notice_timer_id = -1;
 static int flush_job_queue_log_delay = 0;
 static void HandleFlushJobQueueLogTimer();
+
+	// group commit of durable qmgmt transactions, see CommitTransactionGrouped()
+static bool job_queue_group_commit = false;
+static int job_queue_group_commit_max_transactions = 0;
+static int job_queue_group_commit_max_bytes = 0;
+static int job_queue_sync_timer_id = -1;
+static unsigned long job_queue_grouped_commit_seq = 0;
+static unsigned long job_queue_synced_seq_seen = 0;
+struct GroupedCommitWaiter {
+	QmgmtPeer *peer;
+	unsigned long seq;	// durable once JobQueue->SyncedCommitSequence() reaches this
+	double commit_time;
+};
+static std::list<GroupedCommitWaiter> grouped_commit_waiters;
+static void ScheduleJobQueueSync();
+static void HandleJobQueueSyncTimer();
+static void NoteJobQueueSynced();
 static int dirty_notice_interval = 0;
 static void PeriodicDirtyAttributeNotification();
 static void ScheduleJobQueueLogFlush();
@@ -160,6 +541,18 @@ static const char *default_super_user =
 ClassAdLog::filter_iterator
 BeginIterator(const classad::ExprTree &requirements, int timeslice_ms)
 {
+	std::vector<PROC_ID> ids;
+	if( JobQueueIndexCandidates(const_cast<classad::ExprTree *>(&requirements), ids) ) {
+		classad_shared_ptr<std::vector<std::string> > keys(new std::vector<std::string>);
+		keys->reserve(ids.size());
+		char key[PROC_ID_STR_BUFLEN];
+		for( size_t i = 0; i < ids.size(); i++ ) {
+			ProcIdToStr(ids[i].cluster, ids[i].proc, key);
+			keys->push_back(key);
+		}
+		ClassAdLog::filter_iterator it(&JobQueue->table, &requirements, timeslice_ms, keys);
+		return it;
+	}
 	ClassAdLog::filter_iterator it(JobQueue ? &JobQueue->table : NULL, &requirements, timeslice_ms);
 	return it;
 }
@@ -203,6 +596,8 @@ ClusterCleanup(int cluster_id)
 	// remove entry in ClusterSizeHashTable 
 	ClusterSizeHashTable->remove(cluster_id);
 
+	JobFactories.erase(cluster_id);
+
 	// delete the cluster classad
 	JobQueue->DestroyClassAd( key );
 
@@ -252,7 +647,9 @@ DecrementClusterSize(int cluster_id)
 
 		// If this is the last job in the cluster, remove the initial
 		//    checkpoint file and the entry in the ClusterSizeHashTable.
-		if ( *numOfProcs == 0 ) {
+		// A cluster that still has procs to materialize stays around
+		//    until the last of those is gone.
+		if ( *numOfProcs == 0 && !JobFactories.count(cluster_id) ) {
 			ClusterCleanup(cluster_id);
 			numOfProcs = NULL;
 		}
@@ -619,7 +1016,20 @@ InitQmgmt()
     cluster_maximum_val = param_integer("SCHEDD_CLUSTER_MAXIMUM_VALUE",0,0);
 
 	flush_job_queue_log_delay = param_integer("SCHEDD_JOB_QUEUE_LOG_FLUSH_DELAY",5,0);
+	job_queue_group_commit = param_boolean("SCHEDD_JOB_QUEUE_GROUP_COMMIT",false);
+	job_queue_group_commit_max_transactions = param_integer("SCHEDD_JOB_QUEUE_GROUP_COMMIT_MAX_TRANSACTIONS",100,1);
+	job_queue_group_commit_max_bytes = param_integer("SCHEDD_JOB_QUEUE_GROUP_COMMIT_MAX_BYTES",1024*1024,0);
 	dirty_notice_interval = param_integer("SCHEDD_JOB_QUEUE_NOTIFY_UPDATES",30,0);
+
+	std::string index_attrs;
+	param(index_attrs, "SCHEDD_JOB_QUEUE_INDEX_ATTRIBUTES");
+	if( index_attrs != JobQueueIndexAttrs ) {
+		JobQueueIndexAttrs = index_attrs;
+		StringList attrs(index_attrs.c_str());
+		JobQueueIndex.setAttributes(attrs);
+			// does nothing until the job queue has been loaded
+		BuildJobQueueIndex();
+	}
 }
 
 void
@@ -922,7 +1332,16 @@ InitJobQueue(const char *job_queue_name,int max_historical_logs)
 	JobQueue->StartIterateAllClassAds();
 	while (JobQueue->IterateAllClassAds(ad,key)) {
 		const char *tmp = key.value();
-		if ( *tmp == '0' ) continue;	// skip cluster & header ads
+		if ( *tmp == '0' ) {	// skip cluster & header ads
+				// but remember the clusters that have procs left
+				// to materialize
+			if ( ad->LookupExpr(ATTR_JOB_MATERIALIZE_LIMIT) ) {
+				int proc_num;
+				StrToId(tmp,cluster_num,proc_num);
+				JobFactories[cluster_num] = 0;
+			}
+			continue;
+		}
 		if ( (cluster_num = atoi(tmp)) ) {
 
 			// find highest cluster, set next_cluster_num to one increment higher
@@ -1190,6 +1609,12 @@ InitJobQueue(const char *job_queue_name,int max_historical_logs)
 	if( spool_cur_version != SPOOL_CUR_VERSION_SCHEDD_SUPPORTS ) {
 		WriteSpoolVersion(spool.Value(),SPOOL_MIN_VERSION_SCHEDD_WRITES,SPOOL_CUR_VERSION_SCHEDD_SUPPORTS);
 	}
+
+	BuildJobQueueIndex();
+
+	if ( !JobFactories.empty() ) {
+		ScheduleMaterializeJobs(0);
+	}
 }
 
 
@@ -1222,8 +1647,25 @@ DestroyJobQueue( void )
 		CleanJobQueue();
 	}
 	ASSERT( JobQueueDirty == false );
+
+		// Make grouped commits durable.  Connections still waiting for
+		// the reply are dropped; the clients will see an error, as they
+		// would for any connection cut off by the shutdown.
+	JobQueue->SyncLog();
+	if( job_queue_sync_timer_id != -1 ) {
+		daemonCore->Cancel_Timer( job_queue_sync_timer_id );
+		job_queue_sync_timer_id = -1;
+	}
+	while( !grouped_commit_waiters.empty() ) {
+		QmgmtPeer *peer = grouped_commit_waiters.front().peer;
+		grouped_commit_waiters.pop_front();
+		delete peer->getReliSock();
+		delete peer;
+	}
+
 	delete JobQueue;
 	JobQueue = NULL;
+	BuildJobQueueIndex();	// i.e. empty it
 
 	DirtyJobIDs.clearAll();
 
@@ -1246,41 +1688,6 @@ DestroyJobQueue( void )
 }
 
 
-int
-grow_prio_recs( int newsize )
-{
-	int i;
-	prio_rec *tmp;
-
-	// just return if PrioRec already equal/larger than the size requested
-	if ( MAX_PRIO_REC >= newsize ) {
-		return 0;
-	}
-
-	dprintf(D_FULLDEBUG,"Dynamically growing PrioRec to %d\n",newsize);
-
-	tmp = new prio_rec[newsize];
-	if ( tmp == NULL ) {
-		EXCEPT( "grow_prio_recs: out of memory" );
-	}
-
-	/* copy old PrioRecs over */
-	for (i=0;i<N_PrioRecs;i++)
-		tmp[i] = PrioRec[i];
-
-	/* delete old too-small space, but only if we new-ed it; the
-	 * first space came from the heap, so check and don't try to 
-	 * delete that */
-	if ( &PrioRec[0] != &PrioRecArray[0] )
-		delete [] PrioRec;
-
-	/* replace with spanky new big one */
-	PrioRec = tmp;
-	MAX_PRIO_REC = newsize;
-	return 0;
-}
-
-
 bool
 isQueueSuperUser( const char* user )
 {
@@ -1561,6 +1968,9 @@ unsetQmgmtConnection()
 		// was called previously, since getQmgmtConnectionInfo() clears 
 		// out the transaction after returning the handle.
 	JobQueue->AbortTransaction();	
+	AbortPrioRecChanges();
+	AbortJobQueueIndexChanges();
+	AbortJobCountChanges();
 
 	ASSERT(Q_SOCK == NULL);
 
@@ -1633,10 +2043,11 @@ unsetQSock()
 }
 
 
+static int handle_q_requests();
+
 int
 handle_q(Service *, int, Stream *sock)
 {
-	int	rval;
 	bool all_good;
 
 	all_good = setQSock((ReliSock*)sock);
@@ -1655,6 +2066,18 @@ handle_q(Service *, int, Stream *sock)
 
 	BeginTransaction();
 
+	return handle_q_requests();
+}
+
+	// Serve requests on the current Q_SOCK until the client is done
+	// with it, or until it has to wait for a grouped commit to reach
+	// the disk, in which case HandleJobQueueSyncTimer() will pick up
+	// where we left off.
+static int
+handle_q_requests()
+{
+	int	rval;
+
 	bool may_fork = false;
 	ForkStatus fork_status = FORK_FAILED;
 	do {
@@ -1668,8 +2091,20 @@ handle_q(Service *, int, Stream *sock)
 				break;
 			}
 		}
-	} while(rval >= 0);
+	} while(rval == 0);
 
+	if( rval > 0 && fork_status != FORK_PARENT ) {
+			// do_Q_request() committed a grouped transaction and left
+			// the reply for later.  Set the connection aside until then.
+		GroupedCommitWaiter waiter;
+		waiter.seq = job_queue_grouped_commit_seq;
+		waiter.commit_time = UtcTime::getTimeDouble();
+		waiter.peer = getQmgmtConnectionInfo();
+		ASSERT( waiter.peer );
+		grouped_commit_waiters.push_back( waiter );
+		ScheduleJobQueueSync();
+		return KEEP_STREAM;
+	}
 
 	unsetQSock();
 
@@ -1692,6 +2127,131 @@ handle_q(Service *, int, Stream *sock)
 	return 0;
 }
 
+	// Apply a batch of attribute updates to one job in a single
+	// transaction.  This is what QmgrJobUpdater uses instead of a
+	// whole qmgmt connection per update.  The client keeps the
+	// connection (and its security session) open and sends the next
+	// update on it, so we register it as a command socket when we
+	// are done instead of letting DaemonCore close it.
+int
+handle_update_job_attrs(Service *, int, Stream *stream)
+{
+	ReliSock *sock = (ReliSock *)stream;
+	int cluster_id = -1;
+	int proc_id = -1;
+	int set_flags = 0;
+	int commit_flags = 0;
+	std::string effective_owner;
+	std::string pull_attrs;
+	ClassAd updates;
+
+	sock->decode();
+	if( !sock->code(cluster_id) ||
+		!sock->code(proc_id) ||
+		!sock->code(set_flags) ||
+		!sock->code(commit_flags) ||
+		!sock->code(effective_owner) ||
+		!getClassAd(sock, updates) ||
+		!sock->code(pull_attrs) ||
+		!sock->end_of_message() )
+	{
+		dprintf(D_ALWAYS, "handle_update_job_attrs: failed to receive "
+				"update from %s\n", sock->peer_description());
+		return FALSE;
+	}
+
+		// Go through the usual qmgmt permission checks, just as if
+		// this had come in over a qmgmt connection.
+	if( !setQSock(sock) ) {
+		unsetQSock();
+		if( !setQSock(sock) ) {
+			EXCEPT("handle_update_job_attrs: Unable to setQSock!!");
+		}
+	}
+
+	int result = 0;
+	ClassAd pulled;
+	if( QmgmtSetEffectiveOwner(effective_owner.empty() ? NULL : effective_owner.c_str()) < 0 ) {
+		dprintf(D_ALWAYS, "handle_update_job_attrs: failed to set "
+				"effective owner to %s for job %d.%d\n",
+				effective_owner.c_str(), cluster_id, proc_id);
+		result = -1;
+	}
+	else {
+		BeginTransaction();
+
+		classad::ClassAdUnParser unparser;
+		unparser.SetOldClassAd( true );
+		for( classad::ClassAd::iterator itr = updates.begin();
+			 itr != updates.end() && result == 0;
+			 itr++ )
+		{
+			std::string value;
+			unparser.Unparse( value, itr->second );
+			if( SetAttribute(cluster_id, proc_id, itr->first.c_str(),
+							 value.c_str(), (SetAttributeFlags_t)set_flags) < 0 )
+			{
+				dprintf(D_ALWAYS, "handle_update_job_attrs: failed "
+						"SetAttribute(%s = %s) for job %d.%d\n",
+						itr->first.c_str(), value.c_str(),
+						cluster_id, proc_id);
+				result = -1;
+			}
+		}
+
+		StringList pull_list( pull_attrs.c_str() );
+		char const *name;
+		pull_list.rewind();
+		while( result == 0 && (name = pull_list.next()) ) {
+			char *value = NULL;
+			if( GetAttributeExprNew(cluster_id, proc_id, name, &value) < 0 ) {
+				result = -1;
+			}
+			else {
+				pulled.AssignExpr( name, value );
+			}
+			free( value );
+		}
+
+		if( result == 0 ) {
+			CommitTransaction( (SetAttributeFlags_t)commit_flags );
+		}
+		else {
+			AbortTransactionAndRecomputeClusters();
+		}
+	}
+
+	unsetQSock();
+
+	sock->encode();
+	if( !sock->code(result) ||
+		!putClassAd(sock, pulled) ||
+		!sock->end_of_message() )
+	{
+		dprintf(D_ALWAYS, "handle_update_job_attrs: failed to send "
+				"reply to %s\n", sock->peer_description());
+		return FALSE;
+	}
+
+	if( daemonCore->SocketIsRegistered(sock) ) {
+		return KEEP_STREAM;
+	}
+
+	MyString msg;
+	if( daemonCore->TooManyRegisteredSockets(sock->get_file_desc(),&msg) ) {
+			// the client will just have to connect again next time
+		dprintf(D_FULLDEBUG, "Not keeping job update socket from %s "
+				"open: %s\n", sock->peer_description(), msg.Value());
+		return FALSE;
+	}
+	if( daemonCore->Register_Command_Socket(sock, "Job Update Socket") < 0 ) {
+		dprintf(D_ALWAYS, "Failed to register job update socket from %s\n",
+				sock->peer_description());
+		return FALSE;
+	}
+	return KEEP_STREAM;
+}
+
 int GetMyProxyPassword (int, int, char **);
 
 int get_myproxy_password_handler(Service * /*service*/, int /*i*/, Stream *socket) {
@@ -1823,11 +2383,12 @@ NewCluster()
 }
 
 
+void NewProcAd(int cluster_id, int proc_id);
+
 int
 NewProc(int cluster_id)
 {
 	int				proc_id;
-	char			key[PROC_ID_STR_BUFLEN];
 //	LogNewClassAd	*log;
 
 	if( Q_SOCK && !OwnerCheck(NULL, Q_SOCK->getOwner() ) ) {
@@ -1848,6 +2409,19 @@ NewProc(int cluster_id)
 	}
 
 	proc_id = next_proc_num++;
+	NewProcAd(cluster_id,proc_id);
+
+	return proc_id;
+}
+
+	// Put a new proc ad in the current transaction.  This is the part
+	// of NewProc() that the schedd also does for itself when it
+	// materializes a proc.
+void
+NewProcAd(int cluster_id, int proc_id)
+{
+	char			key[PROC_ID_STR_BUFLEN];
+
 	IdToStr(cluster_id,proc_id,key);
 //	log = new LogNewClassAd(key, JOB_ADTYPE, STARTD_ADTYPE);
 //	JobQueue->AppendLog(log);
@@ -1874,8 +2448,261 @@ NewProc(int cluster_id)
 	}
 	gjid += "\"";
 	JobQueue->SetAttribute( key, ATTR_GLOBAL_JOB_ID, gjid.Value() );
+}
 
-	return proc_id;
+	// The attributes that differ from one materialized proc to the
+	// next, each with the text of its value, in which $(ProcId) stands
+	// for the proc id.
+typedef std::vector< std::pair<std::string,std::string> > JobMaterializeTemplate;
+
+	// Can a proc template set this attribute?  Not if the schedd sets
+	// it itself or SetAttribute() would have checked it.
+static bool
+IsJobMaterializeAttrAllowed(char const *name)
+{
+	return IsValidAttrName(name) &&
+		strcasecmp(name, ATTR_OWNER) &&
+		strcasecmp(name, ATTR_USER) &&
+		strcasecmp(name, ATTR_NICE_USER) &&
+		strcasecmp(name, ATTR_CLUSTER_ID) &&
+		strcasecmp(name, ATTR_PROC_ID) &&
+		strcasecmp(name, ATTR_GLOBAL_JOB_ID) &&
+		strncasecmp(name, "JobMaterialize", 14);
+}
+
+static bool
+GetJobMaterializeTemplate(int cluster_id, ClassAd *cluster_ad, JobMaterializeTemplate &tmpl)
+{
+	std::string names;
+	if( !cluster_ad->LookupString(ATTR_JOB_MATERIALIZE_ATTRS, names) ) {
+			// the procs differ only in their ProcId
+		return true;
+	}
+
+	StringList name_list(names.c_str());
+	char const *name;
+	name_list.rewind();
+	while( (name = name_list.next()) ) {
+		std::string attr = ATTR_JOB_MATERIALIZE_ATTR_PREFIX;
+		attr += name;
+		std::string value;
+		if( !IsJobMaterializeAttrAllowed(name) ||
+			!cluster_ad->LookupString(attr.c_str(), value) )
+		{
+			dprintf(D_ALWAYS, "Cluster %d has a bad proc template attribute %s\n",
+					cluster_id, name);
+			return false;
+		}
+
+		MyString test_value = value;
+		test_value.replaceString("$(ProcId)", "0");
+		ExprTree *tree = NULL;
+		if( !IsValidAttrValue(test_value.Value()) ||
+			ParseClassAdRvalExpr(test_value.Value(), tree) != 0 )
+		{
+			dprintf(D_ALWAYS, "Cluster %d has a bad proc template value %s = %s\n",
+					cluster_id, name, value.c_str());
+			return false;
+		}
+		delete tree;
+
+		tmpl.push_back(std::make_pair(std::string(name), value));
+	}
+	return true;
+}
+
+	// Don't do more than this many procs of a cluster in one go, so
+	// that a big window doesn't keep the schedd from other work.
+static const int MATERIALIZE_JOBS_BATCH = 100;
+
+	// Create the next procs of a factory cluster from its template, as
+	// many as it takes to have JobMaterializeMaxIdle of them idle.
+	// low_proc is the lowest proc id that may still be in the queue;
+	// more is set if there is more to do right away.  Returns false
+	// once the cluster has nothing left to materialize.
+static bool
+MaterializeJobs(int cluster_id, int &low_proc, bool &more)
+{
+	char cluster_key[PROC_ID_STR_BUFLEN];
+	ClassAd *cluster_ad = NULL;
+
+	IdToStr(cluster_id,-1,cluster_key);
+	if( !JobQueue->LookupClassAd(cluster_key, cluster_ad) ) {
+		return false;
+	}
+
+	int limit = 0;
+	int next_proc = 0;
+	int max_idle = 0;
+	cluster_ad->LookupInteger(ATTR_JOB_MATERIALIZE_LIMIT, limit);
+	cluster_ad->LookupInteger(ATTR_JOB_MATERIALIZE_NEXT_PROC_ID, next_proc);
+	cluster_ad->LookupInteger(ATTR_JOB_MATERIALIZE_MAX_IDLE, max_idle);
+	if( next_proc >= limit ) {
+		return false;
+	}
+
+	int idle = 0;
+	for( int proc_id = low_proc; proc_id < next_proc; proc_id++ ) {
+		char key[PROC_ID_STR_BUFLEN];
+		ClassAd *ad = NULL;
+		IdToStr(cluster_id,proc_id,key);
+		if( !JobQueue->LookupClassAd(key, ad) ) {
+			if( proc_id == low_proc ) {
+				low_proc++;
+			}
+			continue;
+		}
+		int status = -1;
+		ad->LookupInteger(ATTR_JOB_STATUS, status);
+		if( status == IDLE ) {
+			idle++;
+		}
+	}
+
+	int count = MIN(max_idle - idle, limit - next_proc);
+	if( count > MATERIALIZE_JOBS_BATCH ) {
+		count = MATERIALIZE_JOBS_BATCH;
+		more = true;
+	}
+	if( count > scheduler.getMaxJobsSubmitted() - TotalJobsCount ) {
+			// try again when some jobs have left the queue
+		count = scheduler.getMaxJobsSubmitted() - TotalJobsCount;
+	}
+	if( count <= 0 ) {
+		return true;
+	}
+
+	JobMaterializeTemplate tmpl;
+	if( !GetJobMaterializeTemplate(cluster_id, cluster_ad, tmpl) ) {
+		dprintf(D_ALWAYS, "Not materializing any more procs of cluster %d\n",
+				cluster_id);
+		return false;
+	}
+
+	dprintf(D_FULLDEBUG, "Materializing procs %d to %d of cluster %d\n",
+			next_proc, next_proc + count - 1, cluster_id);
+
+		// Nondurable is good enough: if we crash before this reaches
+		// the disk, JobMaterializeNextProcId goes back with the procs
+		// and they get materialized again.
+	BeginTransaction();
+	for( int proc_id = next_proc; proc_id < next_proc + count; proc_id++ ) {
+		char key[PROC_ID_STR_BUFLEN];
+		MyString proc_str;
+		proc_str += proc_id;
+
+		NewProcAd(cluster_id,proc_id);
+		IdToStr(cluster_id,proc_id,key);
+		JobQueue->SetAttribute(key, ATTR_PROC_ID, proc_str.Value());
+
+		JobMaterializeTemplate::iterator itr;
+		for( itr = tmpl.begin(); itr != tmpl.end(); itr++ ) {
+			MyString value = itr->second;
+			value.replaceString("$(ProcId)", proc_str.Value());
+			JobQueue->SetAttribute(key, itr->first.c_str(), value.Value());
+		}
+	}
+	SetAttributeInt(cluster_id, -1, ATTR_JOB_MATERIALIZE_NEXT_PROC_ID,
+					next_proc + count);
+	CommitTransaction(NONDURABLE);
+
+	if( cluster_ad->LookupExpr(ATTR_CRON_MINUTES) ||
+		cluster_ad->LookupExpr(ATTR_CRON_HOURS) ||
+		cluster_ad->LookupExpr(ATTR_CRON_DAYS_OF_MONTH) ||
+		cluster_ad->LookupExpr(ATTR_CRON_MONTHS) ||
+		cluster_ad->LookupExpr(ATTR_CRON_DAYS_OF_WEEK) )
+	{
+		scheduler.addCronTabClusterId(cluster_id);
+	}
+
+	return true;
+}
+
+static void
+ScheduleMaterializeJobs( int delay )
+{
+	if( materialize_jobs_timer_id == -1 ) {
+		materialize_jobs_timer_id = daemonCore->Register_Timer(
+			delay,
+			HandleMaterializeJobsTimer,
+			"HandleMaterializeJobsTimer");
+	}
+}
+
+static void
+HandleMaterializeJobsTimer()
+{
+	materialize_jobs_timer_id = -1;
+
+		// a client may be in the middle of a transaction of its own
+	if( InTransaction() ) {
+		ScheduleMaterializeJobs(1);
+		return;
+	}
+
+	bool more = false;
+	std::map<int,int>::iterator it = JobFactories.begin();
+	while( it != JobFactories.end() ) {
+		int cluster_id = it->first;
+		if( MaterializeJobs(cluster_id, it->second, more) ) {
+			++it;
+			continue;
+		}
+
+		dprintf(D_FULLDEBUG, "Cluster %d has no more procs to materialize\n",
+				cluster_id);
+		JobFactories.erase(it++);
+
+			// clean up the cluster if DecrementClusterSize() left it
+			// for us
+		char cluster_key[PROC_ID_STR_BUFLEN];
+		ClassAd *cluster_ad = NULL;
+		int *numOfProcs = NULL;
+		IdToStr(cluster_id,-1,cluster_key);
+		if( JobQueue->LookupClassAd(cluster_key, cluster_ad) &&
+			( ClusterSizeHashTable->lookup(cluster_id,numOfProcs) == -1 ||
+			  *numOfProcs == 0 ) )
+		{
+			BeginTransaction();
+			ClusterCleanup(cluster_id);
+			CommitTransaction(NONDURABLE);
+		}
+	}
+
+	if( more ) {
+		ScheduleMaterializeJobs(0);
+	}
+}
+
+void
+StopJobFactoriesByConstraint(const char *constraint)
+{
+	classad::ExprTree *tree = NULL;
+	if( !constraint || ParseClassAdRvalExpr(constraint, tree) != 0 ) {
+		return;
+	}
+
+	std::map<int,int>::iterator it;
+	for( it = JobFactories.begin(); it != JobFactories.end(); it++ ) {
+		char cluster_key[PROC_ID_STR_BUFLEN];
+		ClassAd *cluster_ad = NULL;
+		IdToStr(it->first,-1,cluster_key);
+		if( !JobQueue->LookupClassAd(cluster_key, cluster_ad) ) {
+			continue;
+		}
+		if( Q_SOCK && !OwnerCheck(cluster_ad, Q_SOCK->getOwner()) ) {
+			continue;
+		}
+		if( EvalBool(cluster_ad, tree) ) {
+			int next_proc = 0;
+			cluster_ad->LookupInteger(ATTR_JOB_MATERIALIZE_NEXT_PROC_ID, next_proc);
+			dprintf(D_ALWAYS, "Not materializing any more procs of cluster %d\n",
+					it->first);
+			SetAttributeInt(it->first, -1, ATTR_JOB_MATERIALIZE_LIMIT, next_proc);
+			ScheduleMaterializeJobs(0);
+		}
+	}
+	delete tree;
 }
 
 int 	DestroyMyProxyPassword (int cluster_id, int proc_id);
@@ -1968,8 +2795,14 @@ int DestroyProc(int cluster_id, int proc_id)
 	(void)DestroyMyProxyPassword (cluster_id, proc_id);
 
 	JobQueue->DestroyClassAd(key);
+	NotePrioRecChange(cluster_id, proc_id);
+	NoteJobQueueIndexChange(cluster_id, proc_id);
+	NoteJobCountChange(cluster_id, proc_id);
 
 	DecrementClusterSize(cluster_id);
+	if( JobFactories.count(cluster_id) ) {
+		ScheduleMaterializeJobs(0);
+	}
 
 	int universe = CONDOR_UNIVERSE_STANDARD;
 	ad->LookupInteger(ATTR_JOB_UNIVERSE, universe);
@@ -1999,6 +2832,9 @@ int DestroyProc(int cluster_id, int proc_id)
 				stillLooking = false;
 			} else {
 				JobQueue->DestroyClassAd(otherKey);
+				NotePrioRecChange(cluster_id, otherProc);
+				NoteJobQueueIndexChange(cluster_id, otherProc);
+				NoteJobCountChange(cluster_id, otherProc);
 				DecrementClusterSize(cluster_id);
 			}
 		}
@@ -2110,6 +2946,8 @@ int DestroyCluster(int cluster_id, const char* reason)
 				cleanup_ckpt_files(cluster_id,proc_id, NULL );
 
 				JobQueue->DestroyClassAd(key.value());
+				NotePrioRecChange(cluster_id, proc_id);
+				NoteJobQueueIndexChange(cluster_id, proc_id);
 
 					// remove any match (startd) ad stored w/ this job
 				if ( scheduler.resourcesByProcID ) {
@@ -2346,6 +3184,54 @@ SetAttribute(int cluster_id, int proc_id, const char *attr_name,
 			return -1;
 		}
 	}
+	else if (strcasecmp(attr_name, ATTR_JOB_MATERIALIZE_ATTRS) == 0) {
+			// the schedd sets these attributes in every proc it
+			// materializes, so they can't be ones that are checked here
+		ClassAd tmp_ad;
+		std::string names;
+		if( proc_id != -1 ||
+			!tmp_ad.AssignExpr(ATTR_JOB_MATERIALIZE_ATTRS, attr_value) ||
+			!tmp_ad.LookupString(ATTR_JOB_MATERIALIZE_ATTRS, names) )
+		{
+#if !defined(WIN32)
+			errno = EINVAL;
+#endif
+			dprintf(D_ALWAYS, "SetAttribute: invalid %s for job %d.%d\n",
+					ATTR_JOB_MATERIALIZE_ATTRS, cluster_id, proc_id);
+			return -1;
+		}
+		StringList name_list(names.c_str());
+		char const *name;
+		name_list.rewind();
+		while( (name = name_list.next()) ) {
+			if( !IsJobMaterializeAttrAllowed(name) ) {
+#if !defined(WIN32)
+				errno = EACCES;
+#endif
+				dprintf(D_ALWAYS, "SetAttribute security violation: %s may "
+						"not include %s\n", ATTR_JOB_MATERIALIZE_ATTRS, name);
+				return -1;
+			}
+		}
+	}
+	else if (strcasecmp(attr_name, ATTR_JOB_MATERIALIZE_LIMIT) == 0) {
+		if( proc_id != -1 ) {
+#if !defined(WIN32)
+			errno = EINVAL;
+#endif
+			dprintf(D_ALWAYS, "SetAttribute: %s may only be set in a "
+					"cluster ad, not job %d.%d\n", ATTR_JOB_MATERIALIZE_LIMIT,
+					cluster_id, proc_id);
+			return -1;
+		}
+			// A new factory starts at proc 1.  condor_submit reads this
+			// back before it leaves any procs to us, so it is our word
+			// that they will be materialized.
+		int next_proc;
+		if( GetAttributeInt(cluster_id, -1, ATTR_JOB_MATERIALIZE_NEXT_PROC_ID, &next_proc) < 0 ) {
+			SetAttributeInt(cluster_id, -1, ATTR_JOB_MATERIALIZE_NEXT_PROC_ID, 1, flags);
+		}
+	}
 	else if (strcasecmp(attr_name, ATTR_NICE_USER) == 0) {
 			// Because we're setting a new value for nice user, we
 			// should create a new value for ATTR_USER while we're at
@@ -2398,6 +3284,11 @@ SetAttribute(int cluster_id, int proc_id, const char *attr_name,
 		int status = 0;
 		GetAttributeInt( cluster_id, proc_id, ATTR_JOB_STATUS, &status );
 		SetAttributeInt( cluster_id, proc_id, ATTR_LAST_JOB_STATUS, status, flags );
+
+			// an idle proc of a factory cluster may be starting to run
+		if( JobFactories.count(cluster_id) ) {
+			ScheduleMaterializeJobs(0);
+		}
 	}
 #if defined(ADD_TARGET_SCOPING)
 /* Disable AddTargetRefs() for now
@@ -2430,6 +3321,7 @@ SetAttribute(int cluster_id, int proc_id, const char *attr_name,
 			if ( attrs.contains_anycase(attr_name) ) {
 				ad->Delete(ATTR_AUTO_CLUSTER_ID);
 				ad->Delete(ATTR_AUTO_CLUSTER_ATTRS);
+				NotePrioRecChange(cluster_id, proc_id);
 			}
 			free(sigAttrs);
 			sigAttrs = NULL;
@@ -2545,21 +3437,15 @@ SetAttribute(int cluster_id, int proc_id, const char *attr_name,
 	}
 	free( round_param );
 
-	if( !PrioRecArrayIsDirty ) {
-		if( strcasecmp(attr_name, ATTR_ACCOUNTING_GROUP) == 0 ||
-            strcasecmp(attr_name, ATTR_JOB_PRIO) == 0 ) {
-			DirtyPrioRecArray();
-		} else if( strcasecmp(attr_name, ATTR_JOB_STATUS) == 0 ) {
-			if( atoi(attr_value) == IDLE ) {
-				DirtyPrioRecArray();
-			}
-		}
-		if(PrioRecArrayIsDirty) {
-			dprintf(D_FULLDEBUG,
-					"Prioritized runnable job list will be rebuilt, because "
-					"ClassAd attribute %s=%s changed\n",
-					attr_name,attr_value);
-		}
+		// Jobs not yet committed are picked up by CommitTransaction().
+	if( ad && IsPrioRecAttr(attr_name) ) {
+		NotePrioRecChange(cluster_id, proc_id);
+	}
+	if( ad && IsJobQueueIndexAttr(attr_name) ) {
+		NoteJobQueueIndexChange(cluster_id, proc_id);
+	}
+	if( ad ) {
+		NoteJobCountChange(cluster_id, proc_id);
 	}
 
 	int old_nondurable_level = 0;
@@ -2630,6 +3516,11 @@ SendDirtyJobAdNotification(char *job_id_str)
 	shadow_rec *srec = scheduler.FindSrecByProcID(job_id);
 	if( srec ) {
 		pid = srec->pid;
+			// a shadow running more than one job needs to be told
+			// which one of them to update
+		if( scheduler.signalMultiJobShadow(pid, UPDATE_JOBAD, job_id) ) {
+			return true;
+		}
 	}
 	else {
 		pid = scheduler.FindGManagerPid(job_id);
@@ -2698,6 +3589,67 @@ HandleFlushJobQueueLogTimer()
 	JobQueue->FlushLog();
 }
 
+static void
+ScheduleJobQueueSync()
+{
+		// A zero delay lets the transactions committed by every other
+		// request handled in this pass of the event loop share the fsync.
+	if( job_queue_sync_timer_id == -1 ) {
+		job_queue_sync_timer_id = daemonCore->Register_Timer(
+			0,
+			HandleJobQueueSyncTimer,
+			"HandleJobQueueSyncTimer");
+	}
+}
+
+static void
+HandleJobQueueSyncTimer()
+{
+	job_queue_sync_timer_id = -1;
+
+	JobQueue->SyncLog();
+	NoteJobQueueSynced();
+
+	std::list<GroupedCommitWaiter> waiters;
+	waiters.swap( grouped_commit_waiters );
+
+	while( !waiters.empty() ) {
+		GroupedCommitWaiter waiter = waiters.front();
+		waiters.pop_front();
+
+		if( waiter.seq > JobQueue->SyncedCommitSequence() ) {
+				// committed by one of the connections resumed below
+			grouped_commit_waiters.push_back( waiter );
+			ScheduleJobQueueSync();
+			continue;
+		}
+		scheduler.JobQueueCommitDurable( (UtcTime::getTimeDouble() - waiter.commit_time) * 1000 );
+
+		if( !setQmgmtConnectionInfo( waiter.peer ) ) {
+			EXCEPT( "HandleJobQueueSyncTimer: a qmgmt connection is already active" );
+		}
+
+			// the reply do_Q_request() held back for CONDOR_CommitTransaction
+		ReliSock *sock = Q_SOCK->getReliSock();
+		int rval = 0;
+		sock->encode();
+		if( !sock->code(rval) || !sock->end_of_message() ) {
+			dprintf( D_ALWAYS, "Failed to send commit reply to %s\n",
+					 sock->peer_description() );
+			unsetQSock();
+			delete sock;
+			continue;
+		}
+
+			// Carry on with the connection.  handle_q() returned
+			// KEEP_STREAM for it, so if it is done now, it is up to
+			// us to get rid of the socket.
+		if( handle_q_requests() != KEEP_STREAM ) {
+			delete sock;
+		}
+	}
+}
+
 int
 SetTimerAttribute( int cluster, int proc, const char *attr_name, int dur )
 {
@@ -2917,9 +3869,42 @@ BeginTransaction()
 }
 
 
+static bool DoCommitTransaction(SetAttributeFlags_t flags, bool may_group);
+
 void
 CommitTransaction(SetAttributeFlags_t flags /* = 0 */)
 {
+	DoCommitTransaction( flags, false );
+}
+
+/* Like CommitTransaction(), but if SCHEDD_JOB_QUEUE_GROUP_COMMIT is
+   enabled, a durable transaction is only written to the job queue log;
+   the fsync is shared with other transactions committed in the same
+   pass through the DaemonCore event loop.  Returns true if the
+   transaction is not yet durable, in which case the caller must not
+   tell anyone it has been committed until HandleJobQueueSyncTimer()
+   says so.
+*/
+bool
+CommitTransactionGrouped(SetAttributeFlags_t flags)
+{
+	return DoCommitTransaction( flags, true );
+}
+
+static void
+NoteJobQueueSynced()
+{
+	unsigned long synced = JobQueue->SyncedCommitSequence();
+	if( synced != job_queue_synced_seq_seen ) {
+		scheduler.JobQueueSynced( (int)(synced - job_queue_synced_seq_seen) );
+		job_queue_synced_seq_seen = synced;
+	}
+}
+
+static bool
+DoCommitTransaction(SetAttributeFlags_t flags, bool may_group)
+{
+	bool sync_deferred = false;
 	std::list<std::string> new_ad_keys;
 		// get a list of all new ads being created in this transaction
 	JobQueue->ListNewAdsInTransaction( new_ad_keys );
@@ -2928,12 +3913,33 @@ CommitTransaction(SetAttributeFlags_t flags /* = 0 */)
 		JobQueue->CommitNondurableTransaction();
 		ScheduleJobQueueLogFlush();
 	}
+	else if( may_group && job_queue_group_commit ) {
+		double commit_start = UtcTime::getTimeDouble();
+		job_queue_grouped_commit_seq = JobQueue->CommitGroupedTransaction();
+		if( JobQueue->PendingSyncTransactions() >= job_queue_group_commit_max_transactions ||
+			JobQueue->PendingSyncBytes() >= job_queue_group_commit_max_bytes )
+		{
+			JobQueue->SyncLog();
+			NoteJobQueueSynced();
+		}
+		if( JobQueue->SyncedCommitSequence() < job_queue_grouped_commit_seq ) {
+			sync_deferred = true;
+			ScheduleJobQueueSync();
+		}
+		else {
+			scheduler.JobQueueCommitDurable( (UtcTime::getTimeDouble() - commit_start) * 1000 );
+		}
+	}
 	else {
 		JobQueue->CommitTransaction();
 	}
 
 	// If the commit failed, we should never get here.
 
+	CommitPrioRecChanges();
+	CommitJobQueueIndexChanges();
+	CommitJobCountChanges();
+
 	// Now that the transaction has been commited, we need to chain proc
 	// ads to cluster ads if any new clusters have been submitted.
 	// Also, if EVENT_LOG is defined in condor_config, we will write
@@ -2955,8 +3961,19 @@ CommitTransaction(SetAttributeFlags_t flags /* = 0 */)
 			// do we want to fsync the userLog?
 			bool doFsync = false;
 			if( proc_id == -1 ) {
+					// a new cluster may come with procs for us to
+					// materialize
+				if( JobQueue->LookupClassAd(key,clusterad) &&
+					clusterad->LookupExpr(ATTR_JOB_MATERIALIZE_LIMIT) )
+				{
+					JobFactories[cluster_id] = 0;
+					ScheduleMaterializeJobs(0);
+				}
 				continue; // skip over cluster ads
 			}
+			NotePrioRecChange(cluster_id, proc_id);
+			NoteJobQueueIndexChange(cluster_id, proc_id);
+			NoteJobCountChange(cluster_id, proc_id);
 			// we want to fsync per cluster and on the last ad
 			if ( old_cluster_id == -10 ) {
 				old_cluster_id = cluster_id;
@@ -3040,17 +4057,25 @@ CommitTransaction(SetAttributeFlags_t flags /* = 0 */)
 	}	// end of if a new cluster(s) submitted
 
 	xact_start_time = 0;
+
+	return sync_deferred;
 }
 
 int
 AbortTransaction()
 {
+	AbortPrioRecChanges();
+	AbortJobQueueIndexChanges();
+	AbortJobCountChanges();
 	return JobQueue->AbortTransaction();
 }
 
 void
 AbortTransactionAndRecomputeClusters()
 {
+	AbortPrioRecChanges();
+	AbortJobQueueIndexChanges();
+	AbortJobCountChanges();
 	if ( JobQueue->AbortTransaction() ) {
 		/*	If we made it here, a transaction did exist that was not
 			committed, and we now aborted it.  This would happen if 
@@ -3350,6 +4375,16 @@ DeleteAttribute(int cluster_id, int proc_id, const char *attr_name)
 //	JobQueue->AppendLog(log);
 	JobQueue->DeleteAttribute(key, attr_name);
 
+	if( ad && IsPrioRecAttr(attr_name) ) {
+		NotePrioRecChange(cluster_id, proc_id);
+	}
+	if( ad && IsJobQueueIndexAttr(attr_name) ) {
+		NoteJobQueueIndexChange(cluster_id, proc_id);
+	}
+	if( ad ) {
+		NoteJobCountChange(cluster_id, proc_id);
+	}
+
 	JobQueueDirty = true;
 
 	return 1;
@@ -4237,6 +5272,12 @@ GetNextJob(int initScan)
 }
 
 
+	// Jobs still to be visited by GetNextJobByConstraint(), when the
+	// constraint could be narrowed down with the job queue index.
+static std::vector<PROC_ID> IndexedScanJobs;
+static size_t IndexedScanPos = 0;
+static bool IndexedScanActive = false;
+
 ClassAd *
 GetNextJobByConstraint(const char *constraint, int initScan)
 {
@@ -4244,7 +5285,30 @@ GetNextJobByConstraint(const char *constraint, int initScan)
 	HashKey key;
 
 	if (initScan) {
-		JobQueue->StartIterateAllClassAds();
+		IndexedScanActive = false;
+		if (constraint && constraint[0]) {
+			classad::ExprTree *tree = NULL;
+			if (ParseClassAdRvalExpr(constraint, tree) == 0) {
+				IndexedScanActive = JobQueueIndexCandidates(tree, IndexedScanJobs);
+				IndexedScanPos = 0;
+			}
+			delete tree;
+		}
+		if (!IndexedScanActive) {
+			JobQueue->StartIterateAllClassAds();
+		}
+	}
+
+	if (IndexedScanActive) {
+		char job_key[PROC_ID_STR_BUFLEN];
+		while (IndexedScanPos < IndexedScanJobs.size()) {
+			PROC_ID const &id = IndexedScanJobs[IndexedScanPos++];
+			IdToStr(id.cluster, id.proc, job_key);
+			if (JobQueue->LookupClassAd(job_key, ad) && EvalBool(ad, constraint)) {
+				return ad;
+			}
+		}
+		return NULL;
 	}
 
 	while(JobQueue->IterateAllClassAds(ad,key)) {
@@ -4498,10 +5562,10 @@ PrintQ()
 }
 
 
-// Returns cur_hosts so that another function in the scheduler can
-// update JobsRunning and keep the scheduler and queue manager
-// seperate. 
-int get_job_prio(ClassAd *job)
+// Fill in rec for the given job.  Returns true if the job is runnable
+// and so belongs in PrioRecs.  cur_hosts is set either way.
+static bool
+make_prio_rec(ClassAd *job, prio_rec &rec, int &cur_hosts)
 {
     int     job_prio, 
             pre_job_prio1, 
@@ -4513,7 +5577,6 @@ int get_job_prio(ClassAd *job)
     int     q_date;
     char    buf[100];
     char    owner[100];
-    int     cur_hosts;
     int     max_hosts;
     int     niceUser;
     int     universe;
@@ -4549,7 +5612,7 @@ int get_job_prio(ClassAd *job)
 			job_status==REMOVED || job_status==COMPLETED ||
 			!service_this_universe(universe,job)) 
 	{
-        return cur_hosts;
+        return false;
 	}
 
 	// --- Insert this job into the PrioRec array ---
@@ -4592,29 +5655,38 @@ int get_job_prio(ClassAd *job)
     // No longer judge whether or not a job can run by looking at its status.
     // Rather look at if it has all the hosts that it wanted.
     if (cur_hosts>=max_hosts || job_status==HELD)
-        return cur_hosts;
+        return false;
 	     
-    PrioRec[N_PrioRecs].id             = id;
-    PrioRec[N_PrioRecs].job_prio       = job_prio;
-    PrioRec[N_PrioRecs].pre_job_prio1  = pre_job_prio1;
-    PrioRec[N_PrioRecs].pre_job_prio2  = pre_job_prio2;
-    PrioRec[N_PrioRecs].post_job_prio1 = post_job_prio1;
-    PrioRec[N_PrioRecs].post_job_prio2 = post_job_prio2;
-    PrioRec[N_PrioRecs].status         = job_status;
-    PrioRec[N_PrioRecs].qdate          = q_date;
+    rec.id             = id;
+    rec.job_prio       = job_prio;
+    rec.pre_job_prio1  = pre_job_prio1;
+    rec.pre_job_prio2  = pre_job_prio2;
+    rec.post_job_prio1 = post_job_prio1;
+    rec.post_job_prio2 = post_job_prio2;
+    rec.status         = job_status;
+    rec.qdate          = q_date;
 	if ( auto_id == -1 ) {
-		PrioRec[N_PrioRecs].auto_cluster_id = id.cluster;
+		rec.auto_cluster_id = id.cluster;
 	} else {
-		PrioRec[N_PrioRecs].auto_cluster_id = auto_id;
+		rec.auto_cluster_id = auto_id;
 	}
 
-	strcpy(PrioRec[N_PrioRecs].owner,owner);
+	strcpy(rec.owner,owner);
 
-    N_PrioRecs += 1;
-	if ( N_PrioRecs == MAX_PRIO_REC ) {
-		grow_prio_recs( 2 * N_PrioRecs );
-	}
+	return true;
+}
 
+// Returns cur_hosts so that another function in the scheduler can
+// update JobsRunning and keep the scheduler and queue manager
+// seperate. 
+int get_job_prio(ClassAd *job)
+{
+	prio_rec rec;
+	int cur_hosts = 0;
+
+	if ( make_prio_rec( job, rec, cur_hosts ) ) {
+		PrioRecs.Update( rec );
+	}
 	return cur_hosts;
 }
 
@@ -4803,42 +5875,72 @@ void mark_jobs_idle()
 }
 
 void DirtyPrioRecArray() {
-		// Mark the PrioRecArray as stale. This will trigger a rebuild,
-		// though possibly not immediately.
+		// Mark the whole PrioRecArray as stale. This will trigger a
+		// full rebuild, though possibly not immediately.  Changes to
+		// individual jobs don't need this; see NotePrioRecChange().
 	PrioRecArrayIsDirty = true;
 }
 
 // runtime stats for count & time spent building the priorec array
 //
-typedef _condor_auto_save_runtime< stats_entry_probe<double> > condor_auto_runtime;
+typedef _condor_auto_save_runtime< stats_entry_probe<double> > condor_auto_runtime;
 stats_entry_probe<double> build_priorec_runtime;
 stats_entry_probe<double> build_priorec_mark_runtime;
 stats_entry_probe<double> build_priorec_walk_runtime;
-stats_entry_probe<double> build_priorec_sort_runtime;
+stats_entry_probe<double> build_priorec_update_runtime;
 stats_entry_probe<double> build_priorec_sweep_runtime;
 
+/*
+ * Bring the PrioRecs entries of jobs that changed since we last
+ * looked up to date.  This costs time in proportion to the number of
+ * changed jobs, not the size of the queue.
+ */
+static void UpdateChangedPrioRecs() {
+	if( PrioRecChangedJobs.getNumElements() == 0 ) {
+		return;
+	}
+
+	condor_auto_runtime rt(build_priorec_update_runtime);
+	int num_changed = PrioRecChangedJobs.getNumElements();
+
+	PROC_ID id;
+	int junk;
+	PrioRecChangedJobs.startIterations();
+	while( PrioRecChangedJobs.iterate( id, junk ) ) {
+		char key[PROC_ID_STR_BUFLEN];
+		ClassAd *ad = NULL;
+		prio_rec rec;
+		int cur_hosts = 0;
+
+		IdToStr( id.cluster, id.proc, key );
+		if( JobQueue->LookupClassAd( key, ad ) &&
+			make_prio_rec( ad, rec, cur_hosts ) )
+		{
+			PrioRecs.Update( rec );
+		}
+		else {
+			PrioRecs.Remove( id );
+		}
+	}
+	PrioRecChangedJobs.clear();
+
+	dprintf(D_FULLDEBUG,
+			"Updated prioritized runnable job list for %d changed jobs "
+			"in %.3fs.\n", num_changed, UtcTime::getTimeDouble() - rt.begin);
+}
+
 static void DoBuildPrioRecArray() {
 	condor_auto_runtime rt(build_priorec_runtime);
 	double now = rt.begin;
 	scheduler.autocluster.mark();
 	build_priorec_mark_runtime += rt.tick(now);
 
-	N_PrioRecs = 0;
+		// the walk below looks at every job, changed or not
+	PrioRecChangedJobs.clear();
+	PrioRecs.Clear();
 	WalkJobQueue( get_job_prio );
 	build_priorec_walk_runtime += rt.tick(now);
 
-		// N_PrioRecs might be 0, if we have no jobs to run at the
-		// moment.  If so, we don't want to call qsort(), since that's
-		// bad.  We can still try to find the owner in the Owners
-		// array, since that's not that expensive, and we need it for
-		// all the flocking logic at the end of this function.
-		// Discovered by Derek Wright and insure-- on 2/28/01
-	if( N_PrioRecs ) {
-		qsort( (char *)PrioRec, N_PrioRecs, sizeof(PrioRec[0]),
-			   (int(*)(const void*, const void*))prio_compar );
-		build_priorec_sort_runtime += rt.tick(now);
-	}
-
 	scheduler.autocluster.sweep();
 	build_priorec_sweep_runtime += rt.tick(now);
 
@@ -4848,15 +5950,18 @@ static void DoBuildPrioRecArray() {
 }
 
 /*
- * Build an array of runnable jobs sorted by priority.  If there are
- * a lot of jobs in the queue, this can be expensive, so avoid building
- * the array too often.
+ * Bring PrioRecs, the runnable jobs sorted by priority, up to date.
+ * Jobs that changed since the last call are updated individually.
+ * A full rebuild walks the whole queue, which can be expensive if
+ * there are a lot of jobs, so it is only done when something other
+ * than a single job changed (see DirtyPrioRecArray()), or periodically
+ * so that unused autoclusters get garbage collected, and not too often.
  * Arguments:
  *   no_match_found - caller can't find a runnable job matching
  *                    the requirements of an available startd, so
  *                    consider rebuilding the list sooner
  * Returns:
- *   true if the array was rebuilt; false otherwise
+ *   true if the array was fully rebuilt; false otherwise
  */
 bool BuildPrioRecArray(bool no_match_found /*default false*/) {
 
@@ -4877,10 +5982,17 @@ bool BuildPrioRecArray(bool no_match_found /*default false*/) {
 		PrioRecAutoClusterRejected->clear();
 	}
 
-	if( !PrioRecArrayIsDirty ) {
+	if( !PrioRecArrayIsDirty &&
+		time(NULL) - PrioRecLastRebuild >= PrioRecRebuildMaxInterval )
+	{
 		dprintf(D_FULLDEBUG,
-				"Reusing prioritized runnable job list because nothing has "
-				"changed.\n");
+				"Prioritized runnable job list will be rebuilt to garbage "
+				"collect autoclusters.\n");
+		DirtyPrioRecArray();
+	}
+
+	if( !PrioRecArrayIsDirty ) {
+		UpdateChangedPrioRecs();
 		return false;
 	}
 
@@ -4900,11 +6012,13 @@ bool BuildPrioRecArray(bool no_match_found /*default false*/) {
 		dprintf(D_FULLDEBUG,
 				"Reusing prioritized runnable job list to save time.\n");
 
+		UpdateChangedPrioRecs();
 		return false;
 	}
 
 	PrioRecArrayTimeslice.setStartTimeNow();
 	PrioRecArrayIsDirty = false;
+	PrioRecLastRebuild = time(NULL);
 
 	DoBuildPrioRecArray();
 
@@ -4941,7 +6055,6 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 
 	MyString owner = user;
 	int at_sign_pos;
-	int i;
 
 		// We have been passed user, which is owner@uid.  We want just
 		// owner, place a NULL at the '@'.
@@ -4953,24 +6066,23 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 
 	bool rebuilt_prio_rec_array = BuildPrioRecArray();
 
-		// Iterate through the most recently constructed list of
-		// jobs, nicely pre-sorted in priority order.
+		// Iterate through the runnable jobs of this user (or of
+		// everyone), nicely pre-sorted in priority order.
 
 	do {
-		for (i=0; i < N_PrioRecs; i++) {
-
-			if ( PrioRec[i].owner[0] == '\0' ) {
-					// This record has been disabled, because it is no longer
-					// runnable.
-				continue;
+		PrioRecIndex::Queue const *candidates = &PrioRecs.All();
+		if ( !match_any_user ) {
+			candidates = PrioRecs.ForOwner( owner.Value() );
+			if ( !candidates ) {
+				break;
 			}
+		}
 
-			if ( !match_any_user && strcmp(PrioRec[i].owner,owner.Value()) != 0 ) {
-					// Owner doesn't match.
-				continue;
-			}
+		PrioRecIndex::Queue::const_iterator it;
+		for (it = candidates->begin(); it != candidates->end(); it++) {
+			prio_rec *rec = *it;
 
-			ad = GetJobAd( PrioRec[i].id.cluster, PrioRec[i].id.proc );
+			ad = GetJobAd( rec->id.cluster, rec->id.proc );
 			if (!ad) {
 					// This ad must have been deleted since we last built
 					// runnable job list.
@@ -4978,33 +6090,27 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 			}	
 
 			int junk; // don't care about the value
-			if ( PrioRecAutoClusterRejected->lookup( PrioRec[i].auto_cluster_id, junk ) == 0 ) {
+			if ( PrioRecAutoClusterRejected->lookup( rec->auto_cluster_id, junk ) == 0 ) {
 					// We have already failed to match a job from this same
 					// autocluster with this machine.  Skip it.
 				continue;
 			}
 
-			int isRunnable = Runnable(&PrioRec[i].id);
-			int isMatched = scheduler.AlreadyMatched(&PrioRec[i].id);
+			int isRunnable = Runnable(&rec->id);
+			int isMatched = scheduler.AlreadyMatched(&rec->id);
 			if( !isRunnable || isMatched ) {
 					// This job's status must have changed since the
 					// time it was added to the runnable job list.
-					// Prevent this job from being considered in any
-					// future iterations through the list.
-				PrioRec[i].owner[0] = '\0';
+					// A job that is no longer runnable gets dropped
+					// from the list the next time it is updated; one
+					// that is already matched stays, since it will
+					// be runnable again if the match goes away.
+				if( !isRunnable ) {
+					NotePrioRecChange( rec->id.cluster, rec->id.proc );
+				}
 				dprintf(D_FULLDEBUG,
-						"record for job %d.%d skipped until PrioRec rebuild (%s)\n",
-						jobid.cluster, jobid.proc, isRunnable ? "already matched" : "no longer runnable");
-
-					// Ensure that PrioRecArray is rebuilt
-					// eventually, because changes in the status
-					// of AlreadyMatched() can happen without
-					// changes to the status of the job, (not the
-					// normal case, but still possible) so the
-					// dirty flag may not get set when the job
-					// is no longer AlreadyMatched() unless we
-					// set it here and keep rebuilding the array.
-				DirtyPrioRecArray();
+						"record for job %d.%d skipped (%s)\n",
+						rec->id.cluster, rec->id.proc, isRunnable ? "already matched" : "no longer runnable");
 
 					// Move along to the next job in the prio rec array
 				continue;
@@ -5019,7 +6125,7 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 					// THIS IS A DANGEROUS ASSUMPTION - what if this job is no longer
 					// part of this autocluster?  TODO perhaps we should verify this
 					// job is still part of this autocluster here.
-				PrioRecAutoClusterRejected->insert( PrioRec[i].auto_cluster_id, 1 );
+				PrioRecAutoClusterRejected->insert( rec->auto_cluster_id, 1 );
 					// Move along to the next job in the prio rec array
 				continue;
 			}
@@ -5072,12 +6178,12 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 							"ConcurrencyLimits do not match, cannot "
 							"reuse claim\n");
 					PrioRecAutoClusterRejected->
-						insert(PrioRec[i].auto_cluster_id, 1);
+						insert(rec->auto_cluster_id, 1);
 					continue;
 				}
 			}
 
-			jobid = PrioRec[i].id; // success!
+			jobid = rec->id; // success!
 			return;
 
 		}	// end of for loop through PrioRec array
@@ -5163,47 +6269,18 @@ int Runnable(PROC_ID* id)
 	return Runnable(jobad);
 }
 
-// From the priority records, find the runnable job with the highest priority
-// use the function prio_compar. By runnable I mean that its status is IDLE.
+// From the priority records, find the runnable job with the highest priority.
+// By runnable I mean that its status is IDLE.
 void FindPrioJob(PROC_ID & job_id)
 {
-	int			i;								// iterator over all prio rec
-	int			flag = FALSE;
-
-	// Compare each job in the priority record list with the first job in the
-	// list. If the first job is of lower priority, replace the first job with
-	// the job it is compared against.
-	if(!Runnable(&PrioRec[0].id))
-	{
-		for(i = 1; i < N_PrioRecs; i++)
-		{
-			if(Runnable(&PrioRec[i].id))
-			{
-				PrioRec[0] = PrioRec[i];
-				flag = TRUE;
-				break;
-			}
-		}
-		if(!flag)
-		{
-			job_id.proc = -1;
+	PrioRecIndex::Queue::const_iterator it;
+	for( it = PrioRecs.All().begin(); it != PrioRecs.All().end(); it++ ) {
+		if( Runnable(&(*it)->id) ) {
+			job_id = (*it)->id;
 			return;
 		}
 	}
-	for(i = 1; i < N_PrioRecs; i++)
-	{
-		if( (PrioRec[0].id.proc == PrioRec[i].id.proc) &&
-			(PrioRec[0].id.cluster == PrioRec[i].id.cluster) )
-		{
-			continue;
-		}
-		if(prio_compar(&PrioRec[0], &PrioRec[i])!=-1&&Runnable(&PrioRec[i].id))
-		{
-			PrioRec[0] = PrioRec[i];
-		}
-	}
-	job_id.proc = PrioRec[0].id.proc;
-	job_id.cluster = PrioRec[0].id.cluster;
+	job_id.proc = -1;
 }
 
 void
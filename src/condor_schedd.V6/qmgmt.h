@@ -26,6 +26,8 @@
 #include "prio_rec.h"
 #include "condor_sockaddr.h"
 #include "classad_log.h"
+#include <set>
+#include <vector>
 
 
 void PrintQ();
@@ -83,6 +85,7 @@ void SetMaxHistoricalLogs(int max_historical_logs);
 time_t GetOriginalJobQueueBirthdate();
 void DestroyJobQueue( void );
 int handle_q(Service *, int, Stream *sock);
+int handle_update_job_attrs(Service *, int, Stream *sock);
 void dirtyJobQueue( void );
 bool SendDirtyJobAdNotification(char *job_id_str);
 
@@ -100,6 +103,12 @@ bool OwnerCheck2( ClassAd *ad, const char *test_owner, char const *job_owner=NUL
 
 bool BuildPrioRecArray(bool no_match_found=false);
 void DirtyPrioRecArray();
+// Hand over the jobs and clusters changed since the last call, for
+// keeping the schedd's job counts up to date.
+void TakeJobCountChanges( std::vector<PROC_ID> &jobs, std::set<int> &clusters );
+// Stop materializing procs of the clusters whose cluster ad matches
+// the constraint, as when the whole cluster is removed.
+void StopJobFactoriesByConstraint(const char *constraint);
 extern ClassAd *dollarDollarExpand(int cid, int pid, ClassAd *job, ClassAd *res, bool persist_expansions);
 bool rewriteSpooledJobAd(ClassAd *job_ad, int cluster, int proc, bool modify_ad);
 ClassAd* GetJobAd(int cluster_id, int proc_id, bool expStartdAd, bool persist_expansions);
@@ -114,10 +123,8 @@ QmgmtPeer* getQmgmtConnectionInfo();
 bool OwnerCheck(int,int);
 
 // priority records
-extern prio_rec *PrioRec;
-extern int N_PrioRecs;
+extern PrioRecIndex PrioRecs;
 extern HashTable<int,int> *PrioRecAutoClusterRejected;
-extern int grow_prio_recs(int);
 
 extern void	FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad, char const * user);
 extern int Runnable(PROC_ID*);
@@ -44,6 +44,8 @@ extern char *CondorCertDir;
 
 extern int active_cluster_num;
 
+extern bool CommitTransactionGrouped(SetAttributeFlags_t flags);
+
 static bool QmgmtMayAccessAttribute( char const *attr_name ) {
 	return !ClassAdAttributeIsPrivate( attr_name );
 }
@@ -504,11 +506,18 @@ do_Q_request(ReliSock *syscall_sock,bool &may_fork)
 		assert( syscall_sock->end_of_message() );;
 
 		errno = 0;
-		CommitTransaction( flags );
+		bool sync_deferred = CommitTransactionGrouped( flags );
 			// CommitTransaction() never returns on failure
 		rval = 0;
 		terrno = errno;
-		dprintf( D_SYSCALLS, "\tflags = %d, rval = %d, errno = %d\n", flags, rval, terrno );
+		dprintf( D_SYSCALLS, "\tflags = %d, rval = %d, errno = %d%s\n", flags, rval, terrno,
+				 sync_deferred ? ", reply deferred until on disk" : "" );
+
+		if( sync_deferred ) {
+				// handle_q() sends the reply once the transaction
+				// has been fsynced along with others
+			return 1;
+		}
 
 		syscall_sock->encode();
 		assert( syscall_sock->code(rval) );
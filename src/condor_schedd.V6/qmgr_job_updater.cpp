@@ -272,17 +272,16 @@ QmgrJobUpdater::updateAttr( const char *name, const char *expr, bool updateMaste
 	if (log) {
 		flags = SHOULDLOG;
 	}
-	if( ConnectQ(schedd_addr,SHADOW_QMGMT_TIMEOUT,false,NULL,m_owner.Value(),schedd_ver) ) {
-		if( SetAttribute(cluster,p,name,expr,flags) < 0 ) {
-			err_msg = "SetAttribute() failed";
-			result = FALSE;
-		} else {
-			result = TRUE;
-		}
-		DisconnectQ( NULL );
-	} else {
-		err_msg = "ConnectQ() failed";
+	ClassAd updates;
+	ClassAd pulled;
+	if( ! updates.AssignExpr(name, expr) ) {
+		err_msg = "invalid expression";
 		result = FALSE;
+	} else if( ! sendUpdates(p, updates, NULL, flags, 0, pulled) ) {
+		err_msg = "update failed";
+		result = FALSE;
+	} else {
+		result = TRUE;
 	}
 
 	if( result == FALSE ) {
@@ -306,10 +305,7 @@ bool
 QmgrJobUpdater::updateJob( update_t type, SetAttributeFlags_t commit_flags )
 {
 	ExprTree* tree = NULL;
-	bool is_connected = false;
-	bool had_error = false;
 	const char* name;
-	char *value = NULL;
 	std::list< std::string > undirty_attrs;
 	
 	StringList* job_queue_attrs = NULL;
@@ -343,6 +339,7 @@ QmgrJobUpdater::updateJob( update_t type, SetAttributeFlags_t commit_flags )
 		EXCEPT( "QmgrJobUpdater::updateJob: Unknown update type (%d)!", type );
 	}
 
+	ClassAd updates;
 	job_ad->ResetExpr();
 	while( job_ad->NextDirtyExpr(name, tree) ) {
 		// There used to be a check for tree->invisible here,
@@ -359,46 +356,38 @@ QmgrJobUpdater::updateJob( update_t type, SetAttributeFlags_t commit_flags )
 			(job_queue_attrs &&
 			 job_queue_attrs->contains_anycase(name)) ) {
 
-			if( ! is_connected ) {
-				if( ! ConnectQ(schedd_addr, SHADOW_QMGMT_TIMEOUT, false, NULL, m_owner.Value(),schedd_ver) ) {
-					return false;
-				}
-				is_connected = true;
-			}
-			if( ! updateExprTree(name, tree) ) {
-				had_error = true;
-			}
+			ExprTree *copy = tree->Copy();
+			updates.Insert( name, copy );
 			undirty_attrs.push_back( name );
 		}
 	}
+
+	if( updates.size() == 0 && m_pull_attrs->isEmpty() ) {
+			// nothing to do
+		return true;
+	}
+
+		// All of it goes to the schedd at once and is applied in a
+		// single transaction.
+	ClassAd pulled;
+	char *pull_attrs = m_pull_attrs->print_to_string();
+	bool result = sendUpdates( proc, updates, pull_attrs, 0, commit_flags,
+							   pulled );
+	free( pull_attrs );
+	if( ! result ) {
+		return false;
+	}
+
 	m_pull_attrs->rewind();
 	while ( (name = m_pull_attrs->next()) ) {
-		if ( !is_connected ) {
-			if ( !ConnectQ( schedd_addr, SHADOW_QMGMT_TIMEOUT, true, NULL, NULL, schedd_ver ) ) {
-				return false;
-			}
-			is_connected = true;
-		}
-		if ( GetAttributeExprNew( cluster, proc, name, &value ) < 0 ) {
-			had_error = true;
-		} else {
-			job_ad->AssignExpr( name, value );
+		tree = pulled.LookupExpr( name );
+		if( tree ) {
+			ExprTree *copy = tree->Copy();
+			job_ad->Insert( name, copy );
 			undirty_attrs.push_back( name );
 		}
-		free( value );
-	}
-	if( is_connected ) {
-		if( !had_error) {
-			if( RemoteCommitTransaction(commit_flags)!=0 ) {
-				dprintf(D_ALWAYS,"Failed to commit job update.\n");
-				had_error = true;
-			}
-		}
-		DisconnectQ(NULL,false);
-	} 
-	if( had_error ) {
-		return false;
 	}
+
 	for(std::list< std::string >::iterator itr = undirty_attrs.begin();
 		itr != undirty_attrs.end();
 		++itr)
@@ -409,6 +398,205 @@ QmgrJobUpdater::updateJob( update_t type, SetAttributeFlags_t commit_flags )
 }
 
 
+	// The connection to the schedd that we send job updates on.  All
+	// the QmgrJobUpdaters in this process share it, since a shadow may
+	// be running more than one job.
+static ReliSock *update_channel = NULL;
+static std::string update_channel_addr;
+
+	// If the schedd wouldn't take updates this way (e.g. it is too
+	// old to know the command), don't try again until this time.
+static time_t update_channel_retry_time = 0;
+static const int UPDATE_CHANNEL_RETRY_DELAY = 300;
+
+static void
+closeUpdateChannel( void )
+{
+	delete update_channel;
+	update_channel = NULL;
+}
+
+
+bool
+QmgrJobUpdater::sendUpdates( int p, ClassAd &updates, char const *pull_attrs,
+							 SetAttributeFlags_t set_flags,
+							 SetAttributeFlags_t commit_flags, ClassAd &pulled )
+{
+	int rc = sendUpdatesOnChannel( p, updates, pull_attrs, set_flags,
+								   commit_flags, pulled );
+	if( rc >= 0 ) {
+		return rc == 1;
+	}
+	return sendUpdatesWithQmgmt( p, updates, pull_attrs, set_flags,
+								 commit_flags, pulled );
+}
+
+
+int
+QmgrJobUpdater::sendUpdatesOnChannel( int p, ClassAd &updates,
+									  char const *pull_attrs,
+									  SetAttributeFlags_t set_flags,
+									  SetAttributeFlags_t commit_flags,
+									  ClassAd &pulled )
+{
+	if( ! param_boolean("SHADOW_QUEUE_UPDATE_CHANNEL", true) ) {
+		closeUpdateChannel();
+		return -1;
+	}
+	if( update_channel && update_channel_addr != schedd_addr ) {
+		closeUpdateChannel();
+	}
+	if( ! update_channel && time(NULL) < update_channel_retry_time ) {
+		return -1;
+	}
+
+	for( int attempt = 0; attempt < 2; attempt++ ) {
+		bool is_new = false;
+		if( ! update_channel ) {
+				// this is the only time we pay for connecting and
+				// authenticating; the command int for later updates
+				// goes straight down the same socket
+			DCSchedd schedd( schedd_addr );
+			update_channel = (ReliSock *)schedd.startCommand(
+				UPDATE_JOB_ATTRS, Sock::reli_sock, SHADOW_QMGMT_TIMEOUT );
+			if( ! update_channel ) {
+				dprintf( D_ALWAYS, "QmgrJobUpdater: failed to send "
+						 "UPDATE_JOB_ATTRS to schedd %s, using qmgmt "
+						 "instead\n", schedd_addr );
+				update_channel_retry_time = time(NULL) +
+					UPDATE_CHANNEL_RETRY_DELAY;
+				return -1;
+			}
+			update_channel_addr = schedd_addr;
+			is_new = true;
+		}
+		else {
+			update_channel->encode();
+			if( ! update_channel->put(UPDATE_JOB_ATTRS) ) {
+				closeUpdateChannel();
+				continue;
+			}
+		}
+
+		int cluster_id = cluster;
+		int proc_id = p;
+		int set = set_flags;
+		int commit = commit_flags;
+		std::string owner = m_owner.Value();
+		std::string pull = pull_attrs ? pull_attrs : "";
+		int result = -1;
+
+		update_channel->encode();
+		if( update_channel->code(cluster_id) &&
+			update_channel->code(proc_id) &&
+			update_channel->code(set) &&
+			update_channel->code(commit) &&
+			update_channel->code(owner) &&
+			putClassAd(update_channel, updates) &&
+			update_channel->code(pull) &&
+			update_channel->end_of_message() )
+		{
+			update_channel->decode();
+			if( update_channel->code(result) &&
+				getClassAd(update_channel, pulled) &&
+				update_channel->end_of_message() )
+			{
+				if( result != 0 ) {
+					dprintf( D_ALWAYS, "QmgrJobUpdater: schedd failed "
+							 "to update job %d.%d\n", cluster, p );
+				}
+				return result == 0 ? 1 : 0;
+			}
+		}
+
+		closeUpdateChannel();
+		if( is_new ) {
+				// the schedd hung up on a brand new connection, so
+				// it probably doesn't know this command
+			dprintf( D_ALWAYS, "QmgrJobUpdater: schedd %s did not "
+					 "take UPDATE_JOB_ATTRS, using qmgmt instead\n",
+					 schedd_addr );
+			update_channel_retry_time = time(NULL) +
+				UPDATE_CHANNEL_RETRY_DELAY;
+			return -1;
+		}
+			// otherwise, the schedd probably closed the connection
+			// since our last update; try again with a new one
+		dprintf( D_FULLDEBUG, "QmgrJobUpdater: lost connection to "
+				 "schedd, reconnecting\n" );
+	}
+	return -1;
+}
+
+
+bool
+QmgrJobUpdater::sendUpdatesWithQmgmt( int p, ClassAd &updates,
+									  char const *pull_attrs,
+									  SetAttributeFlags_t set_flags,
+									  SetAttributeFlags_t commit_flags,
+									  ClassAd &pulled )
+{
+	bool had_error = false;
+	bool read_only = (updates.size() == 0);
+
+	if( ! ConnectQ(schedd_addr, SHADOW_QMGMT_TIMEOUT, read_only, NULL,
+				   read_only ? NULL : m_owner.Value(), schedd_ver) )
+	{
+		return false;
+	}
+
+	classad::ClassAdUnParser unparser;
+	unparser.SetOldClassAd( true );
+	for( classad::ClassAd::iterator itr = updates.begin();
+		 itr != updates.end();
+		 itr++ )
+	{
+		std::string value;
+		unparser.Unparse( value, itr->second );
+
+			// We use SetAttribute_NoAck to improve performance, since this
+			// avoids a lot of round-trips between the schedd and shadow.
+			// This means we may not detect failure until CommitTransaction()
+			// or the next call to SetAttribute().
+		if( SetAttribute(cluster, p, itr->first.c_str(), value.c_str(),
+						 set_flags | SetAttribute_NoAck) < 0 )
+		{
+			dprintf( D_ALWAYS, 
+					 "updateJob: Failed SetAttribute(%s, %s)\n",
+					 itr->first.c_str(), value.c_str() );
+			had_error = true;
+			break;
+		}
+		dprintf( D_FULLDEBUG, 
+				 "Updating Job Queue: SetAttribute(%s = %s)\n",
+				 itr->first.c_str(), value.c_str() );
+	}
+
+	StringList pull_list( pull_attrs );
+	char const *name;
+	pull_list.rewind();
+	while( ! had_error && (name = pull_list.next()) ) {
+		char *value = NULL;
+		if ( GetAttributeExprNew( cluster, p, name, &value ) < 0 ) {
+			had_error = true;
+		} else {
+			pulled.AssignExpr( name, value );
+		}
+		free( value );
+	}
+
+	if( !had_error && !read_only ) {
+		if( RemoteCommitTransaction(commit_flags)!=0 ) {
+			dprintf(D_ALWAYS,"Failed to commit job update.\n");
+			had_error = true;
+		}
+	}
+	DisconnectQ(NULL,false);
+
+	return !had_error;
+}
+
+
 bool
 QmgrJobUpdater::retrieveJobUpdates( void )
 {
@@ -450,51 +638,6 @@ QmgrJobUpdater::periodicUpdateQ( void )
 	updateJob( U_PERIODIC, NONDURABLE );
 }
 
-bool
-QmgrJobUpdater::updateExprTree( const char *name, ExprTree* tree )
-{
-	if( ! tree ) {
-		dprintf( D_ALWAYS, "QmgrJobUpdater::updateExprTree: tree is NULL!\n" );
-		return false;
-	}
-	if( ! name ) {
-		dprintf( D_ALWAYS,
-				 "QmgrJobUpdater::updateExprTree: can't find name!\n" );
-		return false;
-	}		
-	const char* value = ExprTreeToString( tree );
-	if( ! value ) {
-		dprintf( D_ALWAYS,
-				 "QmgrJobUpdater::updateExprTree: can't find value!\n" );
-		return false;
-	}		
-		// This code used to be smart about figuring out what type of
-		// expression this is and calling SetAttributeInt(), 
-		// SetAttributeString(), or whatever it needed.  However, all
-		// these "special" versions of SetAttribute*() just force
-		// everything back down into the flat string representation
-		// and call SetAttribute(), so it was both a waste of effort
-		// here, and made this code needlessly more complex.  
-		// Derek Wright, 3/25/02
-
-		// We use SetAttribute_NoAck to improve performance, since this
-		// avoids a lot of round-trips between the schedd and shadow.
-		// This means we may not detect failure until CommitTransaction()
-		// or the next call to SetAttribute().
-	if( SetAttribute(cluster, proc, name, value, SetAttribute_NoAck) < 0 ) {
-		dprintf( D_ALWAYS, 
-				 "updateExprTree: Failed SetAttribute(%s, %s)\n",
-				 name, value );
-		return false;
-	}
-	dprintf( D_FULLDEBUG, 
-			 "Updating Job Queue: SetAttribute(%s = %s)\n",
-			 name, value );
-	return true;
-}
-
-
-
 bool
 QmgrJobUpdater::watchAttribute( const char* attr, update_t type  )
 {
@@ -70,7 +70,7 @@ public:
 
 		/** Connect to the job queue and update one attribute.
 			WARNING: This method is BAD NEWS for schedd scalability.
-			We make a whole new qmgmt connection for *every* attribute
+			We send a whole update to the schedd for *every* attribute
 			we update.  Worse yet, we use this method to service a
 			pseudo syscall from the user job (pseudo_set_job_attr), so
 			the schedd can be held hostage by user-jobs that call this
@@ -112,15 +112,36 @@ private:
 	void periodicUpdateQ( void );
 
 
-		/** Update a specific attribute from our job ad into the
-			queue.  This checks the type of the given ExprTree and
-			calls the appropriate SetAttribute* function to do the
-			work.  This function assumes you're in the middle of a
-			qmgmt operation, i.e., that you've called ConnectQ().
-			@param The ExprTree you want to update in the job queue 
-			@return success or failure to set the attribute
+		/** Set the given attributes of a job in the job queue in a
+			single transaction, and fetch the current values of the
+			attributes named in pull_attrs (a comma-separated list,
+			may be NULL) from the queue into pulled.  This uses the
+			connection we keep open to the schedd if we can, and a
+			new qmgmt connection if we can't.
+			@param p The proc of our cluster to update
+			@param set_flags flags to pass to SetAttribute()
+			@param commit_flags flags to pass to the commit
+			@return true on success, false on failure
 		 */
-	bool updateExprTree( const char *name, ExprTree* tree );
+	bool sendUpdates( int p, ClassAd &updates, char const *pull_attrs,
+					  SetAttributeFlags_t set_flags,
+					  SetAttributeFlags_t commit_flags, ClassAd &pulled );
+
+		/** Like sendUpdates(), using the UPDATE_JOB_ATTRS command on
+			the connection we keep open to the schedd.
+			@return 1 on success, 0 on failure, -1 if we couldn't
+			   use the connection and should use qmgmt instead
+		*/
+	int sendUpdatesOnChannel( int p, ClassAd &updates, char const *pull_attrs,
+							  SetAttributeFlags_t set_flags,
+							  SetAttributeFlags_t commit_flags,
+							  ClassAd &pulled );
+
+		/// Like sendUpdates(), using a new qmgmt connection.
+	bool sendUpdatesWithQmgmt( int p, ClassAd &updates, char const *pull_attrs,
+							   SetAttributeFlags_t set_flags,
+							   SetAttributeFlags_t commit_flags,
+							   ClassAd &pulled );
 
 		/// Pointers to lists of attribute names we care about
 
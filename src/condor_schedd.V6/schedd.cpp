@@ -149,11 +149,6 @@ extern DedicatedScheduler dedicated_scheduler;
 
 extern FILESQL *FILEObj;
 
-// priority records
-extern prio_rec *PrioRec;
-extern int N_PrioRecs;
-extern int grow_prio_recs(int);
-
 void cleanup_ckpt_files(int , int , char*);
 void send_vacate(match_rec*, int);
 void mark_job_stopped(PROC_ID*);
@@ -169,6 +164,7 @@ bool jobCleanupNeedsThread( int cluster, int proc );
 bool jobExternallyManaged(ClassAd * ad);
 bool jobManagedDone(ClassAd * ad);
 int  count_a_job( ClassAd *job );
+bool compute_job_counts( ClassAd *job, JobCountContribution &counts );
 static void WriteCompletionVisa(ClassAd* ad);
 
 
@@ -576,6 +572,10 @@ Scheduler::Scheduler() :
 	SchedUniverseJobsRunning = 0;
 	LocalUniverseJobsIdle = 0;
 	LocalUniverseJobsRunning = 0;
+	m_incremental_job_counts = false;
+	m_job_counts_valid = false;
+	m_job_count_check_interval = 0;
+	m_job_count_cycles = 0;
 	LocalUnivExecuteDir = NULL;
 	ReservedSwap = 0;
 	SwapSpace = 0;
@@ -613,6 +613,8 @@ Scheduler::Scheduler() :
 	matchesByJobID = NULL;
 	shadowsByPid = NULL;
 	spoolJobFileWorkers = NULL;
+	MaxJobsPerShadow = 1;
+	multiJobShadowIdleTid = -1;
 
 	shadowsByProcID = NULL;
 	resourcesByProcID = NULL;
@@ -1118,16 +1120,7 @@ Scheduler::count_jobs()
 	int Old_N_Owners=N_Owners;
 
 	N_Owners = 0;
-	JobsRunning = 0;
-	JobsIdle = 0;
-	JobsHeld = 0;
-	JobsTotalAds = 0;
 	JobsFlocked = 0;
-	JobsRemoved = 0;
-	SchedUniverseJobsIdle = 0;
-	SchedUniverseJobsRunning = 0;
-	LocalUniverseJobsIdle = 0;
-	LocalUniverseJobsRunning = 0;
 	stats.JobsRunning = 0;
 	stats.JobsRunningRuntimes = 0;
 	stats.JobsRunningSizes = 0;
@@ -1149,13 +1142,86 @@ Scheduler::count_jobs()
 		Owners[i].WeightedJobsIdle = 0;
 	}
 
-	GridJobOwners.clear();
+	update_job_counts();
+
+	JobsTotalAds = m_job_totals.JobsTotalAds;
+	JobsIdle = m_job_totals.JobsIdle;
+	JobsRunning = m_job_totals.JobsRunning;
+	JobsHeld = m_job_totals.JobsHeld;
+	JobsRemoved = m_job_totals.JobsRemoved;
+	SchedUniverseJobsIdle = m_job_totals.SchedUniverseJobsIdle;
+	SchedUniverseJobsRunning = m_job_totals.SchedUniverseJobsRunning;
+	LocalUniverseJobsIdle = m_job_totals.LocalUniverseJobsIdle;
+	LocalUniverseJobsRunning = m_job_totals.LocalUniverseJobsRunning;
+
+		// insert owners even if they only have REMOVED or HELD jobs,
+		// for condor_q -{global|sub}.
+		// Don't update Owners[].JobsRunning here; that is done below
+		// from the match records.
+	std::map<std::string,OwnerJobCounts>::const_iterator owner;
+	for( owner = m_job_totals.Owners.begin();
+		 owner != m_job_totals.Owners.end();
+		 owner++ )
+	{
+		int OwnerNum = insert_owner( owner->first.c_str() );
+		Owners[OwnerNum].JobsIdle = owner->second.JobsIdle;
+		Owners[OwnerNum].JobsHeld = owner->second.JobsHeld;
+		Owners[OwnerNum].WeightedJobsIdle = owner->second.WeightedJobsIdle;
+		std::map<int,int>::const_iterator prio;
+		for( prio = owner->second.Prios.begin();
+			 prio != owner->second.Prios.end();
+			 prio++ )
+		{
+			Owners[OwnerNum].PrioSet.insert( prio->first );
+		}
+	}
 
 		// Clear out the DedicatedScheduler's list of idle dedicated
 		// job cluster ids, since we're about to re-create it.
 	dedicated_scheduler.clearDedicatedClusters();
+	std::map<int,int>::const_iterator cluster;
+	for( cluster = m_job_totals.DedicatedClusters.begin();
+		 cluster != m_job_totals.DedicatedClusters.end();
+		 cluster++ )
+	{
+		dedicated_scheduler.addDedicatedCluster( cluster->first );
+	}
 
-	WalkJobQueue( count_a_job );
+		// update statistics for running jobs
+	std::set<PROC_ID,JobIdLess>::const_iterator running;
+	for( running = m_job_totals.RunningJobs.begin();
+		 running != m_job_totals.RunningJobs.end();
+		 running++ )
+	{
+		ClassAd *job = GetJobAd( running->cluster, running->proc );
+		if( !job ) {
+			continue;
+		}
+
+			// build a list of other stats pools that match this job
+		ScheddOtherStats * other_stats = NULL;
+		if (OtherPoolStats.AnyEnabled()) {
+			other_stats = OtherPoolStats.Matches(*job,current_time);
+		}
+		#define OTHER for (ScheddOtherStats * po = other_stats; po; po = po->next) (po->stats)
+
+		stats.JobsRunning += 1;
+		OTHER.JobsRunning += 1;
+
+		int job_image_size = 0;
+		job->LookupInteger("ImageSize_RAW", job_image_size);
+		stats.JobsRunningSizes += (int64_t)job_image_size * 1024;
+		OTHER.JobsRunningSizes += (int64_t)job_image_size * 1024;
+
+		int job_start_date = 0;
+		int job_running_time = 0;
+		if (job->LookupInteger(ATTR_JOB_START_DATE, job_start_date))
+			job_running_time = (current_time - job_start_date);
+		stats.JobsRunningRuntimes += job_running_time;
+		OTHER.JobsRunningRuntimes += job_running_time;
+
+		#undef OTHER
+	}
 
 	if( dedicated_scheduler.hasDedicatedClusters() ) {
 			// We found some dedicated clusters to service.  Wake up
@@ -1258,13 +1324,6 @@ Scheduler::count_jobs()
 	dprintf( D_FULLDEBUG, "N_Owners = %d\n", N_Owners );
 	dprintf( D_FULLDEBUG, "MaxJobsRunning = %d\n", MaxJobsRunning );
 
-	// later when we compute job priorities, we will need PrioRec
-	// to have as many elements as there are jobs in the queue.  since
-	// we just counted the jobs, lets make certain that PrioRec is 
-	// large enough.  this keeps us from guessing to small and constantly
-	// growing PrioRec... Add 5 just to be sure... :^) -Todd 8/97
-	grow_prio_recs( JobsRunning + JobsIdle + 5 );
-	
 	cad->Assign(ATTR_NUM_USERS, N_Owners);
 	cad->Assign(ATTR_MAX_JOBS_RUNNING, MaxJobsRunning);
 
@@ -1983,8 +2042,113 @@ clear_autocluster_id( ClassAd *job )
 	return 0;
 }
 
+JobCountContribution::JobCountContribution() :
+	Counted(false),
+	Owner(-1),
+	JobsIdle(0),
+	JobsRunning(0),
+	JobsHeld(0),
+	JobsRemoved(0),
+	WeightedJobsIdle(0),
+	HasPrio(false),
+	Prio(0),
+	SchedUniverseJobsIdle(0),
+	SchedUniverseJobsRunning(0),
+	LocalUniverseJobsIdle(0),
+	LocalUniverseJobsRunning(0),
+	DedicatedCluster(0),
+	IsRunning(false),
+	GridUser(NULL),
+	GridJobs(0),
+	UnmanagedGridJobs(0)
+{
+}
+
+JobCountContribution::JobCountContribution(const JobCountContribution & src) :
+	GridUser(NULL)
+{
+	*this = src;
+}
+
+JobCountContribution::~JobCountContribution()
+{
+	delete GridUser;
+}
+
+JobCountContribution &
+JobCountContribution::operator=(const JobCountContribution & src)
+{
+	if( this == &src ) {
+		return *this;
+	}
+	Counted = src.Counted;
+	Owner = src.Owner;
+	JobsIdle = src.JobsIdle;
+	JobsRunning = src.JobsRunning;
+	JobsHeld = src.JobsHeld;
+	JobsRemoved = src.JobsRemoved;
+	WeightedJobsIdle = src.WeightedJobsIdle;
+	HasPrio = src.HasPrio;
+	Prio = src.Prio;
+	SchedUniverseJobsIdle = src.SchedUniverseJobsIdle;
+	SchedUniverseJobsRunning = src.SchedUniverseJobsRunning;
+	LocalUniverseJobsIdle = src.LocalUniverseJobsIdle;
+	LocalUniverseJobsRunning = src.LocalUniverseJobsRunning;
+	DedicatedCluster = src.DedicatedCluster;
+	IsRunning = src.IsRunning;
+	delete GridUser;
+	GridUser = src.GridUser ? new UserIdentity( *src.GridUser ) : NULL;
+	GridJobs = src.GridJobs;
+	UnmanagedGridJobs = src.UnmanagedGridJobs;
+	return *this;
+}
+
+	// Turn a submitter name into the index that JobCountContribution
+	// stores instead of the name itself.
 int
-count_a_job( ClassAd *job )
+Scheduler::intern_job_count_owner( const char *owner )
+{
+	std::map<std::string,int>::iterator it = m_job_count_owner_ids.find( owner );
+	if( it != m_job_count_owner_ids.end() ) {
+		return it->second;
+	}
+	int id = (int)m_job_count_owners.size();
+	m_job_count_owners.push_back( owner );
+	m_job_count_owner_ids[owner] = id;
+	return id;
+}
+
+bool
+OwnerJobCounts::operator==(const OwnerJobCounts & rhs) const
+{
+	return Jobs == rhs.Jobs &&
+		JobsIdle == rhs.JobsIdle &&
+		JobsHeld == rhs.JobsHeld &&
+		WeightedJobsIdle == rhs.WeightedJobsIdle &&
+		Prios == rhs.Prios;
+}
+
+void
+JobCountTotals::clear()
+{
+	JobsTotalAds = 0;
+	JobsIdle = 0;
+	JobsRunning = 0;
+	JobsHeld = 0;
+	JobsRemoved = 0;
+	SchedUniverseJobsIdle = 0;
+	SchedUniverseJobsRunning = 0;
+	LocalUniverseJobsIdle = 0;
+	LocalUniverseJobsRunning = 0;
+	Owners.clear();
+	DedicatedClusters.clear();
+	RunningJobs.clear();
+}
+
+	// Work out what the given job adds to the job counts.  Returns
+	// false if the job is not counted at all.
+bool
+compute_job_counts( ClassAd *job, JobCountContribution &counts )
 {
 	int		status;
 	int		niceUser;
@@ -1996,17 +2160,10 @@ count_a_job( ClassAd *job )
 	int		max_hosts;
 	int		universe;
 
-		// we may get passed a NULL job ad if, for instance, the job ad was
-		// removed via condor_rm -f when some function didn't expect it.
-		// So check for it here before continuing onward...
-	if ( job == NULL ) {  
-		return 0;
-	}
-
 	if (job->LookupInteger(ATTR_JOB_STATUS, status) == 0) {
 		dprintf(D_ALWAYS, "Job has no %s attribute.  Ignoring...\n",
 				ATTR_JOB_STATUS);
-		return 0;
+		return false;
 	}
 
 	int noop = 0;
@@ -2031,7 +2188,7 @@ count_a_job( ClassAd *job )
 		job_id.proc = proc;
 		set_job_status(cluster, proc, COMPLETED);
 		scheduler.WriteTerminateToUserLog( job_id, noop_status );
-		return 0;
+		return false;
 	}
 
 	if (job->LookupInteger(ATTR_CURRENT_HOSTS, cur_hosts) == 0) {
@@ -2060,7 +2217,7 @@ count_a_job( ClassAd *job )
 	if( ! job->LookupString(ATTR_OWNER,real_owner) ) {
 		dprintf(D_ALWAYS, "Job has no %s attribute.  Ignoring...\n",
 				ATTR_OWNER);
-		return 0;
+		return false;
 	}
 
 	// calculate owner for per submittor information.
@@ -2070,7 +2227,7 @@ count_a_job( ClassAd *job )
 		if ( owner_buf.Length() == 0 ) {	
 			dprintf(D_ALWAYS, "Job has no %s attribute.  Ignoring...\n",
 					ATTR_OWNER);
-			return 0;
+			return false;
 		}
 	}
 	owner = owner_buf.Value();
@@ -2087,21 +2244,9 @@ count_a_job( ClassAd *job )
 		owner=owner_buf2.Value();
 	}
 
-	// increment our count of the number of job ads in the queue
-	scheduler.JobsTotalAds++;
-
-	// build a list of other stats pools that match this job
-	//
-	time_t now = time(NULL);
-	ScheddOtherStats * other_stats = NULL;
-	if (scheduler.OtherPoolStats.AnyEnabled()) {
-		other_stats = scheduler.OtherPoolStats.Matches(*job,now);
-	}
-	#define OTHER for (ScheddOtherStats * po = other_stats; po; po = po->next) (po->stats)
-
-	// insert owner even if REMOVED or HELD for condor_q -{global|sub}
-	// this function makes its own copies of the memory passed in 
-	int OwnerNum = scheduler.insert_owner( owner );
+	// count this job ad, and its owner even if REMOVED or HELD
+	counts.Counted = true;
+	counts.Owner = scheduler.intern_job_count_owner( owner );
 
 	if ( (universe != CONDOR_UNIVERSE_GRID) &&	// handle Globus below...
 		 (!service_this_universe(universe,job))  ) 
@@ -2112,15 +2257,15 @@ count_a_job( ClassAd *job )
 		{
 			// Count REMOVED or HELD jobs that are in the process of being
 			// killed. cur_hosts tells us which these are.
-			scheduler.SchedUniverseJobsRunning += cur_hosts;
-			scheduler.SchedUniverseJobsIdle += (max_hosts - cur_hosts);
+			counts.SchedUniverseJobsRunning = cur_hosts;
+			counts.SchedUniverseJobsIdle = (max_hosts - cur_hosts);
 		}
 		if( universe == CONDOR_UNIVERSE_LOCAL ) 
 		{
 			// Count REMOVED or HELD jobs that are in the process of being
 			// killed. cur_hosts tells us which these are.
-			scheduler.LocalUniverseJobsRunning += cur_hosts;
-			scheduler.LocalUniverseJobsIdle += (max_hosts - cur_hosts);
+			counts.LocalUniverseJobsRunning = cur_hosts;
+			counts.LocalUniverseJobsIdle = (max_hosts - cur_hosts);
 		}
 			// We want to record the cluster id of all idle MPI and parallel
 		    // jobs
@@ -2137,14 +2282,14 @@ count_a_job( ClassAd *job )
 				job->LookupInteger( ATTR_PROC_ID, proc );
 					// Don't add all the procs in the cluster, just the first
 				if( proc == 0) {
-					dedicated_scheduler.addDedicatedCluster( cluster );
+					counts.DedicatedCluster = cluster;
 				}
 			}
 		}
 
 		// bailout now, since all the crud below is only for jobs
 		// which the schedd needs to service
-		return 0;
+		return true;
 	} 
 
 	if ( universe == CONDOR_UNIVERSE_GRID ) {
@@ -2181,31 +2326,27 @@ count_a_job( ClassAd *job )
 		// Don't count HELD jobs that aren't externally (gridmanager) managed
 		// Don't count jobs that the gridmanager has said it's completely
 		// done with.
-		UserIdentity userident(real_owner.Value(),domain.Value(),job);
+		counts.GridUser = new UserIdentity(real_owner.Value(),domain.Value(),job);
 		if ( ( status != HELD || job_managed != false ) &&
 			 job_managed_done == false ) 
 		{
-			GridJobCounts * gridcounts = scheduler.GetGridJobCounts(userident);
-			ASSERT(gridcounts);
-			gridcounts->GridJobs++;
+			counts.GridJobs = 1;
 		}
 		if ( status != HELD && job_managed == 0 && job_managed_done == 0 ) 
 		{
-			GridJobCounts * gridcounts = scheduler.GetGridJobCounts(userident);
-			ASSERT(gridcounts);
-			gridcounts->UnmanagedGridJobs++;
+			counts.UnmanagedGridJobs = 1;
 		}
 			// If we do not need to do matchmaking on this job (i.e.
 			// service this globus universe job), than we can bailout now.
 		if (!want_service) {
-			return 0;
+			return true;
 		}
 		status = real_status;	// set status back for below logic...
 	}
 
 	if (status == IDLE || status == RUNNING || status == TRANSFERRING_OUTPUT) {
-		scheduler.JobsRunning += cur_hosts;
-		scheduler.JobsIdle += (max_hosts - cur_hosts);
+		counts.JobsRunning = cur_hosts;
+		counts.JobsIdle = (max_hosts - cur_hosts);
 
 			// Update Owner array PrioSet iff knob USE_GLOBAL_JOB_PRIOS is true
 			// and iff job is looking for more matches (max-hosts - cur_hosts)
@@ -2214,13 +2355,11 @@ count_a_job( ClassAd *job )
 		{
 			int job_prio;
 			if ( job->LookupInteger(ATTR_JOB_PRIO,job_prio) ) {
-				scheduler.Owners[OwnerNum].PrioSet.insert( job_prio );
+				counts.HasPrio = true;
+				counts.Prio = job_prio;
 			}
 		}
-			// Update Owners array JobsIdle
-		scheduler.Owners[OwnerNum].JobsIdle += (max_hosts - cur_hosts);
 
-		
 			// If we're biasing by slot weight, and the job is idle, and everything parsed...
 		if ((scheduler.m_use_slot_weights) && (cur_hosts == 0) && scheduler.slotWeightMapAd) {
 
@@ -2232,42 +2371,301 @@ count_a_job( ClassAd *job )
 			if( !rval || !result.IsNumber(job_weight)) {
 				job_weight = request_cpus * (max_hosts - cur_hosts); // fall back if slot weight doesn't evaluate
 			}
-			scheduler.Owners[OwnerNum].WeightedJobsIdle += job_weight;
+			counts.WeightedJobsIdle = job_weight;
 		} else {
-			scheduler.Owners[OwnerNum].WeightedJobsIdle += request_cpus * (max_hosts - cur_hosts);
+			counts.WeightedJobsIdle = request_cpus * (max_hosts - cur_hosts);
 		}
 
-			// Don't update scheduler.Owners[OwnerNum].JobsRunning here.
+			// Don't count the job in Owners[].JobsRunning here.
 			// We do it in Scheduler::count_jobs().
 
-			// if job is not idle, then update statistics for running jobs
+			// if job is not idle, then it goes into the statistics
+			// for running jobs
 		if (status == RUNNING || status == TRANSFERRING_OUTPUT) {
-			scheduler.stats.JobsRunning += 1;
-			OTHER.JobsRunning += 1;
-
-			int job_image_size = 0;
-			job->LookupInteger("ImageSize_RAW", job_image_size);
-			scheduler.stats.JobsRunningSizes += (int64_t)job_image_size * 1024;
-			OTHER.JobsRunningSizes += (int64_t)job_image_size * 1024;
-
-			int job_start_date = 0;
-			int job_running_time = 0;
-			if (job->LookupInteger(ATTR_JOB_START_DATE, job_start_date))
-				job_running_time = (now - job_start_date);
-			scheduler.stats.JobsRunningRuntimes += job_running_time;
-			OTHER.JobsRunningRuntimes += job_running_time;
+			counts.IsRunning = true;
 		}
 	} else if (status == HELD) {
-		scheduler.JobsHeld++;
-		scheduler.Owners[OwnerNum].JobsHeld++;
+		counts.JobsHeld = 1;
 	} else if (status == REMOVED) {
-		scheduler.JobsRemoved++;
+		counts.JobsRemoved = 1;
 	}
 
-	#undef OTHER
+	return true;
+}
+
+int
+count_a_job( ClassAd *job )
+{
+		// we may get passed a NULL job ad if, for instance, the job ad was
+		// removed via condor_rm -f when some function didn't expect it.
+		// So check for it here before continuing onward...
+	if ( job == NULL ) {  
+		return 0;
+	}
+
+	JobCountContribution counts;
+	if( !compute_job_counts( job, counts ) ) {
+		return 0;
+	}
+
+	PROC_ID job_id;
+	job_id.cluster = job_id.proc = -1;
+	job->LookupInteger( ATTR_CLUSTER_ID, job_id.cluster );
+	job->LookupInteger( ATTR_PROC_ID, job_id.proc );
+	scheduler.add_job_counts( job_id, counts, 1 );
+	if( scheduler.m_incremental_job_counts ) {
+		scheduler.m_job_counts[job_id] = counts;
+	}
 	return 0;
 }
 
+void
+Scheduler::add_job_counts( PROC_ID job_id, const JobCountContribution & counts, int sign )
+{
+	if( !counts.Counted ) {
+		return;
+	}
+
+	JobCountTotals &totals = m_job_totals;
+	totals.JobsTotalAds += sign;
+	totals.JobsIdle += sign * counts.JobsIdle;
+	totals.JobsRunning += sign * counts.JobsRunning;
+	totals.JobsHeld += sign * counts.JobsHeld;
+	totals.JobsRemoved += sign * counts.JobsRemoved;
+	totals.SchedUniverseJobsIdle += sign * counts.SchedUniverseJobsIdle;
+	totals.SchedUniverseJobsRunning += sign * counts.SchedUniverseJobsRunning;
+	totals.LocalUniverseJobsIdle += sign * counts.LocalUniverseJobsIdle;
+	totals.LocalUniverseJobsRunning += sign * counts.LocalUniverseJobsRunning;
+
+	const std::string &owner_name = m_job_count_owners[counts.Owner];
+	OwnerJobCounts &owner = totals.Owners[owner_name];
+	owner.Jobs += sign;
+	owner.JobsIdle += sign * counts.JobsIdle;
+	owner.JobsHeld += sign * counts.JobsHeld;
+	owner.WeightedJobsIdle += sign * counts.WeightedJobsIdle;
+	if( counts.HasPrio && (owner.Prios[counts.Prio] += sign) == 0 ) {
+		owner.Prios.erase( counts.Prio );
+	}
+	if( owner.Jobs == 0 ) {
+		totals.Owners.erase( owner_name );
+	}
+
+	if( counts.DedicatedCluster &&
+		(totals.DedicatedClusters[counts.DedicatedCluster] += sign) == 0 )
+	{
+		totals.DedicatedClusters.erase( counts.DedicatedCluster );
+	}
+
+	if( counts.IsRunning ) {
+		if( sign > 0 ) {
+			totals.RunningJobs.insert( job_id );
+		}
+		else {
+			totals.RunningJobs.erase( job_id );
+		}
+	}
+
+	if( counts.GridJobs || counts.UnmanagedGridJobs ) {
+		ASSERT(counts.GridUser);
+		GridJobCounts * gridcounts = GetGridJobCounts( *counts.GridUser );
+		ASSERT(gridcounts);
+		gridcounts->GridJobs += sign * counts.GridJobs;
+		gridcounts->UnmanagedGridJobs += sign * counts.UnmanagedGridJobs;
+		if( gridcounts->GridJobs == 0 && gridcounts->UnmanagedGridJobs == 0 ) {
+			GridJobOwners.remove( *counts.GridUser );
+		}
+	}
+}
+
+	// Count every job in the queue from scratch.
+void
+Scheduler::count_all_jobs()
+{
+	double begin = UtcTime::getTimeDouble();
+
+	m_job_totals.clear();
+	GridJobOwners.clear();
+	m_job_counts.clear();
+	m_job_count_owners.clear();
+	m_job_count_owner_ids.clear();
+	WalkJobQueue( count_a_job );
+
+	dprintf( D_FULLDEBUG, "Counted %d jobs in %.3fs\n",
+			 m_job_totals.JobsTotalAds, UtcTime::getTimeDouble() - begin );
+}
+
+	// Take the given job's old contribution out of the totals, and put
+	// in what it counts for now.
+void
+Scheduler::recount_job( PROC_ID job_id )
+{
+	if( job_id.cluster <= 0 || job_id.proc < 0 ) {
+		return;		// the job queue header
+	}
+
+	std::map<PROC_ID,JobCountContribution,JobIdLess>::iterator it;
+	it = m_job_counts.find( job_id );
+	if( it != m_job_counts.end() ) {
+		add_job_counts( job_id, it->second, -1 );
+		m_job_counts.erase( it );
+	}
+
+	ClassAd *job = GetJobAd( job_id.cluster, job_id.proc );
+	JobCountContribution counts;
+	if( job && compute_job_counts( job, counts ) ) {
+		add_job_counts( job_id, counts, 1 );
+		m_job_counts[job_id] = counts;
+	}
+}
+
+	// Bring m_job_totals up to date.  Without SCHEDD_INCREMENTAL_JOB_COUNTS
+	// this walks the whole job queue; with it, only the jobs that qmgmt
+	// says have changed since last time are counted again, which costs
+	// time in proportion to the number of changes.
+void
+Scheduler::update_job_counts()
+{
+	std::vector<PROC_ID> changed_jobs;
+	std::set<int> changed_clusters;
+
+	if( !m_incremental_job_counts || !m_job_counts_valid ) {
+			// the walk sees all of these anyway
+		TakeJobCountChanges( changed_jobs, changed_clusters );
+		count_all_jobs();
+		m_job_counts_valid = m_incremental_job_counts;
+		m_job_count_cycles = 0;
+		return;
+	}
+
+	double begin = UtcTime::getTimeDouble();
+	size_t recounted = 0;
+
+		// Counting a no-op job marks it completed, which is a change of
+		// its own, so a second round picks that up right away.
+	for( int round = 0; round < 2; round++ ) {
+		TakeJobCountChanges( changed_jobs, changed_clusters );
+
+			// A change to a cluster ad may change every job in it.
+		std::set<int>::const_iterator cluster;
+		for( cluster = changed_clusters.begin();
+			 cluster != changed_clusters.end();
+			 cluster++ )
+		{
+			PROC_ID first;
+			first.cluster = *cluster;
+			first.proc = -1;
+			std::map<PROC_ID,JobCountContribution,JobIdLess>::const_iterator it;
+			for( it = m_job_counts.lower_bound( first );
+				 it != m_job_counts.end() && it->first.cluster == *cluster;
+				 it++ )
+			{
+				changed_jobs.push_back( it->first );
+			}
+		}
+		std::sort( changed_jobs.begin(), changed_jobs.end(), JobIdLess() );
+		changed_jobs.erase( std::unique( changed_jobs.begin(), changed_jobs.end() ),
+							changed_jobs.end() );
+
+		std::vector<PROC_ID>::const_iterator job_id;
+		for( job_id = changed_jobs.begin(); job_id != changed_jobs.end(); job_id++ ) {
+			recount_job( *job_id );
+		}
+		recounted += changed_jobs.size();
+	}
+
+	dprintf( D_FULLDEBUG, "Counted %d changed jobs in %.3fs\n",
+			 (int)recounted, UtcTime::getTimeDouble() - begin );
+
+	if( m_job_count_check_interval > 0 &&
+		++m_job_count_cycles >= m_job_count_check_interval )
+	{
+		m_job_count_cycles = 0;
+		check_job_counts();
+	}
+}
+
+	// Count every job from scratch, and complain about anything the
+	// incremental counts got wrong.  The fresh counts are kept.
+void
+Scheduler::check_job_counts()
+{
+	JobCountTotals incremental( m_job_totals );
+	HashTable<UserIdentity, GridJobCounts> incremental_grid( GridJobOwners );
+	int mismatches = 0;
+
+	count_all_jobs();
+
+#define CHECK_JOB_COUNT(name) \
+	if( incremental.name != m_job_totals.name ) { \
+		dprintf( D_ALWAYS, "Job count check: %s is %d, should be %d\n", \
+				 #name, incremental.name, m_job_totals.name ); \
+		mismatches++; \
+	}
+	CHECK_JOB_COUNT(JobsTotalAds);
+	CHECK_JOB_COUNT(JobsIdle);
+	CHECK_JOB_COUNT(JobsRunning);
+	CHECK_JOB_COUNT(JobsHeld);
+	CHECK_JOB_COUNT(JobsRemoved);
+	CHECK_JOB_COUNT(SchedUniverseJobsIdle);
+	CHECK_JOB_COUNT(SchedUniverseJobsRunning);
+	CHECK_JOB_COUNT(LocalUniverseJobsIdle);
+	CHECK_JOB_COUNT(LocalUniverseJobsRunning);
+#undef CHECK_JOB_COUNT
+
+	std::map<std::string,OwnerJobCounts>::const_iterator owner, other;
+	for( owner = m_job_totals.Owners.begin();
+		 owner != m_job_totals.Owners.end();
+		 owner++ )
+	{
+		other = incremental.Owners.find( owner->first );
+		if( other == incremental.Owners.end() || !(other->second == owner->second) ) {
+			dprintf( D_ALWAYS, "Job count check: counts for %s are wrong\n",
+					 owner->first.c_str() );
+			mismatches++;
+		}
+	}
+	for( owner = incremental.Owners.begin();
+		 owner != incremental.Owners.end();
+		 owner++ )
+	{
+		if( m_job_totals.Owners.find( owner->first ) == m_job_totals.Owners.end() ) {
+			dprintf( D_ALWAYS, "Job count check: %s has no jobs\n",
+					 owner->first.c_str() );
+			mismatches++;
+		}
+	}
+
+	if( incremental.DedicatedClusters != m_job_totals.DedicatedClusters ) {
+		dprintf( D_ALWAYS, "Job count check: idle parallel clusters are wrong\n" );
+		mismatches++;
+	}
+	if( incremental.RunningJobs != m_job_totals.RunningJobs ) {
+		dprintf( D_ALWAYS, "Job count check: running jobs are wrong\n" );
+		mismatches++;
+	}
+
+	UserIdentity userident;
+	GridJobCounts gridcounts, othercounts;
+	GridJobOwners.startIterations();
+	while( GridJobOwners.iterate( userident, gridcounts ) ) {
+		if( incremental_grid.lookup( userident, othercounts ) != 0 ||
+			othercounts.GridJobs != gridcounts.GridJobs ||
+			othercounts.UnmanagedGridJobs != gridcounts.UnmanagedGridJobs )
+		{
+			dprintf( D_ALWAYS, "Job count check: grid job counts for %s are wrong\n",
+					 userident.username().Value() );
+			mismatches++;
+		}
+	}
+	if( incremental_grid.getNumElements() != GridJobOwners.getNumElements() ) {
+		dprintf( D_ALWAYS, "Job count check: grid job owners are wrong\n" );
+		mismatches++;
+	}
+
+	dprintf( mismatches ? D_ALWAYS : D_FULLDEBUG,
+			 "Job count check found %d mismatches\n", mismatches );
+}
+
 bool
 service_this_universe(int universe, ClassAd* job)
 {
@@ -4773,6 +5171,11 @@ Scheduler::actOnJobs(int, Stream* s)
 				jobs[num_matches++] = tmp_id;
 			} 
 		}
+		if( action == JA_REMOVE_JOBS ) {
+				// procs that haven't been materialized yet are
+				// removed too
+			StopJobFactoriesByConstraint( constraint );
+		}
 		free( constraint );
 		constraint = NULL;
 
@@ -5657,7 +6060,6 @@ Scheduler::negotiationFinished( char const *owner, char const *remote_pool, bool
 int
 Scheduler::negotiate(int command, Stream* s)
 {
-	int		job_index;
 	int		jobs;						// # of jobs that CAN be negotiated
 	int		which_negotiator = 0; 		// >0 implies flocking
 	MyString remote_pool_buf;
@@ -5928,13 +6330,21 @@ Scheduler::negotiate(int command, Stream* s)
 	}
 
 	BuildPrioRecArray();
-	jobs = N_PrioRecs;
+	jobs = 0;
 
 	JobsStarted = 0;
 
 	// find owner in the Owners array
 	char *at_sign = strchr(owner, '@');
 	if (at_sign) *at_sign = '\0';
+
+	// only this owner's runnable jobs, already in priority order
+	static PrioRecIndex::Queue const no_prio_recs;
+	PrioRecIndex::Queue const *owner_prio_recs = PrioRecs.ForOwner(owner);
+	if (!owner_prio_recs) {
+		owner_prio_recs = &no_prio_recs;
+	}
+	jobs = (int)owner_prio_recs->size();
 	for (owner_num = 0;
 		 owner_num < N_Owners && strcmp(Owners[owner_num].Name, owner);
 		 owner_num++) ;
@@ -5953,15 +6363,12 @@ Scheduler::negotiate(int command, Stream* s)
 	ResourceRequestCluster *cluster = NULL;
 	int next_cluster = 0;
 
-	for(job_index = 0; job_index < N_PrioRecs && !skip_negotiation; job_index++) {
-		prio_rec *prec = &PrioRec[job_index];
-
-		// make sure owner matches what negotiator wants
-		if(strcmp(owner,prec->owner)!=0)
-		{
-			jobs--;
-			continue;
-		}
+	PrioRecIndex::Queue::const_iterator prio_it;
+	for(prio_it = owner_prio_recs->begin();
+		!skip_negotiation && prio_it != owner_prio_recs->end();
+		prio_it++)
+	{
+		prio_rec *prec = *prio_it;
 
 		// make sure jobprio is in the range the negotiator wants
 		if ( consider_jobprio_min > prec->job_prio ||
@@ -7481,6 +7888,7 @@ Scheduler::spawnShadow( shadow_rec* srec )
 	shadow_path = param("SHADOW");
 	sh_is_dc = TRUE;
 	bool sh_reads_file = true;
+	bool sh_multi_job = false;
 #else
 		// UNIX
 
@@ -7547,6 +7955,7 @@ Scheduler::spawnShadow( shadow_rec* srec )
 
 	sh_is_dc = (int)shadow_obj->isDC();
 	bool sh_reads_file = shadow_obj->provides( ATTR_HAS_JOB_AD_FROM_FILE );
+	bool sh_multi_job = shadow_obj->provides( ATTR_HAS_MULTI_JOB );
 	shadow_path = strdup( shadow_obj->path() );
 
 	if ( shadow_obj ) {
@@ -7564,6 +7973,24 @@ Scheduler::spawnShadow( shadow_rec* srec )
 		return;
 	}
 
+		// See if this job can share a shadow process with other
+		// jobs.  We only do this for the kinds of jobs that the
+		// shadow can recycle itself for, and since the shadow
+		// switches to the job owner's uid, only jobs of the same
+		// owner share a shadow.
+	bool multi_job = false;
+	if( MaxJobsPerShadow > 1 && sh_multi_job && sh_is_dc && sh_reads_file &&
+		!privsep_enabled() &&
+		(universe == CONDOR_UNIVERSE_VANILLA ||
+		 universe == CONDOR_UNIVERSE_JAVA ||
+		 universe == CONDOR_UNIVERSE_VM) )
+	{
+		int want_ps = 0;
+		GetAttributeBool( job_id->cluster, job_id->proc,
+						  "WantParallelScheduling", &want_ps );
+		multi_job = !want_ps;
+	}
+
 	args.AppendArg("condor_shadow");
 	if(sh_is_dc) {
 		args.AppendArg("-f");
@@ -7616,11 +8043,18 @@ Scheduler::spawnShadow( shadow_rec* srec )
 
 	if ( sh_reads_file ) {
 		if( sh_is_dc ) { 
-			argbuf.formatstr("%d.%d",job_id->cluster,job_id->proc);
-			args.AppendArg(argbuf.Value());
+			if( multi_job ) {
+					// the job id and whether to reconnect are sent
+					// along with each job ad
+				args.AppendArg("--multi-job");
+			}
+			else {
+				argbuf.formatstr("%d.%d",job_id->cluster,job_id->proc);
+				args.AppendArg(argbuf.Value());
 
-			if(wants_reconnect) {
-				args.AppendArg("--reconnect");
+				if(wants_reconnect) {
+					args.AppendArg("--reconnect");
+				}
 			}
 
 			// pass the public ip/port of the schedd (used w/ reconnect)
@@ -7637,7 +8071,9 @@ Scheduler::spawnShadow( shadow_rec* srec )
 				// pass the private socket ip/port for use just by shadows
 			args.AppendArg(MyShadowSockName);
 				
-			args.AppendArg("-");
+			if( !multi_job ) {
+				args.AppendArg("-");
+			}
 		} else {
 			args.AppendArg(MyShadowSockName);
 			args.AppendArg(mrec->peer);
@@ -7667,8 +8103,13 @@ Scheduler::spawnShadow( shadow_rec* srec )
 	want_udp = false;
 #endif
 
-	rval = spawnJobHandlerRaw( srec, shadow_path, args, NULL, "shadow",
-							   sh_is_dc, sh_reads_file, want_udp );
+	if( multi_job ) {
+		rval = spawnMultiJobShadow( srec, shadow_path, args, want_udp );
+	}
+	else {
+		rval = spawnJobHandlerRaw( srec, shadow_path, args, NULL, "shadow",
+								   sh_is_dc, sh_reads_file, want_udp );
+	}
 
 	free( shadow_path );
 
@@ -7784,11 +8225,31 @@ Scheduler::tryNextJob()
 }
 
 
+	// How long a shadow running more than one job may sit with no
+	// jobs, waiting for another one, before we close its stdin (which
+	// tells it to exit).
+static const int MULTI_JOB_SHADOW_IDLE_TIME = 10;
+
+	// A shadow running more than one job reads these messages from its
+	// stdin, one per line:
+	//   START_JOB <cluster>.<proc> <is_reconnect>
+	//     followed by the job ad and a line with "***"
+	//   SIGNAL <cluster>.<proc> <signal>
+static void
+formatMultiJobShadowStart( MyString &msg, shadow_rec *srec, ClassAd *job_ad )
+{
+	msg.formatstr( "START_JOB %d.%d %d\n", srec->job_id.cluster,
+				   srec->job_id.proc, srec->is_reconnect ? 1 : 0 );
+	sPrintAd( msg, *job_ad );
+	msg += "***\n";
+}
+
+
 bool
 Scheduler::spawnJobHandlerRaw( shadow_rec* srec, const char* path, 
 							   ArgList const &args, Env const *env, 
 							   const char* name, bool is_dc, bool wants_pipe,
-							   bool want_udp)
+							   bool want_udp, bool keep_pipe)
 {
 	int pid = -1;
 	PROC_ID* job_id = &srec->job_id;
@@ -7836,7 +8297,10 @@ Scheduler::spawnJobHandlerRaw( shadow_rec* srec, const char* path,
 	pipe_fds[0] = -1;
 	pipe_fds[1] = -1;
 	if( wants_pipe ) {
-		if( ! daemonCore->Create_Pipe(pipe_fds) ) {
+			// a pipe we keep open to send more jobs down later gets a
+			// nonblocking write end, which we can register for writing
+		if( ! daemonCore->Create_Pipe(pipe_fds, false, keep_pipe,
+									  false, keep_pipe) ) {
 			dprintf( D_ALWAYS, 
 					 "ERROR: Can't create DC pipe for writing job "
 					 "ClassAd to the %s, aborting\n", name );
@@ -7968,29 +8432,41 @@ Scheduler::spawnJobHandlerRaw( shadow_rec* srec, const char* path,
 
 			// 2) dump out the job ad to the write end, since the
 			// handler is now alive and can read from the pipe.
+			// if the caller wants to keep the pipe open to send
+			// more jobs later, this one goes in the same form and
+			// through the same queue as those will.
 		ASSERT( job_ad );
 		MyString ad_str;
-		sPrintAd(ad_str, *job_ad);
-		const char* ptr = ad_str.Value();
-		int len = ad_str.Length();
-		while (len) {
-			int bytes_written = daemonCore->Write_Pipe(pipe_fds[1], ptr, len);
-			if (bytes_written == -1) {
-				dprintf(D_ALWAYS, "writeJobAd: Write_Pipe failed\n");
-				break;
-			}
-			ptr += bytes_written;
-			len -= bytes_written;
+		if( keep_pipe ) {
+			multi_job_shadow_rec *mjs = &multiJobShadows[pid];
+			mjs->pid = pid;
+			mjs->stdin_pipe = pipe_fds[1];
+			formatMultiJobShadowStart( ad_str, srec, job_ad );
+			writeToMultiJobShadow( mjs, ad_str );
 		}
+		else {
+			sPrintAd(ad_str, *job_ad);
+			const char* ptr = ad_str.Value();
+			int len = ad_str.Length();
+			while (len) {
+				int bytes_written = daemonCore->Write_Pipe(pipe_fds[1], ptr, len);
+				if (bytes_written == -1) {
+					dprintf(D_ALWAYS, "writeJobAd: Write_Pipe failed\n");
+					break;
+				}
+				ptr += bytes_written;
+				len -= bytes_written;
+			}
 
-			// TODO: if this is an MPI job, we should really write all
-			// the match info (ClaimIds, sinful strings and machine
-			// ads) to the pipe before we close it, but that's just a
-			// performance optimization, not a correctness issue.
+				// TODO: if this is an MPI job, we should really write all
+				// the match info (ClaimIds, sinful strings and machine
+				// ads) to the pipe before we close it, but that's just a
+				// performance optimization, not a correctness issue.
 
-			// Now that all the data is written to the pipe, we can
-			// safely close the other end, too.  
-		daemonCore->Close_Pipe(pipe_fds[1]);
+				// Now that all the data is written to the pipe, we can
+				// safely close the other end, too.  
+			daemonCore->Close_Pipe(pipe_fds[1]);
+		}
 	}
 
 	{
@@ -8009,6 +8485,264 @@ Scheduler::spawnJobHandlerRaw( shadow_rec* srec, const char* path,
 }
 
 
+bool
+Scheduler::spawnMultiJobShadow( shadow_rec* srec, const char* path,
+								ArgList const &args, bool want_udp )
+{
+	PROC_ID* job_id = &srec->job_id;
+	MyString owner;
+	GetAttributeString( job_id->cluster, job_id->proc, ATTR_OWNER, owner );
+
+	multi_job_shadow_rec *mjs = findMultiJobShadow( owner.Value() );
+	if( ! mjs ) {
+			// start a new shadow, and keep its stdin open so we can
+			// give it more jobs later
+		if( ! spawnJobHandlerRaw(srec, path, args, NULL, "shadow", true,
+								 true, want_udp, true) )
+		{
+			return false;
+		}
+		mjs = &multiJobShadows[srec->pid];
+		mjs->owner = owner.Value();
+		mjs->num_jobs = 1;
+
+			// like a shadow that recycles itself, stop giving this
+			// one new jobs once it has been around for SHADOW_WORKLIFE
+		int worklife = param_integer( "SHADOW_WORKLIFE", 3600 );
+		if( worklife >= 0 ) {
+			mjs->expires = time(NULL) + worklife;
+		}
+		return true;
+	}
+
+	srec->pid = mjs->pid;
+	add_shadow_rec( srec );
+	mjs->num_jobs++;
+    stats.Tick();
+    stats.ShadowsRunning = numShadows;
+
+	OtherPoolStats.Tick();
+
+		// expand $$ stuff and persist expansions, just like
+		// spawnJobHandlerRaw() does for a new shadow
+	ClassAd *job_ad = GetJobAd( job_id->cluster, job_id->proc, true, true );
+	if( ! job_ad ) {
+		dprintf( D_ALWAYS, "ERROR: Failed to get classad for job "
+				 "%d.%d, can't give it to shadow pid %d, aborting\n",
+				 job_id->cluster, job_id->proc, mjs->pid );
+			// our caller will deal with cleaning up the srec
+		return false;
+	}
+
+	MyString msg;
+	formatMultiJobShadowStart( msg, srec, job_ad );
+	bool sent = writeToMultiJobShadow( mjs, msg );
+
+	if( sent ) {
+		ClassAd *machine_ad = NULL;
+		if( srec->match ) {
+			machine_ad = srec->match->my_match_ad;
+		}
+		setNextJobDelay( job_ad, machine_ad );
+	}
+
+	delete job_ad;
+	return sent;
+}
+
+
+multi_job_shadow_rec *
+Scheduler::findMultiJobShadow( char const *owner )
+{
+	multi_job_shadow_rec *best = NULL;
+	time_t now = time(NULL);
+
+	std::map<int, multi_job_shadow_rec>::iterator it;
+	for( it = multiJobShadows.begin(); it != multiJobShadows.end(); it++ ) {
+		multi_job_shadow_rec *mjs = &it->second;
+		if( mjs->stdin_pipe == -1 ||
+			mjs->num_jobs >= MaxJobsPerShadow ||
+			(mjs->expires && now >= mjs->expires) ||
+			mjs->owner != owner )
+		{
+			continue;
+		}
+			// fill up the busiest shadows first, so that the others
+			// have a chance to run out of jobs and go away
+		if( !best || mjs->num_jobs > best->num_jobs ) {
+			best = mjs;
+		}
+	}
+	return best;
+}
+
+
+bool
+Scheduler::writeToMultiJobShadow( multi_job_shadow_rec *mjs,
+								  MyString const &msg )
+{
+	if( mjs->stdin_pipe == -1 ) {
+		return false;
+	}
+
+	mjs->stdin_buf.append( msg.Value(), msg.Length() );
+	if( mjs->stdin_registered ) {
+			// the pipe is full, and already registered to tell us
+			// when there is room again
+		return true;
+	}
+	return flushMultiJobShadowStdin( mjs );
+}
+
+
+	// Write as much of a shadow's queued stdin as the pipe will take
+	// without blocking.  If some is left, the pipe is registered so we
+	// are called again when it has room.
+bool
+Scheduler::flushMultiJobShadowStdin( multi_job_shadow_rec *mjs )
+{
+	while( mjs->stdin_offset < mjs->stdin_buf.size() ) {
+		int bytes_written = daemonCore->Write_Pipe( mjs->stdin_pipe,
+			mjs->stdin_buf.data() + mjs->stdin_offset,
+			mjs->stdin_buf.size() - mjs->stdin_offset );
+		if( bytes_written >= 0 ) {
+			mjs->stdin_offset += bytes_written;
+			continue;
+		}
+		if( errno == EINTR ) {
+			continue;
+		}
+		if( errno == EAGAIN || errno == EWOULDBLOCK ) {
+			break;
+		}
+			// it won't be getting any more jobs from us; the jobs
+			// it has will be taken care of when it exits
+		dprintf( D_ALWAYS, "Failed to write to stdin of shadow pid %d "
+				 "(errno = %d)\n", mjs->pid, errno );
+		closeMultiJobShadowStdin( mjs );
+		return false;
+	}
+
+	if( mjs->stdin_offset < mjs->stdin_buf.size() ) {
+			// don't keep what it has already read
+		mjs->stdin_buf.erase( 0, mjs->stdin_offset );
+		mjs->stdin_offset = 0;
+		if( !mjs->stdin_registered ) {
+			if( daemonCore->Register_Pipe( mjs->stdin_pipe,
+					"multi-job shadow stdin",
+					(PipeHandlercpp)&Scheduler::multiJobShadowStdinHandler,
+					"Scheduler::multiJobShadowStdinHandler", this,
+					HANDLE_WRITE ) < 0 )
+			{
+				dprintf( D_ALWAYS, "Failed to register stdin of shadow "
+						 "pid %d\n", mjs->pid );
+				closeMultiJobShadowStdin( mjs );
+				return false;
+			}
+			mjs->stdin_registered = true;
+			dprintf( D_FULLDEBUG, "Stdin of shadow pid %d is full, sending "
+					 "the other %d bytes when it has room\n", mjs->pid,
+					 (int)(mjs->stdin_buf.size() - mjs->stdin_offset) );
+		}
+		return true;
+	}
+
+	if( mjs->stdin_registered ) {
+		daemonCore->Cancel_Pipe( mjs->stdin_pipe );
+		mjs->stdin_registered = false;
+	}
+	mjs->stdin_buf.clear();
+	mjs->stdin_offset = 0;
+	return true;
+}
+
+
+int
+Scheduler::multiJobShadowStdinHandler( int pipe_end )
+{
+	std::map<int, multi_job_shadow_rec>::iterator it;
+	for( it = multiJobShadows.begin(); it != multiJobShadows.end(); it++ ) {
+		if( it->second.stdin_pipe == pipe_end ) {
+			flushMultiJobShadowStdin( &it->second );
+			return 0;
+		}
+	}
+	daemonCore->Cancel_Pipe( pipe_end );
+	return 0;
+}
+
+
+void
+Scheduler::closeMultiJobShadowStdin( multi_job_shadow_rec *mjs )
+{
+	if( mjs->stdin_pipe != -1 ) {
+			// this also cancels the pipe's registration, if any
+		daemonCore->Close_Pipe( mjs->stdin_pipe );
+		mjs->stdin_pipe = -1;
+	}
+	mjs->stdin_registered = false;
+	mjs->stdin_buf.clear();
+	mjs->stdin_offset = 0;
+}
+
+
+void
+Scheduler::closeIdleMultiJobShadows()
+{
+	multiJobShadowIdleTid = -1;
+	time_t now = time(NULL);
+	bool still_idle = false;
+
+	std::map<int, multi_job_shadow_rec>::iterator it;
+	for( it = multiJobShadows.begin(); it != multiJobShadows.end(); it++ ) {
+		multi_job_shadow_rec *mjs = &it->second;
+		if( mjs->num_jobs > 0 || mjs->stdin_pipe == -1 ) {
+			continue;
+		}
+			// don't cut it off before it has read all we sent it
+		if( (now - mjs->idle_since < MULTI_JOB_SHADOW_IDLE_TIME &&
+			 !(mjs->expires && now >= mjs->expires)) ||
+			mjs->stdin_offset < mjs->stdin_buf.size() )
+		{
+			still_idle = true;
+			continue;
+		}
+		dprintf( D_FULLDEBUG, "Shadow pid %d has no jobs, closing its stdin\n",
+				 mjs->pid );
+		closeMultiJobShadowStdin( mjs );
+	}
+
+	if( still_idle ) {
+		multiJobShadowIdleTid = daemonCore->Register_Timer(
+			MULTI_JOB_SHADOW_IDLE_TIME,
+			(TimerHandlercpp)&Scheduler::closeIdleMultiJobShadows,
+			"closeIdleMultiJobShadows", this );
+	}
+}
+
+
+bool
+Scheduler::signalMultiJobShadow( int pid, int sig, PROC_ID proc )
+{
+	std::map<int, multi_job_shadow_rec>::iterator it = multiJobShadows.find( pid );
+	if( it == multiJobShadows.end() ) {
+		return false;
+	}
+	if( it->second.stdin_pipe == -1 ) {
+			// We can't talk to it anymore, so the caller has to fall
+			// back on signaling the whole process.
+		return false;
+	}
+
+	dprintf( D_FULLDEBUG, "Sending signal %d to job %d.%d in shadow pid %d\n",
+			 sig, proc.cluster, proc.proc, pid );
+
+	MyString msg;
+	msg.formatstr( "SIGNAL %d.%d %d\n", proc.cluster, proc.proc, sig );
+	return writeToMultiJobShadow( &it->second, msg );
+}
+
+
 void
 Scheduler::noShadowForJob( shadow_rec* srec, NoShadowFailure_t why )
 {
@@ -8754,6 +9488,17 @@ shadow_rec::shadow_rec():
 	job_id.cluster = -1;
 }
 
+multi_job_shadow_rec::multi_job_shadow_rec():
+	pid(-1),
+	num_jobs(0),
+	stdin_pipe(-1),
+	stdin_offset(0),
+	stdin_registered(false),
+	expires(0),
+	idle_since(0)
+{
+}
+
 shadow_rec::~shadow_rec()
 {
 	if( recycle_shadow_stream ) {
@@ -9402,7 +10147,42 @@ Scheduler::delete_shadow_rec( shadow_rec *rec )
 	}
 
 	if( pid ) {
-		shadowsByPid->remove(pid);
+		shadow_rec *first = NULL;
+		shadowsByPid->lookup(pid, first);
+		if( first == rec ) {
+			shadowsByPid->remove(pid);
+		}
+		else {
+				// a shadow running more than one job has a record
+				// for each of them under the same pid, so take them
+				// all out and put back the ones we're keeping
+			std::vector<shadow_rec *> others;
+			shadow_rec *other = NULL;
+			while( shadowsByPid->lookup(pid, other) == 0 ) {
+				shadowsByPid->remove(pid);
+				if( other != rec ) {
+					others.push_back(other);
+				}
+			}
+			for( size_t i = 0; i < others.size(); i++ ) {
+				shadowsByPid->insert(pid, others[i]);
+			}
+		}
+
+		std::map<int, multi_job_shadow_rec>::iterator mjs =
+			multiJobShadows.find(pid);
+		if( mjs != multiJobShadows.end() && --mjs->second.num_jobs == 0 ) {
+				// give it a little while to pick up another job
+				// (e.g. the next one to run on this claim) before
+				// we let it go
+			mjs->second.idle_since = time(NULL);
+			if( multiJobShadowIdleTid == -1 ) {
+				multiJobShadowIdleTid = daemonCore->Register_Timer(
+					MULTI_JOB_SHADOW_IDLE_TIME,
+					(TimerHandlercpp)&Scheduler::closeIdleMultiJobShadows,
+					"closeIdleMultiJobShadows", this );
+			}
+		}
 	}
 	shadowsByProcID->remove(rec->job_id);
 	if ( rec->conn_fd != -1 ) {
@@ -9728,9 +10508,12 @@ Scheduler::preempt( int n, bool force_sched_jobs )
 					} else {
 							//
 							// Call the blocking form of Send_Signal, rather than
-							// sendSignalToShadow().
+							// sendSignalToShadow(), unless the shadow is
+							// running other jobs too.
 							//
-						daemonCore->Send_Signal( rec->pid, SIGKILL );
+						if( !signalMultiJobShadow( rec->pid, SIGKILL, rec->job_id ) ) {
+							daemonCore->Send_Signal( rec->pid, SIGKILL );
+						}
 						dprintf( D_ALWAYS, 
 								"Sent signal %d to %s [pid %d] for job %d.%d\n",
 								SIGKILL, rec->match->peer, rec->pid, cluster, proc );
@@ -9818,7 +10601,6 @@ Scheduler::swap_space_exhausted()
 int
 Scheduler::shadow_prio_recs_consistent()
 {
-	int		i;
 	struct shadow_rec	*srp;
 	int		status, universe;
 
@@ -9826,8 +10608,9 @@ Scheduler::shadow_prio_recs_consistent()
 	BadCluster = -1;
 	BadProc = -1;
 
-	for( i=0; i<N_PrioRecs; i++ ) {
-		if( (srp=find_shadow_rec(&PrioRec[i].id)) ) {
+	PrioRecIndex::Queue::const_iterator it;
+	for( it = PrioRecs.All().begin(); it != PrioRecs.All().end(); it++ ) {
+		if( (srp=find_shadow_rec(&(*it)->id)) ) {
 			BadCluster = srp->job_id.cluster;
 			BadProc = srp->job_id.proc;
 			universe = srp->universe;
@@ -9836,7 +10619,7 @@ Scheduler::shadow_prio_recs_consistent()
 				universe!=CONDOR_UNIVERSE_MPI &&
 				universe!=CONDOR_UNIVERSE_PARALLEL) {
 				// display_shadow_recs();
-				// dprintf(D_ALWAYS,"shadow_prio_recs_consistent(): PrioRec %d - id = %d.%d, owner = %s\n",i,PrioRec[i].id.cluster,PrioRec[i].id.proc,PrioRec[i].owner);
+				// dprintf(D_ALWAYS,"shadow_prio_recs_consistent(): PrioRec id = %d.%d, owner = %s\n",(*it)->id.cluster,(*it)->id.proc,(*it)->owner);
 				dprintf( D_ALWAYS, "ERROR: Found a consistency problem!!!\n" );
 				return FALSE;
 			}
@@ -10012,7 +10795,33 @@ set_job_status(int cluster, int proc, int status)
 void
 Scheduler::child_exit(int pid, int status)
 {
-	shadow_rec*		srec;
+	std::map<int, multi_job_shadow_rec>::iterator mjs =
+		multiJobShadows.find(pid);
+	if( mjs != multiJobShadows.end() ) {
+			// a shadow that was running more than one job.  any of
+			// its jobs it hasn't already told us about are done, and
+			// went the same way it did.
+		closeMultiJobShadowStdin( &mjs->second );
+		multiJobShadows.erase( mjs );
+
+		shadow_rec *srec;
+		while( (srec = FindSrecByPid(pid)) ) {
+			shadow_job_exit( srec, status );
+		}
+		return;
+	}
+
+	shadow_rec *srec = FindSrecByPid(pid);
+	ASSERT(srec);
+	shadow_job_exit( srec, status );
+}
+
+	// The shadow for this job is gone.  status is the shadow's exit
+	// status, as passed to a reaper.
+void
+Scheduler::shadow_job_exit(shadow_rec *srec, int status)
+{
+	int				pid = srec->pid;
 	int				StartJobsFlag=TRUE;
 	PROC_ID			job_id;
 	bool			srec_was_local_universe = false;
@@ -10023,9 +10832,6 @@ Scheduler::child_exit(int pid, int status)
 		// AsyncXfer: Should this match be held idle waiting for a paired match?
 	bool            paired_match_wait = false;
 
-	srec = FindSrecByPid(pid);
-	ASSERT(srec);
-
 		if( srec->match ) {
 			match_rec *mrec = srec->match;
 
@@ -10075,7 +10881,7 @@ Scheduler::child_exit(int pid, int status)
 	if (IsSchedulerUniverse(srec)) {
  		// scheduler universe process 
 		scheduler_univ_job_exit(pid,status,srec);
-		delete_shadow_rec( pid );
+		delete_shadow_rec( srec );
 			// even though this will get set correctly in
 			// count_jobs(), try to keep it accurate here, too.  
 		if( SchedUniverseJobsRunning > 0 ) {
@@ -10154,7 +10960,7 @@ Scheduler::child_exit(int pid, int status)
 		
 			// We always want to delete the shadow record regardless 
 			// of how the job exited
-		delete_shadow_rec( pid );
+		delete_shadow_rec( srec );
 
 	} else {
 			// Hmm -- doesn't seem like we can ever get here, given 
@@ -10169,12 +10975,16 @@ Scheduler::child_exit(int pid, int status)
 
 		//
 		// If the job was a local universe job, we will want to
-		// call count on it so that it can be marked idle again
+		// count it again so that it can be marked idle again
 		// if need be.
 		//
 	if ( srec_was_local_universe == true ) {
 		ClassAd *job_ad = GetJobAd( job_id.cluster, job_id.proc );
-		count_a_job( job_ad );
+		JobCountContribution counts;
+		if ( job_ad && compute_job_counts( job_ad, counts ) ) {
+			LocalUniverseJobsIdle += counts.LocalUniverseJobsIdle;
+			LocalUniverseJobsRunning += counts.LocalUniverseJobsRunning;
+		}
 	}
 
 		// If we're not trying to shutdown, now that either an agent
@@ -11176,6 +11986,17 @@ Scheduler::Init()
 		// note: the special value 0 means 'unlimited'
 	max_pending_startd_contacts = param_integer( "MAX_PENDING_STARTD_CONTACTS", 0, 0 );
 
+		// How many jobs one shadow process may run at a time.  1
+		// means one shadow process per running job.
+	MaxJobsPerShadow = param_integer( "MAX_JOBS_PER_SHADOW", 1, 1 );
+#ifdef WIN32
+	if( MaxJobsPerShadow > 1 ) {
+		dprintf( D_ALWAYS, "MAX_JOBS_PER_SHADOW is not supported on this "
+				 "platform; ignoring it\n" );
+		MaxJobsPerShadow = 1;
+	}
+#endif
+
 		//
 		// Start Local Universe Expression
 		// This will be added into the requirements expression for
@@ -11723,6 +12544,13 @@ Scheduler::Init()
 	slotWeightMapAd = new ClassAd;
 	slotWeightMapAd->initFromString(sswma.c_str());
 
+	m_incremental_job_counts = param_boolean("SCHEDD_INCREMENTAL_JOB_COUNTS", true);
+	m_job_count_check_interval = param_integer("SCHEDD_JOB_COUNT_CHECK_INTERVAL", 0, 0);
+		// SLOT_WEIGHT, USE_GLOBAL_JOB_PRIOS, GRIDMANAGER_SELECTION_EXPR
+		// and friends may have changed what each job counts as, so
+		// count them all again next time.
+	m_job_counts_valid = false;
+
 	first_time_in_init = false;
 }
 
@@ -11782,6 +12610,11 @@ Scheduler::Register()
 			(CommandHandlercpp)&Scheduler::RecycleShadow,
 			"RecycleShadow", this, DAEMON, D_COMMAND,
 			true /*force authentication*/);
+	 daemonCore->Register_CommandWithPayload(SHADOW_JOB_EXIT,
+			"SHADOW_JOB_EXIT",
+			(CommandHandlercpp)&Scheduler::ShadowJobExit,
+			"ShadowJobExit", this, DAEMON, D_COMMAND,
+			true /*force authentication*/);
 
 		 // Commands used by the startd are registered at READ
 		 // level rather than something like DAEMON or WRITE in order
@@ -11850,6 +12683,13 @@ Scheduler::Register()
 								  "handle_q", NULL, WRITE, D_FULLDEBUG,
 								  true /* force authentication */ );
 
+	// Job updates from shadows.  Like QMGMT_WRITE_CMD, the handler
+	// checks that the sender may modify the job.
+	daemonCore->Register_CommandWithPayload( UPDATE_JOB_ATTRS, "UPDATE_JOB_ATTRS",
+								  (CommandHandler)&handle_update_job_attrs,
+								  "handle_update_job_attrs", NULL, WRITE, D_FULLDEBUG,
+								  true /* force authentication */ );
+
 	daemonCore->Register_Command( DUMP_STATE, "DUMP_STATE",
 								  (CommandHandlercpp)&Scheduler::dumpState,
 								  "dumpState", this, READ  );
@@ -12001,27 +12841,28 @@ Scheduler::RegisterTimers()
 
 
 extern "C" {
+/* This must be a strict weak ordering, because PrioRecIndex keeps its
+ * records in std::sets sorted with it.  A pre/post prio of INT_MIN
+ * means the job does not have one, which ranks it below any job that
+ * does.
+ */
 int
 prio_compar(prio_rec* a, prio_rec* b)
 {
 	 /* compare submitted job preprio's: higher values have more priority */
 	 /* Typically used to prioritize entire DAG jobs over other DAG jobs */
-	 if (a->pre_job_prio1 > INT_MIN && b->pre_job_prio1 > INT_MIN ) { 
-	      if( a->pre_job_prio1 < b->pre_job_prio1 ) {
+	 if( a->pre_job_prio1 < b->pre_job_prio1 ) {
 		  return 1;
-              }
-	      if( a->pre_job_prio1 > b->pre_job_prio1 ) {
+	 }
+	 if( a->pre_job_prio1 > b->pre_job_prio1 ) {
 		  return -1;
-	      }
 	 }
 		 
-	 if( a->pre_job_prio2 > INT_MIN && b->pre_job_prio2 > INT_MIN ) {
-	      if( a->pre_job_prio2 < b->pre_job_prio2 ) {
+	 if( a->pre_job_prio2 < b->pre_job_prio2 ) {
 		  return 1;
-	      }
-	      if( a->pre_job_prio2 > b->pre_job_prio2 ) {
+	 }
+	 if( a->pre_job_prio2 > b->pre_job_prio2 ) {
 		  return -1;
-	      }
 	 }
 	 
 	 /* compare job priorities: higher values have more priority */
@@ -12034,22 +12875,18 @@ prio_compar(prio_rec* a, prio_rec* b)
 	 
 	 /* compare submitted job postprio's: higher values have more priority */
 	 /* Typically used to prioritize entire DAG jobs over other DAG jobs */
-	 if( a->post_job_prio1 > INT_MIN && b->post_job_prio1 > INT_MIN ) {
-	      if( a->post_job_prio1 < b->post_job_prio1 ) {
+	 if( a->post_job_prio1 < b->post_job_prio1 ) {
 		  return 1;
-	      }
-	      if( a->post_job_prio1 > b->post_job_prio1 ) {
+	 }
+	 if( a->post_job_prio1 > b->post_job_prio1 ) {
 		  return -1;
-	      }
 	 }
 	 
-	 if( a->post_job_prio2 > INT_MIN && b->post_job_prio2 > INT_MIN ) {
-	      if( a->post_job_prio2 < b->post_job_prio2 ) {
+	 if( a->post_job_prio2 < b->post_job_prio2 ) {
 		  return 1;
-	      }
-	      if( a->post_job_prio2 > b->post_job_prio2 ) {
+	 }
+	 if( a->post_job_prio2 > b->post_job_prio2 ) {
 		  return -1;
-	      }
 	 }
 	      
 	 /* here,updown priority and job_priority are both equal */
@@ -12101,6 +12938,10 @@ void Scheduler::reconfig() {
 		WalkJobQueue( (int(*)(ClassAd *))clear_autocluster_id );
 	}
 
+		// which jobs are runnable, and their autoclusters, may depend
+		// on the configuration, so don't trust the incremental updates
+	DirtyPrioRecArray();
+
 	timeout();
 
 		// The following use of param() is ok, despite the warning at the
@@ -12889,7 +13730,9 @@ Scheduler::sendAlives()
 				DelMrec( mrec );
 				jobExitCode( srec->job_id, JOB_SHOULD_REQUEUE );
 				srec->exit_already_handled = true;
-				daemonCore->Send_Signal( srec->pid, SIGKILL );
+				if( !signalMultiJobShadow( srec->pid, SIGKILL, srec->job_id ) ) {
+					daemonCore->Send_Signal( srec->pid, SIGKILL );
+				}
 			}
 		}
 	}
@@ -14585,6 +15428,18 @@ private:
 void
 Scheduler::sendSignalToShadow(pid_t pid,int sig,PROC_ID proc)
 {
+	if( signalMultiJobShadow(pid,sig,proc) ) {
+			// The shadow is running other jobs too, so it gets told
+			// which job the signal is meant for over its stdin pipe.
+		shadow_rec *srec = FindSrecByProcID( proc );
+		if( srec && srec->pid == pid &&
+			sig != DC_SIGSUSPEND && sig != DC_SIGCONTINUE )
+		{
+			srec->preempted = TRUE;
+		}
+		return;
+	}
+
 	classy_counted_ptr<DCShadowKillMsg> msg = new DCShadowKillMsg(pid,sig,proc);
 	daemonCore->Send_Signal_nonblocking(msg.get());
 
@@ -14831,6 +15686,100 @@ Scheduler::finishRecycleShadow(shadow_rec *srec)
 	delete stream;
 }
 
+int
+Scheduler::ShadowJobExit(int /*cmd*/, Stream *stream)
+{
+		// This is called by a shadow running more than one job when
+		// one of them is done.  We do what we would do if that job
+		// had its own shadow and the shadow had just exited.
+	int shadow_pid = 0;
+	PROC_ID job_id;
+	int exited = 0;
+	int exit_reason = 0;
+	Sock *sock = (Sock *)stream;
+
+		// force authentication
+	sock->decode();
+	if( !sock->triedAuthentication() ) {
+		CondorError errstack;
+		if( ! SecMan::authenticate_sock(sock, WRITE, &errstack) ||
+			! sock->getFullyQualifiedUser() )
+		{
+			dprintf( D_ALWAYS,
+					 "ShadowJobExit(): authentication failed: %s\n", 
+					 errstack.getFullText().c_str() );
+			return FALSE;
+		}
+	}
+
+	stream->decode();
+	if( !stream->get( shadow_pid ) ||
+		!stream->get( job_id.cluster ) ||
+		!stream->get( job_id.proc ) ||
+		!stream->get( exited ) ||
+		!stream->get( exit_reason ) ||
+		!stream->end_of_message() )
+	{
+		dprintf(D_ALWAYS,
+			"ShadowJobExit() failed to receive job exit reason from shadow\n");
+		return FALSE;
+	}
+
+	int ok = 0;
+	shadow_rec *srec = FindSrecByProcID( job_id );
+	if( !srec || srec->pid != shadow_pid ||
+		multiJobShadows.find(shadow_pid) == multiJobShadows.end() )
+	{
+		dprintf(D_ALWAYS,
+				"ShadowJobExit() called by shadow pid %d for job %d.%d, "
+				"which it is not running\n",
+				shadow_pid, job_id.cluster, job_id.proc);
+	}
+	else {
+			// verify that whoever is running this command is either
+			// the queue super user or the owner of the job
+		char const *cmd_user = sock->getOwner();
+		std::string job_owner = multiJobShadows[shadow_pid].owner;
+		if( !OwnerCheck2(NULL,cmd_user,job_owner.c_str()) ) {
+			dprintf(D_ALWAYS,
+					"ShadowJobExit() called by %s failed authorization check!\n",
+					cmd_user ? cmd_user : "(unauthenticated)");
+		}
+		else {
+			ok = 1;
+		}
+	}
+
+	stream->encode();
+	if( !stream->put( ok ) || !stream->end_of_message() ) {
+		dprintf(D_ALWAYS,
+			"ShadowJobExit() failed to send reply to shadow pid %d\n",
+			shadow_pid);
+	}
+	if( !ok ) {
+		return FALSE;
+	}
+
+	dprintf(D_ALWAYS,
+			"Shadow pid %d reports that job %d.%d %s %d\n",
+			shadow_pid, job_id.cluster, job_id.proc,
+			exited ? "exited with status" : "was killed by signal",
+			exited ? exit_reason : SIGKILL);
+
+		// turn it into the exit status the shadow would have had if it
+		// had only been running this one job
+	int status;
+	if( exited ) {
+		status = (exit_reason & 0xff) << 8;
+	}
+	else {
+		status = SIGKILL;
+	}
+	shadow_job_exit( srec, status );
+
+	return TRUE;
+}
+
 int
 Scheduler::FindGManagerPid(PROC_ID job_id)
 {
@@ -95,6 +95,11 @@ void ScheddStatistics::Init(int fOtherPool)
    JobsCompletedRuntimes.set_levels(lifes, COUNTOF(lifes));
    JobsBadputRuntimes.set_levels(lifes, COUNTOF(lifes));
 
+   static const int64_t xacts[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+   JobQueueTransactionsPerSync.set_levels(xacts, COUNTOF(xacts));
+   static const int64_t millisecs[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+   JobQueueCommitLatency.set_levels(millisecs, COUNTOF(millisecs));
+
    Clear();
    // default window size to 1 quantum, we may set it to something else later.
    if ( ! this->RecentWindowQuantum) this->RecentWindowQuantum = 1;
@@ -159,18 +164,22 @@ void ScheddStatistics::Init(int fOtherPool)
       SCHEDD_STATS_ADD_RECENT(Pool, ShadowsRecycled,           IF_VERBOSEPUB);
       SCHEDD_STATS_ADD_RECENT(Pool, ShadowsReconnections,      IF_VERBOSEPUB);
 
+      SCHEDD_STATS_ADD_RECENT(Pool, JobQueueSyncs,               IF_BASICPUB | IF_NONZERO);
+      SCHEDD_STATS_ADD_RECENT(Pool, JobQueueTransactionsPerSync, IF_BASICPUB | IF_NONZERO);
+      SCHEDD_STATS_ADD_RECENT(Pool, JobQueueCommitLatency,       IF_BASICPUB | IF_NONZERO);
+
       SCHEDD_STATS_ADD_VAL(Pool, ShadowsRunning,               IF_BASICPUB);
       SCHEDD_STATS_PUB_PEAK(Pool, ShadowsRunning,              IF_BASICPUB);
 
       extern stats_entry_probe<double> build_priorec_runtime;
       extern stats_entry_probe<double> build_priorec_mark_runtime;
       extern stats_entry_probe<double> build_priorec_walk_runtime;
-      extern stats_entry_probe<double> build_priorec_sort_runtime;
+      extern stats_entry_probe<double> build_priorec_update_runtime;
       extern stats_entry_probe<double> build_priorec_sweep_runtime;
       Pool.AddProbe("SCBuildPrioRec",       &build_priorec_runtime,      "SCBuildPrioRec", IF_VERBOSEPUB | IF_RT_SUM);
       Pool.AddProbe("SCBuildPrioRec_mark",  &build_priorec_mark_runtime, "SCBuildPrioRec_mark", IF_VERBOSEPUB | IF_RT_SUM);
       Pool.AddProbe("SCBuildPrioRec_walk",  &build_priorec_walk_runtime, "SCBuildPrioRec_walk", IF_VERBOSEPUB | IF_RT_SUM);
-      Pool.AddProbe("SCBuildPrioRec_sort",  &build_priorec_sort_runtime, "SCBuildPrioRec_sort", IF_VERBOSEPUB | IF_RT_SUM);
+      Pool.AddProbe("SCBuildPrioRec_update", &build_priorec_update_runtime, "SCBuildPrioRec_update", IF_VERBOSEPUB | IF_RT_SUM);
       Pool.AddProbe("SCBuildPrioRec_sweep", &build_priorec_sweep_runtime, "SCBuildPrioRec_sweep", IF_VERBOSEPUB | IF_RT_SUM);
    //SCHEDD_STATS_PUB_DEBUG(Pool, JobsSubmitted,  IF_BASICPUB);
    //SCHEDD_STATS_PUB_DEBUG(Pool, JobsStarted,  IF_BASICPUB);
@@ -80,6 +80,11 @@ typedef struct ScheddStatistics {
    //stats_entry_recent<int> ShadowExceptions;     // number of times shadows have excepted
    stats_entry_recent<int> ShadowsReconnections; // number of times shadows have reconnected
 
+   // job queue group commit (SCHEDD_JOB_QUEUE_GROUP_COMMIT)
+   stats_entry_recent<int> JobQueueSyncs;                        // fsyncs shared by grouped commits
+   stats_entry_recent_histogram<int64_t> JobQueueTransactionsPerSync;
+   stats_entry_recent_histogram<int64_t> JobQueueCommitLatency;  // milliseconds from commit until on disk
+
    stats_entry_recent_histogram<int64_t> JobsCompletedSizes;
    stats_entry_recent_histogram<int64_t> JobsBadputSizes;
    stats_entry_recent_histogram<time_t> JobsCompletedRuntimes;
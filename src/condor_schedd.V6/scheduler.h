@@ -112,6 +112,28 @@ struct shadow_rec
 	~shadow_rec();
 }; 
 
+	// A shadow process that runs more than one job at a time (see
+	// MAX_JOBS_PER_SHADOW).  Each of its jobs still has its own
+	// shadow_rec, all with the same pid.  New jobs are sent to it
+	// down its stdin, which we keep open for as long as we might want
+	// to give it more work.  The shadow may be blocked on us while
+	// handling a message, so we never wait for it to read one: what
+	// doesn't fit in the pipe waits in stdin_buf until it is writable.
+struct multi_job_shadow_rec
+{
+	int				pid;
+	std::string		owner;
+	int				num_jobs;
+	int				stdin_pipe;		// nonblocking write end, -1 once closed
+	std::string		stdin_buf;		// messages not yet written to stdin_pipe
+	size_t			stdin_offset;	// how much of stdin_buf has been written
+	bool			stdin_registered;	// waiting for room in stdin_pipe
+	time_t			expires;		// no new jobs after this (0 = never)
+	time_t			idle_since;		// when num_jobs dropped to 0
+
+	multi_job_shadow_rec();
+};
+
 struct OwnerData {
   char* Name;
   int JobsRunning;
@@ -232,6 +254,73 @@ struct GridJobCounts {
 	unsigned int UnmanagedGridJobs;
 };
 
+struct JobIdLess {
+	bool operator()( PROC_ID const &a, PROC_ID const &b ) const {
+		return a.cluster < b.cluster ||
+			( a.cluster == b.cluster && a.proc < b.proc );
+	}
+};
+
+	// What one job adds to the schedd's job counts; see compute_job_counts().
+	// With SCHEDD_INCREMENTAL_JOB_COUNTS, the schedd remembers this for
+	// every job, so that the job can be taken back out of the totals
+	// when it changes or leaves the queue, so it is kept small.
+struct JobCountContribution {
+	JobCountContribution();
+	JobCountContribution(const JobCountContribution & src);
+	~JobCountContribution();
+	JobCountContribution & operator=(const JobCountContribution & src);
+	bool Counted;		// false if the job is not counted at all
+	int Owner;			// submitter (as in OwnerData::Name), interned
+						// in Scheduler::m_job_count_owners
+	int JobsIdle;
+	int JobsRunning;
+	int JobsHeld;
+	int JobsRemoved;
+	int WeightedJobsIdle;
+	bool HasPrio;		// JobPrio goes into OwnerData::PrioSet
+	int Prio;
+	int SchedUniverseJobsIdle;
+	int SchedUniverseJobsRunning;
+	int LocalUniverseJobsIdle;
+	int LocalUniverseJobsRunning;
+	int DedicatedCluster;	// idle parallel cluster to schedule, or 0
+	bool IsRunning;		// counted in the running job statistics
+	UserIdentity *GridUser;	// grid universe jobs only, else NULL
+	int GridJobs;
+	int UnmanagedGridJobs;
+};
+
+	// The counts of one submitter, before they go into OwnerData.
+struct OwnerJobCounts {
+	OwnerJobCounts() : Jobs(0), JobsIdle(0), JobsHeld(0), WeightedJobsIdle(0) { }
+	bool operator==(const OwnerJobCounts & rhs) const;
+	int Jobs;
+	int JobsIdle;
+	int JobsHeld;
+	int WeightedJobsIdle;
+	std::map<int,int> Prios;	// number of idle jobs at each JobPrio
+};
+
+	// The sum of the JobCountContributions of all jobs in the queue.
+	// Grid jobs are summed in Scheduler::GridJobOwners.
+struct JobCountTotals {
+	JobCountTotals() { clear(); }
+	void clear();
+	int JobsTotalAds;
+	int JobsIdle;
+	int JobsRunning;
+	int JobsHeld;
+	int JobsRemoved;
+	int SchedUniverseJobsIdle;
+	int SchedUniverseJobsRunning;
+	int LocalUniverseJobsIdle;
+	int LocalUniverseJobsRunning;
+	std::map<std::string,OwnerJobCounts> Owners;
+	std::map<int,int> DedicatedClusters;	// number of jobs naming each
+	std::set<PROC_ID,JobIdLess> RunningJobs;
+};
+
 enum MrecStatus {
     M_UNCLAIMED,
 	M_STARTD_CONTACT_LIMBO,  // after contacting startd; before recv'ing reply
@@ -338,11 +427,21 @@ class Scheduler : public Service
 	void			send_all_jobs_prioritized(ReliSock*, struct sockaddr_in*);
 
 	friend	int		NewProc(int cluster_id);
+	friend	void	NewProcAd(int cluster_id, int proc_id);
 	friend	int		count_a_job(ClassAd *);
+	friend	bool	compute_job_counts(ClassAd *, JobCountContribution &);
 	friend	void	job_prio(ClassAd *);
 	friend  int		find_idle_local_jobs(ClassAd *);
 	friend	int		updateSchedDInterval( ClassAd* );
     friend  void    add_shadow_birthdate(int cluster, int proc, bool is_reconnect);
+		// job queue group commit statistics (see qmgmt.cpp)
+	void			JobQueueSynced( int transactions ) {
+		stats.JobQueueSyncs += 1;
+		stats.JobQueueTransactionsPerSync += (int64_t)transactions;
+	}
+	void			JobQueueCommitDurable( double latency_ms ) {
+		stats.JobQueueCommitLatency += (int64_t)latency_ms;
+	}
 	void			display_shadow_recs();
 	int				actOnJobs(int, Stream *);
 	void            enqueueActOnJobMyself( PROC_ID job_id, JobAction action, bool notify, bool log );
@@ -360,6 +459,7 @@ class Scheduler : public Service
 	void			addCronTabClusterId( int );
 	int				RecycleShadow(int cmd, Stream *stream);
 	void			finishRecycleShadow(shadow_rec *srec);
+	int				ShadowJobExit(int cmd, Stream *stream);
 
 	int				requestSandboxLocation(int mode, Stream* s);
 	int			FindGManagerPid(PROC_ID job_id);
@@ -380,6 +480,9 @@ class Scheduler : public Service
 	shadow_rec*		FindSrecByProcID(PROC_ID);
 	void			RemoveShadowRecFromMrec(shadow_rec*);
 	void            sendSignalToShadow(pid_t pid,int sig,PROC_ID proc);
+		// If pid is a shadow running more than one job, pass the
+		// signal on to the given job's part of it and return true.
+	bool			signalMultiJobShadow(int pid, int sig, PROC_ID proc);
 	int				AlreadyMatched(PROC_ID*);
 	void			ExpediteStartJobs();
 	void			StartJobs();
@@ -587,6 +690,23 @@ private:
 	int				LocalUniverseJobsIdle;
 	int				LocalUniverseJobsRunning;
 
+		// The job counts above, and those in Owners, are published
+		// from m_job_totals by count_jobs().  With
+		// SCHEDD_INCREMENTAL_JOB_COUNTS, m_job_counts holds what each
+		// job adds to the totals, so that only the jobs that changed
+		// need to be counted again.
+	JobCountTotals	m_job_totals;
+	std::map<PROC_ID,JobCountContribution,JobIdLess> m_job_counts;
+		// the submitter names that JobCountContribution::Owner
+		// indexes; only emptied along with m_job_counts
+	std::vector<std::string> m_job_count_owners;
+	std::map<std::string,int> m_job_count_owner_ids;
+	int				intern_job_count_owner(const char *owner);
+	bool			m_incremental_job_counts;
+	bool			m_job_counts_valid;
+	int				m_job_count_check_interval;
+	int				m_job_count_cycles;
+
     // generic statistics pool for scheduler, in schedd_stats.h
     ScheddStatistics stats;
 	ScheddOtherStatsMgr OtherPoolStats;
@@ -606,6 +726,11 @@ private:
 	int				jobThrottleNextJobDelay;	// used by jobThrottle()
 
 	int				shadowReaperId; // daemoncore reaper id for shadows
+
+		// shadow processes running more than one job, by pid
+	std::map<int, multi_job_shadow_rec> multiJobShadows;
+	int				MaxJobsPerShadow;
+	int				multiJobShadowIdleTid;
 //	int 				dirtyNoticeId;
 //	int 				dirtyNoticeInterval;
 
@@ -668,6 +793,11 @@ private:
 
 	// utility functions
 	int				count_jobs();
+	void			update_job_counts();
+	void			count_all_jobs();
+	void			recount_job(PROC_ID job_id);
+	void			add_job_counts(PROC_ID job_id, const JobCountContribution & counts, int sign);
+	void			check_job_counts();
 	bool			fill_submitter_ad(ClassAd & pAd, int owner_num, int flock_level=-1); 
     int             make_ad_list(ClassAdList & ads, ClassAd * pQueryAd=NULL);
     int             command_query_ads(int, Stream* stream);
@@ -678,6 +808,7 @@ private:
 	void   			check_claim_request_timeouts( void );
 	int				insert_owner(char const*);
 	void			child_exit(int, int);
+	void			shadow_job_exit(shadow_rec *srec, int status);
 	void			scheduler_univ_job_exit(int pid, int status, shadow_rec * srec);
 	void			scheduler_univ_job_leave_queue(PROC_ID job_id, int status, ClassAd *ad);
 	void			clean_shadow_recs();
@@ -741,7 +872,17 @@ private:
 										ArgList const &args,
 										Env const *env, 
 										const char* name, bool is_dc,
-										bool wants_pipe, bool want_udp );
+										bool wants_pipe, bool want_udp,
+										bool keep_pipe = false );
+	bool			spawnMultiJobShadow( shadow_rec* srec, const char* path,
+										 ArgList const &args, bool want_udp );
+	multi_job_shadow_rec* findMultiJobShadow( char const *owner );
+	bool			writeToMultiJobShadow( multi_job_shadow_rec *mjs,
+										   MyString const &msg );
+	bool			flushMultiJobShadowStdin( multi_job_shadow_rec *mjs );
+	int				multiJobShadowStdinHandler( int pipe_end );
+	void			closeMultiJobShadowStdin( multi_job_shadow_rec *mjs );
+	void			closeIdleMultiJobShadows();
 	void			check_zombie(int, PROC_ID*);
 	void			kill_zombie(int, PROC_ID*);
 	int				is_alive(shadow_rec* srec);
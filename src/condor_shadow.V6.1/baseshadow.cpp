@@ -36,7 +36,6 @@
 #include <math.h>
 
 // these are declared static in baseshadow.h; allocate space here
-WriteUserLog BaseShadow::uLog;
 BaseShadow* BaseShadow::myshadow_ptr = NULL;
 
 
@@ -72,6 +71,7 @@ BaseShadow::BaseShadow() {
 	m_cleanup_retry_tid = -1;
 	m_cleanup_retry_delay = 30;
 	m_RunAsNobody = false;
+	m_exited = false;
 }
 
 BaseShadow::~BaseShadow() {
@@ -155,6 +155,9 @@ BaseShadow::baseInit( ClassAd *job_ad, const char* schedd_addr, const char *xfer
 
 		// Make sure we've got enough swap space to run
 	checkSwap();
+	if( hasExited() ) {
+		return;
+	}
 
 	// handle system calls with Owner's privilege
 // XXX this belong here?  We'll see...
@@ -210,9 +213,15 @@ BaseShadow::baseInit( ClassAd *job_ad, const char* schedd_addr, const char *xfer
 		// in order to handle the case of the job going on hold as a
 		// result of failure in initUserLog().
 	initUserLog();
+	if( hasExited() ) {
+		return;
+	}
 
 		// change directory; hold on failure
 	if ( cdToIwd() == -1 ) {
+		if( hasExited() ) {
+			return;
+		}
 		EXCEPT("Could not cd to initial working directory");
 	}
 
@@ -224,8 +233,12 @@ BaseShadow::baseInit( ClassAd *job_ad, const char* schedd_addr, const char *xfer
 		if (pending == TRUE) {
 			// If the classad of this job "thinks" that this job should be
 			// finished already, let's enact that belief.
-			// This function does not return.
+			// This function does not return, unless we are a
+			// multi-job shadow.
 			this->terminateJob(US_TERMINATE_PENDING);
+			if( hasExited() ) {
+				return;
+			}
 		}
 	}
 
@@ -264,6 +277,8 @@ BaseShadow::baseInit( ClassAd *job_ad, const char* schedd_addr, const char *xfer
 	// or not
 void BaseShadow::startdClaimedCB(DCMsgCallback *) {
 
+	switchShadow( this );
+
 	// We've claimed the startd, the following kicks off the
 	// activation of the claim, and runs the job
 	this->spawn();
@@ -328,7 +343,8 @@ BaseShadow::shutDown( int reason )
 {
 		// exit now if there is no job ad
 	if ( !getJobAd() ) {
-		DC_Exit( reason );
+		exitJob( reason );
+		return;
 	}
 	
 		// if we are being called from the exception handler, return
@@ -353,6 +369,26 @@ BaseShadow::shutDown( int reason )
 }
 
 
+void
+BaseShadow::exitJob( int reason )
+{
+	if( !multiJobShadow ) {
+			// does not return
+		DC_Exit( reason );
+	}
+
+		// we may get here more than once on the way out (e.g. from
+		// holdJob() and then again from the code that called it),
+		// but the schedd only wants to hear about it once
+	if( m_exited ) {
+		return;
+	}
+	m_exited = true;
+
+	multiJobShadowExit( this, reason );
+}
+
+
 int
 BaseShadow::nextReconnectDelay( int attempts )
 {
@@ -378,7 +414,7 @@ BaseShadow::reconnectFailed( const char* reason )
 	logReconnectFailedEvent( reason );
 
 		// does not return
-	DC_Exit( JOB_SHOULD_REQUEUE );
+	exitJob( JOB_SHOULD_REQUEUE );
 }
 
 
@@ -390,7 +426,8 @@ BaseShadow::holdJob( const char* reason, int hold_reason_code, int hold_reason_s
 
 	if( ! jobAd ) {
 		dprintf( D_ALWAYS, "In HoldJob() w/ NULL JobAd!" );
-		DC_Exit( JOB_SHOULD_HOLD );
+		exitJob( JOB_SHOULD_HOLD );
+		return;
 	}
 
 		// cleanup this shadow (kill starters, etc)
@@ -418,7 +455,7 @@ BaseShadow::holdJobAndExit( const char* reason, int hold_reason_code, int hold_r
 	holdJob(reason,hold_reason_code,hold_reason_subcode);
 
 	// finally, exit and tell the schedd what to do
-	DC_Exit( JOB_SHOULD_HOLD );
+	exitJob( JOB_SHOULD_HOLD );
 }
 
 void
@@ -444,7 +481,8 @@ BaseShadow::mockTerminateJob( MyString exit_reason,
 	if( ! jobAd ) {
 		dprintf(D_ALWAYS, "BaseShadow::mockTerminateJob(): NULL JobAd! "
 			"Holding Job!");
-		DC_Exit( JOB_SHOULD_HOLD );
+		exitJob( JOB_SHOULD_HOLD );
+		return;
 	}
 
 	// Insert the various exit attributes into our job ad.
@@ -504,7 +542,7 @@ void BaseShadow::removeJob( const char* reason )
 	this->removeJobPre(reason);
 	
 	// does not return.
-	DC_Exit( JOB_SHOULD_REMOVE );
+	exitJob( JOB_SHOULD_REMOVE );
 }
 
 void
@@ -517,7 +555,8 @@ BaseShadow::retryJobCleanup( void )
 		        "(SHADOW_MAX_JOB_CLEANUP_RETRIES=%d) reached"
 		        "; Forcing job requeue!\n",
 		        m_max_cleanup_retries);
-		DC_Exit(JOB_SHOULD_REQUEUE);
+		exitJob(JOB_SHOULD_REQUEUE);
+		return;
 	}
 	ASSERT(m_cleanup_retry_tid == -1);
 	m_cleanup_retry_tid = daemonCore->Register_Timer(m_cleanup_retry_delay, 0,
@@ -532,6 +571,7 @@ BaseShadow::retryJobCleanup( void )
 int
 BaseShadow::retryJobCleanupHandler( void )
 {
+	switchShadow( this );
 	m_cleanup_retry_tid = -1;
 	dprintf(D_ALWAYS, "Retrying job cleanup, calling terminateJob()\n");
 	terminateJob();
@@ -602,7 +642,8 @@ BaseShadow::terminateJob( update_style_t kind ) // has a default argument of US_
 			// email the user, but get values from jobad
 		emailTerminateEvent( reason, kind );
 
-		DC_Exit( reason );
+		exitJob( reason );
+		return;
 	}
 
 	// the default path when kind == US_NORMAL
@@ -696,7 +737,7 @@ BaseShadow::terminateJob( update_style_t kind ) // has a default argument of US_
 	}
 
 	// does not return.
-	DC_Exit( reason );
+	exitJob( reason );
 }
 
 
@@ -713,7 +754,8 @@ BaseShadow::evictJob( int reason )
 
 	if( ! jobAd ) {
 		dprintf( D_ALWAYS, "In evictJob() w/ NULL JobAd!" );
-		DC_Exit( reason );
+		exitJob( reason );
+		return;
 	}
 
 		// cleanup this shadow (kill starters, etc)
@@ -736,7 +778,7 @@ BaseShadow::evictJob( int reason )
 	}
 
 		// does not return.
-	DC_Exit( reason );
+	exitJob( reason );
 }
 
 
@@ -775,7 +817,7 @@ BaseShadow::requeueJob( const char* reason )
 	}
 
 		// does not return.
-	DC_Exit( JOB_SHOULD_REQUEUE );
+	exitJob( JOB_SHOULD_REQUEUE );
 }
 
 
@@ -834,6 +876,10 @@ void BaseShadow::initUserLog()
 			dprintf( D_ALWAYS, "%s\n",hold_reason.Value());
 			holdJobAndExit(hold_reason.Value(),
 					CONDOR_HOLD_CODE_UnableToInitUserLog,0);
+			if( hasExited() ) {
+					// a multi-job shadow keeps going with its other jobs
+				return;
+			}
 				// holdJobAndExit() should not return, but just in case it does
 				// EXCEPT
 			EXCEPT("Failed to initialize user log: %s",hold_reason.Value());
@@ -1203,7 +1249,7 @@ BaseShadow::checkSwap( void )
 
 	if( free_swap < reserved_swap ) {
 		dprintf( D_ALWAYS, "Not enough reserved swap space\n" );
-		DC_Exit( JOB_NO_MEM );
+		exitJob( JOB_NO_MEM );
 	}
 }	
 
@@ -1239,7 +1285,8 @@ BaseShadow::log_except(const char *msg)
 		event.sent_bytes = 0.0;
 	}
 
-	if (!exception_already_logged && !uLog.writeEventNoFsync (&event,NULL))
+	if (!exception_already_logged && BaseShadow::myshadow_ptr &&
+		!BaseShadow::myshadow_ptr->uLog.writeEventNoFsync (&event,NULL))
 	{
 		::dprintf (D_ALWAYS, "Unable to log ULOG_SHADOW_EXCEPTION event\n");
 	}
@@ -1479,6 +1526,8 @@ display_dprintf_header(char **buf,int *bufpos,int *buflen)
 		mypid = daemonCore->getpid();
 	}
 
+		// in a multi-job shadow, this is the job whose callback
+		// we are in (see switchShadow())
 	if (Shadow) {
 		mycluster = Shadow->getCluster();
 		myproc = Shadow->getProc();
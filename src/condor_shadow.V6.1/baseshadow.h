@@ -219,6 +219,19 @@ class BaseShadow : public Service
 		*/
 	void evictJob( int reason );
 
+		/** We are done with this job; tell the schedd what to do
+			with it.  Normally this exits the shadow with the given
+			status and does not return.  If this shadow is running
+			more than one job (see the --multi-job option), the
+			reason is reported to the schedd instead, this object is
+			deleted once we are back in DaemonCore, and we return.
+			@param reason The exit status (JOB_BLAH_BLAH)
+		*/
+	void exitJob( int reason );
+
+		/// Has exitJob() been called for this job?
+	bool hasExited( void ) const { return m_exited; }
+
 		/** The total number of bytes sent over the network on
 			behalf of this job.
 			Each shadow class should override this function and
@@ -379,8 +392,9 @@ class BaseShadow : public Service
 			method to supply this information. */
 	virtual int exitCode( void ) = 0;
 
-		// make UserLog static so it can be accessed by EXCEPTION handler
-	static WriteUserLog uLog;
+		// not static, since a multi-job shadow has one per job; the
+		// EXCEPTION handler gets to it through myshadow_ptr
+	WriteUserLog uLog;
 
 	void evalPeriodicUserPolicy( void );
 
@@ -458,6 +472,8 @@ class BaseShadow : public Service
 	double reconnect_e_factor;
 	bool m_RunAsNobody;
 
+	bool m_exited;
+
 	// job parameters
 	int cluster;
 	int proc;
@@ -494,6 +510,20 @@ extern void dumpClassad( const char*, ClassAd*, int );
 // Returns false if no new job found.
 extern bool recycleShadow(int previous_job_exit_reason);
 
+// True if this shadow was started with --multi-job and gets the jobs
+// it runs from the schedd over its stdin.
+extern bool multiJobShadow;
+
+// Called by BaseShadow::exitJob() in a multi-job shadow to report the
+// exit reason of the given job to the schedd and get rid of it.
+extern void multiJobShadowExit(BaseShadow *shadow, int reason);
+
+// Make the given shadow the one that global functions (e.g. the
+// remote syscalls, the dprintf header and the EXCEPT handler) operate
+// on.  In a multi-job shadow, every DaemonCore callback that works on
+// behalf of one job calls this first; NULL means no job in particular.
+extern void switchShadow(BaseShadow *shadow);
+
 extern BaseShadow *Shadow;
 
 #endif
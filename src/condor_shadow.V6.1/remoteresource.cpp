@@ -733,6 +733,7 @@ RemoteResource::dprintfSelf( int debugLevel )
 int
 RemoteResource::attemptShutdownTimeout()
 {
+	switchShadow( shadow );
 	m_attempt_shutdown_tid = -1;
 	attemptShutdown();
 	return TRUE;
@@ -794,6 +795,7 @@ RemoteResource::handleSysCalls( Stream * /* sock */ )
 
 	syscall_sock = claim_sock;
 	thisRemoteResource = this;
+	switchShadow( shadow );
 
 	if (do_REMOTE_syscall() < 0) {
 		shadow->dprintf(D_SYSCALLS,"Shadow: do_REMOTE_syscall returned < 0\n");
@@ -2082,6 +2084,8 @@ RemoteResource::reconnect( void )
 void
 RemoteResource::attemptReconnect( void )
 {
+	switchShadow( shadow );
+
 		// now that the timer went off, clear out this variable so we
 		// don't get confused later.
 	next_reconnect_tid = -1;
@@ -2215,6 +2219,7 @@ RemoteResource::getFileTransferStatus(FileTransferStatus &upload_status,FileTran
 int
 RemoteResource::transferStatusUpdateCallback(FileTransfer *transobject)
 {
+	switchShadow( shadow );
 	ASSERT(jobAd);
 
 	FileTransfer::FileTransferInfo info = transobject->GetInfo();
@@ -2533,6 +2538,7 @@ RemoteResource::updateX509Proxy(const char * filename)
 void 
 RemoteResource::checkX509Proxy( void )
 {
+	switchShadow( shadow );
 	if( state != RR_EXECUTING ) {
 		dprintf(D_FULLDEBUG,"checkX509Proxy() doing nothing, because resource is not in EXECUTING state.\n");
 		return;
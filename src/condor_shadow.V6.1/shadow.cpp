@@ -37,7 +37,9 @@ UniShadow::UniShadow() {
 
 UniShadow::~UniShadow() {
 	if ( remRes ) delete remRes;
-	daemonCore->Cancel_Command( SHADOW_UPDATEINFO );
+	if( !multiJobShadow ) {
+		daemonCore->Cancel_Command( SHADOW_UPDATEINFO );
+	}
 }
 
 
@@ -109,6 +111,9 @@ UniShadow::init( ClassAd* job_ad, const char* schedd_addr, const char *xfer_queu
 
 		// base init takes care of lots of stuff:
 	baseInit( job_ad, schedd_addr, xfer_queue_contact_info );
+	if( hasExited() ) {
+		return;
+	}
 
 		// we're only dealing with one host, so the rest is pretty
 		// trivial.  we can just lookup everything we need in the job
@@ -123,6 +128,13 @@ UniShadow::init( ClassAd* job_ad, const char* schedd_addr, const char *xfer_queu
 		// on the job's image size, cpu usage, etc.  Each kind of
 		// shadow implements it's own version of this to deal w/ it
 		// properly depending on parallel vs. serial jobs, etc. 
+		// Only starters older than 6.9.5 use this instead of the
+		// CONDOR_register_job_info syscall, and since the command
+		// can't tell us which job it is about, a multi-job shadow
+		// doesn't bother.
+	if( multiJobShadow ) {
+		return;
+	}
 	daemonCore->
 		Register_Command( SHADOW_UPDATEINFO, "SHADOW_UPDATEINFO",
 						  (CommandHandlercpp)&UniShadow::updateFromStarter, 
@@ -193,7 +205,7 @@ UniShadow::gracefulShutDown( void )
 			// there's no lease or it has already expired.
 			remRes->killStarter(true);
 		} else {
-			DC_Exit( JOB_SHOULD_REQUEUE );
+			exitJob( JOB_SHOULD_REQUEUE );
 		}
 	}
 }
@@ -270,7 +282,7 @@ void UniShadow::removeJob( const char* reason )
 	if ( iPrevExitReason != JOB_SHOULD_REMOVE && iPrevExitReason != -1)
 	{
 		// don't wait for final update b/c there isn't one.
-		DC_Exit( JOB_SHOULD_REMOVE );
+		exitJob( JOB_SHOULD_REMOVE );
 	}
 }
 
@@ -61,6 +61,8 @@ ShadowUserPolicy::getJobBirthday( )
 void
 ShadowUserPolicy::doAction( int action, bool is_periodic ) 
 {
+	switchShadow( shadow );
+
 	MyString reason;
 	int reason_code;
 	int reason_subcode;
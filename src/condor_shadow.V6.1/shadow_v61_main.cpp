@@ -31,6 +31,11 @@
 #include "dc_schedd.h"
 #include "spool_version.h"
 
+#include <map>
+#include <list>
+#include <vector>
+#include <algorithm>
+
 BaseShadow *Shadow = NULL;
 
 // settings we're given on the command-line
@@ -42,8 +47,30 @@ static int cluster = -1;
 static int proc = -1;
 static const char * xfer_queue_contact_info = NULL;
 bool sendUpdatesToSchedd = true;
+bool multiJobShadow = false;
 static time_t shadow_worklife_expires = 0;
 
+// state of a multi-job shadow: the jobs we are running, keyed by
+// cluster.proc, the ones that are done but not yet deleted, the exits
+// we still have to tell the schedd about, and our stdin from the schedd
+struct multi_job_exit {
+	int cluster;
+	int proc;
+	bool killed;
+	int reason;
+};
+static std::map< std::pair<int,int>, BaseShadow* > multiJobs;
+static std::vector<BaseShadow*> exitedJobs;
+static std::list<multi_job_exit> pendingJobExits;
+static int deleteExitedJobsTid = -1;
+static int reportJobExitsTid = -1;
+static const int REPORT_JOB_EXITS_RETRY_DELAY = 10;
+static int multiJobPipe = -1;
+static bool multiJobPipeClosed = false;
+static bool multiJobShuttingDown = false;
+static std::string multiJobPipeBuf;
+static ClassAd *multiJobAd = NULL;
+
 static void
 usage( int argc, char* argv[] )
 {
@@ -56,11 +83,16 @@ usage( int argc, char* argv[] )
 }
 
 
+static void reportMultiJobExcept();
+
 extern "C" {
 int
 ExceptCleanup(int, int, const char *buf)
 {
   BaseShadow::log_except(buf);
+  if( multiJobShadow ) {
+	  reportMultiJobExcept();
+  }
   return 0;
 }
 }
@@ -132,6 +164,11 @@ parseArgs( int argc, char *argv[] )
 			continue;
 		}
 
+		if (strcmp(opt, "--multi-job") == 0) {
+			multiJobShadow = true;
+			continue;
+		}
+
 			// the only other argument we understand is the
 			// filename we should read our ClassAd from, "-" for
 			// STDIN.  There's no further checking we need to do 
@@ -151,6 +188,14 @@ parseArgs( int argc, char *argv[] )
 		// And that might be it.
 		// The validation used to count arguments processed, which was
 		// easily fooled.
+
+		// a multi-job shadow gets its jobs from the schedd over
+		// STDIN and reports back to it when they are done
+	if( multiJobShadow && (!schedd_addr || !sendUpdatesToSchedd || job_ad_file) ) {
+		dprintf( D_ALWAYS, "ERROR: --multi-job requires a schedd address "
+				 "and no job ad file\n" );
+		usage(argc, argv);
+	}
 }
 
 
@@ -280,6 +325,11 @@ void startShadow( ClassAd *ad )
 	}
 
 	initShadow( ad );
+	if( Shadow->hasExited() ) {
+			// only a multi-job shadow gets here; the job is already
+			// done (e.g. it was put on hold)
+		return;
+	}
 
 	int wantClaiming = 0;
 	ad->LookupBool(ATTR_CLAIM_STARTD, wantClaiming);
@@ -341,6 +391,366 @@ int handleSignals(Service*,int sig)
 }
 
 
+void
+switchShadow( BaseShadow *shadow )
+{
+	if( !multiJobShadow ) {
+		return;
+	}
+	Shadow = shadow;
+	BaseShadow::myshadow_ptr = shadow;
+}
+
+
+static void
+checkMultiJobShadowDone()
+{
+	if( !multiJobs.empty() || !exitedJobs.empty() || !pendingJobExits.empty() ) {
+		return;
+	}
+	if( !multiJobPipeClosed && !multiJobShuttingDown ) {
+		return;
+	}
+	dprintf( D_ALWAYS, "No more jobs to run, exiting\n" );
+		// all of our jobs have been reported, so this status only
+		// matters if the schedd somehow still thinks we have one
+	DC_Exit( JOB_SHOULD_REQUEUE );
+}
+
+
+static void
+reportJobExits()
+{
+	reportJobExitsTid = -1;
+
+	while( !pendingJobExits.empty() ) {
+		multi_job_exit &job_exit = pendingJobExits.front();
+
+		DCSchedd schedd( schedd_addr );
+		MyString error_msg;
+		if( !schedd.shadowJobExit( job_exit.cluster, job_exit.proc,
+								   job_exit.killed, job_exit.reason,
+								   error_msg ) )
+		{
+			dprintf( D_ALWAYS, "Failed to report exit of job %d.%d to the "
+					 "schedd: %s\n", job_exit.cluster, job_exit.proc,
+					 error_msg.Value() );
+			if( multiJobShuttingDown ) {
+					// don't hang around; the schedd will hear about
+					// whatever is left when we exit
+				pendingJobExits.clear();
+				break;
+			}
+			reportJobExitsTid = daemonCore->Register_Timer(
+				REPORT_JOB_EXITS_RETRY_DELAY,
+				(TimerHandler)&reportJobExits,
+				"reportJobExits" );
+			return;
+		}
+		pendingJobExits.pop_front();
+	}
+
+	checkMultiJobShadowDone();
+}
+
+
+static void
+deleteExitedJobs()
+{
+	deleteExitedJobsTid = -1;
+
+	std::vector<BaseShadow*>::iterator it;
+	for( it = exitedJobs.begin(); it != exitedJobs.end(); it++ ) {
+		if( Shadow == *it ) {
+			Shadow = NULL;
+		}
+		if( BaseShadow::myshadow_ptr == *it ) {
+			BaseShadow::myshadow_ptr = NULL;
+		}
+		delete *it;
+	}
+	exitedJobs.clear();
+
+	checkMultiJobShadowDone();
+}
+
+
+static void
+queueJobExit( int job_cluster, int job_proc, bool killed, int reason )
+{
+	multi_job_exit job_exit;
+	job_exit.cluster = job_cluster;
+	job_exit.proc = job_proc;
+	job_exit.killed = killed;
+	job_exit.reason = reason;
+	pendingJobExits.push_back( job_exit );
+
+	if( reportJobExitsTid == -1 ) {
+		reportJobExits();
+	}
+}
+
+
+// An EXCEPT takes the whole process down, but only the job we were
+// working on at the time (if any) is to blame.  Tell the schedd now,
+// while we still can: that job failed with an exception, and the rest
+// are reported as though their shadow had been killed, which leaves
+// their claims around for a new shadow to reconnect to.
+static void
+reportMultiJobExcept()
+{
+	static bool reporting = false;
+	if( reporting ) {
+			// EXCEPT while reporting; the schedd hears about the
+			// rest when we exit
+		return;
+	}
+	reporting = true;
+
+	BaseShadow *culprit = BaseShadow::myshadow_ptr;
+	std::map< std::pair<int,int>, BaseShadow* >::iterator it;
+	for( it = multiJobs.begin(); it != multiJobs.end(); it++ ) {
+		multi_job_exit job_exit;
+		job_exit.cluster = it->first.first;
+		job_exit.proc = it->first.second;
+		if( it->second == culprit ) {
+			job_exit.killed = false;
+			job_exit.reason = JOB_EXCEPTION;
+		}
+		else {
+			job_exit.killed = true;
+			job_exit.reason = 0;
+		}
+		pendingJobExits.push_back( job_exit );
+	}
+
+	DCSchedd schedd( schedd_addr );
+	while( !pendingJobExits.empty() ) {
+		multi_job_exit &job_exit = pendingJobExits.front();
+		MyString error_msg;
+		if( !schedd.shadowJobExit( job_exit.cluster, job_exit.proc,
+								   job_exit.killed, job_exit.reason,
+								   error_msg ) )
+		{
+			dprintf( D_ALWAYS, "Failed to report exit of job %d.%d to the "
+					 "schedd: %s\n", job_exit.cluster, job_exit.proc,
+					 error_msg.Value() );
+		}
+		pendingJobExits.pop_front();
+	}
+}
+
+
+// returns false if we were already done with this job
+static bool
+removeMultiJob( BaseShadow *shadow )
+{
+	if( std::find(exitedJobs.begin(), exitedJobs.end(), shadow) !=
+		exitedJobs.end() )
+	{
+		return false;
+	}
+
+	std::pair<int,int> key( shadow->getCluster(), shadow->getProc() );
+	std::map< std::pair<int,int>, BaseShadow* >::iterator it;
+	it = multiJobs.find( key );
+	if( it != multiJobs.end() && it->second == shadow ) {
+		multiJobs.erase( it );
+	}
+
+		// we are probably somewhere deep inside this shadow's code,
+		// so wait until we are back in DaemonCore to delete it
+	exitedJobs.push_back( shadow );
+	if( deleteExitedJobsTid == -1 ) {
+		deleteExitedJobsTid = daemonCore->Register_Timer( 0,
+			(TimerHandler)&deleteExitedJobs,
+			"deleteExitedJobs" );
+	}
+	return true;
+}
+
+
+void
+multiJobShadowExit( BaseShadow *shadow, int reason )
+{
+	dprintf( D_ALWAYS, "Job %d.%d is done with exit reason %d\n",
+			 shadow->getCluster(), shadow->getProc(), reason );
+
+	if( removeMultiJob( shadow ) ) {
+		queueJobExit( shadow->getCluster(), shadow->getProc(), false, reason );
+	}
+}
+
+
+static void
+startMultiJob( ClassAd *ad )
+{
+	int job_cluster = -1;
+	int job_proc = -1;
+	ad->LookupInteger( ATTR_CLUSTER_ID, job_cluster );
+	ad->LookupInteger( ATTR_PROC_ID, job_proc );
+	std::pair<int,int> key( job_cluster, job_proc );
+	if( multiJobs.find(key) != multiJobs.end() ) {
+		dprintf( D_ALWAYS, "Already running job %d.%d, ignoring request "
+				 "to start it\n", job_cluster, job_proc );
+		delete ad;
+		return;
+	}
+
+	cluster = job_cluster;
+	proc = job_proc;
+	Shadow = NULL;
+	BaseShadow::myshadow_ptr = NULL;
+
+	startShadow( ad );
+
+	if( !Shadow->hasExited() ) {
+		multiJobs[key] = Shadow;
+	}
+}
+
+
+static void
+signalMultiJob( int job_cluster, int job_proc, int sig )
+{
+	std::map< std::pair<int,int>, BaseShadow* >::iterator it;
+	it = multiJobs.find( std::pair<int,int>(job_cluster, job_proc) );
+	if( it == multiJobs.end() ) {
+		dprintf( D_FULLDEBUG, "Ignoring signal %d for job %d.%d, which "
+				 "we are not running\n", sig, job_cluster, job_proc );
+		return;
+	}
+	BaseShadow *shadow = it->second;
+	switchShadow( shadow );
+
+	switch( sig ) {
+	case SIGUSR1:
+	case DC_SIGSUSPEND:
+	case DC_SIGCONTINUE:
+	case UPDATE_JOBAD:
+		handleSignals( NULL, sig );
+		break;
+	case SIGTERM:
+		shadow->gracefulShutDown();
+		break;
+	case SIGQUIT:
+		shadow->shutDown( JOB_NOT_CKPTED );
+		break;
+	case SIGKILL:
+			// we can't do anything more for it, just as if this were
+			// the only job in the shadow and the shadow was killed
+		dprintf( D_ALWAYS, "Job %d.%d was killed\n", job_cluster, job_proc );
+		if( removeMultiJob( shadow ) ) {
+			queueJobExit( job_cluster, job_proc, true, 0 );
+		}
+		break;
+	default:
+		dprintf( D_ALWAYS, "Ignoring unexpected signal %d for job %d.%d\n",
+				 sig, job_cluster, job_proc );
+		break;
+	}
+}
+
+
+static void
+handleMultiJobLine( std::string const &line )
+{
+	if( multiJobAd ) {
+			// in the middle of a START_JOB; this is a line of the
+			// job ad, same as readJobAd() expects
+		if( line == "***" ) {
+			ClassAd *ad = multiJobAd;
+			multiJobAd = NULL;
+			if( IsDebugVerbose(D_JOB) ) {
+				dPrintAd( D_JOB, *ad );
+			}
+			startMultiJob( ad );
+		}
+		else if( !line.empty() && line[0] != '#' &&
+				 !multiJobAd->Insert(line.c_str()) )
+		{
+			EXCEPT( "Failed to insert \"%s\" into ClassAd!", line.c_str() );
+		}
+		return;
+	}
+
+	int job_cluster = -1;
+	int job_proc = -1;
+	int arg = 0;
+	if( sscanf(line.c_str(), "START_JOB %d.%d %d",
+			   &job_cluster, &job_proc, &arg) == 3 )
+	{
+		dprintf( D_FULLDEBUG, "Reading job ClassAd for job %d.%d\n",
+				 job_cluster, job_proc );
+		is_reconnect = (arg != 0);
+		multiJobAd = new ClassAd;
+	}
+	else if( sscanf(line.c_str(), "SIGNAL %d.%d %d",
+					&job_cluster, &job_proc, &arg) == 3 )
+	{
+		signalMultiJob( job_cluster, job_proc, arg );
+	}
+	else {
+		dprintf( D_ALWAYS, "Ignoring unexpected message from schedd: %s\n",
+				 line.c_str() );
+	}
+}
+
+
+static int
+handleMultiJobPipe( Service *, int pipe_end )
+{
+		// nothing we read here is on behalf of any job we already have
+	switchShadow( NULL );
+
+	char buf[4096];
+	int bytes = daemonCore->Read_Pipe( pipe_end, buf, sizeof(buf) );
+	if( bytes < 0 && (errno == EINTR || errno == EAGAIN) ) {
+		return TRUE;
+	}
+	if( bytes <= 0 ) {
+			// the schedd has no more jobs for us; exit once the ones
+			// we have are done
+		dprintf( D_ALWAYS, "Schedd closed our STDIN\n" );
+		daemonCore->Close_Pipe( pipe_end );
+		multiJobPipe = -1;
+		multiJobPipeClosed = true;
+		if( multiJobAd ) {
+			dprintf( D_ALWAYS, "Discarding incomplete job ClassAd\n" );
+			delete multiJobAd;
+			multiJobAd = NULL;
+		}
+		checkMultiJobShadowDone();
+		return TRUE;
+	}
+
+	multiJobPipeBuf.append( buf, bytes );
+	size_t pos;
+	while( (pos = multiJobPipeBuf.find('\n')) != std::string::npos ) {
+		std::string line = multiJobPipeBuf.substr( 0, pos );
+		multiJobPipeBuf.erase( 0, pos + 1 );
+		handleMultiJobLine( line );
+	}
+	return TRUE;
+}
+
+
+static void
+initMultiJobShadow()
+{
+	multiJobPipe = daemonCore->Inherit_Pipe( fileno(stdin), false, true, false );
+	if( multiJobPipe == -1 ) {
+		EXCEPT( "Failed to inherit STDIN pipe from the schedd" );
+	}
+	if( daemonCore->Register_Pipe( multiJobPipe, "schedd pipe",
+								   (PipeHandler)&handleMultiJobPipe,
+								   "handleMultiJobPipe" ) == -1 )
+	{
+		EXCEPT( "Failed to register STDIN pipe from the schedd" );
+	}
+}
+
+
 
 void
 main_init(int argc, char *argv[])
@@ -359,18 +769,24 @@ main_init(int argc, char *argv[])
 							(ReaperHandler)&dummy_reaper,
 							"dummy_reaper",NULL);
 
+	parseArgs( argc, argv );
 
-		// register SIGUSR1 (condor_rm) for shutdown...
-	daemonCore->Register_Signal( SIGUSR1, "SIGUSR1", 
-		(SignalHandler)&handleSignals,"handleSignals");
-		// register UPDATE_JOBAD for qedit changes
-	daemonCore->Register_Signal( UPDATE_JOBAD, "UPDATE_JOBAD", 
-		(SignalHandler)&handleSignals,"handleSignals");
-		// handle daemoncore signals which are passed down
-	daemonCore->Register_Signal( DC_SIGSUSPEND, "DC_SIGSUSPEND", 
-		(SignalHandler)&handleSignals,"handleSignals");
-	daemonCore->Register_Signal( DC_SIGCONTINUE, "DC_SIGCONTINUE", 
-		(SignalHandler)&handleSignals,"handleSignals");
+	if( !multiJobShadow ) {
+			// a multi-job shadow gets these over its STDIN instead,
+			// along with which job they are meant for
+
+			// register SIGUSR1 (condor_rm) for shutdown...
+		daemonCore->Register_Signal( SIGUSR1, "SIGUSR1", 
+			(SignalHandler)&handleSignals,"handleSignals");
+			// register UPDATE_JOBAD for qedit changes
+		daemonCore->Register_Signal( UPDATE_JOBAD, "UPDATE_JOBAD", 
+			(SignalHandler)&handleSignals,"handleSignals");
+			// handle daemoncore signals which are passed down
+		daemonCore->Register_Signal( DC_SIGSUSPEND, "DC_SIGSUSPEND", 
+			(SignalHandler)&handleSignals,"handleSignals");
+		daemonCore->Register_Signal( DC_SIGCONTINUE, "DC_SIGCONTINUE", 
+			(SignalHandler)&handleSignals,"handleSignals");
+	}
 
 	int shadow_worklife = param_integer( "SHADOW_WORKLIFE", 3600 );
 	if( shadow_worklife > 0 ) {
@@ -384,10 +800,14 @@ main_init(int argc, char *argv[])
 		shadow_worklife_expires = 0;
 	}
 
-	parseArgs( argc, argv );
-
 	CheckSpoolVersion(SPOOL_MIN_VERSION_SHADOW_SUPPORTS,SPOOL_CUR_VERSION_SHADOW_SUPPORTS);
 
+	if( multiJobShadow ) {
+			// the schedd decides when we stop getting new jobs
+		initMultiJobShadow();
+		return;
+	}
+
 	ClassAd* ad = readJobAd();
 	if( ! ad ) {
 		EXCEPT( "Failed to read job ad!" );
@@ -396,23 +816,68 @@ main_init(int argc, char *argv[])
 	startShadow( ad );
 }
 
+// the shadows of a multi-job shadow may go away while we iterate over
+// them, so work from a copy
+static void
+getMultiJobs( std::vector<BaseShadow*> &shadows )
+{
+	std::map< std::pair<int,int>, BaseShadow* >::iterator it;
+	for( it = multiJobs.begin(); it != multiJobs.end(); it++ ) {
+		shadows.push_back( it->second );
+	}
+}
+
 void
 main_config()
 {
-	Shadow->config();
+	if( !multiJobShadow ) {
+		Shadow->config();
+		return;
+	}
+
+	std::vector<BaseShadow*> shadows;
+	getMultiJobs( shadows );
+	for( size_t i = 0; i < shadows.size(); i++ ) {
+		switchShadow( shadows[i] );
+		shadows[i]->config();
+	}
 }
 
 
 void
 main_shutdown_fast()
 {
-	Shadow->shutDown( JOB_NOT_CKPTED );
+	if( !multiJobShadow ) {
+		Shadow->shutDown( JOB_NOT_CKPTED );
+		return;
+	}
+
+	multiJobShuttingDown = true;
+	std::vector<BaseShadow*> shadows;
+	getMultiJobs( shadows );
+	for( size_t i = 0; i < shadows.size(); i++ ) {
+		switchShadow( shadows[i] );
+		shadows[i]->shutDown( JOB_NOT_CKPTED );
+	}
+	checkMultiJobShadowDone();
 }
 
 void
 main_shutdown_graceful()
 {
-	Shadow->gracefulShutDown();
+	if( !multiJobShadow ) {
+		Shadow->gracefulShutDown();
+		return;
+	}
+
+	multiJobShuttingDown = true;
+	std::vector<BaseShadow*> shadows;
+	getMultiJobs( shadows );
+	for( size_t i = 0; i < shadows.size(); i++ ) {
+		switchShadow( shadows[i] );
+		shadows[i]->gracefulShutDown();
+	}
+	checkMultiJobShadowDone();
 }
 
 
@@ -447,6 +912,9 @@ printClassAd( void )
 	printf( "%s = True\n", ATTR_HAS_RECONNECT );
 	printf( "%s = True\n", ATTR_HAS_JOB_AD_FROM_FILE );
 	printf( "%s = True\n", ATTR_HAS_VM );
+#if !defined(WIN32)
+	printf( "%s = True\n", ATTR_HAS_MULTI_JOB );
+#endif
 	printf( "%s = \"%s\"\n", ATTR_VERSION, CondorVersion() );
 }
 
@@ -474,6 +942,10 @@ recycleShadow(int previous_job_exit_reason)
 	if( previous_job_exit_reason != JOB_EXITED ) {
 		return false;
 	}
+	if( multiJobShadow ) {
+			// the schedd sends us new jobs on its own
+		return false;
+	}
 	if( shadow_worklife_expires && time(NULL) > shadow_worklife_expires ) {
 		return false;
 	}
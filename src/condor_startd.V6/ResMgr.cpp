@@ -1067,6 +1067,43 @@ ResMgr::send_update( int cmd, ClassAd* public_ad, ClassAd* private_ad,
 }
 
 
+void
+ResMgr::send_batch_update( void )
+{
+	std::vector<ClassAd*> public_ads;
+	std::vector<ClassAd*> private_ads;
+
+	for( int i = 0; i < nresources; i++ ) {
+		ClassAd *public_ad = new ClassAd;
+		ClassAd *private_ad = new ClassAd;
+		if( resources[i]->get_update_ads( public_ad, private_ad ) ) {
+			public_ads.push_back( public_ad );
+			private_ads.push_back( private_ad );
+		} else {
+			delete public_ad;
+			delete private_ad;
+		}
+	}
+	if( public_ads.empty() ) {
+		return;
+	}
+
+	num_updates += public_ads.size();
+	int rval = daemonCore->sendUpdates( UPDATE_STARTD_AD, public_ads,
+										private_ads, true );
+	if( rval ) {
+		dprintf( D_FULLDEBUG, "Sent %d slot update(s) to collector(s)\n", rval );
+	} else {
+		dprintf( D_ALWAYS, "Error sending update to collector(s)\n" );
+	}
+
+	for( size_t i = 0; i < public_ads.size(); i++ ) {
+		delete public_ads[i];
+		delete private_ads[i];
+	}
+}
+
+
 void
 ResMgr::update_all( void )
 {
@@ -1091,7 +1128,15 @@ ResMgr::update_all( void )
 	walk( &Resource::eval_state );
 		// If we didn't update b/c of the eval_state, we need to
 		// actually do the update now.
-	walk( &Resource::update );
+		// Once the collectors have told us they can take all of our
+		// slots in one message, send them that way; otherwise each
+		// slot sends its own, staggered so as not to swamp them.
+	if( batch_updates &&
+		daemonCore->getCollectorList()->acceptsBatchUpdates( UPDATE_STARTD_AD ) ) {
+		send_batch_update();
+	} else {
+		walk( &Resource::update );
+	}
 
 	report_updates();
 	check_polling();
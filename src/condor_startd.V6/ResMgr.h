@@ -144,6 +144,8 @@ public:
 	int		numSlots( void ) { return nresources; }
 
 	int		send_update( int, ClassAd*, ClassAd*, bool nonblocking );
+		// Send the ads of all slots together
+	void	send_batch_update( void );
 	void	final_update( void );
 	
 		// Evaluate the state of all resources.
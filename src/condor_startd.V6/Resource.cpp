@@ -1331,6 +1331,28 @@ Resource::do_update( void )
 	update_tid = -1;
 }
 
+bool
+Resource::get_update_ads( ClassAd *public_ad, ClassAd *private_ad )
+{
+	if (r_no_collector_updates)
+		return false;
+
+	if ( update_tid != -1 ) {
+		daemonCore->Cancel_Timer( update_tid );
+		update_tid = -1;
+	}
+
+	publish_for_update( public_ad, private_ad );
+
+#if defined(WANT_CONTRIB) && defined(WITH_MANAGEMENT)
+#if defined(HAVE_DLOPEN) || defined(WIN32)
+	StartdPluginManager::Update(public_ad, private_ad);
+#endif
+#endif
+
+	return true;
+}
+
 void
 Resource::publish_for_update ( ClassAd *public_ad ,ClassAd *private_ad )
 {
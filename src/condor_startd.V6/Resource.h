@@ -212,6 +212,10 @@ public:
 	void		do_update( void );			// Actually update the CM
     int     update_with_ack( void );    // Actually update the CM and wait for an ACK
     void    publish_for_update ( ClassAd *public_ad ,ClassAd *private_ad );
+		// Ads for an update the ResMgr sends for all slots at once,
+		// in place of any update we had pending.  False if this slot
+		// isn't advertised.
+	bool	get_update_ads( ClassAd *public_ad, ClassAd *private_ad );
 	void	final_update( void );		// Send a final update to the CM
 									    // with Requirements = False.
 
@@ -90,6 +90,7 @@ extern	int		polling_interval;	// Interval for polling when
 									// running a job
 extern	int		update_interval;	// Interval to update CM
 extern	int		update_offset;		// Interval offset to update CM
+extern	bool	batch_updates;		// Send all slots' ads to the CM in one message
 
 // String Lists
 extern	StringList* console_devices;
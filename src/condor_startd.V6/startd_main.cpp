@@ -56,6 +56,7 @@ ResMgr*	resmgr;			// Pointer to the resource manager object
 int	polling_interval = 0;	// Interval for polling when there are resources in use
 int	update_interval = 0;	// Interval to update CM
 int	update_offset = 0;		// Interval offset to update CM
+bool	batch_updates = true;	// Send all slots' ads to the CM in one message
 
 // String Lists
 StringList *startd_job_exprs = NULL;
@@ -484,6 +485,7 @@ init_params( int /* first_time */)
 
 	update_interval = param_integer( "UPDATE_INTERVAL", 300, 1 );
 	update_offset = param_integer( "UPDATE_OFFSET", 0, 0 );
+	batch_updates = param_boolean( "STARTD_BATCH_UPDATES", true );
 
 	if( accountant_host ) {
 		free( accountant_host );
@@ -81,10 +81,13 @@
 #include "condor_vm_universe_types.h"
 #include "vm_univ_utils.h"
 #include "condor_md.h"
+#include "tmp_dir.h"
 
 #include <algorithm>
 #include <string>
 #include <set>
+#include <map>
+#include <vector>
 
 // TODO: hashFunction() is case-insenstive, but when a MyString is the
 //   hash key, the comparison in HashTable is case-sensitive. Therefore,
@@ -144,6 +147,17 @@ bool	RequestCpusIsZeroOrOne = false;
 bool	already_warned_requirements_mem = false;
 bool	already_warned_requirements_disk = false;
 int		MaxProcsPerCluster;
+
+	// Late materialization: when the submit file sets max_idle, the
+	// procs after proc 0 aren't sent to the schedd one by one.  As long
+	// as each of them is proc 1 with its proc id put in (see
+	// SaveFactoryProc()), we only count them, and the schedd makes them
+	// from that template, keeping at most max_idle of them idle.
+int		FactoryClusterId = -1;	// cluster we are doing this for
+int		FactoryMaxIdle = 0;
+int		FactoryProcs = 0;		// procs left to the schedd so far
+ClassAd	*FactoryProcZeroAd = NULL;
+std::vector< std::pair<std::string,std::string> > FactoryTemplate;
 int	  ClusterId = -1;
 int	  ProcId = -1;
 int	  JobUniverse;
@@ -200,6 +214,19 @@ char* UserNotesVal = NULL;
 char* StackSizeVal = NULL;
 List<const char> extraLines;  // lines passed in via -a argument
 
+// -batch: each line of this file names a directory, a submit file and
+// the -a lines for it; all of them are submitted in one transaction.
+// condor_dagman uses this to submit several ready nodes at once.
+MyString BatchFileName;
+struct BatchEntry {
+	MyString directory;
+	MyString cmd_file;
+	StringList extra_lines;
+	int firstSubmitInfo;
+	int lastSubmitInfo;
+};
+std::vector<BatchEntry*> BatchEntries;
+
 // the submit file is read into this macro table
 //
 static MACRO_SET SubmitMacroSet = {
@@ -363,6 +390,8 @@ const char    *ParallelScriptStarter = "parallel_script_starter";
 
 const char    *MaxJobRetirementTime = "max_job_retirement_time";
 
+const char	*MaxIdle = "max_idle";
+
 const char    *JobWantsAds = "want_ads";
 
 //
@@ -533,11 +562,19 @@ char const*full_path(const char *name, bool use_iwd=true);
 void 	log_submit();
 void 	get_time_conv( int &hours, int &minutes );
 int	  SaveClassAd ();
+void	StartJobFactory();
+int		SaveFactoryProc();
+int		FinishJobFactory();
 void	InsertJobExpr (const char *expr, bool clustercheck = true);
 void	InsertJobExpr (const MyString &expr, bool clustercheck = true);
 void	InsertJobExprInt(const char * name, int val, bool clustercheck = true);
 void	InsertJobExprString(const char * name, const char * val, bool clustercheck = true);
 void	check_umask();
+void	read_batch_file( const char *filename );
+void	submit_batch();
+void	reset_for_next_submit_file();
+void	print_cluster_counts( int ixFirst, int ixLast, int batchEntry );
+void	warn_unused_macros();
 void setupAuthentication();
 void	SetPeriodicHoldCheck(void);
 void	SetPeriodicRemoveCheck(void);
@@ -1072,6 +1109,13 @@ main( int argc, char *argv[] )
 			} else if (is_dash_arg_prefix(ptr[0], "help")) {
 				usage();
 				exit( 0 );
+			} else if (is_dash_arg_prefix(ptr[0], "batch", 5)) {
+				if( !(--argc) || !(*(++ptr)) ) {
+					fprintf( stderr, "%s: -batch requires another argument\n",
+							 MyName );
+					exit(1);
+				}
+				BatchFileName = *ptr;
 			} else if (is_dash_arg_prefix(ptr[0], "interactive", 1)) {
 				// we don't currently support -interactive on Windows, but we parse for it anyway.
 				InteractiveJob = 1;
@@ -1093,6 +1137,14 @@ main( int argc, char *argv[] )
 		verbose = true;
 	}
 
+	if ( BatchFileName.Length() &&
+		 ( cmd_file || DumpClassAdToFile || InteractiveJob || Remote ) ) {
+		fprintf( stderr, "%s: -batch cannot be combined with a submit file, "
+				 "-dump, -interactive, -remote or -spool\n", MyName );
+		usage();
+		exit(1);
+	}
+
 	// ensure I have a known transfer method
 	if (STMethod == STM_UNKNOWN) {
 		fprintf( stderr, 
@@ -1209,7 +1261,10 @@ main( int argc, char *argv[] )
 	}
 
 	// open submit file
-	if ( ! cmd_file || SubmitFromStdin) {
+	fp = NULL;
+	if ( BatchFileName.Length() ) {
+		read_batch_file( BatchFileName.Value() );
+	} else if ( ! cmd_file || SubmitFromStdin) {
 		// no file specified, read from stdin
 		fp = stdin;
 		insert_source("<stdin>", SubmitMacroSet, FileMacroSource);
@@ -1243,7 +1298,9 @@ main( int argc, char *argv[] )
 	}
 
 	//  Parse the file and queue the jobs
-	if( read_condor_file(fp) < 0 ) {
+	if ( BatchFileName.Length() ) {
+		submit_batch();
+	} else if( read_condor_file(fp) < 0 ) {
 		if( ExtraLineNo == 0 ) {
 			fprintf( stderr,
 					 "\nERROR: Failed to parse command file (line %d).\n",
@@ -1257,7 +1314,7 @@ main( int argc, char *argv[] )
 		exit(1);
 	}
 
-	if( !GotQueueCommand ) {
+	if( !GotQueueCommand && !BatchFileName.Length() ) {
 		fprintf(stderr, "\nERROR: \"%s\" doesn't contain any \"queue\"",
 				SubmitFromStdin ? "(stdin)" : cmd_file);
 		fprintf( stderr, " commands -- no jobs queued\n" );
@@ -1267,6 +1324,10 @@ main( int argc, char *argv[] )
 	// we can't disconnect from something if we haven't connected to it: since
 	// we are dumping to a file, we don't actually open a connection to the schedd
 	if ( !DumpClassAdToFile ) {
+		if ( FinishJobFactory() < 0 ) {
+			fprintf(stderr, "\nERROR: Failed to queue job.\n");
+			exit(1);
+		}
 		if ( !DisconnectQ(0) ) {
 			fprintf(stderr, "\nERROR: Failed to commit job submission into the queue.\n");
 			exit(1);
@@ -1302,21 +1363,13 @@ main( int argc, char *argv[] )
 					ixFirst = ix+1;
 				}
 			}
-		} else {
-			int this_cluster = -1, job_count=0;
-			for (i=0; i <= CurrentSubmitInfo; i++) {
-				if (SubmitInfo[i].cluster != this_cluster) {
-					if (this_cluster != -1) {
-						fprintf(stdout, "%d job(s) submitted to cluster %d.\n", job_count, this_cluster);
-						job_count = 0;
-					}
-					this_cluster = SubmitInfo[i].cluster;
-				}
-				job_count += SubmitInfo[i].lastjob - SubmitInfo[i].firstjob + 1;
-			}
-			if (this_cluster != -1) {
-				fprintf(stdout, "%d job(s) submitted to cluster %d.\n", job_count, this_cluster);
+		} else if ( BatchFileName.Length() ) {
+			for (i=0; i < (int)BatchEntries.size(); i++) {
+				print_cluster_counts( BatchEntries[i]->firstSubmitInfo,
+									  BatchEntries[i]->lastSubmitInfo, i );
 			}
+		} else {
+			print_cluster_counts( 0, CurrentSubmitInfo, -1 );
 		}
 	}
 
@@ -1423,25 +1476,7 @@ main( int argc, char *argv[] )
 
 	/*	print all of the parameters that were not actually expanded/used 
 		in the submit file */
-	if (WarnOnUnusedMacros) {
-		if (verbose) { fprintf(stdout, "\n"); }
-		HASHITER it = hash_iter_begin(SubmitMacroSet);
-		for ( ; !hash_iter_done(it); hash_iter_next(it) ) {
-			if(0 == hash_iter_used_value(it)) {
-				const char *key = hash_iter_key(it);
-				const char *val = hash_iter_value(it);
-					// Don't warn if DAG_STATUS or FAILED_COUNT is specified
-					// but unused -- these are specified for all DAG node
-					// jobs (see dagman_submit.cpp).  wenger 2012-03-26
-				if ( strcasecmp( key, "DAG_STATUS" ) != MATCH &&
-							strcasecmp( key, "FAILED_COUNT" ) != MATCH ) {
-					fprintf(stderr, "WARNING: the line `%s = %s' was unused by condor_submit. Is it a typo?\n", key, val);
-				}
-			}
-		}
-        hash_iter_delete(&it);
-		
-	}
+	warn_unused_macros();
 
 	// If this is an interactive job, spawn ssh_to_job -auto-retry -X, and also
 	// with pool and schedd names if they were passed into condor_submit
@@ -6485,6 +6520,297 @@ strcmpnull(const char *str1, const char *str2)
 	return (str1 || str2);
 }
 
+void
+print_cluster_counts( int ixFirst, int ixLast, int batchEntry )
+{
+	MyString prefix;
+	if ( batchEntry >= 0 ) {
+		prefix.formatstr( "%d: ", batchEntry );
+	}
+	int this_cluster = -1, job_count=0;
+	for (int i=ixFirst; i <= ixLast; i++) {
+		if (SubmitInfo[i].cluster != this_cluster) {
+			if (this_cluster != -1) {
+				fprintf(stdout, "%s%d job(s) submitted to cluster %d.\n", prefix.Value(), job_count, this_cluster);
+				job_count = 0;
+			}
+			this_cluster = SubmitInfo[i].cluster;
+		}
+		job_count += SubmitInfo[i].lastjob - SubmitInfo[i].firstjob + 1;
+	}
+	if (this_cluster != -1) {
+		fprintf(stdout, "%s%d job(s) submitted to cluster %d.\n", prefix.Value(), job_count, this_cluster);
+	}
+}
+
+void
+warn_unused_macros()
+{
+	if (WarnOnUnusedMacros) {
+		if (verbose) { fprintf(stdout, "\n"); }
+		HASHITER it = hash_iter_begin(SubmitMacroSet);
+		for ( ; !hash_iter_done(it); hash_iter_next(it) ) {
+			if(0 == hash_iter_used_value(it)) {
+				const char *key = hash_iter_key(it);
+				const char *val = hash_iter_value(it);
+					// Don't warn if DAG_STATUS or FAILED_COUNT is specified
+					// but unused -- these are specified for all DAG node
+					// jobs (see dagman_submit.cpp).  wenger 2012-03-26
+				if ( strcasecmp( key, "DAG_STATUS" ) != MATCH &&
+							strcasecmp( key, "FAILED_COUNT" ) != MATCH ) {
+					fprintf(stderr, "WARNING: the line `%s = %s' was unused by condor_submit. Is it a typo?\n", key, val);
+				}
+			}
+		}
+        hash_iter_delete(&it);
+		
+	}
+}
+
+/*
+	Each line of a batch file is a V2 argument string: the directory
+	to submit from, then the arguments condor_submit would otherwise
+	have been given for that submit file (any number of "-a <line>"
+	pairs followed by the submit file name).
+*/
+void
+read_batch_file( const char *filename )
+{
+	FILE *fp = safe_fopen_wrapper_follow( filename, "r" );
+	if ( fp == NULL ) {
+		fprintf( stderr, "\nERROR: Failed to open batch file %s (%s)\n",
+				 filename, strerror(errno) );
+		exit(1);
+	}
+
+	MyString line;
+	int lineno = 0;
+	while ( line.readLine( fp ) ) {
+		lineno++;
+		line.chomp();
+		if ( blankline( line.Value() ) ) {
+			continue;
+		}
+
+		ArgList args;
+		MyString errmsg;
+		if ( !args.AppendArgsV2Raw( line.Value(), &errmsg ) ||
+			 args.Count() < 2 ) {
+			fprintf( stderr, "\nERROR: Invalid entry at line %d of batch "
+					 "file %s: %s\n", lineno, filename, errmsg.Value() );
+			fclose( fp );
+			exit(1);
+		}
+
+		BatchEntry *entry = new BatchEntry;
+		entry->directory = args.GetArg( 0 );
+		entry->firstSubmitInfo = 0;
+		entry->lastSubmitInfo = -1;
+		for ( int i = 1; i < args.Count(); i++ ) {
+			char const *arg = args.GetArg( i );
+			if ( match_prefix( arg, "-append" ) && i+1 < args.Count() ) {
+				entry->extra_lines.append( args.GetArg( ++i ) );
+			} else if ( arg[0] != '-' && i+1 == args.Count() ) {
+				entry->cmd_file = arg;
+			} else {
+				fprintf( stderr, "\nERROR: Invalid argument %s at line %d "
+						 "of batch file %s\n", arg, lineno, filename );
+				fclose( fp );
+				exit(1);
+			}
+		}
+		if ( entry->cmd_file.IsEmpty() ) {
+			fprintf( stderr, "\nERROR: No submit file given at line %d of "
+					 "batch file %s\n", lineno, filename );
+			fclose( fp );
+			exit(1);
+		}
+		BatchEntries.push_back( entry );
+	}
+	fclose( fp );
+
+	if ( BatchEntries.empty() ) {
+		fprintf( stderr, "\nERROR: Batch file %s is empty -- no jobs "
+				 "queued\n", filename );
+		exit(1);
+	}
+}
+
+/*
+	Queue the jobs of every batch entry.  All of them go into the
+	transaction that main() commits with DisconnectQ(), so either all
+	of the entries are submitted or none are.
+*/
+void
+submit_batch()
+{
+	for ( size_t ix = 0; ix < BatchEntries.size(); ix++ ) {
+		BatchEntry *entry = BatchEntries[ix];
+
+		if ( ix > 0 ) {
+			warn_unused_macros();
+			reset_for_next_submit_file();
+		}
+
+		TmpDir tmpDir;
+		MyString errMsg;
+		if ( !tmpDir.Cd2TmpDir( entry->directory.Value(), errMsg ) ) {
+			fprintf( stderr, "\nERROR: Failed to change to directory %s "
+					 "(%s)\n", entry->directory.Value(), errMsg.Value() );
+			DoCleanup(0,0,NULL);
+			exit(1);
+		}
+
+		FILE *fp = safe_fopen_wrapper_follow( entry->cmd_file.Value(), "r" );
+		if ( fp == NULL ) {
+			fprintf( stderr, "\nERROR: Failed to open command file %s (%s)\n",
+					 entry->cmd_file.Value(), strerror(errno) );
+			DoCleanup(0,0,NULL);
+			exit(1);
+		}
+		insert_source( entry->cmd_file.Value(), SubmitMacroSet,
+					   FileMacroSource );
+
+		extraLines.Rewind();
+		while ( extraLines.Next() ) {
+			extraLines.DeleteCurrent();
+		}
+		char const *extra;
+		entry->extra_lines.rewind();
+		while ( (extra = entry->extra_lines.next()) ) {
+			extraLines.Append( extra );
+		}
+
+		entry->firstSubmitInfo = CurrentSubmitInfo + 1;
+		if( read_condor_file(fp) < 0 ) {
+			if( ExtraLineNo == 0 ) {
+				fprintf( stderr, "\nERROR: Failed to parse command file %s "
+						 "(line %d).\n", entry->cmd_file.Value(), LineNo );
+			} else {
+				fprintf( stderr, "\nERROR: Failed to parse -a argument line "
+						 "(#%d) for %s.\n", ExtraLineNo,
+						 entry->cmd_file.Value() );
+			}
+			DoCleanup(0,0,NULL);
+			exit(1);
+		}
+		entry->lastSubmitInfo = CurrentSubmitInfo;
+
+		if( !GotQueueCommand ) {
+			fprintf( stderr, "\nERROR: \"%s\" doesn't contain any \"queue\" "
+					 "commands -- no jobs queued\n", entry->cmd_file.Value() );
+			DoCleanup(0,0,NULL);
+			exit(1);
+		}
+
+		if ( !tmpDir.Cd2MainDir( errMsg ) ) {
+			fprintf( stderr, "\nERROR: Failed to change back to the "
+					 "original directory (%s)\n", errMsg.Value() );
+			DoCleanup(0,0,NULL);
+			exit(1);
+		}
+	}
+}
+
+/*
+	Forget everything read from the previous submit file, so that the
+	next one is processed as if by a fresh condor_submit.  The schedd
+	connection and its transaction are kept.
+*/
+void
+reset_for_next_submit_file()
+{
+	if ( SubmitMacroSet.table ) {
+		memset( SubmitMacroSet.table, 0,
+				sizeof(SubmitMacroSet.table[0]) * SubmitMacroSet.allocation_size );
+	}
+	if ( SubmitMacroSet.metat ) {
+		memset( SubmitMacroSet.metat, 0,
+				sizeof(SubmitMacroSet.metat[0]) * SubmitMacroSet.allocation_size );
+	}
+	SubmitMacroSet.size = 0;
+	SubmitMacroSet.sorted = 0;
+	SubmitMacroSet.apool.clear();
+	SubmitMacroSet.sources.clear();
+
+	forcedAttributes.clear();
+	NoClusterCheckAttrs.clearAll();
+	delete ClusterAd;
+	ClusterAd = NULL;
+
+		// the last cluster of the previous file may still be waiting
+		// for its materialization attributes
+	if ( !DumpClassAdToFile && FinishJobFactory() < 0 ) {
+		fprintf(stderr, "\nERROR: Failed to queue job.\n");
+		exit(1);
+	}
+	FactoryClusterId = -1;
+	FactoryMaxIdle = 0;
+	FactoryProcs = 0;
+	delete FactoryProcZeroAd;
+	FactoryProcZeroAd = NULL;
+	FactoryTemplate.clear();
+
+	ClusterId = -1;
+	ProcId = -1;
+	NewExecutable = false;
+	GotQueueCommand = 0;
+	IsFirstExecutable = true;
+
+		// Everything below is worked out from the submit file as its
+		// jobs are queued.  Some of it is only ever set, never cleared,
+		// so put it all back the way main() starts out.
+	JobIwd = "";
+	JobRequirements = "";
+#if !defined(WIN32)
+	JobRootdir = "";
+#endif
+	JobUniverse = 0;
+	if ( JobGridType ) {
+		free( JobGridType );
+		JobGridType = NULL;
+	}
+	JobDisableFileChecks = 0;
+	RequestMemoryIsZero = false;
+	RequestDiskIsZero = false;
+	RequestCpusIsZeroOrOne = false;
+	already_warned_requirements_mem = false;
+	already_warned_requirements_disk = false;
+	nice_user_setting = false;
+	UserLogSpecified = false;
+	UseXMLInLog = false;
+	should_transfer = STF_IF_NEEDED;
+	stream_stdout_toggle = false;
+	stream_stderr_toggle = false;
+	stream_std_file = false;
+	NeedsPerFileEncryption = false;
+	NeedsJobDeferral = false;
+	HasTDP = false;
+	if ( tdp_cmd ) {
+		free( tdp_cmd );
+		tdp_cmd = NULL;
+	}
+	if ( tdp_input ) {
+		free( tdp_input );
+		tdp_input = NULL;
+	}
+	TransferInputSizeKb = 0;
+
+	VMType = "";
+	VMMemoryMb = 0;
+	VMVCPUS = 0;
+	VMMACAddr = "";
+	VMCheckpoint = false;
+	VMNetworking = false;
+	VMVNC = false;
+	VMNetworkType = "";
+	VMHardwareVT = false;
+	vm_need_fsdomain = false;
+	xen_has_file_to_be_transferred = false;
+
+	init_job_ad();
+}
+
 void
 connect_to_the_schedd()
 {
@@ -6532,6 +6858,10 @@ queue(int num)
 	
 		if (NewExecutable) {
  			if ( !DumpClassAdToFile ) {
+				if ( FinishJobFactory() < 0 ) {
+					fprintf(stderr, "\nERROR: Failed to queue job.\n");
+					exit(1);
+				}
 				if ((ClusterId = NewCluster()) < 0) {
 					fprintf(stderr, "\nERROR: Failed to create cluster\n");
 					if ( ClusterId == -2 ) {
@@ -6563,7 +6893,13 @@ queue(int num)
 				exit(1);
 			}
 		
-			ProcId = NewProc (ClusterId);
+			if ( FactoryClusterId == ClusterId ) {
+					// the schedd will make this proc, unless it turns
+					// out to be unlike the others
+				ProcId = FactoryProcs + 1;
+			} else {
+				ProcId = NewProc (ClusterId);
+			}
 
 			if ( ProcId < 0 ) {
 				fprintf(stderr, "\nERROR: Failed to create proc\n");
@@ -6722,7 +7058,11 @@ queue(int num)
 		SetForcedAttributes();
 		rval = 0; // assume success
 		if ( !DumpClassAdToFile ) {
-			rval = SaveClassAd();
+			if ( FactoryClusterId == ClusterId ) {
+				rval = SaveFactoryProc();
+			} else {
+				rval = SaveClassAd();
+			}
 		}
 
 		switch( rval ) {
@@ -6805,6 +7145,8 @@ queue(int num)
 			while ( (attr = NoClusterCheckAttrs.next()) ) {
 				ClusterAd->Delete( attr );
 			}
+
+			StartJobFactory();
 		}
 
 		if ( job_ad_saved == false ) {
@@ -7439,6 +7781,8 @@ usage()
 	//fprintf( stderr, "\t-force-mpi-universe\tAllow submission of obsolete MPI universe\n );
 	fprintf( stderr, "\t-dump <filename>\tWrite job ClassAds to <filename> instead of\n"
 					 "\t                \tsubmitting to a schedd.\n" );
+	fprintf( stderr, "\t-batch <filename>\tSubmit each submit file listed in <filename>\n"
+					 "\t                 \tin a single transaction (used by condor_dagman)\n" );
 #if !defined(WIN32)
 	fprintf( stderr, "\t-interactive\t\tsubmit an interactive session job\n" );
 #endif
@@ -7810,6 +8154,280 @@ SaveClassAd ()
 	return retval;
 }
 
+/*
+	Decide, once proc 0 of a cluster has been saved, whether to leave
+	the rest of the cluster's procs to the schedd.
+*/
+void
+StartJobFactory()
+{
+	FactoryClusterId = -1;
+	FactoryProcs = 0;
+	FactoryTemplate.clear();
+	delete FactoryProcZeroAd;
+	FactoryProcZeroAd = NULL;
+
+	if ( DumpClassAdToFile || Remote ) {
+		return;
+	}
+
+	char *max_idle = condor_param( MaxIdle, ATTR_JOB_MATERIALIZE_MAX_IDLE );
+	if ( !max_idle ) {
+		return;
+	}
+	FactoryMaxIdle = atoi( max_idle );
+	free( max_idle );
+	if ( FactoryMaxIdle <= 0 ) {
+		fprintf( stderr, "\nERROR: %s must be greater than 0\n", MaxIdle );
+		DoCleanup(0,0,NULL);
+		exit( 1 );
+	}
+
+		// the procs of a parallel job are all started together
+	if ( JobUniverse == CONDOR_UNIVERSE_MPI ||
+		 JobUniverse == CONDOR_UNIVERSE_PARALLEL ) {
+		return;
+	}
+
+	CondorVersionInfo vers( MySchedd->version() );
+	if ( !vers.built_since_version( 8, 3, 3 ) ) {
+		fprintf( stderr, "\nWARNING: the schedd is too old for %s; "
+				 "all procs will be queued now\n", MaxIdle );
+		return;
+	}
+
+	FactoryClusterId = ClusterId;
+	FactoryProcZeroAd = new ClassAd( *job );
+}
+
+/*
+	Turn proc 1's value of an attribute into a template, given proc 0's
+	value: wherever the two differ by proc 0 having "0" and proc 1
+	having "1", put in $(ProcId).  Returns false if they differ in any
+	other way.
+*/
+static bool
+MakeProcTemplate( std::string const &v0, std::string const &v1, std::string &tmpl )
+{
+	size_t i = 0, j = 0;
+	tmpl = "";
+	while ( i < v0.size() && j < v1.size() ) {
+		if ( isdigit(v0[i]) && isdigit(v1[j]) ) {
+			size_t i_end = i, j_end = j;
+			while ( i_end < v0.size() && isdigit(v0[i_end]) ) i_end++;
+			while ( j_end < v1.size() && isdigit(v1[j_end]) ) j_end++;
+			std::string d0 = v0.substr( i, i_end - i );
+			std::string d1 = v1.substr( j, j_end - j );
+			if ( d0 == d1 ) {
+				tmpl += d1;
+			} else if ( d0 == "0" && d1 == "1" ) {
+				tmpl += "$(ProcId)";
+			} else {
+				return false;
+			}
+			i = i_end;
+			j = j_end;
+		} else if ( v0[i] == v1[j] ) {
+			tmpl += v1[j];
+			i++;
+			j++;
+		} else {
+			return false;
+		}
+	}
+	return i == v0.size() && j == v1.size();
+}
+
+/*
+	The attributes SaveClassAd() would put in the ad of the current
+	proc (other than ProcId), with their values.
+*/
+static void
+GetProcAttrs( std::map<std::string,std::string> &attrs )
+{
+	ExprTree *tree = NULL;
+	const char *lhstr;
+
+	job->ResetExpr();
+	while( job->NextExpr(lhstr, tree) ) {
+		if ( !NoClusterCheckAttrs.contains_anycase( lhstr ) ) {
+			ExprTree *cluster_tree = ClusterAd->LookupExpr( lhstr );
+			if ( cluster_tree && *tree == *cluster_tree ) {
+				continue;
+			}
+		}
+		attrs[lhstr] = ExprTreeToString( tree );
+	}
+}
+
+static std::string
+ExpandProcTemplate( std::string const &tmpl, int proc_id )
+{
+	MyString value = tmpl;
+	MyString proc_str;
+	proc_str += proc_id;
+	value.replaceString( "$(ProcId)", proc_str.Value() );
+	return value.Value();
+}
+
+/*
+	Send the procs we have been leaving to the schedd the usual way,
+	and stop leaving procs of this cluster to it.
+*/
+static int
+SendFactoryProcs()
+{
+	int nprocs = FactoryProcs;
+	FactoryClusterId = -1;
+	FactoryProcs = 0;
+
+	for ( int proc_id = 1; proc_id <= nprocs; proc_id++ ) {
+		if ( NewProc(ClusterId) != proc_id ) {
+			fprintf( stderr, "\nERROR: Failed to create proc\n" );
+			return -1;
+		}
+		if ( SetAttributeInt(ClusterId, proc_id, ATTR_PROC_ID, proc_id, setattrflags) == -1 ) {
+			fprintf( stderr, "\nERROR: Failed to set %s=%d for job %d.%d (%d)\n",
+					 ATTR_PROC_ID, proc_id, ClusterId, proc_id, errno );
+			return -1;
+		}
+		for ( size_t ix = 0; ix < FactoryTemplate.size(); ix++ ) {
+			std::string value = ExpandProcTemplate( FactoryTemplate[ix].second, proc_id );
+			if ( SetAttribute(ClusterId, proc_id, FactoryTemplate[ix].first.c_str(),
+							  value.c_str(), setattrflags) == -1 ) {
+				fprintf( stderr, "\nERROR: Failed to set %s=%s for job %d.%d (%d)\n",
+						 FactoryTemplate[ix].first.c_str(), value.c_str(),
+						 ClusterId, proc_id, errno );
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+	Stand-in for SaveClassAd() for procs after proc 0 while we are
+	leaving them to the schedd.  Proc 1 gives us the template.  If a
+	later proc doesn't match it, the ones held back so far and all the
+	rest are sent the usual way after all.
+*/
+int
+SaveFactoryProc()
+{
+	std::map<std::string,std::string> attrs;
+	std::map<std::string,std::string>::iterator it;
+
+	GetProcAttrs( attrs );
+
+	if ( ProcId == 1 ) {
+		FactoryTemplate.clear();
+		for ( it = attrs.begin(); it != attrs.end(); it++ ) {
+			std::string tmpl;
+			ExprTree *tree = FactoryProcZeroAd->LookupExpr( it->first.c_str() );
+			if ( !tree || !MakeProcTemplate( ExprTreeToString(tree), it->second, tmpl ) ) {
+				tmpl = it->second;
+			}
+			FactoryTemplate.push_back( std::make_pair( it->first, tmpl ) );
+		}
+	}
+
+	bool matches = ( attrs.size() == FactoryTemplate.size() );
+	for ( size_t ix = 0; matches && ix < FactoryTemplate.size(); ix++ ) {
+		it = attrs.find( FactoryTemplate[ix].first );
+		matches = ( it != attrs.end() &&
+					it->second == ExpandProcTemplate( FactoryTemplate[ix].second, ProcId ) );
+	}
+	if ( matches ) {
+		FactoryProcs++;
+		return 0;
+	}
+
+	if ( SendFactoryProcs() < 0 ) {
+		return -1;
+	}
+	if ( NewProc(ClusterId) != ProcId ) {
+		fprintf( stderr, "\nERROR: Failed to create proc\n" );
+		return -1;
+	}
+	return SaveClassAd();
+}
+
+/*
+	Hand the procs we have left to the schedd over to it, by putting
+	the template and their count in the cluster ad.  If the schedd
+	doesn't confirm that it will make them, send them after all.
+*/
+int
+FinishJobFactory()
+{
+	int cluster_id = FactoryClusterId;
+	delete FactoryProcZeroAd;
+	FactoryProcZeroAd = NULL;
+
+	if ( cluster_id < 0 || FactoryProcs == 0 ) {
+		FactoryClusterId = -1;
+		FactoryProcs = 0;
+		return 0;
+	}
+
+		// A schedd that materializes procs answers the limit by
+		// setting the next proc id to make.  One that doesn't would
+		// leave the cluster at proc 0.
+	int next_proc = 0;
+	if ( SetAttributeInt(cluster_id, -1, ATTR_JOB_MATERIALIZE_LIMIT, FactoryProcs + 1, setattrflags) == -1 ) {
+		fprintf( stderr, "\nERROR: Failed to set %s for cluster %d (%d)\n",
+				 ATTR_JOB_MATERIALIZE_LIMIT, cluster_id, errno );
+		return -1;
+	}
+	if ( GetAttributeInt(cluster_id, -1, ATTR_JOB_MATERIALIZE_NEXT_PROC_ID, &next_proc) < 0 ||
+		 next_proc != 1 ) {
+		fprintf( stderr, "\nWARNING: the schedd did not accept %s; "
+				 "all procs will be queued now\n", MaxIdle );
+		if ( DeleteAttribute(cluster_id, -1, ATTR_JOB_MATERIALIZE_LIMIT) == -1 ) {
+			fprintf( stderr, "\nERROR: Failed to delete %s for cluster %d (%d)\n",
+					 ATTR_JOB_MATERIALIZE_LIMIT, cluster_id, errno );
+			return -1;
+		}
+		return SendFactoryProcs();
+	}
+	FactoryClusterId = -1;
+
+	std::string names;
+	for ( size_t ix = 0; ix < FactoryTemplate.size(); ix++ ) {
+		std::string attr = ATTR_JOB_MATERIALIZE_ATTR_PREFIX;
+		attr += FactoryTemplate[ix].first;
+		std::string buf;
+		std::string value = "\"";
+		value += EscapeAdStringValue( FactoryTemplate[ix].second.c_str(), buf );
+		value += "\"";
+		if ( SetAttribute(cluster_id, -1, attr.c_str(), value.c_str(), setattrflags) == -1 ) {
+			fprintf( stderr, "\nERROR: Failed to set %s for cluster %d (%d)\n",
+					 attr.c_str(), cluster_id, errno );
+			return -1;
+		}
+		if ( !names.empty() ) {
+			names += ",";
+		}
+		names += FactoryTemplate[ix].first;
+	}
+	if ( !names.empty() ) {
+		std::string value = "\"" + names + "\"";
+		if ( SetAttribute(cluster_id, -1, ATTR_JOB_MATERIALIZE_ATTRS, value.c_str(), setattrflags) == -1 ) {
+			fprintf( stderr, "\nERROR: Failed to set %s for cluster %d (%d)\n",
+					 ATTR_JOB_MATERIALIZE_ATTRS, cluster_id, errno );
+			return -1;
+		}
+	}
+
+	if ( SetAttributeInt(cluster_id, -1, ATTR_JOB_MATERIALIZE_MAX_IDLE, FactoryMaxIdle, setattrflags) == -1 ) {
+		fprintf( stderr, "\nERROR: Failed to set up materialization of cluster %d (%d)\n",
+				 cluster_id, errno );
+		return -1;
+	}
+	FactoryProcs = 0;
+	return 0;
+}
+
 void
 InsertJobExpr (MyString const &expr, bool clustercheck)
 {
@@ -0,0 +1,6 @@
+universe     = vanilla
+executable   = ./x_sleep.pl
+arguments    = 1
+log          = job_dagman_inotify-job.log
+Notification = NEVER
+queue
@@ -0,0 +1,5 @@
+executable   = /bin/true
+universe     = vanilla
+log          = job_dagman_join_nodes-node.log
+Notification = NEVER
+queue
@@ -0,0 +1,123 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/* Test that DCCollector only sends delta updates against ads that
+   actually made it to the collector.
+ */
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "condor_commands.h"
+#include "dc_collector.h"
+#include "function_test_driver.h"
+#include "unit_test_utils.h"
+#include "emit.h"
+
+	// Nothing listens on port 1, so every TCP update to this
+	// collector fails to connect.
+static const char *unreachable_collector = "<127.0.0.1:1>";
+
+static void make_schedd_ad( ClassAd &ad ) {
+	SetMyTypeName( ad, SCHEDD_ADTYPE );
+	SetTargetTypeName( ad, "" );
+	ad.Assign( ATTR_NAME, "test-schedd@example.com" );
+	ad.Assign( ATTR_TOTAL_IDLE_JOBS, 1 );
+}
+
+static bool test_no_base_before_update() {
+	emit_test("Is there no delta base for an ad that was never sent?");
+	emit_input_header();
+	emit_param("collector", "%s", unreachable_collector);
+	emit_param("cmd", "%s", "UPDATE_SCHEDD_AD");
+
+	DCCollector collector( unreachable_collector, DCCollector::TCP );
+	ClassAd ad;
+	make_schedd_ad( ad );
+
+	emit_output_expected_header();
+	emit_retval("%s", "FALSE");
+	bool has_base = collector.hasDeltaBase( UPDATE_SCHEDD_AD, &ad );
+	emit_output_actual_header();
+	emit_retval("%s", tfstr(has_base));
+	if(has_base) FAIL;
+	PASS;
+}
+
+static bool test_failed_update_no_base() {
+	emit_test("Does a failed TCP update leave no delta base behind?");
+	emit_input_header();
+	emit_param("collector", "%s", unreachable_collector);
+	emit_param("cmd", "%s", "UPDATE_SCHEDD_AD");
+
+	DCCollector collector( unreachable_collector, DCCollector::TCP );
+	ClassAd ad;
+	make_schedd_ad( ad );
+
+	emit_output_expected_header();
+	emit_param("sendUpdate()", "%s", "FALSE");
+	emit_param("hasDeltaBase()", "%s", "FALSE");
+	bool sent = collector.sendUpdate( UPDATE_SCHEDD_AD, &ad, NULL, true );
+	bool has_base = collector.hasDeltaBase( UPDATE_SCHEDD_AD, &ad );
+	emit_output_actual_header();
+	emit_param("sendUpdate()", "%s", tfstr(sent));
+	emit_param("hasDeltaBase()", "%s", tfstr(has_base));
+	if(sent) FAIL;
+	if(has_base) FAIL;
+	PASS;
+}
+
+static bool test_failed_retry_no_base() {
+	emit_test("Does a second failed TCP update of the same ad still "
+		"leave no delta base behind?");
+	emit_input_header();
+	emit_param("collector", "%s", unreachable_collector);
+	emit_param("cmd", "%s", "UPDATE_SCHEDD_AD");
+
+	DCCollector collector( unreachable_collector, DCCollector::TCP );
+	ClassAd ad;
+	make_schedd_ad( ad );
+
+	emit_output_expected_header();
+	emit_retval("%s", "FALSE");
+	collector.sendUpdate( UPDATE_SCHEDD_AD, &ad, NULL, true );
+	ad.Assign( ATTR_TOTAL_IDLE_JOBS, 2 );
+	collector.sendUpdate( UPDATE_SCHEDD_AD, &ad, NULL, true );
+	bool has_base = collector.hasDeltaBase( UPDATE_SCHEDD_AD, &ad );
+	emit_output_actual_header();
+	emit_retval("%s", tfstr(has_base));
+	if(has_base) FAIL;
+	PASS;
+}
+
+bool OTEST_DCCollector() {
+	emit_object("DCCollector");
+	emit_comment("DCCollector sends ClassAd updates to a collector.  Over "
+		"TCP, an ad the collector already has is sent as a delta against "
+		"the copy we last sent, so that copy must only be remembered once "
+		"the update carrying it has actually been sent.");
+
+	FunctionDriver driver;
+	driver.register_function(test_no_base_before_update);
+	driver.register_function(test_failed_update_no_base);
+	driver.register_function(test_failed_retry_no_base);
+
+	return driver.do_all_functions();
+}
@@ -65,6 +65,7 @@ bool OTEST_Directory(void);
 bool OTEST_TmpDir(void);
 bool OTEST_StatInfo(void);
 bool OTEST_condor_sockaddr();
+bool OTEST_DCCollector();
 
 	// function map that maps testing function names to testing functions
 const static struct {
@@ -102,6 +103,7 @@ const static struct {
 	map(OTEST_TmpDir),
 	map(OTEST_StatInfo),
 	map(OTEST_condor_sockaddr),
+	map(OTEST_DCCollector),
 };
 int function_map_num_elems = sizeof(function_map) / sizeof(function_map[0]);
 
@@ -0,0 +1,333 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_classad.h"
+#include "string_list.h"
+#include "stl_string_utils.h"
+#include "classad_attr_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+using classad::ExprTree;
+using classad::Operation;
+
+ClassAdAttrIndex::ClassAdAttrIndex()
+{
+}
+
+ClassAdAttrIndex::~ClassAdAttrIndex()
+{
+}
+
+void
+ClassAdAttrIndex::setAttributes( StringList &attrs )
+{
+	m_attrs.clear();
+	m_postings.clear();
+
+	char const *attr;
+	attrs.rewind();
+	while( (attr = attrs.next()) ) {
+		std::string name = attr;
+		lower_case( name );
+		if( findAttr( name ) >= 0 ) {
+			continue;
+		}
+		m_attrs.push_back( AttrIndex() );
+		m_attrs.back().name = name;
+	}
+}
+
+int
+ClassAdAttrIndex::findAttr( const std::string &name ) const
+{
+	for( size_t i = 0; i < m_attrs.size(); i++ ) {
+		if( strcasecmp( m_attrs[i].name.c_str(), name.c_str() ) == 0 ) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+void
+ClassAdAttrIndex::clear()
+{
+	for( size_t i = 0; i < m_attrs.size(); i++ ) {
+		m_attrs[i].strings.clear();
+		m_attrs[i].numbers.clear();
+		m_attrs[i].others.clear();
+	}
+	m_postings.clear();
+}
+
+void
+ClassAdAttrIndex::insert( ClassAd *ad )
+{
+	if( !ad || m_attrs.empty() ) {
+		return;
+	}
+	if( m_postings.find( ad ) != m_postings.end() ) {
+		remove( ad );
+	}
+
+	std::vector<Posting> &postings = m_postings[ad];
+	for( size_t i = 0; i < m_attrs.size(); i++ ) {
+		AttrIndex &index = m_attrs[i];
+		ExprTree *tree = ad->Lookup( index.name );
+		if( !tree ) {
+				// a missing attribute cannot satisfy any indexable
+				// predicate, so there is nothing to file
+			continue;
+		}
+		tree = const_cast<ExprTree *>( tree->self() );
+
+		Posting posting;
+		posting.attr = (int)i;
+		posting.kind = Posting::OTHER;
+
+		classad::Value val;
+		std::string str;
+		double num;
+		if( tree->GetKind() == ExprTree::LITERAL_NODE ) {
+			((classad::Literal *)tree)->GetValue( val );
+			if( val.IsUndefinedValue() || val.IsErrorValue() ) {
+				continue;
+			}
+			if( val.IsStringValue( str ) ) {
+				lower_case( str );
+				posting.kind = Posting::STRING;
+				posting.str = index.strings.insert(
+					StringBuckets::value_type( str, AdSet() ) ).first;
+				posting.str->second.insert( ad );
+			}
+			else if( val.IsNumber( num ) ) {
+				posting.kind = Posting::NUMBER;
+				posting.num = index.numbers.insert(
+					NumberBuckets::value_type( num, AdSet() ) ).first;
+				posting.num->second.insert( ad );
+			}
+		}
+		if( posting.kind == Posting::OTHER ) {
+			index.others.insert( ad );
+		}
+		postings.push_back( posting );
+	}
+}
+
+void
+ClassAdAttrIndex::remove( ClassAd *ad )
+{
+	std::map<ClassAd *, std::vector<Posting> >::iterator it;
+	it = m_postings.find( ad );
+	if( it == m_postings.end() ) {
+		return;
+	}
+
+	std::vector<Posting> &postings = it->second;
+	for( size_t i = 0; i < postings.size(); i++ ) {
+		AttrIndex &index = m_attrs[postings[i].attr];
+		switch( postings[i].kind ) {
+		case Posting::STRING:
+			postings[i].str->second.erase( ad );
+			if( postings[i].str->second.empty() ) {
+				index.strings.erase( postings[i].str );
+			}
+			break;
+		case Posting::NUMBER:
+			postings[i].num->second.erase( ad );
+			if( postings[i].num->second.empty() ) {
+				index.numbers.erase( postings[i].num );
+			}
+			break;
+		case Posting::OTHER:
+			index.others.erase( ad );
+			break;
+		}
+	}
+	m_postings.erase( it );
+}
+
+bool
+ClassAdAttrIndex::candidates( ExprTree *constraint, AdSet &result ) const
+{
+	result.clear();
+	if( !constraint || m_attrs.empty() ) {
+		return false;
+	}
+	return attrCandidates( constraint, result );
+}
+
+bool
+ClassAdAttrIndex::attrCandidates( ExprTree *tree, AdSet &result ) const
+{
+	tree = const_cast<ExprTree *>( tree->self() );
+	if( tree->GetKind() != ExprTree::OP_NODE ) {
+		return false;
+	}
+
+	Operation::OpKind op;
+	ExprTree *t1 = NULL, *t2 = NULL, *t3 = NULL;
+	((Operation *)tree)->GetComponents( op, t1, t2, t3 );
+
+	switch( op ) {
+	case Operation::PARENTHESES_OP:
+		return t1 && attrCandidates( t1, result );
+
+	case Operation::LOGICAL_AND_OP: {
+			// Either side must hold, so the smaller candidate set
+			// of the two will do.
+		AdSet left, right;
+		bool have_left = t1 && attrCandidates( t1, left );
+		bool have_right = t2 && attrCandidates( t2, right );
+		if( have_left && (!have_right || left.size() <= right.size()) ) {
+			result.swap( left );
+			return true;
+		}
+		if( have_right ) {
+			result.swap( right );
+			return true;
+		}
+		return false;
+	}
+
+	case Operation::LOGICAL_OR_OP: {
+		AdSet left, right;
+		if( !t1 || !t2 || !attrCandidates( t1, left ) ||
+			!attrCandidates( t2, right ) )
+		{
+			return false;
+		}
+		std::set_union( left.begin(), left.end(),
+						right.begin(), right.end(),
+						std::inserter( result, result.end() ) );
+		return true;
+	}
+
+	case Operation::EQUAL_OP:
+	case Operation::META_EQUAL_OP:
+	case Operation::LESS_THAN_OP:
+	case Operation::LESS_OR_EQUAL_OP:
+	case Operation::GREATER_THAN_OP:
+	case Operation::GREATER_OR_EQUAL_OP:
+		if( !t1 || !t2 ) {
+			return false;
+		}
+		if( compareCandidates( t1, op, t2, result ) ) {
+			return true;
+		}
+			// try it the other way around, e.g. "Linux" == OpSys
+		switch( op ) {
+		case Operation::LESS_THAN_OP: op = Operation::GREATER_THAN_OP; break;
+		case Operation::LESS_OR_EQUAL_OP: op = Operation::GREATER_OR_EQUAL_OP; break;
+		case Operation::GREATER_THAN_OP: op = Operation::LESS_THAN_OP; break;
+		case Operation::GREATER_OR_EQUAL_OP: op = Operation::LESS_OR_EQUAL_OP; break;
+		default: break;
+		}
+		return compareCandidates( t2, op, t1, result );
+
+	default:
+		return false;
+	}
+}
+
+	// lhs must be an unscoped reference to an indexed attribute and rhs
+	// a string or number literal.
+bool
+ClassAdAttrIndex::compareCandidates( ExprTree *lhs, Operation::OpKind op,
+									 ExprTree *rhs, AdSet &result ) const
+{
+	lhs = const_cast<ExprTree *>( lhs->self() );
+	rhs = const_cast<ExprTree *>( rhs->self() );
+	if( lhs->GetKind() != ExprTree::ATTRREF_NODE ||
+		rhs->GetKind() != ExprTree::LITERAL_NODE )
+	{
+		return false;
+	}
+
+	ExprTree *scope = NULL;
+	std::string attr;
+	bool absolute = false;
+	((classad::AttributeReference *)lhs)->GetComponents( scope, attr, absolute );
+	if( scope || absolute ) {
+		return false;
+	}
+	int i = findAttr( attr );
+	if( i < 0 ) {
+		return false;
+	}
+	const AttrIndex &index = m_attrs[i];
+
+	classad::Value val;
+	std::string str;
+	double num;
+	((classad::Literal *)rhs)->GetValue( val );
+
+	if( val.IsStringValue( str ) ) {
+		if( op != Operation::EQUAL_OP && op != Operation::META_EQUAL_OP ) {
+			return false;
+		}
+			// == on strings is case-insensitive; for =?= this is
+			// merely a superset
+		lower_case( str );
+		StringBuckets::const_iterator it = index.strings.find( str );
+		if( it != index.strings.end() ) {
+			result.insert( it->second.begin(), it->second.end() );
+		}
+	}
+	else if( val.IsNumber( num ) ) {
+		NumberBuckets::const_iterator begin, end;
+		switch( op ) {
+		case Operation::EQUAL_OP:
+		case Operation::META_EQUAL_OP:
+			begin = index.numbers.lower_bound( num );
+			end = index.numbers.upper_bound( num );
+			break;
+		case Operation::LESS_THAN_OP:
+			begin = index.numbers.begin();
+			end = index.numbers.lower_bound( num );
+			break;
+		case Operation::LESS_OR_EQUAL_OP:
+			begin = index.numbers.begin();
+			end = index.numbers.upper_bound( num );
+			break;
+		case Operation::GREATER_THAN_OP:
+			begin = index.numbers.upper_bound( num );
+			end = index.numbers.end();
+			break;
+		case Operation::GREATER_OR_EQUAL_OP:
+			begin = index.numbers.lower_bound( num );
+			end = index.numbers.end();
+			break;
+		default:
+			return false;
+		}
+		for( ; begin != end; ++begin ) {
+			result.insert( begin->second.begin(), begin->second.end() );
+		}
+	}
+	else {
+		return false;
+	}
+
+	result.insert( index.others.begin(), index.others.end() );
+	return true;
+}
@@ -0,0 +1,104 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _CLASSAD_ATTR_INDEX_H
+#define _CLASSAD_ATTR_INDEX_H
+
+#include "condor_classad.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class StringList;
+
+/**
+ * Secondary indexes on a fixed set of attributes of a collection of
+ * ads, such as one of the collector's ad tables or the schedd's job
+ * queue.  Used to narrow down the ads a query's Requirements has to be
+ * evaluated against.
+ *
+ * The index only ever over-approximates: every ad that could satisfy
+ * an indexable predicate is among the candidates, but candidates still
+ * have to be checked against the full constraint.  Ads whose indexed
+ * attribute is not a literal string or number (e.g. an expression) are
+ * returned as candidates for every predicate on that attribute.
+ *
+ * The index holds raw ClassAd pointers, so every ad must be removed
+ * with remove() before it is deleted, and re-inserted with update()
+ * if it is modified in place.
+ */
+class ClassAdAttrIndex
+{
+  public:
+	ClassAdAttrIndex();
+	~ClassAdAttrIndex();
+
+		// Replaces the set of indexed attributes; clears the index.
+	void setAttributes( StringList &attrs );
+	bool hasAttributes() const { return !m_attrs.empty(); }
+	bool isIndexed( const std::string &attr ) const { return findAttr( attr ) >= 0; }
+
+	void insert( ClassAd *ad );
+	void remove( ClassAd *ad );
+	void update( ClassAd *ad ) { remove( ad ); insert( ad ); }
+	void clear();
+	int  size() const { return (int)m_postings.size(); }
+
+	/**
+	 * Find the ads that could satisfy the given constraint.
+	 * @return false if the constraint has no indexable conjunct, in
+	 *         which case every ad must be considered; otherwise true,
+	 *         with a superset of the matching ads in candidates.
+	 */
+	bool candidates( classad::ExprTree *constraint,
+					 std::set<ClassAd *> &candidates ) const;
+
+  private:
+	typedef std::set<ClassAd *> AdSet;
+	typedef std::map<std::string, AdSet> StringBuckets;
+	typedef std::map<double, AdSet> NumberBuckets;
+
+	struct AttrIndex {
+		std::string name;       // lower case
+		StringBuckets strings;  // keyed by lower case value
+		NumberBuckets numbers;
+		AdSet others;           // value is not a string or number literal
+	};
+
+		// where one ad was filed, so it can be removed without
+		// looking at its (possibly modified) attributes again
+	struct Posting {
+		int attr;
+		enum { STRING, NUMBER, OTHER } kind;
+		StringBuckets::iterator str;
+		NumberBuckets::iterator num;
+	};
+
+	bool attrCandidates( classad::ExprTree *tree, AdSet &result ) const;
+	bool compareCandidates( classad::ExprTree *lhs,
+							classad::Operation::OpKind op,
+							classad::ExprTree *rhs, AdSet &result ) const;
+	int findAttr( const std::string &name ) const;
+
+	std::vector<AttrIndex> m_attrs;
+	std::map<ClassAd *, std::vector<Posting> > m_postings;
+};
+
+#endif // _CLASSAD_ATTR_INDEX_H
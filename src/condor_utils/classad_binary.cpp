@@ -0,0 +1,823 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "classad_binary.h"
+
+/*
+  Layout of an encoded ad:
+
+    byte    format version (CLASSAD_BINARY_VERSION)
+    varint  number of entries in the sender's name dictionary
+    varint  number of attributes
+    then, for each attribute, a name followed by an expression.
+
+  A name is a varint n: 0 means the name follows inline as a varint
+  length and bytes, and is remembered; 1..D is entry n-1 of the name
+  dictionary (D being the sender's dictionary size from the header);
+  above D is the (n-1-D)th name sent inline earlier in this ad.
+
+  An expression is a one byte tag followed by tag-specific data.
+  Integers are zig-zag varints, reals are 8 byte little-endian IEEE.
+*/
+
+static const unsigned char CLASSAD_BINARY_VERSION = 1;
+
+	// Nodes may nest no deeper than this; deeper trees are sent as
+	// text, and received ones are rejected rather than risk the stack.
+static const int MAX_DEPTH = 512;
+
+enum {
+	TAG_UNDEFINED = 0,
+	TAG_ERROR,
+	TAG_TRUE,
+	TAG_FALSE,
+	TAG_INTEGER,		// signed
+	TAG_INTEGER_FACTOR,	// factor byte, signed
+	TAG_REAL,			// double
+	TAG_REAL_FACTOR,	// factor byte, double
+	TAG_STRING,			// length, bytes
+	TAG_ABSTIME,		// signed secs, signed offset
+	TAG_RELTIME,		// double
+	TAG_ATTRREF,		// flags (1=absolute, 2=scoped), [scope expr], name
+	TAG_OPERATION,		// op kind, mask of present operands, operands
+	TAG_FUNCTION,		// name, count, args
+	TAG_CLASSAD,		// count, (name, expr)...
+	TAG_LIST,			// count, exprs
+	TAG_TEXT			// length, new ClassAd expression text
+};
+
+/*
+  Names that appear in most ads, so that they need not be spelled out.
+  Both ends index this table, so entries may only ever be appended;
+  a receiver whose table is shorter than the sender's rejects the ad.
+*/
+static const char * const name_dictionary[] = {
+		// common to most ads
+	"MyType", "TargetType", "Name", "Machine", "MyAddress", "Requirements",
+	"Rank", "CurrentTime", "LastHeardFrom", "UpdateSequenceNumber",
+	"DaemonStartTime", "CondorVersion", "CondorPlatform", "AuthenticatedIdentity",
+	"AddressV1", "UpdatesTotal", "UpdatesSequenced", "UpdatesLost",
+	"UpdatesHistory", "MonitorSelfAge", "MonitorSelfCPUUsage",
+	"MonitorSelfImageSize", "MonitorSelfResidentSetSize",
+	"MonitorSelfRegisteredSocketCount", "MonitorSelfSecuritySessions",
+	"MonitorSelfTime", "DetectedCpus", "DetectedMemory", "StartdIpAddr",
+	"ScheddIpAddr", "MY", "TARGET",
+		// machine ads
+	"Arch", "OpSys", "OpSysVer", "OpSysAndVer", "OpSysMajorVer", "OpSysName",
+	"OpSysLegacy", "OpSysLongName", "OpSysShortName", "UidDomain",
+	"FileSystemDomain", "State", "Activity", "EnteredCurrentState",
+	"EnteredCurrentActivity", "Cpus", "Memory", "Disk", "Swap",
+	"TotalCpus", "TotalMemory", "TotalDisk", "TotalSlotCpus",
+	"TotalSlotMemory", "TotalSlotDisk", "TotalVirtualMemory", "VirtualMemory",
+	"LoadAvg", "CondorLoadAvg", "TotalLoadAvg", "TotalCondorLoadAvg",
+	"KeyboardIdle", "ConsoleIdle", "Mips", "KFlops", "Start",
+	"IsValidCheckpointPlatform", "WithinResourceLimits", "SlotID",
+	"SlotType", "SlotWeight", "SlotTypeID", "PartitionableSlot",
+	"DynamicSlot", "ChildCpus", "ChildMemory", "ChildDisk", "ChildState",
+	"ChildActivity", "NumDynamicSlots", "ClaimId", "PublicClaimId",
+	"RemoteUser", "RemoteOwner", "RemoteGroup", "AccountingGroup",
+	"ClientMachine", "JobId", "JobStart", "GlobalJobId", "CurrentRank",
+	"Unhibernate", "CanHibernate", "HibernationLevel", "HibernationState",
+	"HibernationSupportedStates", "HasFileTransfer",
+	"HasPerFileEncryption", "HasReconnect", "HasMPI", "HasJICLocalConfig",
+	"HasJICLocalStdin", "HasJobDeferral", "HasTDP", "HasIOProxy",
+	"HasVM", "HasCheckpointing", "HasRemoteSyscalls", "HasJava",
+	"JavaVendor", "JavaVersion", "JavaMFlops", "JavaSpecificationVersion",
+	"StarterAbilityList", "FileTransferPlugins", "HasFileTransferPluginMethods",
+	"TotalTimeUnclaimedIdle", "TotalTimeClaimedBusy", "TotalTimeClaimedIdle",
+	"TotalTimeOwnerIdle", "TotalTimeMatchedIdle", "TotalTimePreemptingVacating",
+	"TotalTimePreemptingKilling", "TotalTimeBackfillIdle",
+	"TotalTimeBackfillBusy", "TotalTimeClaimedRetiring",
+	"TotalTimeClaimedSuspended", "TotalClaimRunTime", "TotalClaimSuspendTime",
+	"TotalJobRunTime", "TotalJobSuspendTime", "RecentJobRankPreemptions",
+	"RecentJobUserPrioPreemptions", "JobRankPreemptions",
+	"JobUserPrioPreemptions", "JobPreemptions", "RecentJobStarts",
+	"JobStarts", "RecentDaemonCoreDutyCycle", "DaemonCoreDutyCycle",
+	"MachineMaxVacateTime", "MaxJobRetirementTime", "ExpectedMachineGracefulDrainingBadput",
+	"ExpectedMachineGracefulDrainingCompletion", "ExpectedMachineQuickDrainingBadput",
+	"ExpectedMachineQuickDrainingCompletion", "AcceptedWhileDraining",
+	"ClockMin", "ClockDay", "LastBenchmark", "LastFetchWorkSpawned",
+	"LastFetchWorkCompleted", "NextFetchWorkDelay", "MachineResources",
+	"AssignedGPUs", "DetectedGPUs", "GPUs", "TotalGPUs", "CpuBusy",
+	"CpuBusyTime", "CpuIsBusy", "NiceUser", "Owner", "Preempt", "Suspend",
+	"Continue", "Vacate", "Kill", "PeriodicCheckpoint", "WantSuspend",
+	"WantVacate", "WantHold", "COLLECTOR_HOST_STRING", "ConsumptionCpus",
+	"ConsumptionMemory", "ConsumptionDisk", "Offline",
+		// job ads
+	"ClusterId", "ProcId", "Cmd", "Args", "Arguments", "Environment", "Env",
+	"In", "Out", "Err", "Iwd", "JobUniverse", "JobStatus", "LastJobStatus",
+	"JobPrio", "QDate", "CompletionDate", "EnteredCurrentStatus",
+	"JobCurrentStartDate", "JobStartDate", "JobLastStartDate",
+	"JobRunCount", "NumJobStarts", "NumShadowStarts", "NumRestarts",
+	"NumCkpts", "NumSystemHolds", "NumJobMatches", "LastMatchTime",
+	"LastRejMatchTime", "LastRejMatchReason", "User", "NTDomain",
+	"ImageSize", "ImageSize_RAW", "ResidentSetSize", "ResidentSetSize_RAW",
+	"ProportionalSetSizeKb", "MemoryUsage", "DiskUsage", "DiskUsage_RAW",
+	"ExecutableSize", "ExecutableSize_RAW", "RequestCpus", "RequestMemory",
+	"RequestDisk", "RequestGPUs", "RemoteWallClockTime", "CumulativeSlotTime",
+	"CommittedTime", "CommittedSlotTime", "CommittedSuspensionTime",
+	"RemoteUserCpu", "RemoteSysCpu", "LocalUserCpu", "LocalSysCpu",
+	"CumulativeSuspensionTime", "LastSuspensionTime", "TotalSuspensions",
+	"ExitStatus", "ExitCode", "ExitBySignal", "ExitSignal",
+	"OnExitHold", "OnExitRemove", "PeriodicHold", "PeriodicRelease",
+	"PeriodicRemove", "LeaveJobInQueue", "HoldReason", "HoldReasonCode",
+	"HoldReasonSubCode", "ReleaseReason", "RemoveReason", "EnteredHoldStatus",
+	"ShouldTransferFiles", "WhenToTransferOutput", "TransferIn",
+	"TransferInput", "TransferOutput", "TransferExecutable", "TransferFiles",
+	"TransferInputSizeMB", "StreamOut", "StreamErr", "BufferSize",
+	"BufferBlockSize", "CoreSize", "KillSig",
+	"JobNotification", "NotifyUser", "UserLog", "WantRemoteSyscalls",
+	"WantCheckpoint", "WantRemoteIO", "MinHosts", "MaxHosts",
+	"JobLeaseDuration", "LastJobLeaseRenewal",
+	"AutoClusterId", "AutoClusterAttrs", "RemoteHost", "LastRemoteHost",
+	"StartdPrincipal", "ShadowBday", "OrigMaxHosts", "CurrentHosts",
+	"RootDir", "JobAdInformationAttrs", "ConcurrencyLimits",
+	"x509userproxy", "x509userproxysubject", "x509UserProxyExpiration",
+	"x509UserProxyFQAN", "x509UserProxyFirstFQAN", "x509UserProxyVOName",
+	"SUBMIT_Cmd", "SUBMIT_Iwd", "SUBMIT_TransferOutputRemaps", "DAGManJobId",
+	"DAGNodeName", "DAGParentNodeNames", "DAGManNodesLog", "DAGManNodesMask",
+	"StageInStart", "StageInFinish", "JobMaxVacateTime", "WantMatchDiagnostics",
+	"NumJobReconnects", "LastVacateTime", "JobRequiresSandbox",
+	"RecentBlockReads", "RecentBlockWrites", "RecentBlockReadKbytes",
+	"RecentBlockWriteKbytes", "BlockReads", "BlockWrites", "BlockReadKbytes",
+	"BlockWriteKbytes", "BytesSent", "BytesRecvd", "LastCkptTime",
+	"MachineAttrCpus0", "MachineAttrSlotWeight0", "StartdSlotAttrs",
+	"RequestedChroot", "TransferQueued", "TransferringInput",
+	"TransferringOutput", "ServerTime",
+		// functions
+	"ifThenElse", "isUndefined", "isError", "isString", "isInteger",
+	"isReal", "isBoolean", "isList", "isClassAd", "member", "identicalMember",
+	"stringListMember", "stringListIMember", "stringListSize", "stringListSum",
+	"stringListAvg", "stringListMin", "stringListMax", "stringListsIntersect",
+	"regexp", "regexpMember", "regexps", "substr", "strcat", "strcmp",
+	"stricmp", "toUpper", "toLower", "size", "sum", "avg", "min", "max",
+	"anycompare", "allcompare", "time", "int", "real", "string", "bool",
+	"floor", "ceiling", "round", "random", "pow", "quantize", "eval",
+	"envV1ToV2", "mergeEnvironment", "splitUserName", "splitSlotName",
+	"formatTime", "interval", "unparse", "userHome", "debug",
+};
+
+static const size_t name_dictionary_size =
+	sizeof(name_dictionary) / sizeof(name_dictionary[0]);
+
+typedef std::map<std::string,int> NameIndex;
+
+	// exact-spelling lookup from name to (dictionary index + 1)
+static const NameIndex &
+dictionary_index()
+{
+	static NameIndex index;
+	if ( index.empty() ) {
+		for ( size_t i = 0; i < name_dictionary_size; i++ ) {
+			index.insert( NameIndex::value_type( name_dictionary[i], (int)i + 1 ) );
+		}
+	}
+	return index;
+}
+
+ClassAdBinaryWriter::ClassAdBinaryWriter()
+	: m_count(0)
+{
+	dictionary_index();
+}
+
+void
+ClassAdBinaryWriter::Clear()
+{
+	m_body.clear();
+	m_names.clear();
+	m_count = 0;
+}
+
+void
+ClassAdBinaryWriter::PutVarint( unsigned long long v )
+{
+	while ( v >= 0x80 ) {
+		PutByte( (unsigned char)(v | 0x80) );
+		v >>= 7;
+	}
+	PutByte( (unsigned char)v );
+}
+
+void
+ClassAdBinaryWriter::PutSigned( long long v )
+{
+	PutVarint( ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63) );
+}
+
+void
+ClassAdBinaryWriter::PutDouble( double d )
+{
+	unsigned long long bits;
+	memcpy( &bits, &d, sizeof(bits) );
+	for ( int i = 0; i < 8; i++ ) {
+		PutByte( (unsigned char)(bits >> (8*i)) );
+	}
+}
+
+void
+ClassAdBinaryWriter::PutBytes( const char *data, size_t len )
+{
+	PutVarint( len );
+	m_body.append( data, len );
+}
+
+void
+ClassAdBinaryWriter::PutName( const std::string &name )
+{
+	const NameIndex &dict = dictionary_index();
+	NameIndex::const_iterator it = dict.find( name );
+	if ( it != dict.end() ) {
+		PutVarint( it->second );
+		return;
+	}
+	it = m_names.find( name );
+	if ( it != m_names.end() ) {
+		PutVarint( name_dictionary_size + 1 + it->second );
+		return;
+	}
+	int slot = (int)m_names.size();
+	m_names.insert( NameIndex::value_type( name, slot ) );
+	PutVarint( 0 );
+	PutBytes( name.data(), name.size() );
+}
+
+bool
+ClassAdBinaryWriter::PutValue( const classad::Value &val, classad::Value::NumberFactor factor )
+{
+	bool b;
+	long long i;
+	double r;
+	const char *s;
+	classad::abstime_t at;
+
+	switch ( val.GetType() ) {
+	case classad::Value::UNDEFINED_VALUE:
+		PutByte( TAG_UNDEFINED );
+		return true;
+	case classad::Value::ERROR_VALUE:
+		PutByte( TAG_ERROR );
+		return true;
+	case classad::Value::BOOLEAN_VALUE:
+		val.IsBooleanValue( b );
+		PutByte( b ? TAG_TRUE : TAG_FALSE );
+		return true;
+	case classad::Value::INTEGER_VALUE:
+		val.IsIntegerValue( i );
+		if ( factor == classad::Value::NO_FACTOR ) {
+			PutByte( TAG_INTEGER );
+		} else {
+			PutByte( TAG_INTEGER_FACTOR );
+			PutByte( (unsigned char)factor );
+		}
+		PutSigned( i );
+		return true;
+	case classad::Value::REAL_VALUE:
+		val.IsRealValue( r );
+		if ( factor == classad::Value::NO_FACTOR ) {
+			PutByte( TAG_REAL );
+		} else {
+			PutByte( TAG_REAL_FACTOR );
+			PutByte( (unsigned char)factor );
+		}
+		PutDouble( r );
+		return true;
+	case classad::Value::STRING_VALUE: {
+		int len = 0;
+		val.IsStringValue( s );
+		val.IsStringValue( len );
+		PutByte( TAG_STRING );
+		PutBytes( s, len );
+		return true;
+	}
+	case classad::Value::ABSOLUTE_TIME_VALUE:
+		val.IsAbsoluteTimeValue( at );
+		PutByte( TAG_ABSTIME );
+		PutSigned( at.secs );
+		PutSigned( at.offset );
+		return true;
+	case classad::Value::RELATIVE_TIME_VALUE:
+		val.IsRelativeTimeValue( r );
+		PutByte( TAG_RELTIME );
+		PutDouble( r );
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool
+ClassAdBinaryWriter::PutExpr( const classad::ExprTree *expr, int depth )
+{
+	if ( !expr || depth > MAX_DEPTH ) {
+		return false;
+	}
+	expr = expr->self();
+
+	switch ( expr->GetKind() ) {
+	case classad::ExprTree::LITERAL_NODE: {
+		classad::Value val;
+		classad::Value::NumberFactor factor;
+		((const classad::Literal *)expr)->GetComponents( val, factor );
+		return PutValue( val, factor );
+	}
+	case classad::ExprTree::ATTRREF_NODE: {
+		classad::ExprTree *scope = NULL;
+		std::string attr;
+		bool absolute = false;
+		((const classad::AttributeReference *)expr)->GetComponents( scope, attr, absolute );
+		PutByte( TAG_ATTRREF );
+		PutByte( (absolute ? 1 : 0) | (scope ? 2 : 0) );
+		if ( scope && !PutExpr( scope, depth + 1 ) ) {
+			return false;
+		}
+		PutName( attr );
+		return true;
+	}
+	case classad::ExprTree::OP_NODE: {
+		classad::Operation::OpKind op;
+		classad::ExprTree *e[3] = { NULL, NULL, NULL };
+		((const classad::Operation *)expr)->GetComponents( op, e[0], e[1], e[2] );
+		PutByte( TAG_OPERATION );
+		PutByte( (unsigned char)op );
+		PutByte( (e[0] ? 1 : 0) | (e[1] ? 2 : 0) | (e[2] ? 4 : 0) );
+		for ( int i = 0; i < 3; i++ ) {
+			if ( e[i] && !PutExpr( e[i], depth + 1 ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+	case classad::ExprTree::FN_CALL_NODE: {
+		std::string fn;
+		std::vector<classad::ExprTree*> args;
+		((const classad::FunctionCall *)expr)->GetComponents( fn, args );
+		PutByte( TAG_FUNCTION );
+		PutName( fn );
+		PutVarint( args.size() );
+		for ( size_t i = 0; i < args.size(); i++ ) {
+			if ( !PutExpr( args[i], depth + 1 ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+	case classad::ExprTree::CLASSAD_NODE: {
+		const classad::ClassAd *ad = (const classad::ClassAd *)expr;
+		PutByte( TAG_CLASSAD );
+		PutVarint( ad->size() );
+		for ( classad::ClassAd::const_iterator it = ad->begin(); it != ad->end(); ++it ) {
+			PutName( it->first );
+			if ( !PutExpr( it->second, depth + 1 ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+	case classad::ExprTree::EXPR_LIST_NODE: {
+		std::vector<classad::ExprTree*> items;
+		((const classad::ExprList *)expr)->GetComponents( items );
+		PutByte( TAG_LIST );
+		PutVarint( items.size() );
+		for ( size_t i = 0; i < items.size(); i++ ) {
+			if ( !PutExpr( items[i], depth + 1 ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+void
+ClassAdBinaryWriter::PutText( const classad::ExprTree *expr )
+{
+	std::string text;
+	m_unparser.Unparse( text, expr );
+	PutByte( TAG_TEXT );
+	PutBytes( text.data(), text.size() );
+}
+
+void
+ClassAdBinaryWriter::Add( const std::string &attr, const classad::ExprTree *expr )
+{
+	PutName( attr );
+	size_t mark = m_body.size();
+	if ( !PutExpr( expr, 0 ) ) {
+			// Throw away the partial tree (any names it sent inline
+			// stay in the table, which is harmless) and send text.
+		m_body.resize( mark );
+		PutText( expr );
+	}
+	m_count++;
+}
+
+void
+ClassAdBinaryWriter::AddLiteral( const std::string &attr, const classad::Value &val,
+								 classad::Value::NumberFactor factor )
+{
+	PutName( attr );
+	if ( !PutValue( val, factor ) ) {
+		classad::ExprTree *lit = classad::Literal::MakeLiteral( val, factor );
+		if ( lit ) {
+			PutText( lit );
+			delete lit;
+		} else {
+			PutByte( TAG_UNDEFINED );
+		}
+	}
+	m_count++;
+}
+
+const std::string &
+ClassAdBinaryWriter::Finish()
+{
+	std::string body;
+	body.swap( m_body );
+	PutByte( CLASSAD_BINARY_VERSION );
+	PutVarint( name_dictionary_size );
+	PutVarint( m_count );
+	m_result.swap( m_body );
+	m_result += body;
+	Clear();
+	return m_result;
+}
+
+
+namespace {
+
+class BinaryReader {
+ public:
+	BinaryReader( const char *data, size_t len )
+		: m_ptr( (const unsigned char *)data ),
+		  m_end( (const unsigned char *)data + len ),
+		  m_dict_size( 0 )
+	{}
+
+	bool Parse( classad::ClassAd &ad );
+
+ private:
+	bool GetByte( unsigned char &c ) {
+		if ( m_ptr >= m_end ) { return false; }
+		c = *m_ptr++;
+		return true;
+	}
+	bool GetVarint( unsigned long long &v );
+	bool GetSigned( long long &v );
+	bool GetDouble( double &d );
+	bool GetBytes( std::string &str );
+	bool GetName( std::string &name );
+	bool GetFactor( classad::Value::NumberFactor &factor );
+	classad::ExprTree *GetExpr( int depth );
+	bool GetOperands( std::vector<classad::ExprTree*> &items, int depth );
+
+	const unsigned char *m_ptr;
+	const unsigned char *m_end;
+	unsigned long long m_dict_size;
+	std::vector<std::string> m_names;
+	classad::ClassAdParser m_parser;
+	classad::ClassAdUnParser m_unparser;
+	std::string m_text;
+};
+
+bool
+BinaryReader::GetVarint( unsigned long long &v )
+{
+	v = 0;
+	for ( int shift = 0; shift < 64; shift += 7 ) {
+		unsigned char c;
+		if ( !GetByte( c ) ) {
+			return false;
+		}
+		v |= (unsigned long long)(c & 0x7f) << shift;
+		if ( !(c & 0x80) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+BinaryReader::GetSigned( long long &v )
+{
+	unsigned long long u;
+	if ( !GetVarint( u ) ) {
+		return false;
+	}
+	v = (long long)(u >> 1) ^ -(long long)(u & 1);
+	return true;
+}
+
+bool
+BinaryReader::GetDouble( double &d )
+{
+	if ( m_end - m_ptr < 8 ) {
+		return false;
+	}
+	unsigned long long bits = 0;
+	for ( int i = 0; i < 8; i++ ) {
+		bits |= (unsigned long long)m_ptr[i] << (8*i);
+	}
+	m_ptr += 8;
+	memcpy( &d, &bits, sizeof(d) );
+	return true;
+}
+
+bool
+BinaryReader::GetBytes( std::string &str )
+{
+	unsigned long long len;
+	if ( !GetVarint( len ) || len > (unsigned long long)(m_end - m_ptr) ) {
+		return false;
+	}
+	str.assign( (const char *)m_ptr, (size_t)len );
+	m_ptr += len;
+	return true;
+}
+
+bool
+BinaryReader::GetName( std::string &name )
+{
+	unsigned long long n;
+	if ( !GetVarint( n ) ) {
+		return false;
+	}
+	if ( n == 0 ) {
+		if ( !GetBytes( name ) || name.empty() ) {
+			return false;
+		}
+		m_names.push_back( name );
+		return true;
+	}
+	if ( n <= m_dict_size ) {
+		name = name_dictionary[n - 1];
+		return true;
+	}
+	n -= m_dict_size + 1;
+	if ( n >= m_names.size() ) {
+		return false;
+	}
+	name = m_names[n];
+	return true;
+}
+
+bool
+BinaryReader::GetFactor( classad::Value::NumberFactor &factor )
+{
+	unsigned char c;
+	if ( !GetByte( c ) || c > classad::Value::T_FACTOR ) {
+		return false;
+	}
+	factor = (classad::Value::NumberFactor)c;
+	return true;
+}
+
+bool
+BinaryReader::GetOperands( std::vector<classad::ExprTree*> &items, int depth )
+{
+	unsigned long long count;
+	if ( !GetVarint( count ) || count > (unsigned long long)(m_end - m_ptr) ) {
+		return false;
+	}
+	for ( unsigned long long i = 0; i < count; i++ ) {
+		classad::ExprTree *item = GetExpr( depth + 1 );
+		if ( !item ) {
+			for ( size_t j = 0; j < items.size(); j++ ) {
+				delete items[j];
+			}
+			items.clear();
+			return false;
+		}
+		items.push_back( item );
+	}
+	return true;
+}
+
+classad::ExprTree *
+BinaryReader::GetExpr( int depth )
+{
+	unsigned char tag;
+	if ( depth > MAX_DEPTH || !GetByte( tag ) ) {
+		return NULL;
+	}
+
+	classad::Value val;
+	classad::Value::NumberFactor factor = classad::Value::NO_FACTOR;
+	long long i;
+	double r;
+	std::string str;
+
+	switch ( tag ) {
+	case TAG_UNDEFINED:
+		val.SetUndefinedValue();
+		break;
+	case TAG_ERROR:
+		val.SetErrorValue();
+		break;
+	case TAG_TRUE:
+	case TAG_FALSE:
+		val.SetBooleanValue( tag == TAG_TRUE );
+		break;
+	case TAG_INTEGER_FACTOR:
+		if ( !GetFactor( factor ) ) { return NULL; }
+		// fall through
+	case TAG_INTEGER:
+		if ( !GetSigned( i ) ) { return NULL; }
+		val.SetIntegerValue( i );
+		break;
+	case TAG_REAL_FACTOR:
+		if ( !GetFactor( factor ) ) { return NULL; }
+		// fall through
+	case TAG_REAL:
+		if ( !GetDouble( r ) ) { return NULL; }
+		val.SetRealValue( r );
+		break;
+	case TAG_STRING:
+		if ( !GetBytes( str ) ) { return NULL; }
+		val.SetStringValue( str );
+		break;
+	case TAG_ABSTIME: {
+		long long secs, offset;
+		if ( !GetSigned( secs ) || !GetSigned( offset ) ) { return NULL; }
+		classad::abstime_t at;
+		at.secs = (time_t)secs;
+		at.offset = (int)offset;
+		val.SetAbsoluteTimeValue( at );
+		break;
+	}
+	case TAG_RELTIME:
+		if ( !GetDouble( r ) ) { return NULL; }
+		val.SetRelativeTimeValue( r );
+		break;
+
+	case TAG_ATTRREF: {
+		unsigned char flags;
+		classad::ExprTree *scope = NULL;
+		if ( !GetByte( flags ) ) { return NULL; }
+		if ( (flags & 2) && !(scope = GetExpr( depth + 1 )) ) {
+			return NULL;
+		}
+		if ( !GetName( str ) ) {
+			delete scope;
+			return NULL;
+		}
+		return classad::AttributeReference::MakeAttributeReference( scope, str, (flags & 1) != 0 );
+	}
+	case TAG_OPERATION: {
+		unsigned char op, mask;
+		if ( !GetByte( op ) || !GetByte( mask ) ||
+			 op < classad::Operation::__FIRST_OP__ ||
+			 op > classad::Operation::__LAST_OP__ )
+		{
+			return NULL;
+		}
+		classad::ExprTree *e[3] = { NULL, NULL, NULL };
+		for ( int n = 0; n < 3; n++ ) {
+			if ( (mask & (1 << n)) && !(e[n] = GetExpr( depth + 1 )) ) {
+				delete e[0];
+				delete e[1];
+				return NULL;
+			}
+		}
+		classad::ExprTree *tree = classad::Operation::MakeOperation(
+			(classad::Operation::OpKind)op, e[0], e[1], e[2] );
+		if ( !tree ) {
+			delete e[0];
+			delete e[1];
+			delete e[2];
+		}
+		return tree;
+	}
+	case TAG_FUNCTION: {
+		std::vector<classad::ExprTree*> args;
+		if ( !GetName( str ) || !GetOperands( args, depth ) ) {
+			return NULL;
+		}
+		return classad::FunctionCall::MakeFunctionCall( str, args );
+	}
+	case TAG_CLASSAD: {
+		unsigned long long count;
+		if ( !GetVarint( count ) || count > (unsigned long long)(m_end - m_ptr) ) {
+			return NULL;
+		}
+		classad::ClassAd *ad = new classad::ClassAd();
+		for ( unsigned long long n = 0; n < count; n++ ) {
+			classad::ExprTree *tree = NULL;
+			if ( !GetName( str ) || !(tree = GetExpr( depth + 1 )) ||
+				 !ad->Insert( str, tree, false ) )
+			{
+				delete tree;
+				delete ad;
+				return NULL;
+			}
+		}
+		return ad;
+	}
+	case TAG_LIST: {
+		std::vector<classad::ExprTree*> items;
+		if ( !GetOperands( items, depth ) ) {
+			return NULL;
+		}
+		return classad::ExprList::MakeExprList( items );
+	}
+	case TAG_TEXT:
+		if ( !GetBytes( str ) ) { return NULL; }
+		return m_parser.ParseExpression( str );
+
+	default:
+		return NULL;
+	}
+
+	return classad::Literal::MakeLiteral( val, factor );
+}
+
+bool
+BinaryReader::Parse( classad::ClassAd &ad )
+{
+	unsigned char version;
+	unsigned long long count;
+	if ( !GetByte( version ) ) {
+		return false;
+	}
+	if ( version != CLASSAD_BINARY_VERSION ) {
+		dprintf( D_FULLDEBUG, "Binary ClassAd has unknown format version %d\n",
+				 (int)version );
+		return false;
+	}
+	if ( !GetVarint( m_dict_size ) || !GetVarint( count ) ) {
+		return false;
+	}
+	if ( m_dict_size > name_dictionary_size ) {
+		dprintf( D_FULLDEBUG, "Binary ClassAd uses a name dictionary of %llu "
+				 "entries, but only %u are known\n",
+				 m_dict_size, (unsigned)name_dictionary_size );
+		return false;
+	}
+
+	bool caching = classad::ClassAdGetExpressionCaching();
+	std::string name;
+	for ( unsigned long long n = 0; n < count; n++ ) {
+		if ( !GetName( name ) ) {
+			return false;
+		}
+			// Insert through the expression cache, as the text format
+			// does, so that ads received either way share their trees.
+			// Attributes sent as text need not be parsed at all on a
+			// cache hit.
+		if ( m_ptr < m_end && *m_ptr == TAG_TEXT ) {
+			m_ptr++;
+			if ( !GetBytes( m_text ) || !ad.InsertViaCache( name, m_text ) ) {
+				dprintf( D_FULLDEBUG, "Failed to insert binary ClassAd attribute %s\n",
+						 name.c_str() );
+				return false;
+			}
+			continue;
+		}
+		classad::ExprTree *tree = GetExpr( 0 );
+		if ( !tree ) {
+			dprintf( D_FULLDEBUG, "Failed to decode binary ClassAd attribute %s\n",
+					 name.c_str() );
+			return false;
+		}
+		if ( caching ) {
+			m_text.clear();
+			m_unparser.Unparse( m_text, tree );
+			if ( !ad.InsertViaCache( name, m_text, tree ) ) {
+				return false;
+			}
+		} else if ( !ad.Insert( name, tree, false ) ) {
+			delete tree;
+			return false;
+		}
+	}
+	return m_ptr == m_end;
+}
+
+} // namespace
+
+bool
+ParseBinaryClassAd( const char *data, size_t len, classad::ClassAd &ad )
+{
+	BinaryReader reader( data, len );
+	return reader.Parse( ad );
+}
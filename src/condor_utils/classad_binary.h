@@ -0,0 +1,97 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _CLASSAD_BINARY_H
+#define _CLASSAD_BINARY_H
+
+/*
+  Compact binary encoding of a set of ClassAd attributes.
+
+  putClassAd() uses this in place of one "Name = expr" string per
+  attribute when the peer is new enough to understand it (see
+  classad_oldnew.cpp).  Expression trees are sent already tokenized,
+  literals are sent in binary, and attribute and function names are
+  sent as small integers when they appear in a dictionary of common
+  names compiled into both ends, or when they already appeared earlier
+  in the same ad.  The receiver builds the trees directly, without
+  running the ClassAd lexer or parser.
+
+  Anything the encoder does not know how to represent as a tree is
+  sent as new-ClassAd expression text and parsed by the receiver, so
+  every ad can be encoded.
+*/
+
+#include "classad/classad_distribution.h"
+#include <string>
+#include <vector>
+#include <map>
+
+// Sent in place of the attribute count by putClassAd() to announce
+// that the ad follows in binary.  Old receivers never see it, and it
+// must be negative so that it can never be mistaken for a count.
+#define CLASSAD_BINARY_MAGIC (-0x43414442)
+
+class ClassAdBinaryWriter {
+ public:
+	ClassAdBinaryWriter();
+
+		// Forget everything added so far.
+	void Clear();
+
+		// Append an attribute whose value is the given expression.
+	void Add( const std::string &attr, const classad::ExprTree *expr );
+
+		// Append an attribute whose value is the given literal.
+	void AddLiteral( const std::string &attr, const classad::Value &val,
+					 classad::Value::NumberFactor factor = classad::Value::NO_FACTOR );
+
+		// Number of attributes added since the last Clear().
+	int Count() const { return m_count; }
+
+		// Returns the encoded attributes, ready to be handed to
+		// ParseBinaryClassAd().  Valid until the next call to any
+		// other method.
+	const std::string &Finish();
+
+ private:
+	void PutByte( unsigned char c ) { m_body += (char)c; }
+	void PutVarint( unsigned long long v );
+	void PutSigned( long long v );
+	void PutDouble( double d );
+	void PutBytes( const char *data, size_t len );
+	void PutName( const std::string &name );
+	bool PutValue( const classad::Value &val, classad::Value::NumberFactor factor );
+	bool PutExpr( const classad::ExprTree *expr, int depth );
+	void PutText( const classad::ExprTree *expr );
+
+	std::string m_body;
+	std::string m_result;
+	int m_count;
+		// names already sent inline in this ad; case-sensitive since
+		// the receiver must see the same spelling we have
+	std::map<std::string,int> m_names;
+	classad::ClassAdUnParser m_unparser;
+};
+
+// Decode attributes produced by ClassAdBinaryWriter and insert them
+// into ad, in the order they were added.  Returns false if the data
+// is malformed, in which case ad may hold some of the attributes.
+bool ParseBinaryClassAd( const char *data, size_t len, classad::ClassAd &ad );
+
+#endif
@@ -141,6 +141,13 @@ public:
 		// This means doing both a flush and fsync.
   void ForceLog() { ClassAdLog::ForceLog(); }
 
+  		// Group commit, see ClassAdLog::CommitGroupedTransaction().
+  unsigned long CommitGroupedTransaction() { return ClassAdLog::CommitGroupedTransaction(); }
+  void SyncLog() { ClassAdLog::SyncLog(); }
+  unsigned long SyncedCommitSequence() { return ClassAdLog::SyncedCommitSequence(); }
+  int PendingSyncTransactions() { return ClassAdLog::PendingSyncTransactions(); }
+  long long PendingSyncBytes() { return ClassAdLog::PendingSyncBytes(); }
+
   ///
   Transaction* getActiveTransaction() { return ClassAdLog::getActiveTransaction(); }
   ///
@@ -59,15 +59,29 @@ const char *EMPTY_CLASSAD_TYPE_NAME = "(empty)";
 ClassAdLogFilterIterator::ClassAdLogFilterIterator(ClassAdHashTable *table, const classad::ExprTree *requirements, int timeslice_ms, bool invalid)
 	: m_table(table),
 	  m_cur(table->begin()),
+	  m_key_pos(0),
 	  m_found_ad(false),
 	  m_requirements(requirements),
 	  m_timeslice_ms(timeslice_ms),
 	  m_done(invalid)
 	{}
 
+ClassAdLogFilterIterator::ClassAdLogFilterIterator(ClassAdHashTable *table, const classad::ExprTree *requirements, int timeslice_ms, classad_shared_ptr<std::vector<std::string> > keys)
+	: m_table(table),
+	  m_cur(table->begin()),
+	  m_keys(keys),
+	  m_key_pos(0),
+	  m_found_ad(false),
+	  m_requirements(requirements),
+	  m_timeslice_ms(timeslice_ms),
+	  m_done(false)
+	{}
+
 ClassAdLogFilterIterator::ClassAdLogFilterIterator(const ClassAdLogFilterIterator &other)
 	: m_table(other.m_table),
 	  m_cur(other.m_cur),
+	  m_keys(other.m_keys),
+	  m_key_pos(other.m_key_pos),
 	  m_found_ad(other.m_found_ad),
 	  m_requirements(other.m_requirements),
 	  m_timeslice_ms(other.m_timeslice_ms),
@@ -75,12 +89,34 @@ ClassAdLogFilterIterator::ClassAdLogFilterIterator(const ClassAdLogFilterIterato
 {
 }
 
+bool
+ClassAdLogFilterIterator::AtEnd() const
+{
+	if (m_keys.get()) {
+		return m_key_pos >= m_keys->size();
+	}
+	return m_cur == m_table->end();
+}
+
+ClassAd *
+ClassAdLogFilterIterator::CurrentAd() const
+{
+	if (m_keys.get()) {
+		ClassAd *ad = NULL;
+		if (m_table->lookup(HashKey((*m_keys)[m_key_pos].c_str()), ad) < 0) {
+			return NULL;
+		}
+		return ad;
+	}
+	return (*m_cur).second;
+}
+
 ClassAd* ClassAdLogFilterIterator::operator *() const {
-	if (m_done || (m_cur == m_table->end()) || !m_found_ad)
+	if (m_done || AtEnd() || !m_found_ad)
 	{
 		return NULL;
 	}
-	return (*m_cur).second;
+	return CurrentAd();
 }
 
 ClassAdLogFilterIterator
@@ -92,11 +128,10 @@ ClassAdLogFilterIterator::operator++(int)
 		return cur;
 	}
 
-	HashIterator<HashKey, ClassAd*> end = m_table->end();
 	bool boolVal;
 	int intVal;
 	int miss_count = 0;
-	while (!(m_cur == end))
+	while (!AtEnd())
 	{
 		miss_count++;
 		if (miss_count == m_timeslice_ms)
@@ -104,7 +139,13 @@ ClassAdLogFilterIterator::operator++(int)
 			break;
 		}
 		cur = *this;
-		ClassAd *tmp_ad = (*m_cur++).second;
+		ClassAd *tmp_ad = CurrentAd();
+		if (m_keys.get()) {
+			m_key_pos++;
+		}
+		else {
+			m_cur++;
+		}
 		if (!tmp_ad) continue;
 		if (m_requirements) {
 			classad::ExprTree &requirements = *const_cast<classad::ExprTree*>(m_requirements);
@@ -134,7 +175,7 @@ ClassAdLogFilterIterator::operator++(int)
 		m_found_ad = true;
 		break;
 	}
-	if ((m_cur == end) && (!m_found_ad)) {
+	if (AtEnd() && (!m_found_ad)) {
 		m_done = true;
 	}
 	return cur;
@@ -146,6 +187,8 @@ ClassAdLogFilterIterator::operator==(const ClassAdLogFilterIterator &other)
 	if (m_table != other.m_table) return false;
 	if (m_done && other.m_done) return true;
 	if (m_done != other.m_done) return false;
+	if (m_keys != other.m_keys) return false;
+	if (m_keys.get()) return m_key_pos == other.m_key_pos;
 	if (!(m_cur == other.m_cur) ) return false;
 	return true;
 }
@@ -157,6 +200,8 @@ ClassAdLog::ClassAdLog() : table(CLASSAD_LOG_HASHTABLE_SIZE, hashFunction)
 	m_nondurable_level = 0;
 	max_historical_logs = 0;
 	historical_sequence_number = 0;
+	m_commit_seq = m_synced_seq = 0;
+	m_synced_size = m_unsynced_bytes = 0;
 }
 
 ClassAdLog::ClassAdLog(const char *filename,int max_historical_logs_arg) : table(CLASSAD_LOG_HASHTABLE_SIZE, hashFunction)
@@ -164,6 +209,8 @@ ClassAdLog::ClassAdLog(const char *filename,int max_historical_logs_arg) : table
 	log_filename_buf = filename;
 	active_transaction = NULL;
 	m_nondurable_level = 0;
+	m_commit_seq = m_synced_seq = 0;
+	m_synced_size = m_unsynced_bytes = 0;
 
 	bool open_read_only = max_historical_logs_arg < 0;
 	if (open_read_only) { max_historical_logs_arg = -max_historical_logs_arg; }
@@ -278,6 +325,7 @@ ClassAdLog::ClassAdLog(const char *filename,int max_historical_logs_arg) : table
 			EXCEPT("Failed to rotate ClassAd log %s.", logFilename());
 		}
 	}
+	m_synced_size = LogSize();
 }
 
 ClassAdLog::~ClassAdLog()
@@ -343,6 +391,36 @@ ClassAdLog::ForceLog()
 		}
 
 	}
+	NoteLogSynced();
+}
+
+void
+ClassAdLog::SyncLog()
+{
+	if (SyncPending()) {
+		ForceLog();
+	}
+}
+
+long long
+ClassAdLog::LogSize()
+{
+	struct stat st;
+	if (log_fp == NULL || fstat(fileno(log_fp), &st) < 0) {
+		return 0;
+	}
+	return (long long)st.st_size;
+}
+
+	// Everything committed so far is now on disk.
+void
+ClassAdLog::NoteLogSynced()
+{
+	if (m_synced_seq != m_commit_seq || m_unsynced_bytes) {
+		m_synced_seq = m_commit_seq;
+		m_synced_size = LogSize();
+		m_unsynced_bytes = 0;
+	}
 }
 
 
@@ -406,6 +484,9 @@ ClassAdLog::TruncLog()
 
 	dprintf(D_ALWAYS,"About to rotate ClassAd log %s\n",logFilename());
 
+		// grouped commits must not be lost if the rotation fails
+	SyncLog();
+
 	if(!SaveHistoricalLogs()) {
 		dprintf(D_ALWAYS,"Skipping log rotation, because saving of historical log failed for %s.\n",logFilename());
 		return false;
@@ -490,6 +571,7 @@ ClassAdLog::TruncLog()
 		EXCEPT("failed to fdopen log in append mode: "
 			"fdopen(%s) returns %d\n", logFilename(), log_fd);
 	}
+	m_synced_size = LogSize();
 
 	return true;
 }
@@ -540,11 +622,34 @@ ClassAdLog::CommitTransaction()
 		active_transaction->AppendLog(log);
 		bool nondurable = m_nondurable_level > 0;
 		active_transaction->Commit(log_fp, (void *)&table, nondurable );
+		if( !nondurable ) {
+			NoteLogSynced();
+		}
 	}
 	delete active_transaction;
 	active_transaction = NULL;
 }
 
+unsigned long
+ClassAdLog::CommitGroupedTransaction()
+{
+	if (active_transaction && !active_transaction->EmptyTransaction()) {
+		int old_level = IncNondurableCommitLevel();
+		CommitTransaction();
+		DecNondurableCommitLevel( old_level );
+
+			// Make it visible to readers of the log right away; only
+			// the fsync is deferred.
+		FlushLog();
+		m_commit_seq++;
+		m_unsynced_bytes = LogSize() - m_synced_size;
+	}
+	else {
+		CommitTransaction();
+	}
+	return m_commit_seq;
+}
+
 void
 ClassAdLog::CommitNondurableTransaction()
 {
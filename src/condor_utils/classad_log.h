@@ -46,6 +46,8 @@
 #include "log.h"
 #include "classad_hashtable.h"
 #include "log_transaction.h"
+#include <string>
+#include <vector>
 
 
 typedef HashTable <HashKey, ClassAd *> ClassAdHashTable;
@@ -78,9 +80,18 @@ private:
 	friend ClassAdLogFilterIterator EndIterator();
 
 	ClassAdLogFilterIterator(ClassAdHashTable *table, const classad::ExprTree *requirements, int timeslice_ms, bool invalid=false);
+		// Visit only the ads with the given keys, in that order, rather
+		// than the whole table; e.g. the candidates found in an index.
+		// Keys that are no longer in the table are skipped.
+	ClassAdLogFilterIterator(ClassAdHashTable *table, const classad::ExprTree *requirements, int timeslice_ms, classad_shared_ptr<std::vector<std::string> > keys);
+
+	bool AtEnd() const;
+	ClassAd *CurrentAd() const;
 
 	ClassAdHashTable *m_table;
 	HashIterator<HashKey, ClassAd *> m_cur;
+	classad_shared_ptr<std::vector<std::string> > m_keys;
+	size_t m_key_pos;
 	bool m_found_ad;
 	const classad::ExprTree *m_requirements;
 	int m_timeslice_ms;
@@ -129,6 +140,21 @@ public:
 		// This means doing both a flush and fsync.
 	void ForceLog();
 
+		// Group commit: commit the active transaction and flush it to
+		// the log, but leave the fsync to a later SyncLog() (or to any
+		// durable commit or ForceLog() that comes first), so that
+		// several transactions can share one fsync.  Returns the
+		// sequence number of this commit; the transaction is durable
+		// once SyncedCommitSequence() has reached it.
+	unsigned long CommitGroupedTransaction();
+		// fsync the log if any grouped commits are not yet durable
+	void SyncLog();
+	bool SyncPending() { return m_synced_seq != m_commit_seq; }
+	unsigned long SyncedCommitSequence() { return m_synced_seq; }
+		// grouped commits and bytes waiting for SyncLog()
+	int PendingSyncTransactions() { return (int)(m_commit_seq - m_synced_seq); }
+	long long PendingSyncBytes() { return m_unsynced_bytes; }
+
 	bool AdExistsInTableOrTransaction(const char *key);
 
 	// returns 1 and sets val if corresponding SetAttribute found
@@ -187,6 +213,14 @@ private:
 	time_t m_original_log_birthdate;
 	int m_nondurable_level;
 
+		// group commit state, see CommitGroupedTransaction()
+	unsigned long m_commit_seq;
+	unsigned long m_synced_seq;
+	long long m_synced_size;
+	long long m_unsynced_bytes;
+	void NoteLogSynced();
+	long long LogSize();
+
 	bool SaveHistoricalLogs();
 };
 
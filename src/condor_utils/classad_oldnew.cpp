@@ -34,6 +34,8 @@ using namespace std;
 #include "classad/classad_distribution.h"
 #include "classad_oldnew.h"
 #include "compat_classad.h"
+#include "classad_binary.h"
+#include "condor_ver_info.h"
 
 // local helper functions, options are one or more of PUT_CLASSAD_* flags
 int _putClassAd(Stream *sock, classad::ClassAd& ad, int options);
@@ -54,8 +56,65 @@ void AttrList_setPublishServerTimeMangled( bool publish)
     publish_server_timeMangled = publish;
 }
 
+static bool use_binary_wire_format = true;
+void AttrList_setBinaryWireFormat( bool enable )
+{
+	use_binary_wire_format = enable;
+}
+
+static int binary_max_length = 4 * 1024 * 1024;
+void AttrList_setBinaryMaxLength( int max_len )
+{
+	binary_max_length = max_len;
+}
+
 static const char *SECRET_MARKER = "ZKM"; // "it's a Zecret Klassad, Mon!"
 
+// Receive the rest of an ad sent by _putClassAdBinary(), after the
+// CLASSAD_BINARY_MAGIC that stood in for the attribute count.
+static bool _getClassAdBinary( Stream *sock, classad::ClassAd& ad )
+{
+	int len = 0;
+	if ( !sock->code( len ) || len <= 0 ) {
+		dprintf(D_FULLDEBUG, "FAILED to get binary ClassAd length\n" );
+		return false;
+	}
+	if ( len > binary_max_length ) {
+		dprintf(D_ALWAYS, "Rejecting binary ClassAd of %d bytes, more than "
+				"CLASSAD_BINARY_MAX_LENGTH (%d)\n", len, binary_max_length );
+		return false;
+	}
+	std::vector<char> buf( len );
+	if ( sock->get_bytes( &buf[0], len ) != len ) {
+		dprintf(D_FULLDEBUG, "FAILED to get %d bytes of binary ClassAd\n", len );
+		return false;
+	}
+	if ( !ParseBinaryClassAd( &buf[0], len, ad ) ) {
+		dprintf(D_FULLDEBUG, "FAILED to parse binary ClassAd\n" );
+		return false;
+	}
+
+		// private attributes that had to be encrypted follow as text
+	int numSecrets = 0;
+	if ( !sock->code( numSecrets ) ) {
+		return false;
+	}
+	for ( int i = 0; i < numSecrets; i++ ) {
+		char *secret_line = NULL;
+		if ( !sock->get_secret( secret_line ) ) {
+			dprintf(D_FULLDEBUG, "Failed to read encrypted ClassAd expression.\n");
+			return false;
+		}
+		std::string buffer( secret_line );
+		free( secret_line );
+		if ( !ad.Insert( buffer ) ) {
+			dprintf(D_FULLDEBUG, "FAILED to insert %s\n", buffer.c_str() );
+			return false;
+		}
+	}
+	return true;
+}
+
 compat_classad::ClassAd *
 getClassAd( Stream *sock )
 {
@@ -88,6 +147,13 @@ bool getClassAd( Stream *sock, classad::ClassAd& ad )
  		return false;
 	}
 
+	if ( numExprs == CLASSAD_BINARY_MAGIC ) {
+		if ( !_getClassAdBinary( sock, ad ) ) {
+			return false;
+		}
+		numExprs = 0;
+	}
+
 		// pack exprs into classad
 	for( int i = 0 ; i < numExprs ; i++ ) {
 		char const *strptr = NULL;
@@ -184,6 +250,28 @@ getClassAdNoTypes( Stream *sock, classad::ClassAd& ad )
  		return false;
 	}
 
+	if ( numExprs == CLASSAD_BINARY_MAGIC ) {
+		if ( !_getClassAdBinary( sock, ad ) ) {
+			return false;
+		}
+			// same renaming as the text case below
+		std::vector<std::string> limits;
+		for ( classad::ClassAd::iterator it = ad.begin(); it != ad.end(); ++it ) {
+			if ( strncmp( it->first.c_str(), "ConcurrencyLimit.", 17 ) == 0 ) {
+				limits.push_back( it->first );
+			}
+		}
+		for ( size_t i = 0; i < limits.size(); i++ ) {
+			std::string name = limits[i];
+			name[16] = '_';
+			ExprTree *tree = ad.Remove( limits[i] );
+			if ( tree ) {
+				ad.Insert( name, tree, false );
+			}
+		}
+		return true;
+	}
+
 		// pack exprs into classad
 	buffer = "[";
 	for( int i = 0 ; i < numExprs ; i++ ) {
@@ -716,8 +804,131 @@ static int _putClassAdTrailingInfo(Stream *sock, classad::ClassAd& ad, bool send
 	return true;
 }
 
+// helper function for _putClassAd: true if the peer can receive the ad
+// as produced by _putClassAdBinary().  Receiving is always supported,
+// so only the sender needs to know the peer's version.
+static bool _peerAcceptsBinaryClassAds( Stream *sock )
+{
+	if ( !use_binary_wire_format ) {
+		return false;
+	}
+	CondorVersionInfo const *peer_version = sock->get_peer_version();
+	return peer_version && peer_version->built_since_version(8, 3, 3);
+}
+
+// helper function for _putClassAdBinary
+static void _addBinaryAttr( ClassAdBinaryWriter &writer, std::vector<std::string> &secrets,
+							Stream *sock, const std::string &attr, classad::ExprTree const *expr,
+							bool encrypt_private )
+{
+	if ( encrypt_private && compat_classad::ClassAdAttributeIsPrivate(attr.c_str()) ) {
+		classad::ClassAdUnParser unp;
+		std::string buf = attr;
+		buf += " = ";
+		unp.Unparse( buf, expr );
+		secrets.push_back( buf );
+		return;
+	}
+
+	classad::ExprTree const *tree = expr->self();
+	if ( tree->GetKind() == ExprTree::LITERAL_NODE ) {
+		classad::Value val;
+		classad::Value::NumberFactor factor;
+		((classad::Literal const *)tree)->GetComponents( val, factor );
+		std::string str;
+		if ( val.IsStringValue( str ) ) {
+				// does nothing unless attr holds this daemon's address
+			ConvertDefaultIPToSocketIP( attr.c_str(), str, *sock );
+			val.SetStringValue( str );
+		}
+		writer.AddLiteral( attr, val, factor );
+		return;
+	}
+	writer.Add( attr, expr );
+}
+
+// Send the ad as a single binary blob in place of one string per
+// attribute; see classad_binary.h.  The attributes sent, and their
+// order, are the same as _putClassAd() would send.
+static int _putClassAdBinary( Stream *sock, classad::ClassAd& ad, int options, const classad::References *whitelist )
+{
+	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
+	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
+	bool encrypt_private = !sock->prepare_crypto_for_secret_is_noop();
+
+	ClassAdBinaryWriter writer;
+	std::vector<std::string> secrets;
+
+	if ( whitelist ) {
+		for (classad::References::const_iterator attr = whitelist->begin(); attr != whitelist->end(); ++attr) {
+			classad::ExprTree const *expr = ad.Lookup(*attr);
+			if ( !expr || (exclude_private && compat_classad::ClassAdAttributeIsPrivate(attr->c_str())) ) {
+				continue;
+			}
+			if ( publish_server_timeMangled && strcasecmp(attr->c_str(), ATTR_SERVER_TIME) == 0 ) {
+				continue;
+			}
+			_addBinaryAttr( writer, secrets, sock, *attr, expr, encrypt_private );
+		}
+	} else {
+		classad::ClassAd *chainedAd = ad.GetChainedParentAd();
+		for (int pass = 0; pass < 2; pass++) {
+			classad::ClassAd *cur = pass ? &ad : chainedAd;
+			if ( !cur ) {
+				continue;
+			}
+			for (classad::AttrList::const_iterator itor = cur->begin(); itor != cur->end(); itor++) {
+				std::string const &attr = itor->first;
+				if (strcasecmp(ATTR_CURRENT_TIME, attr.c_str()) == 0) {
+					continue;
+				}
+				if (exclude_private && compat_classad::ClassAdAttributeIsPrivate(attr.c_str())) {
+					continue;
+				}
+				if (excludeTypes &&
+					(strcasecmp(ATTR_MY_TYPE, attr.c_str()) == 0 ||
+					 strcasecmp(ATTR_TARGET_TYPE, attr.c_str()) == 0))
+				{
+					continue;
+				}
+				_addBinaryAttr( writer, secrets, sock, attr, itor->second, encrypt_private );
+			}
+		}
+	}
+
+	if ( publish_server_timeMangled ) {
+		classad::Value now;
+		now.SetIntegerValue( (long long)time(NULL) );
+		writer.AddLiteral( ATTR_SERVER_TIME, now );
+	}
+
+	std::string const &blob = writer.Finish();
+	int marker = CLASSAD_BINARY_MAGIC;
+	int len = (int)blob.size();
+	int numSecrets = (int)secrets.size();
+
+	sock->encode( );
+	if ( !sock->code( marker ) || !sock->code( len ) ||
+		 sock->put_bytes( blob.data(), len ) != len ||
+		 !sock->code( numSecrets ) )
+	{
+		return false;
+	}
+	for (size_t i = 0; i < secrets.size(); i++) {
+		if ( !sock->put_secret( secrets[i].c_str() ) ) {
+			return false;
+		}
+	}
+
+	return _putClassAdTrailingInfo(sock, ad, false, excludeTypes);
+}
+
 int _putClassAd( Stream *sock, classad::ClassAd& ad, int options)
 {
+	if ( _peerAcceptsBinaryClassAds(sock) ) {
+		return _putClassAdBinary(sock, ad, options, NULL);
+	}
+
 	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
 	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
 
@@ -851,6 +1062,10 @@ int _putClassAd( Stream *sock, classad::ClassAd& ad, int options)
 
 int _putClassAd( Stream *sock, classad::ClassAd& ad, int options, const classad::References &whitelist)
 {
+	if ( _peerAcceptsBinaryClassAds(sock) ) {
+		return _putClassAdBinary(sock, ad, options, &whitelist);
+	}
+
 	bool excludeTypes = (options & PUT_CLASSAD_NO_TYPES) == PUT_CLASSAD_NO_TYPES;
 	bool exclude_private = (options & PUT_CLASSAD_NO_PRIVATE) == PUT_CLASSAD_NO_PRIVATE;
 
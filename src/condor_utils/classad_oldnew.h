@@ -36,6 +36,14 @@ class ReliSock;
 
 void AttrList_setPublishServerTimeMangled( bool publish);
 
+// When false, putClassAd() always sends ads as text, even to peers
+// that understand the binary encoding in classad_binary.h.
+void AttrList_setBinaryWireFormat( bool enable );
+
+// getClassAd() rejects binary ads whose encoded length exceeds this
+// many bytes, rather than allocating whatever the peer asks for.
+void AttrList_setBinaryMaxLength( int max_len );
+
 namespace compat_classad { class ClassAd; } //forward declaration
 compat_classad::ClassAd* getClassAd( Stream *sock );
 
@@ -183,6 +183,8 @@ const struct Translation DCTranslation[] = {
 	{ "SHARED_PORT_CONNECT", SHARED_PORT_CONNECT },
 	{ "SHARED_PORT_PASS_SOCK", SHARED_PORT_PASS_SOCK },
 	{ "RECYCLE_SHADOW", RECYCLE_SHADOW },
+	{ "SHADOW_JOB_EXIT", SHADOW_JOB_EXIT },
+	{ "UPDATE_JOB_ATTRS", UPDATE_JOB_ATTRS },
         { "CLEAR_DIRTY_JOB_ATTRS", CLEAR_DIRTY_JOB_ATTRS },
         { "UPDATE_JOBAD", UPDATE_JOBAD },
 	{ "DRAIN_JOBS", DRAIN_JOBS },
@@ -305,6 +307,7 @@ const struct Translation CollectorTranslation[] = {
 	{ "QUERY_GRID_ADS", QUERY_GRID_ADS },
 	{ "INVALIDATE_GRID_ADS", INVALIDATE_GRID_ADS },
 	{ "MERGE_STARTD_AD", MERGE_STARTD_AD },
+	{ "UPDATE_STARTD_ADS", UPDATE_STARTD_ADS },
 	{ "UPDATE_QUILL_AD", UPDATE_QUILL_AD },
 	{ "QUERY_QUILL_ADS", QUERY_QUILL_ADS },
 	{ "INVALIDATE_QUILL_ADS", INVALIDATE_QUILL_ADS },
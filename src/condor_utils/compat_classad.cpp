@@ -26,6 +26,7 @@
 #include "condor_config.h"
 #include "Regex.h"
 #include "classad/classadCache.h"
+#include "classad/regexCache.h"
 
 using namespace std;
 
@@ -58,6 +59,10 @@ Reconfig()
 	classad::_useOldClassAdSemantics = !m_strictEvaluation;
 
 	classad::ClassAdSetExpressionCaching( param_boolean( "ENABLE_CLASSAD_CACHING", false ) );
+	classad::ClassAdSetRegexCacheSize( param_integer( "CLASSAD_REGEX_CACHE_SIZE", 500, 0 ) );
+
+	AttrList_setBinaryWireFormat( param_boolean( "ENABLE_CLASSAD_BINARY_WIRE_FORMAT", true ) );
+	AttrList_setBinaryMaxLength( param_integer( "CLASSAD_BINARY_MAX_LENGTH", 4 * 1024 * 1024, 1024 ) );
 
 	char *new_libs = param( "CLASSAD_USER_LIBS" );
 	if ( new_libs ) {
@@ -94,8 +99,16 @@ void releaseTheMyRef( classad::ClassAd *ad )
 	}
 }
 
-static classad::MatchClassAd *the_match_ad = NULL;
-static bool the_match_ad_in_use = false;
+	// One match ad per thread, so that threads evaluating disjoint
+	// pairs of ads (e.g. the negotiator's match workers) can do so
+	// concurrently.
+#if defined(WIN32)
+#define MATCH_AD_THREAD_LOCAL __declspec(thread)
+#else
+#define MATCH_AD_THREAD_LOCAL __thread
+#endif
+static MATCH_AD_THREAD_LOCAL classad::MatchClassAd *the_match_ad = NULL;
+static MATCH_AD_THREAD_LOCAL bool the_match_ad_in_use = false;
 classad::MatchClassAd *getTheMatchAd( classad::ClassAd *source,
 									  classad::ClassAd *target )
 {
@@ -129,6 +142,14 @@ void releaseTheMatchAd()
 	the_match_ad_in_use = false;
 }
 
+void deleteTheMatchAd()
+{
+	ASSERT( !the_match_ad_in_use );
+
+	delete the_match_ad;
+	the_match_ad = NULL;
+}
+
 static
 bool stringListSize_func( const char * /*name*/,
 						  const classad::ArgumentList &arg_list,
@@ -351,6 +372,39 @@ static int regexp_str_to_options( const char *option_str )
 	return options;
 }
 
+// stringListRegexpMember() is evaluated over and over with the same
+// pattern (in START and Requirements, for instance), so compiled
+// patterns are kept in the ClassAd library's cache along with those
+// of regexp(), see classad/regexCache.h.
+class CachedRegex : public classad::RegexCacheEntry {
+public:
+	Regex re;
+};
+
+	// our kind of entry in the cache
+static const int REGEX_CACHE_KIND_CONDOR = 1;
+
+static classad::RegexCacheEntryPtr
+compile_cached_regex( const std::string &pattern, int options )
+{
+	classad::RegexCacheEntryPtr r =
+		classad::RegexCacheFind( REGEX_CACHE_KIND_CONDOR, options, pattern );
+	if ( r ) {
+		return r;
+	}
+
+	CachedRegex *cached = new CachedRegex;
+	r.reset( cached );
+	const char *errstr = 0;
+	int errpos = 0;
+	if ( ! cached->re.compile( pattern.c_str(), &errstr, &errpos, options ) ) {
+		return classad::RegexCacheEntryPtr();
+	}
+	classad::RegexCacheInsert( REGEX_CACHE_KIND_CONDOR, options, pattern, r );
+
+	return r;
+}
+
 static
 bool stringListRegexpMember_func( const char * /*name*/,
 								  const classad::ArgumentList &arg_list,
@@ -394,25 +448,22 @@ bool stringListRegexpMember_func( const char * /*name*/,
 		return true;
 	}
 
-	Regex r;
-	const char *errstr = 0;
-	int errpos = 0;
-	bool valid;
 	int options = regexp_str_to_options(options_str.c_str());
 
 	/* can the pattern be compiled */
-	valid = r.compile(pattern_str.c_str(), &errstr, &errpos, options);
-	if (!valid) {
+	classad::RegexCacheEntryPtr cached = compile_cached_regex( pattern_str, options );
+	if (!cached) {
 		result.SetErrorValue();
 		return true;
 	}
+	Regex *r = &static_cast<CachedRegex *>( cached.get() )->re;
 
 	result.SetBooleanValue( false );
 
 	sl.rewind();
 	char *entry;
 	while( (entry = sl.next())) {
-		if (r.match(entry)) {
+		if (r->match(entry)) {
 			result.SetBooleanValue( true );
 		}
 	}
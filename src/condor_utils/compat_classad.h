@@ -515,6 +515,9 @@ void releaseTheMyRef( classad::ClassAd *ad );
 classad::MatchClassAd *getTheMatchAd( classad::ClassAd *source,
 									  classad::ClassAd *target );
 void releaseTheMatchAd();
+	/** Free the calling thread's match ad.  Threads other than the main
+	 *  thread that use getTheMatchAd() must call this before exiting. */
+void deleteTheMatchAd();
 
 
 // Modify all expressions in the given ad, such that if they refer
@@ -116,6 +116,7 @@ void process_directory( const char* dirlist, const char* host);
 static int  process_dynamic_configs();
 void check_params();
 bool find_user_file(MyString & filename, const char * basename, bool check_access);
+static void bump_param_generation();
 
 // External variables
 extern int	ConfigLineNo;
@@ -1087,6 +1088,9 @@ real_config(const char* host, int wantsQuiet, int config_options)
 		// be de-optimized.
 	optimize_macros(ConfigMacroSet);
 
+		// anything cached from the half-built table is stale now
+	bump_param_generation();
+
 		// We have to do some platform-specific checking to make sure
 		// all the parameters we think are defined really are.
 	check_params();
@@ -1737,6 +1741,7 @@ void
 param_insert(const char * name, const char * value)
 {
 	insert(name, value, ConfigMacroSet, WireMacro);
+	bump_param_generation();
 }
 
 void
@@ -1803,6 +1808,7 @@ clear_config()
 	*/
 	global_config_source       = "";
 	local_config_sources.clearAll();
+	bump_param_generation();
 	return;
 }
 
@@ -3012,6 +3018,7 @@ config_insert( const char* attrName, const char* attrValue )
 		return;
 	}
 	insert(attrName, attrValue, ConfigMacroSet, WireMacro);
+	bump_param_generation();
 }
 
 int macro_stats(MACRO_SET& set, struct _macro_stats &stats)
@@ -3050,6 +3057,75 @@ int  get_config_stats(struct _macro_stats *pstats)
 	return macro_stats(ConfigMacroSet, *pstats);
 }
 
+// bumped whenever the contents of ConfigMacroSet change, starts at 1 so
+// that a cached value with a generation of 0 is always stale.
+static unsigned int config_generation = 1;
+
+static void bump_param_generation()
+{
+	if (++config_generation == 0) { config_generation = 1; }
+}
+
+unsigned int param_generation()
+{
+	return config_generation;
+}
+
+static bool sort_by_use_count(const std::pair<int, const char *> & a, const std::pair<int, const char *> & b)
+{
+	return a.first > b.first;
+}
+
+int param_most_used(int max_names, std::vector<std::string> & names, std::vector<int> & counts)
+{
+	names.clear();
+	counts.clear();
+	if ( ! ConfigMacroSet.metat || max_names <= 0) {
+		return 0;
+	}
+
+	std::vector<std::pair<int, const char *> > used;
+	for (int ii = 0; ii < ConfigMacroSet.size; ++ii) {
+		if (ConfigMacroSet.metat[ii].use_count > 0) {
+			used.push_back(std::make_pair(ConfigMacroSet.metat[ii].use_count, ConfigMacroSet.table[ii].key));
+		}
+	}
+	MACRO_DEFAULTS * defs = ConfigMacroSet.defaults;
+	if (defs && defs->metat) {
+		for (int ii = 0; ii < defs->size; ++ii) {
+			if (defs->metat[ii].use_count > 0) {
+				used.push_back(std::make_pair(defs->metat[ii].use_count, defs->table[ii].key));
+			}
+		}
+	}
+
+	int cNames = MIN(max_names, (int)used.size());
+	std::partial_sort(used.begin(), used.begin() + cNames, used.end(), sort_by_use_count);
+	for (int ii = 0; ii < cNames; ++ii) {
+		names.push_back(used[ii].second);
+		counts.push_back(used[ii].first);
+	}
+	return cNames;
+}
+
+void ParamBoolean::refresh()
+{
+	m_generation = param_generation();
+	m_value = param_boolean(m_name, m_default);
+}
+
+void ParamInteger::refresh()
+{
+	m_generation = param_generation();
+	m_value = param_integer(m_name, m_default, m_min, m_max);
+}
+
+void ParamString::refresh()
+{
+	m_generation = param_generation();
+	m_defined = param(m_value, m_name);
+}
+
 
 void
 check_params()
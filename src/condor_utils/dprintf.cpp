@@ -505,6 +505,7 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 	int saved_errno;
 	priv_state	priv;
 	std::vector<DebugFileInfo>::iterator it;
+	bool async = false;
 
 		/* DebugFP should be static initialized to stderr,
 	 	   but stderr is not a constant on all systems. */
@@ -531,6 +532,11 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 		return;
 
 
+		/* With DEBUG_ASYNC, log files are already open and are only
+		   written by the writer thread, so we don't need to fix the
+		   umask just to queue the message. */
+	async = _dprintf_async_active();
+
 #if !defined(WIN32) /* signals and umasks don't exist in WIN32 */
 
 	/* Block any signal handlers which might try to print something */
@@ -547,7 +553,9 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 		/* Make sure our umask is reasonable, in case we're the shadow
 		   and the remote job has tried to set its umask or
 		   something.  -Derek Wright 6/11/98 */
-	old_umask = umask( 022 );
+	if ( ! async ) {
+		old_umask = umask( 022 );
+	}
 #endif
 
 	/* We want dprintf to be thread safe.  For now, we achieve this
@@ -661,6 +669,20 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 				case STD_OUT: it->debugFP = stdout; break;
 				default:
 				case FILE_OUT:
+#if !defined(WIN32)
+					if (async) {
+						if (_dprintf_async_write(ixOutput, *it, cat_and_flags, DebugHeaderOptions, info, message_buffer)) {
+							continue;
+						}
+							/* the writer thread isn't handling this
+							   one, so we may have to (re)open it */
+						mode_t async_umask = umask( 022 );
+						debug_lock_it(&(*it), NULL, 0, it->dont_panic);
+						(void)umask( async_umask );
+						funlock_it = true;
+						break;
+					}
+#endif
 					debug_lock_it(&(*it), NULL, 0, it->dont_panic);
 					funlock_it = true;
 					break;
@@ -674,6 +696,12 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 			}
 		}
 
+			/* make sure a failure message (EXCEPT, for one) is
+			   in the log before the caller goes on to exit */
+		if (async && (cat_and_flags & D_FAILURE)) {
+			dprintf_async_flush();
+		}
+
 			/* restore privileges */
 		_set_priv(priv, __FILE__, __LINE__, 0);
 
@@ -688,7 +716,9 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 
 #if !defined(WIN32) // umasks don't exist in WIN32
 		/* restore umask */
-	(void)umask( old_umask );
+	if ( ! async ) {
+		(void)umask( old_umask );
+	}
 #endif
 
 	/* Release mutex.  Note: we MUST do this before we renable signals */
@@ -1423,6 +1453,10 @@ _condor_dprintf_exit( int error_code, const char* msg )
 	time_t clock_now;
 	std::vector<DebugFileInfo>::iterator it;
 
+		/* get whatever the writer thread still has queued into the
+		   log before we write our last words and close it */
+	_dprintf_async_stop();
+
 		/* We might land here with DprintfBroken true if our call to
 		   dprintf_unlock() down below hits an error.  Since the
 		   "error" that it hit might simply be that there was no lock,
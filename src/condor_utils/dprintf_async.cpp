@@ -0,0 +1,583 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/************************************************************************
+**
+**	Asynchronous writing of debug log files (DEBUG_ASYNC).
+**
+**	dprintf() formats each message as usual, but instead of seeking,
+**	writing and checking the size of every log file the message goes to,
+**	it appends the finished line to a ring buffer and returns.  A writer
+**	thread drains the ring buffer, gathering consecutive lines for the
+**	same file into a single writev().
+**
+**	The ring buffer has one producer and one consumer, so it needs no
+**	lock.  dprintf() is the only producer (it is already serialized by
+**	_condor_dprintf_critsec when there are other threads), and the writer
+**	thread is the only consumer.  Each side advances only its own
+**	position, with a memory barrier between touching the buffer and
+**	publishing the new position.
+**
+**	The writer thread never opens files or switches privilege, since
+**	privilege is per-process.  It keeps track of how much it has written
+**	to each file, and when a file is due for rotation it says so; the
+**	next dprintf() waits for the ring buffer to drain and then rotates
+**	the file the usual way.
+**
+************************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "dprintf_internal.h"
+
+int DebugAsync = 0;
+int DebugAsyncBufferSize = 4*1024*1024;
+
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+
+#include <pthread.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <vector>
+#include "log_rotate.h"
+
+extern bool debug_check_it(struct DebugFileInfo& it, bool fTruncate, bool dont_panic);
+
+	// how long dprintf() will wait for room in a full buffer before
+	// it gives up on a message, and how long a crashing daemon will
+	// wait for the writer to finish before it dumps the stack.
+#define ASYNC_MAX_WAIT_MS   1000
+#define ASYNC_CRASH_WAIT_MS 2000
+
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+#define ASYNC_MAX_IOV (IOV_MAX < 256 ? IOV_MAX : 256)
+
+	// both ends of the ring buffer use this to order their accesses to
+	// the buffer against their updates of its positions.
+#define async_barrier() __sync_synchronize()
+
+	// each queued line is preceded by one of these; records are padded
+	// to 8 bytes.  A record with output < 0 pads out the rest of the
+	// buffer so that no record wraps around the end.
+struct AsyncRecord {
+	int output;				// index of the DebugLogs entry
+	unsigned int length;	// of the text that follows
+};
+#define ASYNC_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+struct AsyncOutput {
+	int fd;					// < 0 if not written asynchronously
+	long long length;		// of the file, as far as the writer knows
+	long long max_length;	// rotate at this size, 0 for never
+	time_t rotate_at;		// rotate at this time, 0 for never
+	volatile int rotate_due;
+};
+
+static char *ring = NULL;
+static size_t ring_size = 0;			// always a power of 2
+static volatile size_t ring_head = 0;	// advanced by dprintf()
+static volatile size_t ring_tail = 0;	// advanced by the writer
+
+static std::vector<AsyncOutput> async_outputs;
+static pthread_t writer_thread;
+static int wake_pipe[2] = { -1, -1 };
+
+static volatile int async_active = 0;
+static volatile int writer_running = 0;
+static volatile int writer_stop = 0;
+static volatile int writer_sleeping = 0;
+static volatile int writer_errno = 0;
+
+	// statistics, all updated by the producer
+static long long records_queued = 0;
+static long long records_delayed = 0;
+static long long records_dropped = 0;
+static long long records_dropped_reported = 0;
+
+static void
+async_wake_writer( void )
+{
+	char c = 0;
+	int rc = write( wake_pipe[1], &c, 1 );
+	(void)rc; // a full pipe is as good as a wakeup
+}
+
+static bool
+async_writev( AsyncOutput &out, struct iovec *iov, int niov )
+{
+	while( niov > 0 ) {
+		ssize_t rc = writev( out.fd, iov, niov );
+		if( rc < 0 ) {
+			if( errno == EINTR ) {
+				continue;
+			}
+			return false;
+		}
+		out.length += rc;
+		while( niov > 0 && (size_t)rc >= iov->iov_len ) {
+			rc -= iov->iov_len;
+			++iov;
+			--niov;
+		}
+		if( niov > 0 ) {
+			iov->iov_base = (char *)iov->iov_base + rc;
+			iov->iov_len -= rc;
+		}
+	}
+
+	if( (out.max_length && out.length >= out.max_length) ||
+		(out.rotate_at && time(NULL) >= out.rotate_at) )
+	{
+		out.rotate_due = 1;
+	}
+	return true;
+}
+
+static void *
+async_writer( void * )
+{
+	struct iovec iov[ASYNC_MAX_IOV];
+	size_t mask = ring_size - 1;
+
+	for(;;) {
+		size_t head = ring_head;
+		async_barrier();
+		size_t pos = ring_tail;
+
+		if( pos == head ) {
+			if( writer_stop ) {
+				break;
+			}
+				// tell dprintf() to wake us, then look once more
+				// in case it queued something before it could see that.
+			writer_sleeping = 1;
+			async_barrier();
+			if( ring_head == pos && ! writer_stop ) {
+				struct pollfd pfd;
+				pfd.fd = wake_pipe[0];
+				pfd.events = POLLIN;
+				pfd.revents = 0;
+				if( poll( &pfd, 1, 1000 ) > 0 ) {
+					char buf[64];
+					while( read( wake_pipe[0], buf, sizeof(buf) ) > 0 ) {}
+				}
+			}
+			writer_sleeping = 0;
+			async_barrier();
+			continue;
+		}
+
+			// gather the run of records for the same output
+		int output = -1;
+		int niov = 0;
+		while( pos != head && niov < ASYNC_MAX_IOV ) {
+			AsyncRecord *rec = (AsyncRecord *)(ring + (pos & mask));
+			if( rec->output < 0 ) {
+				pos += ring_size - (pos & mask);
+				continue;
+			}
+			if( niov && rec->output != output ) {
+				break;
+			}
+			output = rec->output;
+			iov[niov].iov_base = (char *)(rec + 1);
+			iov[niov].iov_len = rec->length;
+			++niov;
+			pos += ASYNC_ALIGN( sizeof(AsyncRecord) + rec->length );
+		}
+
+		if( niov && ! async_writev( async_outputs[output], iov, niov ) ) {
+				// dprintf() will notice and exit the usual way
+			writer_errno = errno ? errno : EIO;
+			break;
+		}
+
+		async_barrier();
+		ring_tail = pos;
+	}
+
+	writer_running = 0;
+	return NULL;
+}
+
+	// pick up the size of the file and when it is next due to rotate.
+static void
+async_sync_output( AsyncOutput &out, DebugFileInfo &it )
+{
+	out.fd = fileno( it.debugFP );
+	out.length = lseek( out.fd, 0, SEEK_END );
+	out.max_length = 0;
+	out.rotate_at = 0;
+	out.rotate_due = 0;
+	if( it.maxLog ) {
+		if( it.rotate_by_time ) {
+			time_t zero = it.logZero ? (time_t)it.logZero : time(NULL);
+			out.rotate_at = quantizeTimestamp( zero, it.maxLog ) + it.maxLog;
+		} else {
+			out.max_length = it.maxLog;
+		}
+	}
+}
+
+	// Wait for the writer to empty the ring buffer.  Returns false if
+	// the writer is gone with records still queued.
+static bool
+async_drain( int max_wait_ms )
+{
+	int waited_ms = 0;
+	while( ring_tail != ring_head ) {
+		if( ! writer_running || writer_errno ) {
+			return false;
+		}
+		if( max_wait_ms >= 0 && waited_ms >= max_wait_ms ) {
+			return false;
+		}
+		if( writer_sleeping ) {
+			async_wake_writer();
+		}
+		usleep( 1000 );
+		++waited_ms;
+	}
+	return true;
+}
+
+	// Reserve need bytes at the head of the ring buffer, waiting a
+	// while for the writer if it is full.  Returns the position of
+	// the reserved space, or (size_t)-1 if there was no room.
+static size_t
+async_reserve( size_t need )
+{
+	size_t mask = ring_size - 1;
+	size_t head = ring_head;
+	size_t pad = 0;
+	if( ring_size - (head & mask) < need ) {
+		pad = ring_size - (head & mask);
+	}
+
+	int waited_ms = 0;
+	for(;;) {
+		size_t tail = ring_tail;
+		async_barrier();
+		if( ring_size - (head - tail) >= need + pad ) {
+			break;
+		}
+		if( ! writer_running || writer_errno || waited_ms >= ASYNC_MAX_WAIT_MS ) {
+			return (size_t)-1;
+		}
+		if( waited_ms == 0 ) {
+			++records_delayed;
+		}
+		if( writer_sleeping ) {
+			async_wake_writer();
+		}
+		usleep( 1000 );
+		++waited_ms;
+	}
+
+	if( pad ) {
+		AsyncRecord *rec = (AsyncRecord *)(ring + (head & mask));
+		rec->output = -1;
+		rec->length = 0;
+		head += pad;
+	}
+	return head;
+}
+
+static bool
+async_enqueue( int ixOutput, const char *header, const char *message )
+{
+	size_t header_len = header ? strlen( header ) : 0;
+	size_t message_len = strlen( message );
+	size_t need = ASYNC_ALIGN( sizeof(AsyncRecord) + header_len + message_len );
+
+	size_t pos = async_reserve( need );
+	if( pos == (size_t)-1 ) {
+		++records_dropped;
+		return false;
+	}
+
+	AsyncRecord *rec = (AsyncRecord *)(ring + (pos & (ring_size - 1)));
+	rec->output = ixOutput;
+	rec->length = (unsigned int)(header_len + message_len);
+	char *text = (char *)(rec + 1);
+	if( header_len ) {
+		memcpy( text, header, header_len );
+	}
+	memcpy( text + header_len, message, message_len );
+
+	async_barrier();
+	ring_head = pos + need;
+	async_barrier();
+	if( writer_sleeping ) {
+		async_wake_writer();
+	}
+	++records_queued;
+	return true;
+}
+
+	// Rotate a log file that the writer says is due.  This must happen
+	// here rather than in the writer thread because it switches privilege.
+static void
+async_rotate( AsyncOutput &out, DebugFileInfo &it )
+{
+	async_drain( -1 );
+
+	mode_t old_umask = umask( 022 );
+	bool ok = debug_check_it( it, false, it.dont_panic );
+	umask( old_umask );
+
+	if( ok && it.debugFP ) {
+		async_sync_output( out, it );
+	} else {
+			// leave this one to the synchronous code
+		out.fd = -1;
+		out.rotate_due = 0;
+	}
+}
+
+static void
+async_fork_child( void )
+{
+		// The writer thread did not come along.  Whatever is still
+		// queued belongs to the parent, which will write it.
+	async_active = 0;
+	writer_running = 0;
+	ring_head = ring_tail = 0;
+	if( wake_pipe[0] >= 0 ) { close( wake_pipe[0] ); wake_pipe[0] = -1; }
+	if( wake_pipe[1] >= 0 ) { close( wake_pipe[1] ); wake_pipe[1] = -1; }
+}
+
+static void
+async_atexit( void )
+{
+	_dprintf_async_stop();
+}
+
+bool
+_dprintf_async_active( void )
+{
+	return async_active != 0;
+}
+
+bool
+_dprintf_async_write( int ixOutput, DebugFileInfo &it, int cat_and_flags, int hdr_flags, DebugHeaderInfo &info, const char *message )
+{
+	if( ! async_active || ixOutput >= (int)async_outputs.size() ) {
+		return false;
+	}
+	if( writer_errno ) {
+		int error = writer_errno;
+		_dprintf_async_stop();
+		_condor_dprintf_exit( error, "Error writing debug log\n" );
+	}
+
+	AsyncOutput &out = async_outputs[ixOutput];
+	if( out.fd >= 0 && out.rotate_due ) {
+		async_rotate( out, it );
+	}
+	if( out.fd < 0 ) {
+		return false;
+	}
+
+	int all_hdr_flags = hdr_flags | it.headerOpts;
+
+		// tell the reader of the log that there is a gap
+	if( records_dropped != records_dropped_reported ) {
+		char notice[100];
+		snprintf( notice, sizeof(notice),
+				  "dprintf: %lld debug messages dropped because the log writer fell behind\n",
+				  records_dropped - records_dropped_reported );
+		if( async_enqueue( ixOutput, _format_global_header( D_ALWAYS, all_hdr_flags, info ), notice ) ) {
+			records_dropped_reported = records_dropped;
+		}
+	}
+
+	const char *header = _format_global_header( cat_and_flags, all_hdr_flags, info );
+	size_t length = (header ? strlen( header ) : 0) + strlen( message );
+	if( ASYNC_ALIGN( sizeof(AsyncRecord) + length ) > ring_size / 4 ) {
+			// too big to queue; write it directly once the writer has
+			// caught up, so that it lands in order.
+		if( ! async_drain( -1 ) ) {
+			return false;
+		}
+		it.dprintfFunc( cat_and_flags, hdr_flags, info, message, &it );
+		out.length += length;
+		return true;
+	}
+
+		// a dropped message is counted, and noted in the log later
+	async_enqueue( ixOutput, header, message );
+	return true;
+}
+
+void
+_dprintf_async_start( std::vector<DebugFileInfo> &logs, int buffer_size )
+{
+	static bool registered = false;
+
+	if( async_active ) {
+		return;
+	}
+
+	async_outputs.clear();
+	bool any = false;
+	for( size_t ix = 0; ix < logs.size(); ++ix ) {
+		AsyncOutput out;
+		out.fd = -1;
+		out.length = out.max_length = 0;
+		out.rotate_at = 0;
+		out.rotate_due = 0;
+		if( logs[ix].outputTarget == FILE_OUT && logs[ix].debugFP &&
+			logs[ix].dprintfFunc == _dprintf_global_func )
+		{
+			async_sync_output( out, logs[ix] );
+			any = true;
+		}
+		async_outputs.push_back( out );
+	}
+	if( ! any ) {
+		async_outputs.clear();
+		return;
+	}
+
+	size_t size = 64*1024;
+	while( size < (size_t)buffer_size && size < ((size_t)1 << 30) ) {
+		size <<= 1;
+	}
+	if( size != ring_size ) {
+		free( ring );
+		ring = (char *)malloc( size );
+		if( ! ring ) {
+			ring_size = 0;
+			async_outputs.clear();
+			return;
+		}
+		ring_size = size;
+	}
+	ring_head = ring_tail = 0;
+
+	if( pipe( wake_pipe ) < 0 ) {
+		wake_pipe[0] = wake_pipe[1] = -1;
+		async_outputs.clear();
+		return;
+	}
+	for( int ix = 0; ix < 2; ++ix ) {
+		fcntl( wake_pipe[ix], F_SETFL, fcntl( wake_pipe[ix], F_GETFL ) | O_NONBLOCK );
+		fcntl( wake_pipe[ix], F_SETFD, FD_CLOEXEC );
+	}
+
+		// the writer must never be the thread that runs a signal handler
+	sigset_t fullset, oldset;
+	sigfillset( &fullset );
+	pthread_sigmask( SIG_SETMASK, &fullset, &oldset );
+	writer_stop = 0;
+	writer_sleeping = 0;
+	writer_errno = 0;
+	writer_running = 1;
+	int rc = pthread_create( &writer_thread, NULL, async_writer, NULL );
+	pthread_sigmask( SIG_SETMASK, &oldset, NULL );
+	if( rc != 0 ) {
+		writer_running = 0;
+		close( wake_pipe[0] );
+		close( wake_pipe[1] );
+		wake_pipe[0] = wake_pipe[1] = -1;
+		async_outputs.clear();
+		return;
+	}
+
+	if( ! registered ) {
+		registered = true;
+		atexit( async_atexit );
+		pthread_atfork( NULL, NULL, async_fork_child );
+	}
+	async_active = 1;
+}
+
+void
+_dprintf_async_stop( void )
+{
+	if( ! async_active ) {
+		return;
+	}
+	async_active = 0;
+
+	async_drain( -1 );
+	writer_stop = 1;
+	async_barrier();
+	async_wake_writer();
+	pthread_join( writer_thread, NULL );
+	writer_stop = 0;
+
+	close( wake_pipe[0] );
+	close( wake_pipe[1] );
+	wake_pipe[0] = wake_pipe[1] = -1;
+	ring_head = ring_tail = 0;
+	async_outputs.clear();
+}
+
+void
+_dprintf_async_crash_flush( void )
+{
+	if( async_active && ! pthread_equal( pthread_self(), writer_thread ) ) {
+		async_drain( ASYNC_CRASH_WAIT_MS );
+	}
+}
+
+void
+dprintf_async_flush( void )
+{
+	if( async_active ) {
+		async_drain( -1 );
+	}
+}
+
+void
+dprintf_get_async_stats( long long *queued, long long *delayed, long long *dropped )
+{
+	if( queued ) *queued = records_queued;
+	if( delayed ) *delayed = records_delayed;
+	if( dropped ) *dropped = records_dropped;
+}
+
+#else // WIN32 or no pthreads: dprintf() is always synchronous
+
+bool _dprintf_async_active( void ) { return false; }
+
+bool
+_dprintf_async_write( int, DebugFileInfo &, int, int, DebugHeaderInfo &, const char * )
+{
+	return false;
+}
+
+void _dprintf_async_start( std::vector<DebugFileInfo> &, int ) {}
+void _dprintf_async_stop( void ) {}
+void _dprintf_async_crash_flush( void ) {}
+void dprintf_async_flush( void ) {}
+
+void
+dprintf_get_async_stats( long long *queued, long long *delayed, long long *dropped )
+{
+	if( queued ) *queued = 0;
+	if( delayed ) *delayed = 0;
+	if( dropped ) *dropped = 0;
+}
+
+#endif
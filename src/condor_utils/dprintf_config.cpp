@@ -350,6 +350,14 @@ dprintf_config( const char *subsys, struct dprintf_output_settings *p_info /* =
 		log_keep_open = param_boolean_int(pname, log_open_default);//dprintf_param_funcs->param_boolean_int(pname, log_open_default);
 	}
 
+	/*
+	If DEBUG_ASYNC is enabled, log files are written by a separate
+	thread, see dprintf_async.cpp.  This only takes effect when the
+	log files are kept open and not locked.
+	*/
+	DebugAsync = param_boolean_int( "DEBUG_ASYNC", FALSE );
+	DebugAsyncBufferSize = param_integer( "DEBUG_ASYNC_BUFFER_SIZE", 4*1024*1024, 64*1024 );
+
 	/*
 	If LOGS_USE_TIMESTAMP is enabled, we will print out Unix timestamps
 	instead of the standard date format in all the log messages
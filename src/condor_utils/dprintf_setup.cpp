@@ -40,6 +40,9 @@ extern std::vector<DebugFileInfo> *DebugLogs;
 extern time_t	DebugLastMod;
 extern int		DebugContinueOnOpenFailure;
 extern int		_condor_dprintf_works;
+extern int		DebugShouldLockToAppend;
+extern char		*DebugLock;
+extern int		log_keep_open;
 
 extern bool		debug_check_it(struct DebugFileInfo& it, bool fTruncate, bool dont_panic);
 extern void		_condor_dprintf_saved_lines( void );
@@ -48,6 +51,10 @@ extern void		_condor_dprintf_saved_lines( void );
 static void
 sig_backtrace_handler(int signum)
 {
+		// give the DEBUG_ASYNC writer a chance to catch up, so that
+		// the stack dump follows the last messages before the crash.
+	_dprintf_async_crash_flush();
+
 	dprintf_dump_stack();
 
 		// terminate for the same reason.
@@ -78,6 +85,10 @@ void dprintf_set_outputs(const struct dprintf_output_settings *p_info, int c_inf
 {
 	static int first_time = 1;
 
+		// the writer thread holds indexes into DebugLogs, so let it
+		// finish with the old outputs before we replace them.
+	_dprintf_async_stop();
+
 	std::vector<DebugFileInfo> *debugLogsOld = DebugLogs;
 	DebugLogs = new std::vector<DebugFileInfo>();
 
@@ -244,6 +255,13 @@ void dprintf_set_outputs(const struct dprintf_output_settings *p_info, int c_inf
 		delete debugLogsOld;
 	}
 
+		// The writer thread counts on having the log files to itself
+		// between rotations, which is only true if they stay open and
+		// nobody else needs to take a lock to append to them.
+	if (DebugAsync && log_keep_open && ! DebugLock && ! DebugShouldLockToAppend) {
+		_dprintf_async_start(*DebugLogs, DebugAsyncBufferSize);
+	}
+
 	_condor_dprintf_saved_lines();
 }
 
@@ -280,6 +280,7 @@ void Stream::set_deadline_timeout(int){not_impl();}
 void Stream::set_deadline(time_t){not_impl();}
 time_t Stream::get_deadline(){not_impl();return 0;}
 bool Stream::deadline_expired(){not_impl();return false;}
+CondorVersionInfo const *Stream::get_peer_version() const{not_impl();return NULL;}
 
 
 /* stubs for generic query object */
@@ -478,6 +478,14 @@ ProcFamilyProxy::start_procd()
 		args.AppendArg(min_tracking_gid);
 		args.AppendArg(max_tracking_gid);
 	}
+
+	// have the ProcD follow process creation and exit through the
+	// kernel's proc connector instead of scanning every process on
+	// every snapshot
+	//
+	if (param_boolean("PROCD_USE_PROC_CONNECTOR", false)) {
+		args.AppendArg("-N");
+	}
 #endif
 
 	// for the GLEXEC_JOB feature, we'll need to pass the ProcD paths
@@ -31,6 +31,10 @@
 
 #include "fs_util.h"
 
+#if defined(LINUX)
+#include <sys/inotify.h>
+#endif
+
 #ifdef WIN32
 // Note inversion of argument order...
 #define realpath(path,resolved_path) _fullpath((resolved_path),(path),_MAX_PATH)
@@ -51,7 +55,9 @@
 
 ReadMultipleUserLogs::ReadMultipleUserLogs() :
 	allLogFiles(LOG_INFO_HASH_SIZE, MyStringHash, rejectDuplicateKeys),
-	activeLogFiles(LOG_INFO_HASH_SIZE, MyStringHash, rejectDuplicateKeys)
+	activeLogFiles(LOG_INFO_HASH_SIZE, MyStringHash, rejectDuplicateKeys),
+	notifyFd(-1),
+	notifyFdOwned(false)
 {
 }
 
@@ -176,6 +182,122 @@ ReadMultipleUserLogs::detectLogGrowth()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+ReadMultipleUserLogs::enableFileNotification()
+{
+	if ( notifyFd >= 0 ) {
+		return true;
+	}
+
+#if defined(LINUX)
+		// Not using inotify_init1() here so that we still build
+		// against older glibc versions.
+	notifyFd = inotify_init();
+	if ( notifyFd < 0 ) {
+		dprintf( D_ALWAYS, "ReadMultipleUserLogs: inotify_init() failed "
+					"with errno %d (%s); falling back to polling\n",
+					errno, strerror( errno ) );
+		return false;
+	}
+
+	int flags = fcntl( notifyFd, F_GETFL );
+	if ( flags < 0 || fcntl( notifyFd, F_SETFL, flags | O_NONBLOCK ) < 0 ||
+				fcntl( notifyFd, F_SETFD, FD_CLOEXEC ) < 0 ) {
+		dprintf( D_ALWAYS, "ReadMultipleUserLogs: fcntl() on inotify "
+					"descriptor failed with errno %d (%s); falling back "
+					"to polling\n", errno, strerror( errno ) );
+		close( notifyFd );
+		notifyFd = -1;
+		return false;
+	}
+	notifyFdOwned = true;
+
+	activeLogFiles.startIterations();
+	LogFileMonitor *monitor;
+	while ( activeLogFiles.iterate( monitor ) ) {
+		addFileWatch( monitor );
+	}
+
+	dprintf( D_FULLDEBUG, "ReadMultipleUserLogs: using inotify to "
+				"detect log growth\n" );
+	return true;
+#else
+	return false;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ReadMultipleUserLogs::drainFileNotifications()
+{
+	if ( notifyFd < 0 ) {
+		return false;
+	}
+
+	bool changed = false;
+
+#if defined(LINUX)
+		// We don't care which log changed, or how -- detectLogGrowth()
+		// will figure that out -- so just empty the queue.
+	char buf[4096];
+	ssize_t len;
+	while ( (len = read( notifyFd, buf, sizeof( buf ) )) > 0 ) {
+		changed = true;
+	}
+	if ( len < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+				errno != EINTR ) {
+		dprintf( D_ALWAYS, "ReadMultipleUserLogs: read() from inotify "
+					"descriptor failed with errno %d (%s)\n",
+					errno, strerror( errno ) );
+			// Play it safe and have the caller check the logs.
+		changed = true;
+	}
+#endif
+
+	return changed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ReadMultipleUserLogs::addFileWatch( LogFileMonitor *monitor )
+{
+#if defined(LINUX)
+	if ( notifyFd < 0 || monitor->watchDescriptor >= 0 ) {
+		return;
+	}
+
+	monitor->watchDescriptor = inotify_add_watch( notifyFd,
+				monitor->logFile.Value(), IN_MODIFY );
+	if ( monitor->watchDescriptor < 0 ) {
+			// Not fatal -- we still poll this log.
+		dprintf( D_ALWAYS, "ReadMultipleUserLogs: inotify_add_watch(%s) "
+					"failed with errno %d (%s)\n", monitor->logFile.Value(),
+					errno, strerror( errno ) );
+	}
+#else
+	(void)monitor;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ReadMultipleUserLogs::removeFileWatch( LogFileMonitor *monitor )
+{
+#if defined(LINUX)
+	if ( notifyFd >= 0 && monitor->watchDescriptor >= 0 ) {
+			// Failure here just means the kernel already dropped
+			// the watch (e.g., the file was removed).
+		(void)inotify_rm_watch( notifyFd, monitor->watchDescriptor );
+	}
+#endif
+	monitor->watchDescriptor = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int
 ReadMultipleUserLogs::totalLogFileCount() const
 {
@@ -234,6 +356,12 @@ ReadMultipleUserLogs::cleanup()
 		delete monitor;
 	}
 	allLogFiles.clear();
+
+	if ( notifyFd >= 0 && notifyFdOwned ) {
+		close( notifyFd );
+	}
+	notifyFd = -1;
+	notifyFdOwned = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1188,6 +1316,8 @@ ReadMultipleUserLogs::monitorLogFile( MyString logfile,
 						"file %s (%s) to active list\n", logfile.Value(),
 						fileID.Value() );
 		}
+
+		addFileWatch( monitor );
 	}
 
 	monitor->refCount++;
@@ -1265,6 +1395,8 @@ ReadMultipleUserLogs::unmonitorLogFile( MyString logfile,
 		delete monitor->readUserLog;
 		monitor->readUserLog = NULL;
 
+		removeFileWatch( monitor );
+
 			// Now we remove this file from the "active" list, so
 			// we don't check it the next time we get an event.
 		if ( activeLogFiles.remove( fileID ) != 0 ) {
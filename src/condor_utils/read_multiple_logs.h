@@ -289,6 +289,37 @@ public:
 		*/
 	void printActiveLogMonitors( FILE *stream ) const;
 
+		/** Ask to be notified when any log we're monitoring is
+			written to (uses inotify, so this only works on Linux).
+			Logs that are already being monitored get watched, too.
+			Note that detectLogGrowth() must still be called to find
+			out which logs actually grew; the notification just lets
+			the caller do that right away instead of at the next
+			polling interval.
+			@return true if notification is available, false if the
+				caller must rely on polling alone
+		*/
+	bool enableFileNotification();
+
+		/** Returns a file descriptor that becomes readable when
+			a monitored log has been written to, or -1 if notification
+			is not enabled.
+		 */
+	int fileNotificationFd() const { return notifyFd; }
+
+		/** Tell us that the caller has taken over fileNotificationFd()
+			(e.g., handed it to DaemonCore with Inherit_Pipe()) and
+			will close it, after cleanup(); we keep reading from it,
+			but never close it ourselves.
+		 */
+	void disownFileNotificationFd() { notifyFdOwned = false; }
+
+		/** Read (and throw away) any pending notifications, so that
+			fileNotificationFd() is no longer readable.
+			@return true iff any monitored log may have changed
+		 */
+	bool drainFileNotifications();
+
 protected:
 	friend class CheckEvents;
 
@@ -300,7 +331,7 @@ private:
 	struct LogFileMonitor {
 		LogFileMonitor( const MyString &file ) : logFile(file), refCount(0),
 					readUserLog(NULL), state(NULL), stateError(false),
-					lastLogEvent(NULL) {}
+					lastLogEvent(NULL), watchDescriptor(-1) {}
 
 		~LogFileMonitor() {
 			delete readUserLog;
@@ -338,6 +369,9 @@ private:
 
 			// The last event we read from this log.
 		ULogEvent	*lastLogEvent;
+
+			// The inotify watch on this log while it's active, or -1.
+		int			watchDescriptor;
 	};
 
 		// allLogFiles contains pointers to all of the LogFileMonitors
@@ -351,6 +385,18 @@ private:
 
 	HashTable<MyString, LogFileMonitor *>	activeLogFiles;
 
+		// inotify file descriptor, or -1 if we're only polling.
+	int		notifyFd;
+
+		// Whether we close notifyFd, or whoever took it over does.
+	bool	notifyFdOwned;
+
+		/** Start or stop watching the given log for changes (no-ops
+			if notification is not enabled).
+		*/
+	void addFileWatch( LogFileMonitor *monitor );
+	void removeFileWatch( LogFileMonitor *monitor );
+
 	// For instantiation in programs that use this class.
 #define MULTI_LOG_HASH_INSTANCE template class \
 		HashTable<MyString, ReadMultipleUserLogs::LogFileMonitor *>
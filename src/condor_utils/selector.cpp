@@ -60,11 +60,21 @@ Selector::Selector()
 	save_write_fds = read_fds + ( 4 * fd_set_size );
 	save_except_fds = read_fds + ( 5 * fd_set_size );
 
+#ifdef SELECTOR_USE_EPOLL
+	m_epfd = -1;
+	m_epoll_pid = 0;
+#endif
+
 	reset();
 }
 
 Selector::~Selector()
 {
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		close( m_epfd );
+	}
+#endif
 	free( read_fds );
 }
 
@@ -78,6 +88,17 @@ Selector::reset()
 	timeout.tv_sec = timeout.tv_usec = 0;
 
 	max_fd = -1;
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+			// The fd_sets are not used by the epoll backend, and the
+			// kernel interest list is deliberately left alone.
+		epoll_reset();
+		if (IsDebugLevel(D_DAEMONCORE)) {
+			dprintf(D_DAEMONCORE | D_VERBOSE, "selector %p resetting\n", this);
+		}
+		return;
+	}
+#endif
 #if defined(WIN32)
 	FD_ZERO( save_read_fds );
 	FD_ZERO( save_write_fds );
@@ -184,6 +205,13 @@ Selector::add_fd( int fd, IO_FUNC interest )
 		free(fd_description);
 	}
 
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		epoll_add_fd( fd, interest );
+		return;
+	}
+#endif
+
 	bool new_fd = false;
 	if ((m_single_shot == SINGLE_SHOT_OK) && (m_poll.fd != fd)) {
 		new_fd = true;
@@ -248,6 +276,13 @@ Selector::delete_fd( int fd, IO_FUNC interest )
 		dprintf(D_DAEMONCORE | D_VERBOSE, "selector %p deleting fd %d\n", this, fd);
 	}
 
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		epoll_delete_fd( fd, interest );
+		return;
+	}
+#endif
+
 	switch( interest ) {
 
 	  case IO_READ:
@@ -295,9 +330,14 @@ Selector::execute()
 	struct timeval timeout_copy;
 	struct timeval	*tp;
 
-	memcpy( read_fds, save_read_fds, fd_set_size * sizeof(fd_set) );
-	memcpy( write_fds, save_write_fds, fd_set_size * sizeof(fd_set) );
-	memcpy( except_fds, save_except_fds, fd_set_size * sizeof(fd_set) );
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd == -1 )
+#endif
+	{
+		memcpy( read_fds, save_read_fds, fd_set_size * sizeof(fd_set) );
+		memcpy( write_fds, save_write_fds, fd_set_size * sizeof(fd_set) );
+		memcpy( except_fds, save_except_fds, fd_set_size * sizeof(fd_set) );
+	}
 
 	if( timeout_wanted ) {
 		timeout_copy = timeout;
@@ -306,9 +346,24 @@ Selector::execute()
 		tp = NULL;
 	}
 
+#ifdef SELECTOR_USE_EPOLL
+		// Other threads may add and delete fds while we wait, so only
+		// the wait itself happens outside of the lock.
+	int epoll_ms = -1;
+	if ( m_epfd != -1 ) {
+		epoll_ms = epoll_prepare( tp );
+	}
+#endif
+
 		// select() ignores its first argument on Windows. We still track
 		// max_fd for the display() functions.
 	start_thread_safe("select");
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		nfds = epoll_wait( m_epfd, &m_events[0], (int)m_events.size(), epoll_ms );
+	}
+	else
+#endif
 	if (m_single_shot == SINGLE_SHOT_OK)
 	{
 		nfds = poll(&m_poll, 1, tp ? (1000*tp->tv_sec + tp->tv_usec/1000) : -1);
@@ -323,6 +378,11 @@ Selector::execute()
 	}
 	_select_errno = errno;
 	stop_thread_safe("select");
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		nfds = epoll_collect( nfds, _select_errno );
+	}
+#endif
 	_select_retval = nfds;
 
 	if( nfds < 0 ) {
@@ -374,6 +434,23 @@ Selector::fd_ready( int fd, IO_FUNC interest )
 	}
 #endif
 
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		if ( fd < 0 || fd >= (int)m_ready.size() ) {
+			return false;
+		}
+		switch( interest ) {
+		  case IO_READ:
+			return (m_ready[fd] & WANT_READ) != 0;
+		  case IO_WRITE:
+			return (m_ready[fd] & WANT_WRITE) != 0;
+		  case IO_EXCEPT:
+			return (m_ready[fd] & WANT_EXCEPT) != 0;
+		}
+		return false;
+	}
+#endif
+
 	switch( interest ) {
 
 	  case IO_READ:
@@ -447,8 +524,13 @@ Selector::display()
 
 	dprintf( D_ALWAYS, "max_fd = %d\n", max_fd );
 
-	dprintf( D_ALWAYS, "Selection FD's\n" );
 	bool try_dup = ( (FAILED == state) &&  (EBADF == _select_errno) );
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		epoll_display();
+	} else {
+#endif
+	dprintf( D_ALWAYS, "Selection FD's\n" );
 	display_fd_set( "\tRead", save_read_fds, max_fd, try_dup );
 	display_fd_set( "\tWrite", save_write_fds, max_fd, try_dup );
 	display_fd_set( "\tExcept", save_except_fds, max_fd, try_dup );
@@ -459,6 +541,9 @@ Selector::display()
 		display_fd_set( "\tWrite", write_fds, max_fd );
 		display_fd_set( "\tExcept", except_fds, max_fd );
 	}
+#ifdef SELECTOR_USE_EPOLL
+	}
+#endif
 	if( timeout_wanted ) {
 		dprintf( D_ALWAYS,
 			"Timeout = %ld.%06ld seconds\n", (long) timeout.tv_sec, 
@@ -502,3 +587,408 @@ display_fd_set( const char *msg, fd_set *set, int max, bool try_dup )
 	}
 	dprintf( D_ALWAYS | D_NOHEADER, "} = %d\n", count );
 }
+
+bool
+Selector::enable_epoll()
+{
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		return true;
+	}
+	m_epfd = epoll_create1( EPOLL_CLOEXEC );
+	if ( m_epfd == -1 ) {
+		dprintf( D_ALWAYS, "Selector: epoll_create1 failed, falling back "
+				 "to select(): %s (errno=%d)\n", strerror(errno), errno );
+		return false;
+	}
+	m_epoll_pid = getpid();
+	m_want.clear();
+	m_registered.clear();
+	m_ready.clear();
+	m_dirty.clear();
+	m_registered_pos.clear();
+	m_registered_fds.clear();
+	m_dirty_fds.clear();
+	m_unpollable_fds.clear();
+	m_ready_fds.clear();
+	reset();
+	dprintf( D_FULLDEBUG, "selector %p using epoll\n", this );
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool
+Selector::epoll_enabled() const
+{
+#ifdef SELECTOR_USE_EPOLL
+	return m_epfd != -1;
+#else
+	return false;
+#endif
+}
+
+const std::vector<int> *
+Selector::ready_fds() const
+{
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd != -1 ) {
+		return &m_ready_fds;
+	}
+#endif
+	return NULL;
+}
+
+void
+Selector::forget_fd( int fd )
+{
+#ifdef SELECTOR_USE_EPOLL
+	if ( m_epfd == -1 || fd < 0 || fd >= (int)m_registered.size() ) {
+		return;
+	}
+	if ( m_registered[fd] == 0 || epoll_check_fork() ) {
+		return;
+	}
+	if ( !(m_registered[fd] & NOT_POLLABLE) ) {
+			// The descriptor may already be closed, in which case the
+			// kernel has dropped it from the interest list for us.
+		epoll_ctl( m_epfd, EPOLL_CTL_DEL, fd, NULL );
+	}
+	epoll_unregister( fd );
+		// whatever interest is still wanted gets registered afresh
+	epoll_set_want( fd, m_want[fd] );
+#else
+	if ( fd ) {}
+#endif
+}
+
+#ifdef SELECTOR_USE_EPOLL
+
+	// Our epoll fd is shared with any child we fork, and epoll_ctl() from
+	// the child would change the parent's interest list.  If we find
+	// ourselves in a different process than the one that created the
+	// epoll fd, drop it and start over with a private one.
+	// Returns true if the interest list was rebuilt.
+bool
+Selector::epoll_check_fork()
+{
+	if ( m_epoll_pid == getpid() ) {
+		return false;
+	}
+	close( m_epfd );
+	m_epfd = epoll_create1( EPOLL_CLOEXEC );
+	if ( m_epfd == -1 ) {
+		EXCEPT( "Selector: epoll_create1 failed after fork: %s (errno=%d)",
+				strerror(errno), errno );
+	}
+	m_epoll_pid = getpid();
+	while ( !m_registered_fds.empty() ) {
+		int fd = m_registered_fds.back();
+		epoll_unregister( fd );
+		epoll_set_want( fd, m_want[fd] );
+	}
+	return true;
+}
+
+void
+Selector::epoll_grow( int fd )
+{
+	if ( fd < (int)m_want.size() ) {
+		return;
+	}
+	size_t new_size = m_want.size() ? m_want.size() : 64;
+	while ( (int)new_size <= fd ) {
+		new_size *= 2;
+	}
+	m_want.resize( new_size, 0 );
+	m_registered.resize( new_size, 0 );
+	m_ready.resize( new_size, 0 );
+	m_dirty.resize( new_size, 0 );
+	m_registered_pos.resize( new_size, -1 );
+}
+
+	// Record the interest in fd, and remember to tell the kernel about
+	// it at the next execute() if that is different from what it has.
+void
+Selector::epoll_set_want( int fd, unsigned char want )
+{
+	m_want[fd] = want;
+	if ( m_dirty[fd] == 0 && want != (m_registered[fd] & ~NOT_POLLABLE) ) {
+		m_dirty[fd] = 1;
+		m_dirty_fds.push_back( fd );
+	}
+}
+
+void
+Selector::epoll_register( int fd, unsigned char reg )
+{
+	if ( m_registered[fd] == 0 ) {
+		m_registered_pos[fd] = (int)m_registered_fds.size();
+		m_registered_fds.push_back( fd );
+	}
+	if ( (reg & NOT_POLLABLE) && !(m_registered[fd] & NOT_POLLABLE) ) {
+		m_unpollable_fds.push_back( fd );
+	}
+	m_registered[fd] = reg;
+}
+
+void
+Selector::epoll_unregister( int fd )
+{
+	if ( m_registered[fd] == 0 ) {
+		return;
+	}
+	if ( m_registered[fd] & NOT_POLLABLE ) {
+		for ( size_t i = 0; i < m_unpollable_fds.size(); i++ ) {
+			if ( m_unpollable_fds[i] == fd ) {
+				m_unpollable_fds[i] = m_unpollable_fds.back();
+				m_unpollable_fds.pop_back();
+				break;
+			}
+		}
+	}
+	int pos = m_registered_pos[fd];
+	int last = m_registered_fds.back();
+	m_registered_fds[pos] = last;
+	m_registered_pos[last] = pos;
+	m_registered_fds.pop_back();
+	m_registered_pos[fd] = -1;
+	m_registered[fd] = 0;
+}
+
+	// Forget all interest, as reset() does for the select() backend.
+	// The kernel is only told at the next execute(), and only about
+	// fds that are not added back before then.
+void
+Selector::epoll_reset()
+{
+	for ( size_t i = 0; i < m_registered_fds.size(); i++ ) {
+		epoll_set_want( m_registered_fds[i], 0 );
+	}
+	for ( size_t i = 0; i < m_dirty_fds.size(); i++ ) {
+		m_want[m_dirty_fds[i]] = 0;
+	}
+	for ( size_t i = 0; i < m_ready_fds.size(); i++ ) {
+		m_ready[m_ready_fds[i]] = 0;
+	}
+	m_ready_fds.clear();
+	m_single_shot = SINGLE_SHOT_SKIP;
+}
+
+void
+Selector::epoll_add_fd( int fd, IO_FUNC interest )
+{
+	epoll_grow( fd );
+	unsigned char want = m_want[fd];
+	switch( interest ) {
+	  case IO_READ:
+		want |= WANT_READ;
+		break;
+	  case IO_WRITE:
+		want |= WANT_WRITE;
+		break;
+	  case IO_EXCEPT:
+		want |= WANT_EXCEPT;
+		break;
+	}
+	epoll_set_want( fd, want );
+}
+
+void
+Selector::epoll_delete_fd( int fd, IO_FUNC interest )
+{
+	if ( fd >= (int)m_want.size() ) {
+		return;
+	}
+	unsigned char want = m_want[fd];
+	switch( interest ) {
+	  case IO_READ:
+		want &= ~WANT_READ;
+		break;
+	  case IO_WRITE:
+		want &= ~WANT_WRITE;
+		break;
+	  case IO_EXCEPT:
+		want &= ~WANT_EXCEPT;
+		break;
+	}
+	epoll_set_want( fd, want );
+}
+
+	// Bring the kernel interest list in line with the fds whose
+	// interest changed since the last execute().
+void
+Selector::epoll_sync()
+{
+	epoll_check_fork();
+
+	for ( size_t i = 0; i < m_dirty_fds.size(); i++ ) {
+		int fd = m_dirty_fds[i];
+		m_dirty[fd] = 0;
+		unsigned char want = m_want[fd];
+		unsigned char reg = m_registered[fd];
+
+		if ( want == 0 ) {
+			if ( reg && !(reg & NOT_POLLABLE) ) {
+					// may fail if the fd is already closed, which
+					// removed it from the kernel's list anyway
+				epoll_ctl( m_epfd, EPOLL_CTL_DEL, fd, NULL );
+			}
+			epoll_unregister( fd );
+			continue;
+		}
+		if ( reg & NOT_POLLABLE ) {
+			m_registered[fd] = want | NOT_POLLABLE;
+			continue;
+		}
+		if ( want == reg ) {
+			continue;
+		}
+
+		struct epoll_event ev;
+		memset( &ev, 0, sizeof(ev) );
+		if ( want & WANT_READ ) {
+			ev.events |= EPOLLIN;
+		}
+		if ( want & WANT_WRITE ) {
+			ev.events |= EPOLLOUT;
+		}
+		if ( want & WANT_EXCEPT ) {
+			ev.events |= EPOLLPRI;
+		}
+		ev.data.fd = fd;
+
+		int op = reg ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+		int rc = epoll_ctl( m_epfd, op, fd, &ev );
+		if ( rc == -1 && op == EPOLL_CTL_MOD && errno == ENOENT ) {
+			op = EPOLL_CTL_ADD;
+			rc = epoll_ctl( m_epfd, op, fd, &ev );
+		} else if ( rc == -1 && op == EPOLL_CTL_ADD && errno == EEXIST ) {
+			op = EPOLL_CTL_MOD;
+			rc = epoll_ctl( m_epfd, op, fd, &ev );
+		}
+		if ( rc == -1 ) {
+			if ( errno == EBADF ) {
+					// Someone closed the fd without taking it out of
+					// the selector first.  There is nothing left to
+					// wait for, so drop it rather than fail the caller.
+				dprintf( D_ALWAYS, "Selector: fd %d was closed while "
+						 "still selected on; dropping it\n", fd );
+				m_want[fd] = 0;
+				epoll_unregister( fd );
+				continue;
+			}
+			if ( errno != EPERM ) {
+				EXCEPT( "Selector: epoll_ctl(%d) on fd %d failed: %s (errno=%d)",
+						op, fd, strerror(errno), errno );
+			}
+				// e.g. a regular file; select() would always report
+				// it ready, so we do the same.
+			want |= NOT_POLLABLE;
+		}
+		epoll_register( fd, want );
+	}
+	m_dirty_fds.clear();
+}
+
+	// Get ready for epoll_wait(): tell the kernel about changed fds, and
+	// return how many milliseconds to wait.
+int
+Selector::epoll_prepare( struct timeval *tp )
+{
+	epoll_sync();
+
+	for ( size_t i = 0; i < m_ready_fds.size(); i++ ) {
+		m_ready[m_ready_fds[i]] = 0;
+	}
+	m_ready_fds.clear();
+
+	int ms = -1;
+	for ( size_t i = 0; i < m_unpollable_fds.size(); i++ ) {
+		int fd = m_unpollable_fds[i];
+		m_ready[fd] = m_want[fd];
+		m_ready_fds.push_back( fd );
+	}
+	if ( !m_ready_fds.empty() ) {
+		ms = 0;
+	} else if ( tp ) {
+			// round up so we do not spin on a sub-millisecond timeout
+		ms = tp->tv_sec * 1000 + (tp->tv_usec + 999) / 1000;
+	}
+
+	if ( m_events.size() < m_registered_fds.size() || m_events.empty() ) {
+		m_events.resize( m_registered_fds.empty() ? 1 : m_registered_fds.size() );
+	}
+	return ms;
+}
+
+	// Record what epoll_wait() returned, and return the number of
+	// ready fds (or -1 as the wait did).
+int
+Selector::epoll_collect( int nevents, int wait_errno )
+{
+	if ( nevents < 0 ) {
+		if ( wait_errno == EINTR && !m_ready_fds.empty() ) {
+			return (int)m_ready_fds.size();
+		}
+		return nevents;
+	}
+
+	for ( int i = 0; i < nevents; i++ ) {
+		int fd = m_events[i].data.fd;
+		uint32_t events = m_events[i].events;
+		unsigned char want = m_want[fd];
+		unsigned char ready = 0;
+			// select() reports errors and hangups as readable/writable
+		if ( events & (EPOLLIN | EPOLLERR | EPOLLHUP) ) {
+			ready |= WANT_READ;
+		}
+		if ( events & (EPOLLOUT | EPOLLERR | EPOLLHUP) ) {
+			ready |= WANT_WRITE;
+		}
+		if ( events & EPOLLPRI ) {
+			ready |= WANT_EXCEPT;
+		}
+		ready &= want;
+		if ( ready && m_ready[fd] == 0 ) {
+			m_ready_fds.push_back( fd );
+		}
+		m_ready[fd] |= ready;
+	}
+	return (int)m_ready_fds.size();
+}
+
+void
+Selector::epoll_display()
+{
+	dprintf( D_ALWAYS, "Selection FD's (epoll fd %d)\n", m_epfd );
+	dprintf( D_ALWAYS, "\tWanted {" );
+	for ( size_t i = 0; i < m_registered_fds.size() + m_dirty_fds.size(); i++ ) {
+		int fd = i < m_registered_fds.size() ? m_registered_fds[i] :
+			m_dirty_fds[i - m_registered_fds.size()];
+		if ( m_want[fd] && (i < m_registered_fds.size() || m_registered[fd] == 0) ) {
+			dprintf( D_ALWAYS | D_NOHEADER, "%d%s%s%s ", fd,
+					 (m_want[fd] & WANT_READ) ? "r" : "",
+					 (m_want[fd] & WANT_WRITE) ? "w" : "",
+					 (m_want[fd] & WANT_EXCEPT) ? "e" : "" );
+		}
+	}
+	dprintf( D_ALWAYS | D_NOHEADER, "}\n" );
+	dprintf( D_ALWAYS, "\tRegistered = %d, changed = %d\n",
+			 (int)m_registered_fds.size(), (int)m_dirty_fds.size() );
+
+	if( state == FDS_READY ) {
+		dprintf( D_ALWAYS, "Ready FD's {" );
+		for ( size_t i = 0; i < m_ready_fds.size(); i++ ) {
+			int fd = m_ready_fds[i];
+			dprintf( D_ALWAYS | D_NOHEADER, "%d%s%s%s ", fd,
+					 (m_ready[fd] & WANT_READ) ? "r" : "",
+					 (m_ready[fd] & WANT_WRITE) ? "w" : "",
+					 (m_ready[fd] & WANT_EXCEPT) ? "e" : "" );
+		}
+		dprintf( D_ALWAYS | D_NOHEADER, "} = %d\n", (int)m_ready_fds.size() );
+	}
+}
+
+#endif /* SELECTOR_USE_EPOLL */
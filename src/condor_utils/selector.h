@@ -27,6 +27,10 @@
 #define SELECTOR_USE_POLL 1
 #endif
 
+#ifdef CONDOR_HAVE_EPOLL
+#define SELECTOR_USE_EPOLL 1
+#endif
+
 #ifdef SELECTOR_USE_POLL
 #include <poll.h>
 #else
@@ -39,6 +43,11 @@ struct fake_pollfd {
 };
 #endif
 
+#ifdef SELECTOR_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+#include <vector>
+
 class Selector {
 public:
 	Selector();
@@ -69,6 +78,36 @@ public:
 	bool fd_ready( int fd, IO_FUNC interest );
 	void display();
 
+		// Switch this selector over to a persistent epoll(7) backend.
+		// The fds of interest are kept in the kernel across execute()
+		// calls: add_fd() and delete_fd() change them, and only fds
+		// whose interest changed since the previous execute() cost a
+		// system call.  A caller that keeps its interest up to date
+		// this way, rather than calling reset() and adding every fd
+		// before each execute(), and that looks at ready_fds() rather
+		// than asking fd_ready() about each fd, pays only for the fds
+		// that changed or are ready.  This also lifts the FD_SETSIZE
+		// limit of select().
+		// Returns false (and leaves the selector using select()) if
+		// epoll is not available.
+	bool enable_epoll();
+	bool epoll_enabled() const;
+
+		// With the epoll backend, the fds the last execute() found
+		// ready, each listed once and in no particular order.  Returns
+		// NULL for the select() backend, which can only be asked about
+		// one fd at a time with fd_ready().
+	const std::vector<int> *ready_fds() const;
+
+		// Tell a persistent selector that whatever fd was registered
+		// under this number is going away (or has been replaced), so the
+		// next execute() must register it with the kernel from scratch.
+		// Must be called when an fd is closed while this selector may
+		// still consider it registered, otherwise a new descriptor that
+		// reuses the number would never be reported.  A no-op for
+		// selectors that are not using epoll.
+	void forget_fd( int fd );
+
 private:
 	enum SINGLE_SHOT {
 		SINGLE_SHOT_VIRGIN, SINGLE_SHOT_OK, SINGLE_SHOT_SKIP
@@ -92,6 +131,48 @@ private:
 #else
 	struct fake_pollfd m_poll;
 #endif
+
+#ifdef SELECTOR_USE_EPOLL
+		// Interest bits kept per fd by the epoll backend.  NOT_POLLABLE
+		// marks an fd that epoll refused (e.g. a regular file); like
+		// select(), we then report it as always ready.
+	enum {
+		WANT_READ = 0x1, WANT_WRITE = 0x2, WANT_EXCEPT = 0x4,
+		NOT_POLLABLE = 0x8
+	};
+
+	void epoll_reset();
+	void epoll_grow( int fd );
+	void epoll_set_want( int fd, unsigned char want );
+	void epoll_add_fd( int fd, IO_FUNC interest );
+	void epoll_delete_fd( int fd, IO_FUNC interest );
+	void epoll_register( int fd, unsigned char reg );
+	void epoll_unregister( int fd );
+	int  epoll_prepare( struct timeval *tp );
+	int  epoll_collect( int nevents, int wait_errno );
+	void epoll_sync();
+	bool epoll_check_fork();
+	void epoll_display();
+
+	int		m_epfd;
+	pid_t	m_epoll_pid;
+		// indexed by fd
+	std::vector<unsigned char> m_want;
+	std::vector<unsigned char> m_registered;
+	std::vector<unsigned char> m_ready;
+	std::vector<unsigned char> m_dirty;
+		// position of each registered fd in m_registered_fds, so that
+		// it can be removed without a search
+	std::vector<int> m_registered_pos;
+		// fds with non-zero entries in the tables above, so that
+		// nothing ever has to walk the whole fd range.  every fd with
+		// interest is either registered or dirty.
+	std::vector<int> m_registered_fds;
+	std::vector<int> m_dirty_fds;
+	std::vector<int> m_unpollable_fds;
+	std::vector<int> m_ready_fds;
+	std::vector<struct epoll_event> m_events;
+#endif
 };
 
 void display_fd_set( const char *msg, fd_set *set, int max,
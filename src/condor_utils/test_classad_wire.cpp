@@ -0,0 +1,343 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/*
+  Throughput benchmark for putClassAd()/getClassAd().
+
+  Sends typical startd and job ads over a loopback ReliSock, once with
+  the text encoding and once with the binary encoding, and reports how
+  many ads per second each side can serialize and parse.  Also checks
+  that every ad received in binary is identical to the one sent.
+
+  usage: test_classad_wire [-iterations <n>]
+  (default: 20000 of each kind of ad)
+*/
+
+#include "condor_common.h"
+#include "condor_config.h"
+#include "condor_debug.h"
+#include "condor_io.h"
+#include "condor_classad.h"
+#include "condor_attributes.h"
+#include "condor_ver_info.h"
+#include "classad_oldnew.h"
+#include "subsystem_info.h"
+#include "utc_time.h"
+
+static void
+insert( ClassAd &ad, const char *fmt, ... )
+{
+	std::string line;
+	va_list args;
+	va_start( args, fmt );
+	vformatstr( line, fmt, args );
+	va_end( args );
+	if ( !ad.Insert( line.c_str() ) ) {
+		EXCEPT( "failed to insert %s", line.c_str() );
+	}
+}
+
+static void
+make_startd_ad( ClassAd &ad )
+{
+	SetMyTypeName( ad, STARTD_ADTYPE );
+	SetTargetTypeName( ad, JOB_ADTYPE );
+	insert( ad, "Name = \"slot1_12@exec0423.example.edu\"" );
+	insert( ad, "Machine = \"exec0423.example.edu\"" );
+	insert( ad, "MyAddress = \"<10.1.4.23:9618?addrs=10.1.4.23-9618&noUDP&sock=2071_bd2c_3>\"" );
+	insert( ad, "StartdIpAddr = \"<10.1.4.23:9618?addrs=10.1.4.23-9618&noUDP&sock=2071_bd2c_3>\"" );
+	insert( ad, "CondorVersion = \"$CondorVersion: 8.3.2 Nov 14 2014 BuildID: 282315 $\"" );
+	insert( ad, "CondorPlatform = \"$CondorPlatform: x86_64_RedHat6 $\"" );
+	insert( ad, "Arch = \"X86_64\"" );
+	insert( ad, "OpSys = \"LINUX\"" );
+	insert( ad, "OpSysAndVer = \"SL6\"" );
+	insert( ad, "OpSysMajorVer = 6" );
+	insert( ad, "OpSysVer = 605" );
+	insert( ad, "UidDomain = \"example.edu\"" );
+	insert( ad, "FileSystemDomain = \"example.edu\"" );
+	insert( ad, "State = \"Claimed\"" );
+	insert( ad, "Activity = \"Busy\"" );
+	insert( ad, "EnteredCurrentState = 1416000123" );
+	insert( ad, "EnteredCurrentActivity = 1416000124" );
+	insert( ad, "Cpus = 1" );
+	insert( ad, "Memory = 2048" );
+	insert( ad, "Disk = 41943040" );
+	insert( ad, "Swap = 8388608" );
+	insert( ad, "TotalCpus = 32.0" );
+	insert( ad, "TotalMemory = 131072" );
+	insert( ad, "TotalDisk = 1342177280" );
+	insert( ad, "LoadAvg = 1.0000001" );
+	insert( ad, "CondorLoadAvg = 0.99" );
+	insert( ad, "TotalLoadAvg = 31.52" );
+	insert( ad, "KeyboardIdle = 1204312" );
+	insert( ad, "ConsoleIdle = 1204312" );
+	insert( ad, "Mips = 19842" );
+	insert( ad, "KFlops = 1843201" );
+	insert( ad, "SlotID = 12" );
+	insert( ad, "SlotType = \"Dynamic\"" );
+	insert( ad, "DynamicSlot = true" );
+	insert( ad, "RemoteUser = \"alice@example.edu\"" );
+	insert( ad, "RemoteOwner = \"alice@example.edu\"" );
+	insert( ad, "AccountingGroup = \"group_physics.alice@example.edu\"" );
+	insert( ad, "JobId = \"submit03.example.edu#1234.56\"" );
+	insert( ad, "GlobalJobId = \"submit03.example.edu#1234.56#1416000100\"" );
+	insert( ad, "JobStart = 1416000125" );
+	insert( ad, "HasFileTransfer = true" );
+	insert( ad, "HasPerFileEncryption = true" );
+	insert( ad, "HasReconnect = true" );
+	insert( ad, "HasJobDeferral = true" );
+	insert( ad, "HasJava = true" );
+	insert( ad, "JavaVendor = \"Oracle Corporation\"" );
+	insert( ad, "JavaVersion = \"1.7.0_71\"" );
+	insert( ad, "JavaMFlops = 912.3251" );
+	insert( ad, "StarterAbilityList = \"HasTDP,HasEncryptExecuteDirectory,HasFileTransferPluginMethods,HasJobDeferral,HasJICLocalConfig,HasJICLocalStdin,HasPerFileEncryption,HasFileTransfer,HasReconnect,HasMPI,HasVM\"" );
+	insert( ad, "FileTransferPlugins = \"/usr/libexec/condor/curl_plugin,/usr/libexec/condor/data_plugin\"" );
+	insert( ad, "HasFileTransferPluginMethods = \"file,ftp,http,data\"" );
+	for ( int i = 0; i < 10; i++ ) {
+		insert( ad, "TotalTimeState%d = %d", i, 1000 * i + 17 );
+	}
+	insert( ad, "MachineMaxVacateTime = 10 * 60" );
+	insert( ad, "MaxJobRetirementTime = 0" );
+	insert( ad, "IsValidCheckpointPlatform = ( TARGET.JobUniverse isnt 1 || ( ( MY.CheckpointPlatform isnt undefined ) && ( ( TARGET.LastCheckpointPlatform is MY.CheckpointPlatform ) || ( TARGET.NumCkpts == 0 ) ) ) )" );
+	insert( ad, "WithinResourceLimits = ( MY.Cpus > 0 && TARGET.RequestCpus <= MY.Cpus && MY.Memory > 0 && TARGET.RequestMemory <= MY.Memory && MY.Disk > 0 && TARGET.RequestDisk <= MY.Disk )" );
+	insert( ad, "Start = ( ( KeyboardIdle > 15 * 60 ) && ( ( ( LoadAvg - CondorLoadAvg ) <= 0.3 ) || ( State != \"Unclaimed\" && State != \"Owner\" ) ) ) || ( TARGET.Owner =?= \"admin\" )" );
+	insert( ad, "Requirements = ( START ) && ( IsValidCheckpointPlatform ) && ( WithinResourceLimits )" );
+	insert( ad, "Rank = ifThenElse(regexp(\"^group_physics\", TARGET.AcctGroup), 10, 0) + TARGET.JobPrio" );
+	insert( ad, "CurrentRank = 0.0" );
+	insert( ad, "MachineResources = \"Cpus Memory Disk Swap\"" );
+	insert( ad, "ChildCpus = { 1, 1, 2, 4 }" );
+	insert( ad, "ChildState = { \"Claimed\", \"Claimed\", \"Claimed\", \"Claimed\" }" );
+	insert( ad, "RecentDaemonCoreDutyCycle = 0.0291" );
+	insert( ad, "MonitorSelfAge = 1204312" );
+	insert( ad, "MonitorSelfCPUUsage = 0.1873" );
+	insert( ad, "MonitorSelfImageSize = 18360" );
+	insert( ad, "MonitorSelfResidentSetSize = 7620" );
+	insert( ad, "UpdateSequenceNumber = 4312" );
+	insert( ad, "LastHeardFrom = 1416001234" );
+	insert( ad, "DaemonStartTime = 1414796922" );
+	insert( ad, "Site_Rack = \"R23\"" );
+	insert( ad, "Site_HasInfiniband = false" );
+}
+
+static void
+make_job_ad( ClassAd &ad )
+{
+	SetMyTypeName( ad, JOB_ADTYPE );
+	SetTargetTypeName( ad, STARTD_ADTYPE );
+	insert( ad, "ClusterId = 1234" );
+	insert( ad, "ProcId = 56" );
+	insert( ad, "Owner = \"alice\"" );
+	insert( ad, "User = \"alice@example.edu\"" );
+	insert( ad, "AcctGroup = \"group_physics\"" );
+	insert( ad, "AccountingGroup = \"group_physics.alice\"" );
+	insert( ad, "Cmd = \"/home/alice/analysis/run_analysis.sh\"" );
+	insert( ad, "Arguments = \"--input data_00056.root --output out_00056.root --events 100000\"" );
+	insert( ad, "Environment = \"HOME=/home/alice PATH=/usr/bin:/bin ANALYSIS_RELEASE=17.2.4\"" );
+	insert( ad, "Iwd = \"/home/alice/analysis/run1234\"" );
+	insert( ad, "In = \"/dev/null\"" );
+	insert( ad, "Out = \"run.1234.56.out\"" );
+	insert( ad, "Err = \"run.1234.56.err\"" );
+	insert( ad, "UserLog = \"/home/alice/analysis/run1234/run.log\"" );
+	insert( ad, "JobUniverse = 5" );
+	insert( ad, "JobStatus = 2" );
+	insert( ad, "LastJobStatus = 1" );
+	insert( ad, "JobPrio = 0" );
+	insert( ad, "QDate = 1416000100" );
+	insert( ad, "EnteredCurrentStatus = 1416000125" );
+	insert( ad, "JobCurrentStartDate = 1416000125" );
+	insert( ad, "JobStartDate = 1416000125" );
+	insert( ad, "NumJobStarts = 1" );
+	insert( ad, "NumShadowStarts = 1" );
+	insert( ad, "NumJobMatches = 1" );
+	insert( ad, "ImageSize = 1750000" );
+	insert( ad, "ImageSize_RAW = 1739204" );
+	insert( ad, "ResidentSetSize = 1500000" );
+	insert( ad, "ResidentSetSize_RAW = 1487320" );
+	insert( ad, "DiskUsage = 2500000" );
+	insert( ad, "DiskUsage_RAW = 2483125" );
+	insert( ad, "RequestCpus = 1" );
+	insert( ad, "RequestMemory = ifThenElse(MemoryUsage isnt undefined, MemoryUsage, ( ImageSize + 1023 ) / 1024)" );
+	insert( ad, "RequestDisk = DiskUsage" );
+	insert( ad, "MemoryUsage = ( ( ResidentSetSize + 1023 ) / 1024 )" );
+	insert( ad, "Requirements = ( TARGET.Arch == \"X86_64\" ) && ( TARGET.OpSys == \"LINUX\" ) && ( TARGET.Disk >= RequestDisk ) && ( TARGET.Memory >= RequestMemory ) && ( TARGET.HasFileTransfer ) && ( TARGET.OpSysMajorVer == 6 )" );
+	insert( ad, "Rank = 0.0" );
+	insert( ad, "PeriodicRemove = ( JobStatus == 5 && ( CurrentTime - EnteredCurrentStatus ) > 7 * 24 * 60 * 60 )" );
+	insert( ad, "PeriodicHold = ( ( JobStatus == 2 ) && ( ( CurrentTime - EnteredCurrentStatus ) > 48 * 3600 ) )" );
+	insert( ad, "PeriodicRelease = false" );
+	insert( ad, "OnExitRemove = true" );
+	insert( ad, "OnExitHold = false" );
+	insert( ad, "LeaveJobInQueue = false" );
+	insert( ad, "ShouldTransferFiles = \"YES\"" );
+	insert( ad, "WhenToTransferOutput = \"ON_EXIT\"" );
+	insert( ad, "TransferInput = \"data_00056.root,calib.db,run_analysis.sh\"" );
+	insert( ad, "TransferOutput = \"out_00056.root\"" );
+	insert( ad, "TransferInputSizeMB = 1843" );
+	insert( ad, "RemoteWallClockTime = 0.0" );
+	insert( ad, "CumulativeSlotTime = 0" );
+	insert( ad, "RemoteUserCpu = 0.0" );
+	insert( ad, "RemoteSysCpu = 0.0" );
+	insert( ad, "CommittedTime = 0" );
+	insert( ad, "ExitStatus = 0" );
+	insert( ad, "NumCkpts = 0" );
+	insert( ad, "NumRestarts = 0" );
+	insert( ad, "NumSystemHolds = 0" );
+	insert( ad, "CoreSize = 0" );
+	insert( ad, "KillSig = \"SIGTERM\"" );
+	insert( ad, "JobNotification = 0" );
+	insert( ad, "MaxHosts = 1" );
+	insert( ad, "MinHosts = 1" );
+	insert( ad, "CurrentHosts = 1" );
+	insert( ad, "WantCheckpoint = false" );
+	insert( ad, "WantRemoteSyscalls = false" );
+	insert( ad, "WantRemoteIO = true" );
+	insert( ad, "JobLeaseDuration = 2400" );
+	insert( ad, "GlobalJobId = \"submit03.example.edu#1234.56#1416000100\"" );
+	insert( ad, "RemoteHost = \"slot1_12@exec0423.example.edu\"" );
+	insert( ad, "StartdPrincipal = \"execute-side@matchsession/10.1.4.23\"" );
+	insert( ad, "AutoClusterId = 17" );
+	insert( ad, "AutoClusterAttrs = \"JobUniverse,LastCheckpointPlatform,NumCkpts,RequestCpus,RequestDisk,RequestMemory,Requirements,NiceUser,ConcurrencyLimits\"" );
+	insert( ad, "DAGManJobId = 1200" );
+	insert( ad, "DAGNodeName = \"analysis_00056\"" );
+	insert( ad, "DAGParentNodeNames = \"\"" );
+	insert( ad, "x509userproxysubject = \"/DC=org/DC=example/OU=People/CN=Alice Analyst 123456\"" );
+	insert( ad, "x509UserProxyExpiration = 1416086500" );
+	insert( ad, "x509UserProxyVOName = \"physics\"" );
+	insert( ad, "x509UserProxyFQAN = \"/DC=org/DC=example/OU=People/CN=Alice Analyst 123456,/physics/Role=NULL/Capability=NULL\"" );
+	insert( ad, "JobMaxVacateTime = 10 * 60" );
+	insert( ad, "BytesSent = 0.0" );
+	insert( ad, "BytesRecvd = 1932734464.0" );
+	insert( ad, "MachineAttrCpus0 = 1" );
+	insert( ad, "MachineAttrSlotWeight0 = 1" );
+}
+
+static bool
+same_ad( ClassAd &sent, ClassAd &received )
+{
+	for ( classad::ClassAd::iterator it = sent.begin(); it != sent.end(); ++it ) {
+		if ( strcasecmp( it->first.c_str(), ATTR_CURRENT_TIME ) == 0 ) {
+			continue;
+		}
+		classad::ExprTree *tree = received.Lookup( it->first );
+		if ( !tree || !tree->SameAs( it->second ) ) {
+			fprintf( stderr, "attribute %s differs after round trip\n",
+					 it->first.c_str() );
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool
+run_one( ReliSock &client, ReliSock &server, ClassAd &ad, int iterations,
+		 bool check, double &put_secs, double &get_secs )
+{
+	put_secs = get_secs = 0;
+	for ( int i = 0; i < iterations; i++ ) {
+		double t0 = UtcTime::getTimeDouble();
+		client.encode();
+		if ( !putClassAd( &client, ad ) || !client.end_of_message() ) {
+			fprintf( stderr, "putClassAd() failed\n" );
+			return false;
+		}
+		double t1 = UtcTime::getTimeDouble();
+
+		ClassAd received;
+		server.decode();
+		if ( !getClassAd( &server, received ) || !server.end_of_message() ) {
+			fprintf( stderr, "getClassAd() failed\n" );
+			return false;
+		}
+		double t2 = UtcTime::getTimeDouble();
+
+		put_secs += t1 - t0;
+		get_secs += t2 - t1;
+		if ( check && i == 0 && !same_ad( ad, received ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int
+main( int argc, const char **argv )
+{
+	set_mySubSystem( "TEST_CLASSAD_WIRE", SUBSYSTEM_TYPE_TOOL );
+	config();
+	dprintf_set_tool_debug( "TOOL", 0 );
+
+	int iterations = 20000;
+	for ( int i = 1; i < argc; i++ ) {
+		if ( strcmp( argv[i], "-iterations" ) == 0 && i+1 < argc ) {
+			iterations = atoi( argv[++i] );
+		} else {
+			fprintf( stderr, "usage: %s [-iterations <n>]\n", argv[0] );
+			return 1;
+		}
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	ReliSock listener;
+	if ( !listener.bind( false, 0, true ) || !listener.listen() ) {
+		fprintf( stderr, "cannot listen on loopback\n" );
+		return 1;
+	}
+	ReliSock client;
+	if ( !client.connect( listener.get_sinful() ) ) {
+		fprintf( stderr, "cannot connect to %s\n", listener.get_sinful() );
+		return 1;
+	}
+	ReliSock *server = listener.accept();
+	if ( !server ) {
+		fprintf( stderr, "accept() failed\n" );
+		return 1;
+	}
+		// pretend the handshake told us the peer is as new as we are
+	CondorVersionInfo our_version;
+	client.set_peer_version( &our_version );
+
+	ClassAd startd_ad, job_ad;
+	make_startd_ad( startd_ad );
+	make_job_ad( job_ad );
+
+	struct { const char *name; ClassAd *ad; } kinds[] = {
+		{ "startd", &startd_ad },
+		{ "job", &job_ad },
+	};
+
+	bool ok = true;
+	printf( "%-8s %-8s %14s %14s\n", "ad", "format", "put ads/sec", "get ads/sec" );
+	for ( size_t k = 0; ok && k < sizeof(kinds)/sizeof(kinds[0]); k++ ) {
+		for ( int binary = 0; ok && binary < 2; binary++ ) {
+			double put_secs = 0, get_secs = 0;
+			AttrList_setBinaryWireFormat( binary != 0 );
+			ok = run_one( client, *server, *kinds[k].ad, iterations,
+						  binary != 0, put_secs, get_secs );
+			if ( ok ) {
+				printf( "%-8s %-8s %14.0f %14.0f\n", kinds[k].name,
+						binary ? "binary" : "text",
+						iterations / put_secs, iterations / get_secs );
+			}
+		}
+	}
+
+	delete server;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2014, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+/*
+  Wakeup latency benchmark for the Selector backends.
+
+  Registers N idle pipe ends with a Selector, then repeatedly makes one
+  of them readable and measures how long it takes to get back out of
+  execute() and find it.  The select backend rebuilds its interest set
+  before every pass; the epoll backend registers the fds once and only
+  looks at the ones it reports ready, the same way DaemonCore::Driver()
+  uses each of them.
+
+  usage: test_selector [-iterations <n>] [<nfds> ...]
+  (default: 1000 10000 50000 fds)
+*/
+
+#include "condor_common.h"
+#include "condor_config.h"
+#include "condor_debug.h"
+#include "subsystem_info.h"
+#include "utc_time.h"
+#include "selector.h"
+#include <vector>
+
+static bool
+run_one( int nfds, int iterations, bool use_epoll, double &usec_per_wakeup )
+{
+	std::vector<int> fds;
+	std::vector<int> writers;
+
+	for ( int i = 0; i < nfds; i += 2 ) {
+		int p[2];
+		if ( pipe( p ) != 0 ) {
+			fprintf( stderr, "pipe() failed after %d fds: %s\n",
+					 (int)fds.size(), strerror(errno) );
+			break;
+		}
+		fds.push_back( p[0] );
+		fds.push_back( p[1] );
+		writers.push_back( p[1] );
+	}
+
+	bool ok = (int)fds.size() >= nfds;
+	if ( ok && !use_epoll ) {
+		for ( size_t i = 0; i < fds.size(); i++ ) {
+			if ( fds[i] >= FD_SETSIZE ) {
+					// select() cannot go here without overrunning fd_set
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	if ( ok ) {
+		Selector selector;
+		if ( use_epoll ) {
+			if ( selector.enable_epoll() ) {
+				for ( size_t i = 0; i < fds.size(); i++ ) {
+					selector.add_fd( fds[i], Selector::IO_READ );
+				}
+			} else {
+				ok = false;
+			}
+		}
+
+		double total = 0;
+		for ( int iter = 0; ok && iter < iterations; iter++ ) {
+			int w = rand() % writers.size();
+			int rfd = fds[2*w];
+
+			if ( !use_epoll ) {
+				selector.reset();
+				for ( size_t i = 0; i < fds.size(); i++ ) {
+					selector.add_fd( fds[i], Selector::IO_READ );
+				}
+			}
+			selector.set_timeout( 5 );
+
+			double begin = UtcTime::getTimeDouble();
+			char c = 'x';
+			if ( write( writers[w], &c, 1 ) != 1 ) {
+				ok = false;
+				break;
+			}
+			selector.execute();
+			int found = -1;
+			const std::vector<int> *ready = selector.ready_fds();
+			if ( ready ) {
+				for ( size_t i = 0; i < ready->size(); i++ ) {
+					if ( selector.fd_ready( (*ready)[i], Selector::IO_READ ) ) {
+						found = (*ready)[i];
+					}
+				}
+			} else {
+				for ( size_t i = 0; i < fds.size(); i++ ) {
+					if ( selector.fd_ready( fds[i], Selector::IO_READ ) ) {
+						found = fds[i];
+					}
+				}
+			}
+			total += UtcTime::getTimeDouble() - begin;
+
+			if ( found != rfd || read( rfd, &c, 1 ) != 1 ) {
+				fprintf( stderr, "wrong fd reported ready (%d, wanted %d)\n",
+						 found, rfd );
+				ok = false;
+			}
+		}
+		usec_per_wakeup = total * 1e6 / iterations;
+	}
+
+	for ( size_t i = 0; i < fds.size(); i++ ) {
+		close( fds[i] );
+	}
+	return ok;
+}
+
+int
+main( int argc, const char **argv )
+{
+	set_mySubSystem( "TEST_SELECTOR", SUBSYSTEM_TYPE_TOOL );
+	config();
+	dprintf_set_tool_debug( "TOOL", 0 );
+
+	int iterations = 1000;
+	std::vector<int> sizes;
+	for ( int i = 1; i < argc; i++ ) {
+		if ( strcmp( argv[i], "-iterations" ) == 0 && i+1 < argc ) {
+			iterations = atoi( argv[++i] );
+		} else {
+			sizes.push_back( atoi( argv[i] ) );
+		}
+	}
+	if ( sizes.empty() ) {
+		sizes.push_back( 1000 );
+		sizes.push_back( 10000 );
+		sizes.push_back( 50000 );
+	}
+	if ( iterations < 1 ) {
+		iterations = 1;
+	}
+
+#if defined(RLIMIT_NOFILE)
+	struct rlimit rl;
+	if ( getrlimit( RLIMIT_NOFILE, &rl ) == 0 ) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit( RLIMIT_NOFILE, &rl );
+	}
+#endif
+
+	printf( "%8s %18s %18s\n", "fds", "select usec/wake", "epoll usec/wake" );
+	for ( size_t i = 0; i < sizes.size(); i++ ) {
+		double sel = 0, ep = 0;
+		bool sel_ok = run_one( sizes[i], iterations, false, sel );
+		bool ep_ok = run_one( sizes[i], iterations, true, ep );
+		printf( "%8d", sizes[i] );
+		if ( sel_ok ) { printf( " %18.1f", sel ); } else { printf( " %18s", "n/a" ); }
+		if ( ep_ok ) { printf( " %18.1f", ep ); } else { printf( " %18s", "n/a" ); }
+		printf( "\n" );
+	}
+	return 0;
+}